@@ -787,6 +787,7 @@ dnl----------------------------------------------------------------------------
 	asm/system.h \
 	linux/seq_file.h \
 	linux/smpboot.h \
+	linux/sched/clock.h \
 	], [:], [:], [
 #include <linux/compiler.h>
 #ifdef NEED_LINUX_AUTOCONF_H
@@ -821,6 +822,7 @@ dnl----------------------------------------------------------------------------
     _LINUX_CHECK_FUNCS([ \
 	MOD_DEC_USE_COUNT \
 	MOD_INC_USE_COUNT \
+	__alloc_percpu_gfp \
 	__in_dev_get_rcu \
 	__ip_select_ident \
 	__symbol_get \
@@ -834,6 +836,9 @@ dnl----------------------------------------------------------------------------
 	class_destroy \
 	cli \
 	compat_ptr \
+	copy_from_iter \
+	copy_splice_read \
+	copy_to_iter \
 	cpu_raise_softirq \
 	cpumask_scnprintf \
 	create_proc_info_entry \
@@ -854,12 +859,18 @@ dnl----------------------------------------------------------------------------
 	force_delete \
 	free_dma \
 	generic_delete_inode \
+	generic_file_splice_read \
 	get_pid \
 	get_unused_fd_flags \
+	idr_alloc \
+	idr_get_next \
+	idr_preload \
 	iget_locked \
 	in_atomic \
+	iov_iter_pipe \
 	inet_csk \
 	inet_get_local_port_range \
+	iter_file_splice_write \
 	interruptible_sleep_on \
 	ip_dst_output \
 	ip_route_output_flow \
@@ -870,7 +881,10 @@ dnl----------------------------------------------------------------------------
 	kern_umount \
 	kill_litter_super \
 	kill_proc \
+	kmalloc_node \
+	kmem_cache_alloc_node \
 	ksize \
+	local_clock \
 	module_put \
 	nf_reset \
 	num_online_cpus \
@@ -907,11 +921,14 @@ dnl----------------------------------------------------------------------------
 	process_group \
 	process_session \
 	put_pid \
+	rcu_barrier \
 	rcu_read_lock \
 	read_trylock \
 	register_cpu_notifier \
 	register_ioctl32_conversion \
+	remap_vmalloc_range \
 	request_dma \
+	sched_clock \
 	session_of_pgrp \
 	set_cpus_allowed \
 	set_nlink \
@@ -919,6 +936,10 @@ dnl----------------------------------------------------------------------------
 	simple_statfs \
 	skb_dst \
 	skb_dst_set \
+	skb_fill_page_desc \
+	skb_frag_off \
+	skb_frag_page \
+	skb_frag_size \
 	skb_get_tx_queue \
 	skb_rtable \
 	skb_transport_header \
@@ -927,6 +948,7 @@ dnl----------------------------------------------------------------------------
 	smpboot_register_percpu_thread \
 	sti \
 	synchronize_net \
+	synchronize_rcu \
 	task_pgrp \
 	task_pgrp_nr \
 	task_pgrp_nr_ns \
@@ -948,6 +970,7 @@ dnl----------------------------------------------------------------------------
 	unregister_ioctl32_conversion \
 	vfree \
 	vmalloc \
+	vmalloc_user \
 	write_trylock \
 	yield \
     ], [:], [
@@ -977,8 +1000,11 @@ dnl----------------------------------------------------------------------------
 #ifdef HAVE_KINC_LINUX_SLAB_H
 #include <linux/slab.h>
 #endif
+#include <linux/vmalloc.h>
+#include <linux/idr.h>
 #include <linux/fs.h>
 #include <linux/file.h>
+#include <linux/uio.h>
 #ifdef HAVE_KINC_LINUX_FDTABLE_H
 #include <linux/fdtable.h>
 #endif
@@ -986,6 +1012,9 @@ dnl----------------------------------------------------------------------------
 #include <linux/cpumask.h>
 #endif
 #include <linux/sched.h>
+#ifdef HAVE_KINC_LINUX_SCHED_CLOCK_H
+#include <linux/sched/clock.h>
+#endif
 #include <linux/wait.h>
 #ifdef HAVE_KINC_LINUX_KDEV_T_H
 #include <linux/kdev_t.h>
@@ -1210,6 +1239,10 @@ dnl----------------------------------------------------------------------------
 	struct file_operations.unlocked_ioctl,
 	struct file_operations.readdir,
 	struct file_operations.iterate,
+	struct file_operations.read_iter,
+	struct file_operations.write_iter,
+	struct file_operations.splice_read,
+	struct file_operations.splice_write,
 	struct files_struct.fdtab,
 	struct files_struct.max_fdset,
 	struct file_system_type.get_sb,
@@ -263,7 +263,7 @@ register_bpf(struct cdevsw *cdev)
 	}
 	memset(cmin, 0, sizeof(*cmin));
 	INIT_LIST_HEAD(&cmin->n_list);
-	INIT_LIST_HEAD(&cmin->n_hash);
+	INIT_HLIST_NODE(&cmin->n_hash);
 	cmin->n_name = cdev->d_name;
 	cmin->n_str = cdev->d_str;
 	cmin->n_flag = bpf_cdev.d_flag;
@@ -283,7 +283,7 @@ register_bpf(struct cdevsw *cdev)
 	node = cmin + 1;
 	memset(node, 0, sizeof(*node));
 	INIT_LIST_HEAD(&node->n_list);
-	INIT_LIST_HEAD(&node->n_hash);
+	INIT_HLIST_NODE(&node->n_hash);
 	node->n_name = "bpf";
 	node->n_str = cdev->d_str;
 	node->n_flag = D_CLONE;
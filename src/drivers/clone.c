@@ -335,7 +335,7 @@ register_clone(struct cdevsw *cdev)
 	}
 	memset(cmin, 0, sizeof(*cmin));
 	INIT_LIST_HEAD(&cmin->n_list);
-	INIT_LIST_HEAD(&cmin->n_hash);
+	INIT_HLIST_NODE(&cmin->n_hash);
 	cmin->n_name = cdev->d_name;
 	cmin->n_str = cdev->d_str;
 	cmin->n_flag = clone_cdev.d_flag;
@@ -337,6 +337,28 @@ typedef struct tg {
 	isup_stats_tg_t statsp;		/* trunk group statistics periods */
 } tg_t;
 
+/*
+ *  Q.752 message counters.  The Q.752 11.1 and 11.2 totals are stepped for every ISUP message sent
+ *  or received, at the signalling relation, at the signalling point and at the default object, and
+ *  would otherwise bounce the same three cache lines between all processors carrying ISUP traffic.
+ *  Where the kernel can allocate per-CPU memory from atomic context they are kept per CPU and only
+ *  folded together when read with ISUP_IOCGSTATS or ISUP_IOCCSTATS.  The by-type counters are
+ *  spread over 512 words (and so over many cache lines) and stay in the shared statistics: keeping
+ *  them per CPU would take 4 kbytes per object per CPU from the small atomic per-CPU reserve.  This
+ *  structure must match the message statistics of isup_stats_sr_t, isup_stats_sp_t and
+ *  isup_stats_df_t beginning at msgs_sent.
+ */
+#if defined alloc_percpu && defined HAVE_KFUNC___ALLOC_PERCPU_GFP
+#define ISUP_PERCPU_MSGS 1
+#endif
+
+struct isup_msgs {
+	cc_ulong msgs_sent;		/* Q.752 11.1 */
+	cc_ulong msgs_recv;		/* Q.752 11.2 */
+};
+
+#define ISUP_MSGS_COUNT (sizeof(struct isup_msgs) / sizeof(cc_ulong))
+
 /*
    signalling relation 
  */
@@ -356,6 +378,8 @@ typedef struct sr {
 	isup_opt_conf_sr_t config;	/* signalling relation configuration */
 	isup_stats_sr_t stats;		/* signalling relation statistics */
 	isup_stats_sr_t statsp;		/* signalling relation statistics periods */
+	struct isup_msgs *msgs;		/* per-CPU message counters (or NULL) */
+	struct isup_msgs msgs_base;	/* message counter totals at last collection */
 } sr_t;
 
 /*
@@ -376,6 +400,8 @@ typedef struct sp {
 	isup_opt_conf_sp_t config;	/* signalling point configuration */
 	isup_stats_sp_t stats;		/* signalling point statistics */
 	isup_stats_sp_t statsp;		/* signalling point statistics periods */
+	struct isup_msgs *msgs;		/* per-CPU message counters (or NULL) */
+	struct isup_msgs msgs_base;	/* message counter totals at last collection */
 } sp_t;
 
 /*
@@ -412,6 +438,8 @@ typedef struct df {
 	isup_opt_conf_df_t config;	/* default configuration */
 	isup_stats_df_t stats;		/* default statistics */
 	isup_stats_df_t statsp;		/* default statistics periods */
+	struct isup_msgs *msgs;		/* per-CPU message counters (or NULL) */
+	struct isup_msgs msgs_base;	/* message counter totals at last collection */
 } df_t;
 STATIC struct df master = {
 #if	defined __SPIN_LOCK_UNLOCKED
@@ -423,6 +451,113 @@ STATIC struct df master = {
 #endif
 };
 
+/*
+ *  Q.752 message counters
+ *  -----------------------------------
+ *  When the per-CPU counters could not be allocated (or the kernel cannot allocate them from
+ *  atomic context) the counters in the shared statistics structure are stepped instead and there
+ *  is nothing to fold.
+ */
+STATIC struct isup_msgs *
+isup_msgs_alloc(void)
+{
+#if defined ISUP_PERCPU_MSGS
+	return (__alloc_percpu_gfp(sizeof(struct isup_msgs), __alignof__(struct isup_msgs),
+				   GFP_ATOMIC));
+#else
+	return (NULL);
+#endif
+}
+STATIC void
+isup_msgs_free(struct isup_msgs *msgs)
+{
+#if defined ISUP_PERCPU_MSGS
+	if (msgs)
+		free_percpu(msgs);
+#endif
+}
+STATIC inline fastcall struct isup_msgs *
+isup_msgs_cpu(struct isup_msgs *msgs, cc_ulong *stats, int cpu)
+{
+#if defined ISUP_PERCPU_MSGS
+	if (likely(msgs != NULL))
+		return (per_cpu_ptr(msgs, cpu));
+#endif
+	return ((struct isup_msgs *) stats);
+}
+
+/*
+ *  Q.752 11.1: count a message sent on the signalling relation.
+ */
+STATIC inline fastcall void
+isup_msgs_sent(struct sr *sr, uchar mt)
+{
+	struct sp *sp = sr->sp.sp;
+	struct isup_msgs *m;
+	int cpu = get_cpu();
+
+	m = isup_msgs_cpu(sr->msgs, &sr->stats.msgs_sent, cpu);
+	m->msgs_sent++;
+	m = isup_msgs_cpu(sp->msgs, &sp->stats.msgs_sent, cpu);
+	m->msgs_sent++;
+	m = isup_msgs_cpu(master.msgs, &master.stats.msgs_sent, cpu);
+	m->msgs_sent++;
+	put_cpu();
+	sr->stats.msgs_sent_by_type[mt]++;
+	sp->stats.msgs_sent_by_type[mt]++;
+	master.stats.msgs_sent_by_type[mt]++;
+}
+
+/*
+ *  Q.752 11.2: count a message received on the signalling relation.
+ */
+STATIC inline fastcall void
+isup_msgs_recv(struct sr *sr, uchar mt)
+{
+	struct sp *sp = sr->sp.sp;
+	struct isup_msgs *m;
+	int cpu = get_cpu();
+
+	m = isup_msgs_cpu(sr->msgs, &sr->stats.msgs_sent, cpu);
+	m->msgs_recv++;
+	m = isup_msgs_cpu(sp->msgs, &sp->stats.msgs_sent, cpu);
+	m->msgs_recv++;
+	m = isup_msgs_cpu(master.msgs, &master.stats.msgs_sent, cpu);
+	m->msgs_recv++;
+	put_cpu();
+	sr->stats.msgs_recv_by_type[mt]++;
+	sp->stats.msgs_recv_by_type[mt]++;
+	master.stats.msgs_recv_by_type[mt]++;
+}
+
+/*
+ *  Fold the per-CPU counters into the message totals at @stats (the msgs_sent member of a
+ *  statistics structure being returned to the user).  The result is the count since the last
+ *  collection.  When @collect is set, the base is advanced to the folded totals, so that each
+ *  message is reported by exactly one collection, even though other processors keep counting while
+ *  the fold runs.  Called with the master lock held, which serializes collections.
+ */
+STATIC void
+isup_msgs_fold(struct isup_msgs *msgs, struct isup_msgs *base, cc_ulong *stats, int collect)
+{
+#if defined ISUP_PERCPU_MSGS
+	cc_ulong *b = (cc_ulong *) base;
+	int i, cpu;
+
+	if (msgs == NULL)
+		return;
+	for (i = 0; i < ISUP_MSGS_COUNT; i++) {
+		cc_ulong total = 0;
+
+		for_each_possible_cpu(cpu)
+			total += ((cc_ulong *) per_cpu_ptr(msgs, cpu))[i];
+		stats[i] = total - b[i];
+		if (collect)
+			b[i] = total;
+	}
+#endif
+}
+
 /*
  *  Forward declarations.
  */
@@ -7468,12 +7603,7 @@ isup_send_msg(queue_t *q, struct sr *sr, uchar mt, ulong prio, ulong sls, mblk_t
 				ss7_oput(mtp->oq, mp);
 				/* 
 				   Q.752 11.1 */
-				sr->stats.msgs_sent++;
-				sr->stats.msgs_sent_by_type[mt]++;
-				sr->sp.sp->stats.msgs_sent++;
-				sr->sp.sp->stats.msgs_sent_by_type[mt]++;
-				master.stats.msgs_sent++;
-				master.stats.msgs_sent_by_type[mt]++;
+				isup_msgs_sent(sr, mt);
 				return (QR_DONE);
 			}
 			rare();
@@ -7520,12 +7650,7 @@ isup_send_cpy(queue_t *q, struct ct *ct, uchar mt, ulong prio, ulong sls, mblk_t
 					ss7_oput(mtp->oq, mp);
 					/* 
 					   Q.752 11.1 */
-					sr->stats.msgs_sent++;
-					sr->stats.msgs_sent_by_type[mt]++;
-					sr->sp.sp->stats.msgs_sent++;
-					sr->sp.sp->stats.msgs_sent_by_type[mt]++;
-					master.stats.msgs_sent++;
-					master.stats.msgs_sent_by_type[mt]++;
+					isup_msgs_sent(sr, mt);
 					return (QR_DONE);
 				}
 				rare();
@@ -17975,12 +18100,7 @@ mtp_read(queue_t *q, mblk_t *mp, struct sr *sr)
 	msg->mt = *p++;
 	/* 
 	   Q.752 11.2 */
-	sr->stats.msgs_recv++;
-	sr->stats.msgs_recv_by_type[msg->mt]++;
-	sr->sp.sp->stats.msgs_recv++;
-	sr->sp.sp->stats.msgs_recv_by_type[msg->mt]++;
-	master.stats.msgs_recv++;
-	master.stats.msgs_recv_by_type[msg->mt]++;
+	isup_msgs_recv(sr, msg->mt);
 	todo(("Change to hash lookup later (cic = %lu, mt = %lu)\n", msg->cic, msg->mt));
 	for (ct = sr->ct.list; ct && ct->cic != msg->cic; ct = ct->sr.next) ;
 	if (!ct)
@@ -24212,6 +24332,7 @@ isup_stat_get_sr(isup_stats_t * arg, struct sr *sr, int size)
 	if (!sr || (size -= sizeof(*sta)) < 0)
 		return (-EINVAL);
 	*sta = sr->stats;
+	isup_msgs_fold(sr->msgs, &sr->msgs_base, &sta->msgs_sent, 0);
 	return (QR_DONE);
 }
 STATIC int
@@ -24222,6 +24343,7 @@ isup_stat_get_sp(isup_stats_t * arg, struct sp *sp, int size)
 	if (!sp || (size -= sizeof(*sta)) < 0)
 		return (-EINVAL);
 	*sta = sp->stats;
+	isup_msgs_fold(sp->msgs, &sp->msgs_base, &sta->msgs_sent, 0);
 	return (QR_DONE);
 }
 STATIC int
@@ -24242,102 +24364,94 @@ isup_stat_get_df(isup_stats_t * arg, struct df *df, int size)
 	if (!df || (size -= sizeof(*sta)) < 0)
 		return (-EINVAL);
 	*sta = df->stats;
+	isup_msgs_fold(df->msgs, &df->msgs_base, &sta->msgs_sent, 0);
 	return (QR_DONE);
 }
 
 /*
  *  CLR Statistics
  *  - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+ *  Collect and clear: the statistics are returned as they stood at the time of clearing, so that a
+ *  collector sees each event in exactly one interval.
  */
 STATIC int
 isup_stat_clr_ct(isup_stats_t * arg, struct ct *ct, int size)
 {
-	uchar *s, *d;
 	isup_stats_ct_t *sta = (typeof(sta)) (arg + 1);
 
 	if (!ct || (size -= sizeof(*sta)) < 0)
 		return (-EINVAL);
-	s = (typeof(s)) (sta + 1);
-	d = (typeof(d)) & ct->stats;
-	for (size = sizeof(*sta); size--; *d &= *s) ;
+	*sta = ct->stats;
+	bzero(&ct->stats, sizeof(ct->stats));
 	return (QR_DONE);
 }
 STATIC int
 isup_stat_clr_cg(isup_stats_t * arg, struct cg *cg, int size)
 {
-	uchar *s, *d;
 	isup_stats_cg_t *sta = (typeof(sta)) (arg + 1);
 
 	if (!cg || (size -= sizeof(*sta)) < 0)
 		return (-EINVAL);
-	s = (typeof(s)) (sta + 1);
-	d = (typeof(d)) & cg->stats;
-	for (size = sizeof(*sta); size--; *d &= *s) ;
+	*sta = cg->stats;
+	bzero(&cg->stats, sizeof(cg->stats));
 	return (QR_DONE);
 }
 STATIC int
 isup_stat_clr_tg(isup_stats_t * arg, struct tg *tg, int size)
 {
-	uchar *s, *d;
 	isup_stats_tg_t *sta = (typeof(sta)) (arg + 1);
 
 	if (!tg || (size -= sizeof(*sta)) < 0)
 		return (-EINVAL);
-	s = (typeof(s)) (sta + 1);
-	d = (typeof(d)) & tg->stats;
-	for (size = sizeof(*sta); size--; *d &= *s) ;
+	*sta = tg->stats;
+	bzero(&tg->stats, sizeof(tg->stats));
 	return (QR_DONE);
 }
 STATIC int
 isup_stat_clr_sr(isup_stats_t * arg, struct sr *sr, int size)
 {
-	uchar *s, *d;
 	isup_stats_sr_t *sta = (typeof(sta)) (arg + 1);
 
 	if (!sr || (size -= sizeof(*sta)) < 0)
 		return (-EINVAL);
-	s = (typeof(s)) (sta + 1);
-	d = (typeof(d)) & sr->stats;
-	for (size = sizeof(*sta); size--; *d &= *s) ;
+	*sta = sr->stats;
+	bzero(&sr->stats, sizeof(sr->stats));
+	isup_msgs_fold(sr->msgs, &sr->msgs_base, &sta->msgs_sent, 1);
 	return (QR_DONE);
 }
 STATIC int
 isup_stat_clr_sp(isup_stats_t * arg, struct sp *sp, int size)
 {
-	uchar *s, *d;
 	isup_stats_sp_t *sta = (typeof(sta)) (arg + 1);
 
 	if (!sp || (size -= sizeof(*sta)) < 0)
 		return (-EINVAL);
-	s = (typeof(s)) (sta + 1);
-	d = (typeof(d)) & sp->stats;
-	for (size = sizeof(*sta); size--; *d &= *s) ;
+	*sta = sp->stats;
+	bzero(&sp->stats, sizeof(sp->stats));
+	isup_msgs_fold(sp->msgs, &sp->msgs_base, &sta->msgs_sent, 1);
 	return (QR_DONE);
 }
 STATIC int
 isup_stat_clr_mtp(isup_stats_t * arg, struct mtp *mtp, int size)
 {
-	uchar *s, *d;
 	isup_stats_mtp_t *sta = (typeof(sta)) (arg + 1);
 
 	if (!mtp || (size -= sizeof(*sta)) < 0)
 		return (-EINVAL);
-	s = (typeof(s)) (sta + 1);
-	d = (typeof(d)) & mtp->stats;
-	for (size = sizeof(*sta); size--; *d &= *s) ;
+	*sta = mtp->stats;
+	bzero(&mtp->stats, sizeof(mtp->stats));
 	return (QR_DONE);
 }
 STATIC int
 isup_stat_clr_df(isup_stats_t * arg, struct df *df, int size)
 {
-	uchar *s, *d;
 	isup_stats_df_t *sta = (typeof(sta)) (arg + 1);
 
 	if (!df || (size -= sizeof(*sta)) < 0)
 		return (-EINVAL);
-	s = (typeof(s)) (sta + 1);
-	d = (typeof(d)) & df->stats;
-	for (size = sizeof(*sta); size--; *d &= *s) ;
+	*sta = df->stats;
+	bzero(&df->stats, sizeof(df->stats));
+	isup_msgs_fold(df->msgs, &df->msgs_base, &sta->msgs_sent, 1);
 	return (QR_DONE);
 }
 
@@ -24851,19 +24965,26 @@ isup_iocgstats(queue_t *q, mblk_t *mp)
 		spin_lock_irqsave(&master.lock, flags);
 		switch (arg->type) {
 		case ISUP_OBJ_TYPE_CT:
-			return isup_stat_get_ct(arg, ct_lookup(arg->id), size);
+			ret = isup_stat_get_ct(arg, ct_lookup(arg->id), size);
+			break;
 		case ISUP_OBJ_TYPE_CG:
-			return isup_stat_get_cg(arg, cg_lookup(arg->id), size);
+			ret = isup_stat_get_cg(arg, cg_lookup(arg->id), size);
+			break;
 		case ISUP_OBJ_TYPE_TG:
-			return isup_stat_get_tg(arg, tg_lookup(arg->id), size);
+			ret = isup_stat_get_tg(arg, tg_lookup(arg->id), size);
+			break;
 		case ISUP_OBJ_TYPE_SR:
-			return isup_stat_get_sr(arg, sr_lookup(arg->id), size);
+			ret = isup_stat_get_sr(arg, sr_lookup(arg->id), size);
+			break;
 		case ISUP_OBJ_TYPE_SP:
-			return isup_stat_get_sp(arg, sp_lookup(arg->id), size);
+			ret = isup_stat_get_sp(arg, sp_lookup(arg->id), size);
+			break;
 		case ISUP_OBJ_TYPE_MT:
-			return isup_stat_get_mtp(arg, mtp_lookup(arg->id), size);
+			ret = isup_stat_get_mtp(arg, mtp_lookup(arg->id), size);
+			break;
 		case ISUP_OBJ_TYPE_DF:
-			return isup_stat_get_df(arg, &master, size);
+			ret = isup_stat_get_df(arg, &master, size);
+			break;
 		default:
 			goto einval;
 		}
@@ -24898,19 +25019,26 @@ isup_ioccstats(queue_t *q, mblk_t *mp)
 		spin_lock_irqsave(&master.lock, flags);
 		switch (arg->type) {
 		case ISUP_OBJ_TYPE_CT:
-			return isup_stat_clr_ct(arg, ct_lookup(arg->id), size);
+			ret = isup_stat_clr_ct(arg, ct_lookup(arg->id), size);
+			break;
 		case ISUP_OBJ_TYPE_CG:
-			return isup_stat_clr_cg(arg, cg_lookup(arg->id), size);
+			ret = isup_stat_clr_cg(arg, cg_lookup(arg->id), size);
+			break;
 		case ISUP_OBJ_TYPE_TG:
-			return isup_stat_clr_tg(arg, tg_lookup(arg->id), size);
+			ret = isup_stat_clr_tg(arg, tg_lookup(arg->id), size);
+			break;
 		case ISUP_OBJ_TYPE_SR:
-			return isup_stat_clr_sr(arg, sr_lookup(arg->id), size);
+			ret = isup_stat_clr_sr(arg, sr_lookup(arg->id), size);
+			break;
 		case ISUP_OBJ_TYPE_SP:
-			return isup_stat_clr_sp(arg, sp_lookup(arg->id), size);
+			ret = isup_stat_clr_sp(arg, sp_lookup(arg->id), size);
+			break;
 		case ISUP_OBJ_TYPE_MT:
-			return isup_stat_clr_mtp(arg, mtp_lookup(arg->id), size);
+			ret = isup_stat_clr_mtp(arg, mtp_lookup(arg->id), size);
+			break;
 		case ISUP_OBJ_TYPE_DF:
-			return isup_stat_clr_df(arg, &master, size);
+			ret = isup_stat_clr_df(arg, &master, size);
+			break;
 		default:
 			goto einval;
 		}
@@ -26947,6 +27075,7 @@ isup_alloc_sr(ulong id, struct sp *sp, mtp_addr_t * add)
 		sr_get(sr);	/* first get */
 		spin_lock_init(&sr->lock);	/* "sr-lock" */
 		sr->id = id;
+		sr->msgs = isup_msgs_alloc();
 		/* 
 		   add to master list */
 		for (srp = &master.sr.list; *srp && (*srp)->id < id; srp = &(*srp)->next) ;
@@ -27095,6 +27224,7 @@ sr_put(struct sr *sr)
 	if (sr) {
 		assure(atomic_read(&sr->refcnt) > 1);
 		if (atomic_dec_and_test(&sr->refcnt)) {
+			isup_msgs_free(sr->msgs);
 			kmem_cache_free(isup_sr_cachep, sr);
 			printd(("%s: %s: %p: deallocated sr structure\n", DRV_NAME,
 				__FUNCTION__, sr));
@@ -27141,6 +27271,7 @@ isup_alloc_sp(ulong id, mtp_addr_t * add)
 		sp_get(sp);	/* first get */
 		spin_lock_init(&sp->lock);	/* "sp-lock" */
 		sp->id = id;
+		sp->msgs = isup_msgs_alloc();
 		sp->add = *add;
 		for (spp = &master.sp.list; *spp && (*spp)->id < id; spp = &(*spp)->next) ;
 		if ((sp->next = *spp))
@@ -27256,6 +27387,7 @@ sp_put(struct sp *sp)
 	if (sp) {
 		assure(atomic_read(&sp->refcnt) > 1);
 		if (atomic_dec_and_test(&sp->refcnt)) {
+			isup_msgs_free(sp->msgs);
 			kmem_cache_free(isup_sp_cachep, sp);
 			printd(("%s: %s: %p: deallocated sp structure\n", DRV_NAME,
 				__FUNCTION__, sp));
@@ -27524,6 +27656,7 @@ isupterminate(void)
 				isup_majors[mindex] = 0;
 		}
 	}
+	isup_msgs_free(xchg(&master.msgs, NULL));
 	if ((err = isup_term_caches()))
 		cmn_err(CE_WARN, "%s: could not terminate caches", DRV_NAME);
 	return;
@@ -27540,6 +27673,7 @@ isupinit(void)
 		isupterminate();
 		return (err);
 	}
+	master.msgs = isup_msgs_alloc();
 	for (mindex = 0; mindex < CMAJORS; mindex++) {
 		if ((err = isup_register_strdev(isup_majors[mindex])) < 0) {
 			if (mindex) {
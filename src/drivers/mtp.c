@@ -353,9 +353,14 @@ struct rs {
 	int cong_status;		/* congestion status */
 	int disc_status;		/* discard status */
 	uint32_t dest;			/* remote signalling point/cluster */
+	uint sls;			/* sls generator for the signalling relation */
 	size_t cong_msg_count;		/* msg counts under congestion */
 	size_t cong_oct_count;		/* msg octets under congestion */
 	SLIST_LINKAGE (sp, rs, sp);	/* signalling point list linkage */
+	struct {
+		struct rs *next;	/* next in destination hash chain */
+		struct rs **prev;	/* prev in destination hash chain */
+	} hash;				/* signalling point destination hash linkage */
 	SLIST_COUNTERS (rl, rl);	/* list and counts of route lists */
 	SLIST_HEAD (rr, rr);		/* route set restriction list */
 	struct mtp_timers_rs timers;	/* route set timers */
@@ -369,6 +374,9 @@ static struct rs *mtp_alloc_rs(uint, struct sp *, struct mtp_conf_rs *);
 static void mtp_free_rs(struct rs *);
 static struct rs *rs_lookup(uint);
 static uint rs_get_id(uint);
+static struct rs *rs_find(struct sp *, uint32_t, int);
+static struct rs *rs_route(struct sp *, uint32_t);
+static inline fastcall uint rs_sls_next(struct sp *, struct rs *);
 
 /*
  *  CR - Controlled rerouting buffer
@@ -459,8 +467,14 @@ static uint rt_get_id(uint);
  *  SP - Signalling point
  *  -----------------------------------
  *  The signalling point structure represents a local (real, virtual or alias) signalling point
- *  within a network appearance.
- */
+ *  within a network appearance.  Route sets belonging to the signalling point are also hashed by
+ *  destination and type so that the routing of sent and transferred messages does not require a
+ *  search of the entire route set list.  The hash starts with 2^RS_HASH_ORDER buckets and doubles
+ *  whenever the number of route sets exceeds the number of buckets, up to 2^RS_HASH_MAXORDER
+ *  buckets, which is one bucket per 14-bit ITU-T point code.
+ */
+#define RS_HASH_ORDER	8
+#define RS_HASH_MAXORDER	14
 struct sp {
 	HEAD_DECLARATION (struct sp);	/* head declaration */
 	int users;
@@ -482,6 +496,8 @@ struct sp {
 	} mtp;
 	SLIST_COUNTERS (ls, ls);	/* list and counts of link sets */
 	SLIST_COUNTERS (rs, rs);	/* list and counts of route sets */
+	struct rs **rs_hash;		/* route sets hashed by destination and type */
+	uint rs_hash_order;		/* log2 of the number of hash buckets */
 	SLIST_HEAD (sl, sl);		/* signalling link list */
 	struct mtp_timers_sp timers;	/* signalling point timers */
 	struct mtp_opt_conf_sp config;	/* signalling point configuration */
@@ -532,14 +548,18 @@ static uint cb_get_id(uint);
  *  -----------------------------------
  *  The link set structure represents a combined link set.  Each link set belongs to a local
  *  signalling point and contains a number of link (LK) structures.  An SLS map is used to select a
- *  link within the link set.
+ *  link within the link set.  The route list and link SLS map indexes for each SLS value are
+ *  precomputed from the SLS masks whenever the masks are configured.
  */
+#define LS_SLS_SIZE	256
 struct ls {
 	HEAD_DECLARATION (struct ls);	/* head declaration */
 	uint sls;			/* sls for mgmt load sharing */
 	SLIST_LINKAGE (sp, ls, sp);	/* signalling point list linkage */
 	SLIST_COUNTERS (rl, rl);	/* list and counts of route lists */
 	SLIST_COUNTERS (lk, lk);	/* list and counts of links */
+	uchar rl_index[LS_SLS_SIZE];	/* route list sls map index by sls */
+	uchar lk_index[LS_SLS_SIZE];	/* link sls map index by sls */
 	struct mtp_timers_ls timers;	/* link set timers */
 	struct mtp_opt_conf_ls config;	/* link set configuration */
 	struct mtp_stats_ls statsp;	/* link set statistics periods */
@@ -630,11 +650,55 @@ struct sl {
 	struct mtp_opt_conf_sl config;	/* signalling link configuration */
 	struct mtp_stats_sl statsp;	/* signalling link statistics periods */
 	struct mtp_stats_sl stats;	/* signalling link statistics */
+	struct mtp_stats_sl *pstats;	/* per-CPU traffic counters (or NULL) */
+	struct mtp_stats_sl pbase;	/* traffic counter totals at last collection */
 	struct mtp_notify_sl notify;	/* signalling link notifications */
 };
 
 #define SL_PRIV(__q) ((struct sl *)(__q)->q_ptr)
 
+/*
+ *  Signalling link traffic counters are stepped for every MSU placed on the link, from whichever
+ *  processor routes it.  Where the kernel can allocate per-CPU memory from atomic context they are
+ *  kept per CPU and folded into the signalling link statistics by mtp_get_stats_sl(); otherwise
+ *  (or when the allocation fails) sl->stats is stepped directly.
+ */
+#if defined alloc_percpu && defined HAVE_KFUNC___ALLOC_PERCPU_GFP
+#define MTP_PERCPU_STATS 1
+#endif
+
+static inline fastcall struct mtp_stats_sl *
+sl_stats_cpu(struct sl *sl, int cpu)
+{
+#if defined MTP_PERCPU_STATS
+	if (likely(sl->pstats != NULL))
+		return (per_cpu_ptr(sl->pstats, cpu));
+#endif
+	return (&sl->stats);
+}
+static inline fastcall void
+sl_count_local(struct sl *sl, mblk_t *mp)
+{
+	struct mtp_stats_sl *c;
+	int dsize = msgdsize(mp);
+
+	c = sl_stats_cpu(sl, get_cpu());
+	c->sl_local_msus++;
+	c->sl_local_octets += dsize;
+	put_cpu();
+}
+static inline fastcall void
+sl_count_xfer(struct sl *sl, mblk_t *mp)
+{
+	struct mtp_stats_sl *c;
+	int dsize = msgdsize(mp);
+
+	c = sl_stats_cpu(sl, get_cpu());
+	c->sl_xfer_msus++;
+	c->sl_xfer_octets += dsize;
+	put_cpu();
+}
+
 static struct sl *mtp_alloc_link(queue_t *, int, cred_t *, minor_t);
 static void mtp_free_link(struct sl *);
 static struct sl *mtp_alloc_sl(uint, struct sl *, struct lk *, struct mtp_conf_sl *);
@@ -1457,7 +1521,16 @@ mtp_send_msg(queue_t *q, struct mtp *mtp, struct mtp_opts *opt, struct mtp_addr
 {
 	struct sp *sp = mtp->sp.loc;
 	uint mp = (opt && opt->mp) ? *opt->mp : 0;
-	uint sls = (opt && opt->sls) ? *opt->sls : (sp->sls++ & sp->ls.sls_mask);
+	struct rs *rs;
+	uint sls;
+
+	if (opt && opt->sls)
+		sls = *opt->sls;
+	else if (((rs = mtp->sp.rem) && rs->dest == dst->pc) || (rs = rs_route(sp, dst->pc)))
+		/* generate the sls for the signalling relation */
+		sls = rs_sls_next(sp, rs);
+	else
+		sls = (sp->sls++ & sp->ls.sls_mask);
 
 	fixme(("Rewrite this function for multiple interface styles\n"));
 	return mtp_send_user(q, sp, sp->ni, dst->pc, sp->pc, sls, mp, dst->si, dp);
@@ -5678,6 +5751,120 @@ sls_index(uchar sls, uchar mask, uchar bits)
 	return (index);
 }
 
+/*
+ *  Precompute SLS map indexes for a link set
+ *  -------------------------------------------------------------------------
+ *  Builds the route list and link SLS map indexes for each possible SLS value so that routing a
+ *  message does not need to walk the SLS masks bit by bit.  This must be called whenever the SLS
+ *  masks of the link set are changed.
+ */
+static void
+ls_sls_build(struct ls *ls)
+{
+	uint sls;
+
+	for (sls = 0; sls < LS_SLS_SIZE; sls++) {
+		ls->rl_index[sls] = sls_index(sls, ls->rl.sls_mask, ls->rl.sls_bits);
+		ls->lk_index[sls] = sls_index(sls, ls->lk.sls_mask, ls->lk.sls_bits);
+	}
+}
+
+/*
+ *  Generate an SLS for a signalling relation
+ *  -------------------------------------------------------------------------
+ *  Each route set keeps its own SLS generator so that locally originated messages without an SLS
+ *  are spread over all SLS values, and so over all routes and links, for each signalling relation
+ *  rather than for the signalling point as a whole.
+ */
+static inline fastcall uint
+rs_sls_next(struct sp *sp, struct rs *rs)
+{
+	return (rs->sls++ & sp->ls.sls_mask);
+}
+
+/*
+ *  SLS bit rotation
+ *  -------------------------------------------------------------------------
+ *  SLS bit rotation is performed by default for ANSI, JTTC and CHIN and not for ITU-T and ETSI.
+ *  The SS7_POPT_SLSR and SS7_POPT_NOSLSR protocol options override the default.  ANSI-format
+ *  labels rotate the least significant 5 bits of the SLS (for 5-bit and 8-bit compatibility);
+ *  ITU-T-format labels rotate the 4-bit SLS.  The SLS in the routing label is rewritten.
+ */
+static inline fastcall bool
+na_sls_rotation(struct na *na)
+{
+	if (na->option.popt & SS7_POPT_NOSLSR)
+		return (false);
+	if (na->option.popt & SS7_POPT_SLSR)
+		return (true);
+	switch (na->option.pvar & SS7_PVAR_MASK) {
+	case SS7_PVAR_ANSI:
+	case SS7_PVAR_JTTC:
+	case SS7_PVAR_CHIN:	/* ??? */
+		return (true);
+	}
+	return (false);
+}
+
+static inline fastcall uint
+sls_label(struct na *na, mblk_t *mp)
+{
+	switch (na->option.pvar & SS7_PVAR_MASK) {
+	case SS7_PVAR_ANSI:
+	case SS7_PVAR_JTTC:
+	case SS7_PVAR_CHIN:
+		return (mp->b_rptr[7]);
+	default:
+		return (mp->b_rptr[4] >> 4);
+	}
+}
+
+static uint
+sls_rotate(struct na *na, mblk_t *mp, uint sls)
+{
+	if (!na_sls_rotation(na))
+		return (sls);
+	switch (na->option.pvar & SS7_PVAR_MASK) {
+	case SS7_PVAR_ANSI:
+	case SS7_PVAR_JTTC:
+	case SS7_PVAR_CHIN:
+		sls = (sls & 0xe0) | ((sls & 0x1f) >> 1) | ((sls & 0x01) << 4);
+		/* rewrite sls in routing label */
+		mp->b_rptr[7] = sls;
+		break;
+	default:
+		sls = ((sls & 0x0f) >> 1) | ((sls & 0x01) << 3);
+		/* rewrite sls in routing label */
+		mp->b_rptr[4] = (mp->b_rptr[4] & 0x0f) | (sls << 4);
+		break;
+	}
+	return (sls);
+}
+
+static void
+sls_unrotate(struct na *na, mblk_t *mp)
+{
+	uint sls;
+
+	if (!na_sls_rotation(na))
+		return;
+	sls = sls_label(na, mp);
+	switch (na->option.pvar & SS7_PVAR_MASK) {
+	case SS7_PVAR_ANSI:
+	case SS7_PVAR_JTTC:
+	case SS7_PVAR_CHIN:
+		sls = (sls & 0xe0) | ((sls & 0x0f) << 1) | ((sls & 0x10) >> 4);
+		/* rewrite sls in routing label */
+		mp->b_rptr[7] = sls;
+		break;
+	default:
+		sls = ((sls & 0x07) << 1) | ((sls & 0x08) >> 3);
+		/* rewrite sls in routing label */
+		mp->b_rptr[4] = (mp->b_rptr[4] & 0x0f) | (sls << 4);
+		break;
+	}
+}
+
 /*
  *  -------------------------------------------------------------------------
  *
@@ -5699,29 +5886,12 @@ mtp_send_link(queue_t *q, mblk_t *dp, struct sl *sl)
 {
 	(void) q;
 	if (canputnext(sl->wq)) {
-		if (sl->lk.lk->ls.ls->lk.numb > 1) {
-			/* only rotate on combined linksets (i.e. not C-links) */
-			struct sp *sp = sl->lk.lk->sp.loc;
+		struct sp *sp = sl->lk.lk->sp.loc;
 
-			switch (sp->na.na->option.pvar) {
-			case SS7_PVAR_ANSI:
-			case SS7_PVAR_JTTC:
-			case SS7_PVAR_CHIN:	/* ??? */
-			{
-				uint sls = dp->b_rptr[7] & sp->ls.sls_mask;
-
-				/* Actually, for 5-bit and 8-bit compatability, we rotate based on
-				   5 sls bits regardless of the number of bits in the SLS */
-				if (sls & 0x01)
-					sls = (sls & 0xe0) | ((sls & 0x1f) >> 1) | 0x10;
-				else
-					sls = (sls & 0xe0) | ((sls & 0x1f) >> 1) | 0x00;
-				/* rewrite sls in routing label */
-				dp->b_rptr[7] = sls;
-				break;
-			}
-			}
-		}
+		if (sl->lk.lk->ls.ls->lk.numb > 1)
+			/* only rotate on combined linksets (i.e. not C-links) */
+			sls_rotate(sp->na.na, dp, sls_label(sp->na.na, dp) & sp->ls.sls_mask);
+		sl_count_local(sl, dp);
 		putnext(sl->wq, dp);	/* send message */
 		return (0);
 	}
@@ -5731,22 +5901,19 @@ mtp_send_link(queue_t *q, mblk_t *dp, struct sl *sl)
 }
 
 /**
- * mtp_send_route: - send a message with full routing
+ * mtp_send_route_rs: - send a message on a route set
  * @q: active queue
  * @sp: signalling point from which to send
+ * @rs: route set to the destination
  * @mp: the message
  * @priority: message priority
- * @dpc: destination to which to send
  * @sls: signalling link selection
  *
- *
- * Full routing for management messages sent from a signalling point.  This is for management only
- * message because it does not report congestion back to the user.
+ * Full routing, once the route set has been selected, for messages sent from a signalling point.
  */
 static int
-mtp_send_route(queue_t *q, struct sp *sp, mblk_t *mp, uint priority, uint32_t dpc, uint sls)
+mtp_send_route_rs(queue_t *q, struct sp *sp, struct rs *rs, mblk_t *mp, uint priority, uint sls)
 {
-	struct rs *rs;
 	struct rl *rl;
 	struct rt *rt;
 	struct ls *ls;
@@ -5754,14 +5921,6 @@ mtp_send_route(queue_t *q, struct sp *sp, mblk_t *mp, uint priority, uint32_t dp
 	struct na *na = sp->na.na;
 	int err;
 
-	for (rs = sp->rs.list; rs; rs = rs->sp.next)
-		if (rs->rs_type == RT_TYPE_MEMBER && rs->dest == dpc)
-			goto rs_found;
-	for (rs = sp->rs.list; rs; rs = rs->sp.next)
-		if (rs->rs_type == RT_TYPE_CLUSTER && rs->dest == (dpc & na->mask.cluster))
-			goto rs_found;
-	goto efault;
-      rs_found:
 	if (rs->state > RS_RESTRICTED)
 		goto discard;
 	if (!(rl = rs->rl.curr))
@@ -5769,7 +5928,7 @@ mtp_send_route(queue_t *q, struct sp *sp, mblk_t *mp, uint priority, uint32_t dp
 	if (!(ls = rl->ls.ls))
 		goto efault;
 	/* select active route based on sls */
-	if (!(rt = rl->smap[sls_index(sls, ls->rl.sls_mask, ls->rl.sls_bits)].rt))
+	if (!(rt = rl->smap[ls->rl_index[sls & (LS_SLS_SIZE - 1)]].rt))
 		goto efault;
 	if (rt->type == MTP_OBJ_TYPE_CR) {
 		/* we are performing controlled rerouting, buffer message */
@@ -5781,7 +5940,7 @@ mtp_send_route(queue_t *q, struct sp *sp, mblk_t *mp, uint priority, uint32_t dp
 	   for 8-bit SLSs) after route selection and sls rotation.  Again, the following algorithm
 	   does the job for both ITU-T and ANSI and will accomodate quad linksets to quad STPs. */
 	/* select active signalling link based on sls */
-	if (!(sl = rt->lk.lk->smap[sls_index(sls, ls->lk.sls_mask, ls->lk.sls_bits)].sl))
+	if (!(sl = rt->lk.lk->smap[ls->lk_index[sls & (LS_SLS_SIZE - 1)]].sl))
 		goto efault;
 	/* Check for changeback on the signalling link index: normally the pointer is to a
 	   signalling link object not a changeback buffer object. This approach is faster than the
@@ -5814,25 +5973,13 @@ mtp_send_route(queue_t *q, struct sp *sp, mblk_t *mp, uint priority, uint32_t dp
 	   Signalling Transfer Point (see mtp_xfer_route()). However, because we must unrotate all
 	   ANSI messages retrieved from the signalling link on changeover, we still need to rotate. 
 	 */
-	if (sl->lk.lk->ls.ls->lk.numb > 1) {
+	if (sl->lk.lk->ls.ls->lk.numb > 1)
 		/* Only rotate when part of the sls was actually used for route selection (i.e. not 
-		   on C-Links or F-Links, but only on combined link sets (A-, B-, D-, E- Links) */
-		switch (na->option.pvar) {
-		case SS7_PVAR_ANSI:
-		case SS7_PVAR_JTTC:
-		case SS7_PVAR_CHIN:	/* ??? */
-			/* XXX Actually, for 5-bit and 8-bit compatability, we rotate based on 5
-			   sls bits regardless of the number of bits in the SLS */
-			if (sls & 0x01)
-				sls = (sls & 0xe0) | ((sls & 0x1f) >> 1) | 0x10;
-			else
-				sls = (sls & 0xe0) | ((sls & 0x1f) >> 1) | 0x00;
-			/* rewrite sls in routing label */
-			mp->b_rptr[7] = sls;
-			break;
-		}
-	}
+		   on C-Links or F-Links, but only on combined link sets (A-, B-, D-, E- Links).
+		   Rotate the sls in the label, which need not be the @sls used for selection. */
+		sls_rotate(na, mp, sls_label(na, mp) & sp->ls.sls_mask);
 	sl->flags |= SLF_TRAFFIC;
+	sl_count_local(sl, mp);
 	putnext(sl->wq, mp);	/* send message */
 	return (0);
       discard:
@@ -5849,6 +5996,32 @@ mtp_send_route(queue_t *q, struct sp *sp, mblk_t *mp, uint priority, uint32_t dp
 	goto discard;
 }
 
+/**
+ * mtp_send_route: - send a message with full routing
+ * @q: active queue
+ * @sp: signalling point from which to send
+ * @mp: the message
+ * @priority: message priority
+ * @dpc: destination to which to send
+ * @sls: signalling link selection
+ *
+ *
+ * Full routing for management messages sent from a signalling point.  This is for management only
+ * message because it does not report congestion back to the user.
+ */
+static int
+mtp_send_route(queue_t *q, struct sp *sp, mblk_t *mp, uint priority, uint32_t dpc, uint sls)
+{
+	struct rs *rs;
+
+	if (!(rs = rs_route(sp, dpc))) {
+		mi_strlog(q, 0, SL_ERROR, "discard: no outgoing route for message");
+		freemsg(mp);
+		return (0);
+	}
+	return mtp_send_route_rs(q, sp, rs, mp, priority, sls);
+}
+
 /**
  * mtp_send_route_loadshare: - send with route loadsharing
  * @q: active queue
@@ -5858,13 +6031,24 @@ mtp_send_route(queue_t *q, struct sp *sp, mblk_t *mp, uint priority, uint32_t dp
  * @dpc: destination
  * @sls: signalling link selection
  *
- * Full routing for a message we created with load sharing.
+ * Full routing for a message we created with load sharing.  The SLS used for route and signalling
+ * link selection is taken from the SLS generator of the signalling relation instead of the SLS
+ * passed in, so that management messages to a destination are spread across the routes and links
+ * of combined link sets.  The generated SLS is never written into the routing label (which, for
+ * some messages, carries the SLC in the SLS field): the label SLS is only rotated in place when SLS
+ * rotation applies, as for mtp_send_route().
  */
 static int
 mtp_send_route_loadshare(queue_t *q, struct sp *sp, mblk_t *bp, uint mp, uint32_t dpc, uint sls)
 {
-	fixme(("Select new sls based on loadsharing\n"));
-	return mtp_send_route(q, sp, bp, mp, dpc, sls);
+	struct rs *rs;
+
+	if (!(rs = rs_route(sp, dpc))) {
+		mi_strlog(q, 0, SL_ERROR, "discard: no outgoing route for message");
+		freemsg(bp);
+		return (0);
+	}
+	return mtp_send_route_rs(q, sp, rs, bp, mp, rs_sls_next(sp, rs));
 }
 
 /*
@@ -6418,15 +6602,59 @@ mtp_send_sslta(queue_t *q, struct sp *sp, uint ni, uint32_t dpc, uint32_t opc,
 	}
 	return (-ENOBUFS);
 }
+/*
+ *  When the user part left room ahead of its data (see allocb_room()), the Level 2 header room, SIO
+ *  and routing label are pushed in place instead of being placed in a newly allocated block.
+ */
+static mblk_t *
+mtp_enc_hdr(struct sp *sp, uint ni, uint mp, uint si, uint dpc, uint opc, uint sls, mblk_t *dp)
+{
+	unsigned char *wptr = dp->b_wptr;
+	size_t hlen = 6 + 1;
+
+	switch (sp->na.na->option.pvar & SS7_PVAR_MASK) {
+	case SS7_PVAR_ANSI:
+	case SS7_PVAR_JTTC:
+	case SS7_PVAR_CHIN:
+		hlen += 7;
+		break;
+	default:
+		hlen += 4;
+		break;
+	}
+	if (dp->b_datap->db_type != M_DATA || mblk_push(dp, hlen) == NULL)
+		return (NULL);
+	bzero(dp->b_rptr, 6);	/* zero header */
+	dp->b_rptr += 6;	/* reserve header room for Level 2 */
+	dp->b_wptr = dp->b_rptr;
+	mtp_enc_sio(dp, sp, mp, ni, si);
+	mtp_enc_rl(dp, sp, dpc, opc, sls);
+	dp->b_wptr = wptr;
+	return (dp);
+}
+
 static int
 mtp_send_user(queue_t *q, struct sp *sp, uint ni, uint32_t dpc, uint32_t opc,
 	      uint sls, uint mp, uint si, mblk_t *dp)
 {
+	unsigned char *rptr = dp->b_rptr;
 	mblk_t *bp;
+	int err;
 
+	if ((bp = mtp_enc_hdr(sp, ni, mp, si, dpc, opc, sls, dp))) {
+		/* a non-zero return leaves the message with the caller: pop the header again so
+		   that it is not pushed twice when the message is retried */
+		if ((err = mtp_send_route(q, sp, bp, mp, dpc, sls)))
+			dp->b_rptr = rptr;
+		return (err);
+	}
 	if ((bp = mtp_enc_msg(q, sp, ni, mp, si, dpc, opc, sls))) {
 		mtp_enc_user(bp, dp);
-		return mtp_send_route(q, sp, bp, mp, dpc, sls);
+		if ((err = mtp_send_route(q, sp, bp, mp, dpc, sls))) {
+			bp->b_cont = NULL;
+			freeb(bp);
+		}
+		return (err);
 	}
 	return (-ENOBUFS);
 }
@@ -6506,7 +6734,7 @@ mtp_tfp_broadcast(queue_t *q, struct rs *rs)
 				mtp_send_tfp(q, sp, lk->ni, adj->dest, sp->pc, sls, rs->dest);
 			} else
 				mtp_send_tcp(q, sp, lk->ni, adj->dest, sp->pc, sls, rs->dest);
-			sls = (sls + 1) & ((1 << sp->rs.sls_bits) - 1);
+			sls = (sls + 1) & sp->ls.sls_mask;
 		}
 	}
 	return (0);
@@ -6553,7 +6781,7 @@ mtp_tfp_adjacent(queue_t *q, struct rs *adj)
 			mtp_send_tfp(q, sp, sp->ni, adj->dest, sp->pc, sls, rs->dest);
 		else
 			mtp_send_tcp(q, sp, sp->ni, adj->dest, sp->pc, sls, rs->dest);
-		sls = (sls + 1) & ((1 << sp->rs.sls_bits) - 1);
+		sls = (sls + 1) & sp->ls.sls_mask;
 	}
 }
 
@@ -6590,7 +6818,7 @@ mtp_tfp_reroute(queue_t *q, struct rl *rl)
 			mtp_send_tfp(q, sp, lk->ni, adj->dest, sp->pc, sls, rs->dest);
 		} else
 			mtp_send_tcp(q, sp, lk->ni, adj->dest, sp->pc, sls, rs->dest);
-		sls = (sls + 1) & ((1 << sp->rs.sls_bits) - 1);
+		sls = (sls + 1) & sp->ls.sls_mask;
 	}
 }
 
@@ -6655,7 +6883,7 @@ mtp_tfr_broadcast(queue_t *q, struct rs *rs)
 				mtp_send_tfr(q, sp, lk->ni, adj->dest, sp->pc, sls, rs->dest);
 			} else
 				mtp_send_tcr(q, sp, lk->ni, adj->dest, sp->pc, sls, rs->dest);
-			sls = (sls + 1) & ((1 << sp->rs.sls_bits) - 1);
+			sls = (sls + 1) & sp->ls.sls_mask;
 		}
 	}
 	return (0);
@@ -6702,7 +6930,7 @@ mtp_tfr_adjacent(queue_t *q, struct rs *adj)
 			mtp_send_tfr(q, sp, sp->ni, adj->dest, sp->pc, sls, rs->dest);
 		else
 			mtp_send_tcr(q, sp, sp->ni, adj->dest, sp->pc, sls, rs->dest);
-		sls = (sls + 1) & ((1 << sp->rs.sls_bits) - 1);
+		sls = (sls + 1) & sp->ls.sls_mask;
 	}
 }
 
@@ -6741,7 +6969,7 @@ mtp_tfr_reroute(queue_t *q, struct rl *rl)
 			mtp_send_tfr(q, sp, lk->ni, adj->dest, sp->pc, sls, rs->dest);
 		} else
 			mtp_send_tcr(q, sp, lk->ni, adj->dest, sp->pc, sls, rs->dest);
-		sls = (sls + 1) & ((1 << sp->rs.sls_bits) - 1);
+		sls = (sls + 1) & sp->ls.sls_mask;
 	}
 }
 
@@ -6807,7 +7035,7 @@ mtp_tfa_broadcast(queue_t *q, struct rs *rs)
 				mtp_send_tfa(q, sp, lk->ni, adj->dest, sp->pc, sls, rs->dest);
 			} else
 				mtp_send_tca(q, sp, lk->ni, adj->dest, sp->pc, sls, rs->dest);
-			sls = (sls + 1) & ((1 << sp->rs.sls_bits) - 1);
+			sls = (sls + 1) & sp->ls.sls_mask;
 
 			/* Note that errors are ignored on sending TFA/TCA because remote route set 
 			   test procedures will discover the loss. */
@@ -6851,7 +7079,7 @@ mtp_tfa_reroute(queue_t *q, struct rl *rl)
 			mtp_send_tfa(q, sp, lk->ni, adj->dest, sp->pc, sls, rs->dest);
 		} else
 			mtp_send_tca(q, sp, lk->ni, adj->dest, sp->pc, sls, rs->dest);
-		sls = (sls + 1) & ((1 << sp->rs.sls_bits) - 1);
+		sls = (sls + 1) & sp->ls.sls_mask;
 	}
 }
 
@@ -6893,7 +7121,7 @@ mtp_trw_broadcast(queue_t *q, struct sp *sp)
 		    || rs->rl.curr->rt.curr->lk.lk->sp.adj != rs)
 			continue;
 		mtp_send_trw(q, sp, sp->ni, rs->dest, sp->pc, sls);
-		sls = (sls + 1) & ((1 << sp->rs.sls_bits) - 1);
+		sls = (sls + 1) & sp->ls.sls_mask;
 	}
 }
 
@@ -6924,14 +7152,8 @@ mtp_xfer_route(queue_t *q, struct sl *sl, mblk_t *mp, struct mtp_msg *m)
 	   restarting are discarded. */
 	if (loc->state >= SP_RESTART)
 		goto discard;
-	/* this linear search could be changed to a hash later */
-	for (rs = loc->rs.list; rs; rs = rs->sp.next)
-		if (rs->rs_type == RT_TYPE_MEMBER && rs->dest == m->dpc)
-			goto rs_found;
-	for (rs = loc->rs.list; rs; rs = rs->sp.next)
-		if (rs->rs_type == RT_TYPE_CLUSTER
-		    && rs->dest == (m->dpc & loc->na.na->mask.cluster))
-			goto rs_found;
+	if ((rs = rs_route(loc, m->dpc)))
+		goto rs_found;
 	/* Somebody could be probing our route sets.  There is an additional reason for not sending 
 	   responsive TFP here and it is described in Q.704: if we send TFP, we will get a lot of
 	   uninvited RST messages every T10 inquiring as to the state of the route, when a
@@ -6993,7 +7215,7 @@ mtp_xfer_route(queue_t *q, struct sl *sl, mblk_t *mp, struct mtp_msg *m)
 	if (!(ls = rl->ls.ls))
 		goto efault;
 	/* select active route based on sls */
-	if (!(rt = rl->smap[sls_index(m->sls, ls->rl.sls_mask, ls->rl.sls_bits)].rt))
+	if (!(rt = rl->smap[ls->rl_index[m->sls & (LS_SLS_SIZE - 1)]].rt))
 		goto efault;
 	if (rt->type == MTP_OBJ_TYPE_CR) {
 		/* we are performing controlled rerouting, buffer message */
@@ -7005,7 +7227,7 @@ mtp_xfer_route(queue_t *q, struct sl *sl, mblk_t *mp, struct mtp_msg *m)
 	   for 8-bit SLSs) after route selection and sls rotation.  Again, the following algorithm
 	   does the job for both ITU-T and ANSI and will accomodate quad linksets to quad STPs. */
 	/* select active signalling link based on sls */
-	if (!(sl = rt->lk.lk->smap[sls_index(m->sls, ls->lk.sls_mask, ls->lk.sls_bits)].sl))
+	if (!(sl = rt->lk.lk->smap[ls->lk_index[m->sls & (LS_SLS_SIZE - 1)]].sl))
 		goto efault;
 	/* Check for changeback on the signalling link index: normally the pointer is to a
 	   signalling link object not a changeback buffer object. This approach is faster than the
@@ -7033,25 +7255,12 @@ mtp_xfer_route(queue_t *q, struct sl *sl, mblk_t *mp, struct mtp_msg *m)
 		goto discard;
 	if (!canputnext(sl->wq))
 		goto ebusy;
-	if (rl->rt.numb > 1) {
+	if (rl->rt.numb > 1)
 		/* Only rotate when part of the sls was actually used for route selection (i.e. not 
 		   on C-Links or F-Links. */
-		switch (na->option.pvar) {
-		case SS7_PVAR_ANSI:
-		case SS7_PVAR_JTTC:
-		case SS7_PVAR_CHIN:	/* ??? */
-			/* Actually, for 5-bit and 8-bit compatability, we rotate based on 5 sls
-			   bits regardless of the number of bits in the SLS */
-			if (m->sls & 0x01)
-				m->sls = (m->sls & 0xe0) | ((m->sls & 0x1f) >> 1) | 0x10;
-			else
-				m->sls = (m->sls & 0xe0) | ((m->sls & 0x1f) >> 1) | 0x00;
-			/* rewrite sls in routing label */
-			mp->b_rptr[7] = m->sls;
-			break;
-		}
-	}
+		m->sls = sls_rotate(na, mp, m->sls);
 	sl->flags |= SLF_TRAFFIC;
+	sl_count_xfer(sl, mp);
 	putnext(sl->wq, mp);	/* send message */
 	return (0);
       screened:
@@ -8708,7 +8917,72 @@ sl_set_state(queue_t *q, struct sl *sl, uint state)
  *
  *  -------------------------------------------------------------------------
  */
-#if 0
+/*
+ *  Hash a route set destination and type into a route set hash of 2^order buckets.  Point codes are
+ *  at most 24 bits, so folding the upper bits down onto the lower order bits spreads both 14-bit
+ *  ITU-T and 24-bit ANSI point codes evenly across the table.
+ */
+static inline fastcall uint
+rs_hash_index(uint32_t dest, int type, uint order)
+{
+	return ((dest ^ (dest >> order) ^ (dest >> (order << 1)) ^ type) & ((1U << order) - 1));
+}
+
+/*
+ *  Add a route set to the signalling point hash.  The route set type, destination and signalling
+ *  point must be set before the route set is hashed.
+ */
+static void
+rs_hash_add(struct rs *rs)
+{
+	struct sp *sp = rs->sp.sp;
+	struct rs **rsp = &sp->rs_hash[rs_hash_index(rs->dest, rs->rs_type, sp->rs_hash_order)];
+
+	if ((rs->hash.next = *rsp))
+		rs->hash.next->hash.prev = &rs->hash.next;
+	rs->hash.prev = rsp;
+	*rsp = rs;
+}
+
+/*
+ *  Remove a route set from the signalling point hash.  This must be done before the route set
+ *  destination or type is changed.
+ */
+static void
+rs_hash_del(struct rs *rs)
+{
+	if (rs->hash.prev) {
+		if ((*rs->hash.prev = rs->hash.next))
+			rs->hash.next->hash.prev = rs->hash.prev;
+		rs->hash.next = NULL;
+		rs->hash.prev = NULL;
+	}
+}
+
+/*
+ *  Double the size of the signalling point route set hash once the number of route sets exceeds the
+ *  number of buckets.  If the larger table cannot be allocated the existing table is retained:
+ *  lookups remain correct, only the hash chains are longer.
+ */
+static void
+rs_hash_grow(struct sp *sp)
+{
+	struct rs **hash, **old = sp->rs_hash;
+	uint order = sp->rs_hash_order + 1;
+	struct rs *rs;
+
+	if (sp->rs.numb <= (1U << sp->rs_hash_order) || order > RS_HASH_MAXORDER)
+		return;
+	if (!(hash = kmalloc(sizeof(*hash) << order, GFP_ATOMIC)))
+		return;
+	bzero(hash, sizeof(*hash) << order);
+	sp->rs_hash = hash;
+	sp->rs_hash_order = order;
+	for (rs = sp->rs.list; rs; rs = rs->sp.next)
+		rs_hash_add(rs);
+	kfree(old);
+}
+
 /*
  *  Select the route set to be used for routing messages on the specified signalling point.
  */
@@ -8717,12 +8991,30 @@ rs_find(struct sp *sp, uint32_t dest, int type)
 {
 	struct rs *rs;
 
-	for (rs = sp->rs.list; rs; rs = rs->sp.next)
+	for (rs = sp->rs_hash[rs_hash_index(dest, type, sp->rs_hash_order)]; rs;
+	     rs = rs->hash.next)
 		if (rs->dest == dest && rs->rs_type == type)
 			break;
 	return (rs);
 }
 
+/*
+ *  Select the route set to be used for routing a message to the specified destination point code
+ *  on the specified signalling point: a member route set to the destination is preferred over a
+ *  cluster route set to the cluster containing the destination.
+ */
+static struct rs *
+rs_route(struct sp *sp, uint32_t dpc)
+{
+	struct rs *rs;
+
+	if (likely((rs = rs_find(sp, dpc, RT_TYPE_MEMBER)) != NULL))
+		return (rs);
+	return (rs_find(sp, dpc & sp->na.na->mask.cluster, RT_TYPE_CLUSTER));
+}
+
+#if 0
+
 /*
  *  Select the route list to be used for routing messages on the specified route set.
  */
@@ -8748,6 +9040,28 @@ rt_find(struct rl *rl, int state)
 }
 #endif
 
+/**
+ * mtp_lookup_rt_rs: - lookup a route in a route set over a link
+ * @rs: the route set
+ * @lk: the link (set)
+ *
+ * Find the route belonging to the route set that is via the specified link (set).  The number of
+ * routes in a route set is small, whereas the number of routes over a link (set) to an STP grows
+ * with the number of route sets.
+ */
+static struct rt *
+mtp_lookup_rt_rs(struct rs *rs, struct lk *lk)
+{
+	struct rl *rl;
+	struct rt *rt;
+
+	for (rl = rs->rl.list; rl; rl = rl->rs.next)
+		for (rt = rl->rt.list; rt; rt = rt->rl.next)
+			if (rt->lk.lk == lk)
+				return (rt);
+	return (NULL);
+}
+
 /**
  * mtp_lookup_rs_local: - lookup a route set (local)
  * @sl: signalling link for the local route set
@@ -8759,15 +9073,10 @@ rt_find(struct rl *rl, int state)
 static struct rs *
 mtp_lookup_rs_local(struct sl *sl, uint32_t dest, int type)
 {
-	struct rt *rt;
-	struct rl *rl;
-	struct rs *rs = NULL;
+	struct rs *rs;
 
-	for (rt = sl->lk.lk->rt.list; rt; rt = rt->lk.next) {
-		if ((rl = rt->rl.rl) && (rs = rl->rs.rs) && rs->dest == dest && rs->rs_type == type)
-			break;
+	if ((rs = rs_find(sl->lk.lk->sp.loc, dest, type)) && !mtp_lookup_rt_rs(rs, sl->lk.lk))
 		rs = NULL;
-	}
 	return (rs);
 }
 
@@ -8800,10 +9109,7 @@ mtp_lookup_rs(queue_t *q, struct sl *sl, struct mtp_msg *m, uint type)
 		if (m->opc != m->dest && !(rs->flags & RSF_XFER_FUNC))
 			goto error3;
 	}
-	for (rs = sp->rs.list; rs; rs = rs->sp.next)
-		if (rs->dest == m->dest && rs->rs_type == type)
-			break;
-	if (!rs)
+	if (!(rs = rs_find(sp, m->dest, type)))
 		goto error7;
 	return (rs);
       error1:
@@ -8834,14 +9140,11 @@ mtp_lookup_rs(queue_t *q, struct sl *sl, struct mtp_msg *m, uint type)
 static struct rt *
 mtp_lookup_rt_local(struct sl *sl, uint32_t dest, int type)
 {
-	struct rt *rt;
-	struct rl *rl;
 	struct rs *rs;
 
-	for (rt = sl->lk.lk->rt.list; rt; rt = rt->lk.next)
-		if ((rl = rt->rl.rl) && (rs = rl->rs.rs) && rs->dest == dest && rs->rs_type == type)
-			break;
-	return (rt);
+	if (!(rs = rs_find(sl->lk.lk->sp.loc, dest, type)))
+		return (NULL);
+	return (mtp_lookup_rt_rs(rs, sl->lk.lk));
 }
 
 /**
@@ -8981,10 +9284,7 @@ mtp_lookup_rt(queue_t *q, struct sl *sl, struct mtp_msg *m, uint type)
 		/* 03. route-related messages must have the adjacent (non-alias) signalling point
 		   code as the OPC */
 		if ((adj = rel)->dest != m->opc) {
-			for (adj = loc->rs.list; adj; adj = adj->sp.next)
-				if (adj->rs_type == RT_TYPE_MEMBER && adj->dest == m->opc)
-					break;
-			if (!adj)
+			if (!(adj = rs_find(loc, m->opc, RT_TYPE_MEMBER)))
 				goto error03;
 			if (!(adj->flags & RSF_ADJACENT))
 				goto error03;
@@ -14013,26 +14313,9 @@ sl_retrieved_message_ind(queue_t *q, mblk_t *mp)
 		goto outstate;
 	if (!mp->b_cont)
 		goto efault;
-	if (sl->lk.lk->ls.ls->lk.numb > 1) {
+	if (sl->lk.lk->ls.ls->lk.numb > 1)
 		/* When the SLS was rotated for transmission, we need to unrotate on retrieval. */
-		switch (sl->lk.lk->ls.ls->sp.sp->na.na->option.pvar) {
-		case SS7_PVAR_ANSI:
-		case SS7_PVAR_JTTC:
-		case SS7_PVAR_CHIN:	/* ??? */
-		{
-			/* XXX Actually, for 5-bit and 7-bit compatibility, we rotate based on 5
-			   sls bits regardless of the number of bits in the SLS */
-			uint sls = mp->b_cont->b_rptr[7];
-
-			if (sls & 0x10)
-				sls = (sls & 0xe0) | ((sls & 0x0f) << 1) | 0x01;
-			else
-				sls = (sls & 0xe0) | ((sls & 0x0f) << 1) | 0x00;
-			/* rewrite sls in routing label */
-			mp->b_cont->b_rptr[7] = sls;
-		}
-		}
-	}
+		sls_unrotate(sl->lk.lk->ls.ls->sp.sp->na.na, mp->b_cont);
 	bufq_queue(&sl->rbuf, mp->b_cont);
 	mp->b_cont = NULL;
 	return (0);
@@ -14079,27 +14362,10 @@ sl_retrieval_complete_ind(queue_t *q, mblk_t *mp)
 	if (sl_get_l_state(sl) != SLS_WCON_RET)
 		goto outstate;
 	if (mp->b_cont) {
-		if (ls->lk.numb > 1) {
+		if (ls->lk.numb > 1)
 			/* When the SLS was rotated for transmission, we need to unrotate on
 			   retrieval. */
-			switch (na->option.pvar) {
-			case SS7_PVAR_ANSI:
-			case SS7_PVAR_JTTC:
-			case SS7_PVAR_CHIN:	/* ??? */
-			{
-				/* XXX Actually, for 5-bit and 7-bit compatibility, we rotate based 
-				   on 5 sls bits regardless of the number of bits in the SLS */
-				uint sls = mp->b_cont->b_rptr[7];
-
-				if (sls & 0x10)
-					sls = (sls & 0xe0) | ((sls & 0x0f) << 1) | 0x01;
-				else
-					sls = (sls & 0xe0) | ((sls & 0x0f) << 1) | 0x00;
-				/* rewrite sls in routing label */
-				mp->b_cont->b_rptr[7] = sls;
-			}
-			}
-		}
+			sls_unrotate(na, mp->b_cont);
 		bufq_queue(&sl->rbuf, mp->b_cont);
 		mp->b_cont = NULL;
 	}
@@ -15079,6 +15345,7 @@ m_conn_req(queue_t *q, mblk_t *mp)
 	struct mtp *mtp = MTP_PRIV(q);
 	int err;
 	const struct MTP_conn_req *p = (typeof(p)) mp->b_rptr;
+	struct rs *rs;
 
 	switch (mtp_get_state(mtp)) {
 	default:
@@ -15120,24 +15387,26 @@ m_conn_req(queue_t *q, mblk_t *mp)
 		/* There is another thing to do once the connection has been established: that is
 		   to deliver MTP restart begins indication or to deliver MTP resume or MTP pause
 		   indications for the peer depending on the peer's state. */
-		switch (mtp->sp.rem->state) {
+		/* the route set is only attached to the MTP user by mtp_connect() when the
+		   connection is acknowledged */
+		if (!(rs = mtp->sp.rem) && !(rs = rs_route(mtp->sp.loc, mtp->dst.pc)))
+			goto badaddr;
+		switch (rs->state) {
 		case RS_RESTART:
 		case RS_PROHIBITED:
 		case RS_BLOCKED:
-			if ((err = mtp_pause_ind(q, mtp, mtp->sp.rem)))
+			if ((err = mtp_pause_ind(q, mtp, rs)))
 				goto error;
 			break;
 		case RS_ALLOWED:
-			if ((err = mtp_resume_ind(q, mtp, mtp->sp.rem)))
+			if ((err = mtp_resume_ind(q, mtp, rs)))
 				goto error;
 			break;
 		case RS_CONGESTED:
-			if ((err = mtp_resume_ind(q, mtp, mtp->sp.rem)))
+			if ((err = mtp_resume_ind(q, mtp, rs)))
 				goto error;
-			if (mtp->sp.rem->cong_status)
-				if ((err =
-				     mtp_cong_status_ind(q, mtp, mtp->sp.rem,
-							 mtp->sp.rem->cong_status)))
+			if (rs->cong_status)
+				if ((err = mtp_cong_status_ind(q, mtp, rs, rs->cong_status)))
 					goto error;
 			break;
 		default:
@@ -17105,6 +17374,23 @@ mtp_get_stats_sl(struct mtp_stats *p, struct sl *sl, bool clear)
 	*c = sl->stats;
 	if (clear)
 		bzero(&sl->stats, sizeof(sl->stats));
+#if defined MTP_PERCPU_STATS
+	if (sl->pstats) {
+		mtp_ulong *d = (typeof(d)) c, *b = (typeof(b)) &sl->pbase;
+		int i, cpu;
+
+		/* fold per-CPU counters; on clear, rebase so each MSU is collected exactly once */
+		for (i = 0; i < sizeof(*c) / sizeof(*d); i++) {
+			mtp_ulong total = 0;
+
+			for_each_possible_cpu(cpu)
+				total += ((mtp_ulong *) per_cpu_ptr(sl->pstats, cpu))[i];
+			d[i] = total - b[i];
+			if (clear)
+				b[i] = total;
+		}
+	}
+#endif
 	return (sizeof(*p) + sizeof(*c));
 }
 static int
@@ -18493,9 +18779,12 @@ mtp_cha_rs(struct mtp_config *p, struct rs *rs, const bool force, const bool tes
 	if (!test) {
 		uint mask = (RSF_TFR_PENDING | RSF_ADJACENT | RSF_CLUSTER | RSF_XFER_FUNC);
 
+		rs_hash_del(rs);
 		rs->dest = c->dest;
 		rs->flags &= ~mask;
 		rs->flags |= c->flags & mask;
+		rs->rs_type = (rs->flags & RSF_CLUSTER) ? RT_TYPE_CLUSTER : RT_TYPE_MEMBER;
+		rs_hash_add(rs);
 	}
 	return (0);
 }
@@ -18570,6 +18859,7 @@ mtp_cha_ls(struct mtp_config *p, struct ls *ls, const bool force, const bool tes
 		}
 		ls->rl.sls_mask = ~c->sls_mask & sp->ls.sls_mask;
 		ls->rl.sls_bits = sp->ls.sls_bits - ls->lk.sls_bits;
+		ls_sls_build(ls);
 	}
 	return (0);
 }
@@ -21632,6 +21922,10 @@ mtp_free_link(struct sl *sl)
 	mi_timer_free(sl->timers.t1t);
 	mi_timer_free(sl->timers.t2t);
 	mi_timer_free(sl->timers.t1s);
+#if defined MTP_PERCPU_STATS
+	if (sl->pstats)
+		free_percpu(sl->pstats);
+#endif
 	mi_close_free_cache(mtp_sl_cachep, (caddr_t) sl);
 }
 static struct sl *
@@ -21762,6 +22056,11 @@ mtp_alloc_link(queue_t *q, int index, cred_t *crp, minor_t unit)
 		(t = (typeof(t)) sl->timers.t1s->b_rptr)->timer = t1s;
 		t->count = 0;
 		t->sl = sl;
+#if defined MTP_PERCPU_STATS
+		/* without per-CPU counters, sl->stats is counted directly */
+		sl->pstats = __alloc_percpu_gfp(sizeof(*sl->pstats), __alignof__(*sl->pstats),
+						GFP_ATOMIC);
+#endif
 		/* assign defaults */
 	} else
 		ptrace(("%s: ERROR: Could not allocate sl private structure %d\n",
@@ -22199,6 +22498,7 @@ mtp_alloc_ls(uint id, struct sp *sp, struct mtp_conf_ls *c)
 		}
 		ls->rl.sls_mask = ~c->sls_mask & sp->ls.sls_mask;
 		ls->rl.sls_bits = sp->ls.sls_bits - ls->lk.sls_bits;
+		ls_sls_build(ls);
 		/* defaults inherited from sp */
 		{
 			/* signalling link timer defaults */
@@ -22731,6 +23031,13 @@ mtp_alloc_rs(uint id, struct sp *sp, struct mtp_conf_rs *c)
 		rs->flags =
 		    c->flags & (RSF_TFR_PENDING | RSF_ADJACENT | RSF_CLUSTER | RSF_XFER_FUNC);
 		rs->dest = c->dest;
+		rs->rs_type = (rs->flags & RSF_CLUSTER) ? RT_TYPE_CLUSTER : RT_TYPE_MEMBER;
+		/* start each relation at a different point in the sls cycle */
+		rs->sls = rs->dest ^ (rs->dest >> 8) ^ (rs->dest >> 16);
+		if (sp) {
+			rs_hash_add(rs);
+			rs_hash_grow(sp);
+		}
 		/* allocate timers */
 		if (!(rs->timers.t8 = mi_timer_alloc(sizeof(*t))))
 			goto free_error;
@@ -22797,6 +23104,7 @@ mtp_free_rs(struct rs *rs)
 		mtp_free_rl(rl);
 	/* remove from sp list */
 	if ((sp = rs->sp.sp)) {
+		rs_hash_del(rs);
 		if ((*rs->sp.prev = rs->sp.next))
 			rs->sp.next->sp.prev = rs->sp.prev;
 		rs->sp.next = NULL;
@@ -22876,6 +23184,11 @@ mtp_alloc_sp(uint id, struct na *na, struct mtp_conf_sp *c)
 			     SPF_SECURITY | SPF_XFER_FUNC);
 		sp->pc = c->pc;
 		sp->mtp.equipped = c->users;
+		/* allocate route set hash */
+		if (!(sp->rs_hash = kmalloc(sizeof(*sp->rs_hash) << RS_HASH_ORDER, GFP_ATOMIC)))
+			goto free_error;
+		bzero(sp->rs_hash, sizeof(*sp->rs_hash) << RS_HASH_ORDER);
+		sp->rs_hash_order = RS_HASH_ORDER;
 		/* allocate timers */
 		if (!(sp->timers.t1r = mi_timer_alloc(sizeof(*t))))
 			goto free_error;
@@ -23002,6 +23315,11 @@ mtp_free_sp(struct sp *sp)
 	/* remove all link sets */
 	while ((ls = sp->ls.list))
 		mtp_free_ls(ls);
+	/* free route set hash */
+	if (sp->rs_hash) {
+		kfree(sp->rs_hash);
+		sp->rs_hash = NULL;
+	}
 	/* remove from na list */
 	if ((na = sp->na.na)) {
 		if ((*sp->na.prev = sp->na.next))
@@ -260,7 +260,7 @@ register_nit(struct cdevsw *cdev)
 	}
 	memset(cmin, 0, sizeof(*cmin));
 	INIT_LIST_HEAD(&cmin->n_list);
-	INIT_LIST_HEAD(&cmin->n_hash);
+	INIT_HLIST_NODE(&cmin->n_hash);
 	cmin->n_name = cdev->d_name;
 	cmin->n_str = cdev->d_str;
 	cmin->n_flag = nit_cdev.d_flag;
@@ -280,7 +280,7 @@ register_nit(struct cdevsw *cdev)
 	node = cmin + 1;
 	memset(node, 0, sizeof(*node));
 	INIT_LIST_HEAD(&node->n_list);
-	INIT_LIST_HEAD(&node->n_hash);
+	INIT_HLIST_NODE(&node->n_hash);
 	node->n_name = "nit";
 	node->n_str = cdev->d_str;
 	node->n_flag = D_CLONE;
@@ -61,6 +61,7 @@ static char const ident[] = "src/drivers/sccp.c (" PACKAGE_ENVR ") " PACKAGE_DAT
 
 #include <sys/os7/compat.h>
 #include <linux/socket.h>
+#include <linux/rcupdate.h>	/* for call_rcu */
 
 #include <ss7/lmi.h>
 #include <ss7/lmi_ioctl.h>
@@ -192,6 +193,11 @@ typedef struct sc {
 	np_ulong ret;			/* return on error */
 	np_ulong slr;			/* src local reference */
 	np_ulong dlr;			/* dst local reference */
+	np_ulong rpc;			/* point code of dst local reference */
+	struct sc *rr_next;		/* remote reference hash linkage */
+	struct sc **rr_prev;		/* remote reference hash linkage */
+	unsigned long tias_exp;		/* send inactivity expiry (jiffies, 0 when stopped) */
+	unsigned long tiar_exp;		/* receive inactivity expiry (jiffies, 0 when stopped) */
 	struct sccp_addr src;		/* bound src address */
 	uint8_t saddr[SCCP_MAX_ADDR_LENGTH];
 	struct sccp_addr dst;		/* bound dst address */
@@ -258,6 +264,8 @@ static void sccp_put(struct sc *);
 #define SCCPF_ASSOC_REQUIRED	0x00040000
 #define SCCPF_CHANGE_REQUIRED	0x00080000
 
+#define SCCPF_GT_TRANSLATED	0x00100000
+
 /*
  *  NA - Network Appearance
  *  -----------------------------------
@@ -475,8 +483,10 @@ static void sr_put(struct sr *);
  */
 #define SCCP_CL_HASH_SIZE   32	/* connection-less bind hash slots */
 #define SCCP_CR_HASH_SIZE   16	/* connection-oriented listening hash slots */
-#define SCCP_CO_HASH_SIZE   64	/* connection-oriented established hash slots */
+#define SCCP_CO_HASH_SIZE   1024	/* connection-oriented remote reference hash slots */
 #define SCCP_CP_HASH_SIZE   64	/* connection-oriented coupling slots */
+#define SCCP_DEFAULT_TFRZ   60000	/* default local reference freeze time (msec) */
+#define SCCP_DEFAULT_TSWEEP 1000	/* default inactivity sweep interval (msec) */
 typedef struct sp {
 	HEAD_DECLARATION (struct sp);	/* head declaration */
 	struct {
@@ -493,12 +503,18 @@ typedef struct sp {
 	SLIST_LINKAGE (na, sp, na);	/* network appearance linkage */
 	np_ulong sccp_next_cl_sls;	/* rotate SLS values */
 	np_ulong sccp_next_co_sls;	/* rotate SLS values */
-	np_ulong sccp_next_slr;		/* rotate SLR values */
+	struct {
+		struct lre **dir;	/* local reference entries, by chunk */
+		uint numb;		/* local references in use */
+		uint next;		/* next never used index */
+		uint head;		/* oldest released index (0 when none) */
+		uint tail;		/* newest released index (0 when none) */
+	} lr;				/* local reference table */
 	np_ulong level;			/* congestion level */
 	np_ulong count;			/* count for congestion dropping */
 	struct sc *sccp_cl_hash[SCCP_CL_HASH_SIZE];	/* hash of connectionless binds */
 	struct sc *sccp_cr_hash[SCCP_CR_HASH_SIZE];	/* hash of connection request listeners */
-	struct sc *sccp_co_hash[SCCP_CO_HASH_SIZE];	/* hash of connection-oriented connections */
+	struct sc *sccp_co_hash[SCCP_CO_HASH_SIZE];	/* connections by remote reference */
 	struct cp *sccp_cp_hash[SCCP_CP_HASH_SIZE];	/* hash of connection-oriented couplings */
 	struct lmi_option proto;	/* sp protocol variant and options */
 	struct sccp_notify_sp notify;	/* sp nitifications */
@@ -507,6 +523,8 @@ typedef struct sp {
 	struct sccp_stats_sp statsp;	/* sp statistics periods */
 	struct sccp_stats_sp stamp;	/* sp statistics timestamps */
 	struct sccp_stats_sp stats;	/* sp statistics */
+	SLIST_HEAD (gte, gte);		/* global title translation entries */
+	struct gtt *gtt;		/* compiled global title translations (rcu) */
 } sp_t;
 
 static struct sp *sccp_alloc_sp(uint, struct na *, mtp_addr_t *);
@@ -517,6 +535,27 @@ static uint sp_get_id(uint);
 static void sccp_free_sp(struct sp *);
 static void sp_put(struct sp *);
 
+/*
+ *  Global Title Translation entry
+ *  -----------------------------------
+ *  A GTE is one management-configured translation: a digit prefix within the translation table
+ *  selected by GTI/TT/NP/NAI, and the destinations to which matching global titles translate.
+ *  The entries of a signalling point are compiled into a struct gtt (see sccp_gtt_compile()).
+ */
+typedef struct gte {
+	struct gte *next;		/* signalling point list linkage */
+	struct gte **prev;		/* signalling point list linkage */
+	np_ulong id;			/* entry identifier */
+	struct sp *sp;			/* local signalling point */
+	struct sccp_conf_gt config;	/* translation */
+} gte_t;
+
+static struct gte *sccp_alloc_gte(uint, struct sp *, struct sccp_conf_gt *);
+static struct gte *gte_lookup(uint);
+static uint gte_get_id(uint);
+static void sccp_free_gte(struct gte *);
+static int sccp_gtt_compile(struct sp *, struct gte *);
+
 /*
  *  Message Transfer Part
  *  -----------------------------------
@@ -1634,7 +1673,9 @@ typedef struct sccp_msg {
 	sccp_ins_t ins;
 	sccp_isni_t isni;
 	struct sccp_addr cdpa;
+	uint8_t cdpa_digits[SCCP_MAX_ADDR_LENGTH];	/* storage for cdpa.addr */
 	struct sccp_addr cgpa;
+	uint8_t cgpa_digits[SCCP_MAX_ADDR_LENGTH];	/* storage for cgpa.addr */
 	np_ulong cred;
 	np_ulong cause;
 	struct sccp_sgmt sgmt;
@@ -5442,7 +5483,20 @@ sccp_dec_opt(uchar *p, uchar *e, struct sccp_msg *m)
  *  -------------------------------------------------------------------------
  *  These functions are used to take an unpacked message from the queue, pack
  *  it into a message for transmission and then place it back on the queue.
+ *  Room is left ahead of the packed message so that MTP (and M3UA) can push
+ *  their headers in place rather than allocating a header block of their own.
  */
+#define SCCP_WROFF	32
+
+static inline mblk_t *
+sccp_allocb(queue_t *q, size_t mlen)
+{
+	mblk_t *mp;
+
+	if ((mp = mi_allocb(q, SCCP_WROFF + mlen, BPRI_MED)))
+		mblk_reserve(mp, SCCP_WROFF);
+	return (mp);
+}
 
 /*
  *  SCCP_MT_CR    0x01 - Connection Request
@@ -5467,7 +5521,7 @@ sccp_pack_cr(queue_t *q, mblk_t *msg)
 	    ((m->parms & SCCP_PTF_IMP) ? 2 + size_imp() : 0) +	/* IMP */
 	    1;
 
-	if ((mp = mi_allocb(q, mlen, BPRI_MED))) {
+	if ((mp = sccp_allocb(q, mlen))) {
 		register uchar *p;
 
 		DB_TYPE(mp) = M_DATA;
@@ -5534,7 +5588,7 @@ sccp_pack_cc(queue_t *q, mblk_t *msg)
 	    ((m->parms & SCCP_PTF_IMP) ? 2 + size_imp() : 0) +	/* IMP */
 	    1;				/* EOP */
 
-	if ((mp = mi_allocb(q, mlen, BPRI_MED))) {
+	if ((mp = sccp_allocb(q, mlen))) {
 		register uchar *p;
 
 		DB_TYPE(mp) = M_DATA;
@@ -5592,7 +5646,7 @@ sccp_pack_cref(queue_t *q, mblk_t *msg)
 	    ((m->parms & SCCP_PTF_IMP) ? 2 + size_imp() : 0) +	/* IMP */
 	    1;				/* EOP */
 
-	if ((mp = mi_allocb(q, mlen, BPRI_MED))) {
+	if ((mp = sccp_allocb(q, mlen))) {
 		register uchar *p;
 
 		DB_TYPE(mp) = M_DATA;
@@ -5644,7 +5698,7 @@ sccp_pack_rlsd(queue_t *q, mblk_t *msg)
 	    ((m->parms & SCCP_PTF_IMP) ? 2 + size_imp() : 0) +	/* IMP */
 	    1;				/* EOP */
 
-	if ((mp = mi_allocb(q, mlen, BPRI_MED))) {
+	if ((mp = sccp_allocb(q, mlen))) {
 		register uchar *p;
 
 		DB_TYPE(mp) = M_DATA;
@@ -5683,7 +5737,7 @@ sccp_pack_rlc(queue_t *q, mblk_t *msg)
 	    size_dlr() +		/* DLR */
 	    size_slr();			/* SLR */
 
-	if ((mp = mi_allocb(q, mlen, BPRI_MED))) {
+	if ((mp = sccp_allocb(q, mlen))) {
 		DB_TYPE(mp) = M_DATA;
 		*(mp->b_wptr)++ = SCCP_MT_RLC;
 		pack_dlr(m, &mp->b_wptr);	/* DLR F */
@@ -5710,7 +5764,7 @@ sccp_pack_dt1(queue_t *q, mblk_t *msg)
 	    2 + size_data(m) +		/* DATA */
 	    1;				/* EOP */
 
-	if ((mp = mi_allocb(q, mlen, BPRI_MED))) {
+	if ((mp = sccp_allocb(q, mlen))) {
 		register uchar *p;
 
 		DB_TYPE(mp) = M_DATA;
@@ -5744,7 +5798,7 @@ sccp_pack_dt2(queue_t *q, mblk_t *msg)
 	    2 + size_data(m) +		/* DATA */
 	    1;				/* EOP */
 
-	if ((mp = mi_allocb(q, mlen, BPRI_MED))) {
+	if ((mp = sccp_allocb(q, mlen))) {
 		register uchar *p;
 
 		DB_TYPE(mp) = M_DATA;
@@ -5778,7 +5832,7 @@ sccp_pack_ak(queue_t *q, mblk_t *msg)
 	    size_cred() +		/* CRED */
 	    1;				/* EOP */
 
-	if ((mp = mi_allocb(q, mlen, BPRI_MED))) {
+	if ((mp = sccp_allocb(q, mlen))) {
 		DB_TYPE(mp) = M_DATA;
 		*(mp->b_wptr)++ = SCCP_MT_AK;
 		pack_dlr(m, &mp->b_wptr);	/* DLR F */
@@ -5806,7 +5860,7 @@ sccp_pack_udt(queue_t *q, mblk_t *msg)
 	    2 + size_data(m) +		/* DATA */
 	    1;				/* EOP */
 
-	if ((mp = mi_allocb(q, mlen, BPRI_MED))) {
+	if ((mp = sccp_allocb(q, mlen))) {
 		register uchar *p;
 
 		DB_TYPE(mp) = M_DATA;
@@ -5848,7 +5902,7 @@ sccp_pack_udts(queue_t *q, mblk_t *msg)
 	    2 + size_data(m) +		/* DATA */
 	    1;				/* EOP */
 
-	if ((mp = mi_allocb(q, mlen, BPRI_MED))) {
+	if ((mp = sccp_allocb(q, mlen))) {
 		register uchar *p;
 
 		DB_TYPE(mp) = M_DATA;
@@ -5888,7 +5942,7 @@ sccp_pack_ed(queue_t *q, mblk_t *msg)
 	    2 + size_data(m) +		/* DATA */
 	    1;				/* EOP */
 
-	if ((mp = mi_allocb(q, mlen, BPRI_MED))) {
+	if ((mp = sccp_allocb(q, mlen))) {
 		register uchar *p;
 
 		DB_TYPE(mp) = M_DATA;
@@ -5920,7 +5974,7 @@ sccp_pack_ea(queue_t *q, mblk_t *msg)
 	    size_dlr() +		/* DLR */
 	    1;				/* EOP */
 
-	if ((mp = mi_allocb(q, mlen, BPRI_MED))) {
+	if ((mp = sccp_allocb(q, mlen))) {
 		DB_TYPE(mp) = M_DATA;
 		*(mp->b_wptr)++ = SCCP_MT_EA;
 		pack_dlr(m, &mp->b_wptr);	/* DLR F */
@@ -5946,7 +6000,7 @@ sccp_pack_rsr(queue_t *q, mblk_t *msg)
 	    size_resc() +		/* RESC */
 	    1;				/* EOP */
 
-	if ((mp = mi_allocb(q, mlen, BPRI_MED))) {
+	if ((mp = sccp_allocb(q, mlen))) {
 		DB_TYPE(mp) = M_DATA;
 		*(mp->b_wptr)++ = SCCP_MT_RSR;
 		pack_dlr(m, &mp->b_wptr);	/* DLR F */
@@ -5973,7 +6027,7 @@ sccp_pack_rsc(queue_t *q, mblk_t *msg)
 	    size_slr() +		/* SLR */
 	    1;				/* EOP */
 
-	if ((mp = mi_allocb(q, mlen, BPRI_MED))) {
+	if ((mp = sccp_allocb(q, mlen))) {
 		DB_TYPE(mp) = M_DATA;
 		*(mp->b_wptr)++ = SCCP_MT_RSC;
 		pack_dlr(m, &mp->b_wptr);	/* DLR F */
@@ -5999,7 +6053,7 @@ sccp_pack_err(queue_t *q, mblk_t *msg)
 	    size_errc() +		/* ERRC */
 	    1;				/* EOP */
 
-	if ((mp = mi_allocb(q, mlen, BPRI_MED))) {
+	if ((mp = sccp_allocb(q, mlen))) {
 		DB_TYPE(mp) = M_DATA;
 		*(mp->b_wptr)++ = SCCP_MT_ERR;
 		pack_dlr(m, &mp->b_wptr);	/* DLR F */
@@ -6028,7 +6082,7 @@ sccp_pack_it(queue_t *q, mblk_t *msg)
 	    size_cred() +		/* CRED */
 	    1;				/* EOP */
 
-	if ((mp = mi_allocb(q, mlen, BPRI_MED))) {
+	if ((mp = sccp_allocb(q, mlen))) {
 		DB_TYPE(mp) = M_DATA;
 		*(mp->b_wptr)++ = SCCP_MT_IT;
 		pack_dlr(m, &mp->b_wptr);	/* DLR F */
@@ -6066,7 +6120,7 @@ sccp_pack_xudt(queue_t *q, mblk_t *msg)
 	    ((m->parms & SCCP_PTF_MTI) ? 2 + size_mti() : 0) +	/* MTI */
 	    1;				/* EOP */
 
-	if ((mp = mi_allocb(q, mlen, BPRI_MED))) {
+	if ((mp = sccp_allocb(q, mlen))) {
 		register uchar *p, *pd;
 
 		DB_TYPE(mp) = M_DATA;
@@ -6144,7 +6198,7 @@ sccp_pack_xudts(queue_t *q, mblk_t *msg)
 	    ((m->parms & SCCP_PTF_ISNI) ? 2 + size_isni(m) : 0) +	/* ISNI */
 	    1;				/* EOP */
 
-	if ((mp = mi_allocb(q, mlen, BPRI_MED))) {
+	if ((mp = sccp_allocb(q, mlen))) {
 		register uchar *p, *pd;
 
 		DB_TYPE(mp) = M_DATA;
@@ -6221,7 +6275,7 @@ sccp_pack_ludt(queue_t *q, mblk_t *msg)
 	    ((m->parms & SCCP_PTF_INS) ? 2 + size_ins(m) : 0) +	/* INS */
 	    1;				/* EOP */
 
-	if ((mp = mi_allocb(q, mlen, BPRI_MED))) {
+	if ((mp = sccp_allocb(q, mlen))) {
 		register uchar *p, *pd;
 
 		DB_TYPE(mp) = M_DATA;
@@ -6293,7 +6347,7 @@ sccp_pack_ludts(queue_t *q, mblk_t *msg)
 	    ((m->parms & SCCP_PTF_INS) ? 2 + size_ins(m) : 0) +	/* INS */
 	    1;				/* EOP */
 
-	if ((mp = mi_allocb(q, mlen, BPRI_MED))) {
+	if ((mp = sccp_allocb(q, mlen))) {
 		register uchar *p, *pd;
 
 		DB_TYPE(mp) = M_DATA;
@@ -6359,7 +6413,7 @@ sccp_pack_scmg(queue_t *q, mblk_t *msg)
 	    2 + dlen +			/* DATA */
 	    1;				/* EOP */
 
-	if ((mp = mi_allocb(q, mlen, BPRI_MED))) {
+	if ((mp = sccp_allocb(q, mlen))) {
 		register uchar *p;
 
 		DB_TYPE(mp) = M_DATA;
@@ -7436,7 +7490,7 @@ static sccp_opt_conf_sr_t jttc_sr_config_default = {
  */
 
 enum { tall, tcon, tias, tiar, trel, trel2, tint, tguard, tres, trea, tack, tgtt,
-	tattack, tdecay, tstatinfo, tsst, tisst, twsog, trsst
+	tattack, tdecay, tstatinfo, tsst, tisst, twsog, trsst, tsweep
 };
 
 struct sc_timer {
@@ -7453,7 +7507,21 @@ struct sc_timer {
 /*
  *  SCCP timers
  *  -------------------------------------------------------------------------
+ *  The inactivity timers run for the life of every connection section and are restarted for
+ *  almost every message sent or received, so they are not kept running as timer messages: starting
+ *  one just records its expiry time, and a single sweep timer for the signalling point walks the
+ *  local reference table looking for expired ones (see sp_tsweep_timeout()).  The sweep then fires
+ *  the tias or tiar timer message of the connection section onto its own Stream, where the expiry
+ *  time is checked again and the timeout is run with the connection section locked.
  */
+static inline unsigned long
+sccp_expiry(np_ulong msec)
+{
+	unsigned long expiry = jiffies + drv_msectohz(msec);
+
+	/* zero means stopped */
+	return (expiry ? expiry : 1);
+}
 static void
 sccp_timer_stop(struct sc *sc, const uint t)
 {
@@ -7469,11 +7537,13 @@ sccp_timer_stop(struct sc *sc, const uint t)
 			break;
 		/* fall through */
 	case tias:
+		sc->tias_exp = 0;
 		mi_timer_stop(sc->timers.tias);
 		if (single)
 			break;
 		/* fall through */
 	case tiar:
+		sc->tiar_exp = 0;
 		mi_timer_stop(sc->timers.tiar);
 		if (single)
 			break;
@@ -7527,10 +7597,10 @@ sccp_timer_start(struct sc *sc, const uint t)
 		mi_timer_MAC(sc->timers.tcon, sc->config.tcon);
 		break;
 	case tias:
-		mi_timer_MAC(sc->timers.tias, sc->config.tias);
+		sc->tias_exp = sccp_expiry(sc->config.tias);
 		break;
 	case tiar:
-		mi_timer_MAC(sc->timers.tiar, sc->config.tiar);
+		sc->tiar_exp = sccp_expiry(sc->config.tiar);
 		break;
 	case trel:
 		mi_timer_MAC(sc->timers.trel, sc->config.trel);
@@ -7659,6 +7729,11 @@ sp_timer_stop(struct sp *sp, const uint t)
 		if (single)
 			break;
 		/* fall through */
+	case tsweep:
+		mi_timer_stop(sp->timers.tsweep);
+		if (single)
+			break;
+		/* fall through */
 		break;
 	default:
 		swerr();
@@ -7672,6 +7747,12 @@ sp_timer_start(struct sp *sp, const uint t)
 	case tgtt:
 		mi_timer_MAC(sp->timers.tgtt, sp->config.tgtt);
 		break;
+	case tsweep:
+		/* the sweep runs on the MTP lower Stream, and waits for one to be linked */
+		if (sp->mt)
+			mi_timer(sp->mt->iq, sp->timers.tsweep,
+				 sp->config.tsweep ? : SCCP_DEFAULT_TSWEEP);
+		break;
 	default:
 		swerr();
 		break;
@@ -8175,6 +8256,318 @@ sccp_traffic_ind(struct sc *sc, queue_t *q, struct sccp_addr *add, np_ulong tmix
 }
 #endif
 
+/*
+ *  Local reference table
+ *  -------------------------------------------------------------------------
+ *  Each signalling point assigns local references from a table indexed by the low 16 bits of the
+ *  reference.  The upper 8 bits of the 24-bit reference are a generation that is advanced each
+ *  time the entry is released, so that a message carrying a stale reference does not find the
+ *  connection section that now uses the same entry.  Looking up the connection section for a
+ *  DLR is therefore a direct index, and index zero is never assigned so that no reference is zero.
+ *
+ *  Released entries are frozen (Q.714 3.3.2) and queued in order of release; an entry is only
+ *  reassigned once its freeze time has expired, otherwise a never used entry is taken.  The table
+ *  grows in chunks of 128 entries (3 kbytes) as required so that it can be grown with atomic
+ *  allocations.
+ *
+ *  The table and the remote reference hash below are updated and searched under the signalling
+ *  point lock (sp->lock) only, whichever Stream the caller is running on.
+ */
+#define SCCP_LR_INDEX_BITS	16
+#define SCCP_LR_INDEX_MASK	((1U << SCCP_LR_INDEX_BITS) - 1)
+#define SCCP_LR_GEN_MASK	0xffU
+#define SCCP_LR_CHUNK_SHIFT	7
+#define SCCP_LR_CHUNK_SIZE	(1U << SCCP_LR_CHUNK_SHIFT)
+#define SCCP_LR_CHUNKS		(1U << (SCCP_LR_INDEX_BITS - SCCP_LR_CHUNK_SHIFT))
+
+struct lre {
+	struct sc *sc;			/* connection section (NULL when free) */
+	unsigned long frz;		/* end of freeze (jiffies) */
+	uint32_t link;			/* next released index (0 when none) */
+	uint32_t gen;			/* generation */
+};
+
+#define sccp_lre(__sp, __i) \
+	(&(__sp)->lr.dir[(__i) >> SCCP_LR_CHUNK_SHIFT][(__i) & (SCCP_LR_CHUNK_SIZE - 1)])
+
+static inline np_ulong
+sccp_lr_ref(struct lre *e, uint idx)
+{
+	return ((e->gen << SCCP_LR_INDEX_BITS) | idx);
+}
+
+/*
+ *  Look up the connection section that holds local reference @lr.  Called with sp->lock held.
+ */
+static inline fastcall struct sc *
+__sccp_lr_lookup(struct sp *sp, np_ulong lr)
+{
+	uint idx = lr & SCCP_LR_INDEX_MASK;
+	struct lre *e;
+
+	if (idx == 0 || idx >= sp->lr.next)
+		return (NULL);
+	e = sccp_lre(sp, idx);
+	if (e->gen != ((lr >> SCCP_LR_INDEX_BITS) & SCCP_LR_GEN_MASK))
+		return (NULL);
+	return (e->sc);
+}
+/*
+ *  As above, but takes sp->lock and returns the connection section with a reference held.  The
+ *  caller must release the reference with sccp_put().
+ */
+static inline fastcall struct sc *
+sccp_lr_lookup(struct sp *sp, np_ulong lr)
+{
+	struct sc *sc;
+	psw_t flags;
+
+	spin_lock_irqsave(&sp->lock, flags);
+	if ((sc = __sccp_lr_lookup(sp, lr)))
+		sccp_get(sc);
+	spin_unlock_irqrestore(&sp->lock, flags);
+	return (sc);
+}
+
+/*
+ *  Make the never used entries up to and including @idx available, allocating the table
+ *  directory and chunks as required.  Entries skipped over are queued as released (but not
+ *  frozen) so that they are not lost.
+ */
+static int
+sccp_lr_grow(struct sp *sp, uint idx)
+{
+	struct lre *e, **chunk;
+	uint i;
+
+	if (!sp->lr.dir) {
+		if (!(sp->lr.dir = kmalloc(SCCP_LR_CHUNKS * sizeof(*sp->lr.dir), GFP_ATOMIC)))
+			return (-ENOMEM);
+		bzero(sp->lr.dir, SCCP_LR_CHUNKS * sizeof(*sp->lr.dir));
+		sp->lr.next = 1;
+	}
+	for (i = sp->lr.next >> SCCP_LR_CHUNK_SHIFT; i <= (idx >> SCCP_LR_CHUNK_SHIFT); i++) {
+		if (*(chunk = &sp->lr.dir[i]))
+			continue;
+		if (!(*chunk = kmalloc(SCCP_LR_CHUNK_SIZE * sizeof(**chunk), GFP_ATOMIC)))
+			return (-ENOMEM);
+		bzero(*chunk, SCCP_LR_CHUNK_SIZE * sizeof(**chunk));
+	}
+	for (; sp->lr.next < idx; sp->lr.next++) {
+		e = sccp_lre(sp, sp->lr.next);
+		e->frz = jiffies;
+		if (sp->lr.tail)
+			sccp_lre(sp, sp->lr.tail)->link = sp->lr.next;
+		else
+			sp->lr.head = sp->lr.next;
+		sp->lr.tail = sp->lr.next;
+	}
+	sp->lr.next = idx + 1;
+	return (0);
+}
+
+/*
+ *  Assign a local reference to connection section @sc.  When @lr is non-zero, that reference is
+ *  assigned (for permanent and semi-permanent connections), otherwise the oldest released
+ *  reference whose freeze has expired, or else a never used reference.  Returns -EADDRINUSE when
+ *  a requested reference is in use or frozen, -EAGAIN when all references are in use or frozen.
+ *  Called with sp->lock held.
+ */
+static int
+__sccp_lr_alloc(struct sp *sp, struct sc *sc, np_ulong lr)
+{
+	uint idx = lr & SCCP_LR_INDEX_MASK;
+	struct lre *e;
+	int err;
+
+	if (lr) {
+		if (idx == 0)
+			return (-EINVAL);
+		if (idx >= sp->lr.next) {
+			if ((err = sccp_lr_grow(sp, idx)))
+				return (err);
+		} else {
+			uint prev = 0, cur;
+
+			e = sccp_lre(sp, idx);
+			if (e->sc || time_before(jiffies, e->frz))
+				return (-EADDRINUSE);
+			/* unlink from released queue: rare, so just walk it */
+			for (cur = sp->lr.head; cur && cur != idx;
+			     prev = cur, cur = sccp_lre(sp, cur)->link) ;
+			if (!cur) {
+				swerr();
+				return (-EFAULT);
+			}
+			if (prev)
+				sccp_lre(sp, prev)->link = e->link;
+			else
+				sp->lr.head = e->link;
+			if (sp->lr.tail == idx)
+				sp->lr.tail = prev;
+		}
+		e = sccp_lre(sp, idx);
+		e->gen = (lr >> SCCP_LR_INDEX_BITS) & SCCP_LR_GEN_MASK;
+	} else if ((idx = sp->lr.head) && !time_before(jiffies, sccp_lre(sp, idx)->frz)) {
+		e = sccp_lre(sp, idx);
+		if (!(sp->lr.head = e->link))
+			sp->lr.tail = 0;
+	} else if (sp->lr.next <= SCCP_LR_INDEX_MASK) {
+		/* next is zero until the table is first used */
+		if ((err = sccp_lr_grow(sp, (idx = sp->lr.next ? : 1))))
+			return (err);
+		e = sccp_lre(sp, idx);
+	} else
+		return (-EAGAIN);
+	e->sc = sc;
+	e->link = 0;
+	sc->slr = sccp_lr_ref(e, idx);
+	if (sp->lr.numb++ == 0)
+		sp_timer_start(sp, tsweep);
+	return (0);
+}
+static int
+sccp_lr_alloc(struct sp *sp, struct sc *sc, np_ulong lr)
+{
+	psw_t flags;
+	int err;
+
+	spin_lock_irqsave(&sp->lock, flags);
+	err = __sccp_lr_alloc(sp, sc, lr);
+	spin_unlock_irqrestore(&sp->lock, flags);
+	return (err);
+}
+
+/*
+ *  Release and freeze the local reference of connection section @sc.  The reference is left in
+ *  sc->slr for the messages that are still to be sent for the released connection.
+ */
+static void
+sccp_lr_free(struct sp *sp, struct sc *sc)
+{
+	uint idx = sc->slr & SCCP_LR_INDEX_MASK;
+	struct lre *e;
+	psw_t flags;
+
+	spin_lock_irqsave(&sp->lock, flags);
+	if (__sccp_lr_lookup(sp, sc->slr) != sc) {
+		spin_unlock_irqrestore(&sp->lock, flags);
+		return;
+	}
+	e = sccp_lre(sp, idx);
+	e->sc = NULL;
+	e->gen = (e->gen + 1) & SCCP_LR_GEN_MASK;
+	e->frz = jiffies + drv_msectohz(sp->config.tfrz ? : SCCP_DEFAULT_TFRZ);
+	e->link = 0;
+	if (sp->lr.tail)
+		sccp_lre(sp, sp->lr.tail)->link = idx;
+	else
+		sp->lr.head = idx;
+	sp->lr.tail = idx;
+	if (--sp->lr.numb == 0)
+		sp_timer_stop(sp, tsweep);
+	spin_unlock_irqrestore(&sp->lock, flags);
+}
+
+/*
+ *  Start the inactivity sweep when an MTP Stream is linked to a signalling point that already has
+ *  connection sections, and stop it before the MTP Stream is unlinked.
+ */
+static void
+sccp_lr_sweep(struct sp *sp, bool on)
+{
+	psw_t flags;
+
+	spin_lock_irqsave(&sp->lock, flags);
+	if (!on)
+		sp_timer_stop(sp, tsweep);
+	else if (sp->lr.numb)
+		sp_timer_start(sp, tsweep);
+	spin_unlock_irqrestore(&sp->lock, flags);
+}
+
+/*
+ *  Free the local reference table.  Called with sp->lock held.
+ */
+static void
+sccp_lr_destroy(struct sp *sp)
+{
+	uint i;
+
+	if (sp->lr.dir) {
+		for (i = 0; i < SCCP_LR_CHUNKS; i++)
+			kfree(sp->lr.dir[i]);
+		kfree(sp->lr.dir);
+	}
+	bzero(&sp->lr, sizeof(sp->lr));
+}
+
+/*
+ *  Remote references
+ *  -------------------------------------------------------------------------
+ *  Connection sections are also hashed by remote point code and remote reference once the remote
+ *  reference is associated, so that a CR that repeats one for which a connection section already
+ *  exists can be recognized during connection establishment without searching.
+ */
+static inline uint
+sccp_rr_hash(np_ulong pc, np_ulong lr)
+{
+	return ((lr ^ (lr >> 10) ^ (pc * 0x9e37)) & (SCCP_CO_HASH_SIZE - 1));
+}
+static struct sc *
+sccp_rr_lookup(struct sp *sp, np_ulong pc, np_ulong lr)
+{
+	struct sc *sc;
+	psw_t flags;
+
+	spin_lock_irqsave(&sp->lock, flags);
+	for (sc = sp->sccp_co_hash[sccp_rr_hash(pc, lr)]; sc; sc = sc->rr_next)
+		if (sc->dlr == lr && sc->rpc == pc)
+			break;
+	spin_unlock_irqrestore(&sp->lock, flags);
+	return (sc);
+}
+static void
+__sccp_rr_unlink(struct sc *sc)
+{
+	if (sc->rr_prev) {
+		if ((*sc->rr_prev = sc->rr_next))
+			sc->rr_next->rr_prev = sc->rr_prev;
+		sc->rr_next = NULL;
+		sc->rr_prev = NULL;
+	}
+}
+static void
+sccp_rr_unlink(struct sp *sp, struct sc *sc)
+{
+	psw_t flags;
+
+	spin_lock_irqsave(&sp->lock, flags);
+	__sccp_rr_unlink(sc);
+	spin_unlock_irqrestore(&sp->lock, flags);
+}
+
+/*
+ *  Associate remote reference @lr at point code @pc with connection section @sc.
+ */
+static void
+sccp_rr_link(struct sp *sp, struct sc *sc, np_ulong pc, np_ulong lr)
+{
+	struct sc **scp;
+	psw_t flags;
+
+	spin_lock_irqsave(&sp->lock, flags);
+	__sccp_rr_unlink(sc);
+	sc->rpc = pc;
+	sc->dlr = lr;
+	scp = &sp->sccp_co_hash[sccp_rr_hash(pc, lr)];
+	if ((sc->rr_next = *scp))
+		sc->rr_next->rr_prev = &sc->rr_next;
+	sc->rr_prev = scp;
+	*scp = sc;
+	spin_unlock_irqrestore(&sp->lock, flags);
+}
+
 static void
 sccp_release(struct sc *sc)
 {
@@ -8189,8 +8582,10 @@ sccp_release(struct sc *sc)
 	spin_lock_irqsave(&master.lock, flags);
 	{
 		if (sc->sp.sp) {
-			fixme(("Freeze local reference\n"));
-			// sc->slr = 0; /* Oooops need this for released message */ 
+			/* release and freeze local reference, but keep sc->slr for the released
+			   message */
+			sccp_lr_free(sc->sp.sp, sc);
+			sccp_rr_unlink(sc->sp.sp, sc);
 			if ((*(sc->sp.prev) = sc->sp.next))
 				sc->sp.next->sp.prev = sc->sp.prev;
 			sc->sp.next = NULL;
@@ -8335,7 +8730,7 @@ sccp_recv_cc(struct sc *sc, queue_t *q, mblk_t *bp, mblk_t *msg, struct sccp_msg
 		sccp_timer_start(sc, tiar);
 		if ((sc->pcl = m->pcl) == 3)
 			sc->p_cred = m->cred;
-		sc->dlr = m->slr;
+		sccp_rr_link(sc->sp.sp, sc, m->rl.opc, m->slr);
 		sc->sp.sp->add.pc = m->rl.opc;	/* ANSI */
 		sccp_set_state(sc, SS_DATA_XFER);
 		return (QR_DONE);
@@ -10787,6 +11182,407 @@ sccp_recv_scmg(struct sp *sp, queue_t *q, mblk_t *bp, mblk_t *mp, struct sccp_ms
 	return (0);
 }
 
+/*
+ *  SCCP GLOBAL TITLE TRANSLATION
+ *  -------------------------------------------------------------------------
+ *  The translation entries of a signalling point are compiled into a longest-prefix-match digit
+ *  trie, one per translation table (the GTI, TT, NP and NAI of the global title).  Each trie node
+ *  holds sixteen 32-bit slots, one for each BCD digit, so that a node occupies exactly one cache
+ *  line and a lookup touches one node per digit.  A slot either indexes a child node or, with
+ *  GTT_LEAF set, holds the index of the translation result (zero for no translation).  Results of
+ *  shorter prefixes are pushed down into the empty slots of the nodes below them when those nodes
+ *  are created, so that the walk can stop at the first leaf it meets; the result to use when the
+ *  digits run out at an interior node is kept beside the node in gtt_best.
+ *
+ *  Nodes and results are allocated in page-sized blocks so that large tables can be built with
+ *  atomic allocations.  A compiled struct gtt is never changed: management builds a complete new
+ *  one whenever translations are added, changed or deleted, and swaps it in with a single pointer
+ *  exchange.  Lookups run under rcu_read_lock() and never block; the old translations are freed
+ *  after a grace period.  If the new translations cannot be built, the old ones stay in service.
+ */
+#define GTT_LEAF	0x80000000U	/* slot holds a result index */
+#define GTT_SHIFT	6	/* 64 nodes or results to a block */
+#define GTT_BLOCK	(1U << GTT_SHIFT)
+#define GTT_MASK	(GTT_BLOCK - 1)
+
+struct gtt_node {
+	uint32_t slot[16];		/* child node index, or GTT_LEAF | result index */
+};
+
+struct gtt_res {
+	uint32_t mode;			/* destination selection mode */
+	uint32_t ndest;			/* number of destinations */
+	struct sccp_gt_dest dest[SCCP_GT_MAX_DEST];	/* destinations in order of preference */
+	uint32_t pad[2];		/* pad to 64 bytes */
+};
+
+struct gtt_tab {
+	uint32_t key;			/* table key: see sccp_gtt_key() */
+	uint32_t root;			/* index of root node */
+};
+
+struct gtt {
+	struct rcu_head rcu;		/* deferred free */
+	uint ntab;			/* number of translation tables */
+	uint nnode;			/* number of nodes */
+	uint nres;			/* number of results (including unused result 0) */
+	uint nblk;			/* number of block pointers in each array */
+	struct gtt_tab tab[SCCP_GT_MAX_TABLES];	/* translation tables */
+	struct gtt_node **node;		/* node blocks */
+	uint32_t **best;		/* best result at each node, by node block */
+	struct gtt_res **res;		/* result blocks */
+};
+
+#define gtt_node(__g, __i) (&(__g)->node[(__i) >> GTT_SHIFT][(__i) & GTT_MASK])
+#define gtt_best(__g, __i) ((__g)->best[(__i) >> GTT_SHIFT][(__i) & GTT_MASK])
+#define gtt_res(__g, __i) (&(__g)->res[(__i) >> GTT_SHIFT][(__i) & GTT_MASK])
+
+/*
+ *  Form the table key for a global title.  Only the fields that are present for the global title
+ *  indicator (which differ between ANSI and ITU-T) take part, so that stale values left in absent
+ *  fields of a decoded address do not select the wrong table.
+ */
+static inline fastcall uint32_t
+sccp_gtt_key(np_ulong pvar, np_ulong gti, np_ulong tt, np_ulong nplan, np_ulong nai)
+{
+	uint32_t key = (gti & 0x0f) << 24;
+
+	switch (pvar & SS7_PVAR_MASK) {
+	case SS7_PVAR_ANSI:
+	case SS7_PVAR_JTTC:
+		switch (gti) {
+		case 1:
+			return (key | ((tt & 0xff) << 16) | ((nplan & 0x0f) << 8));
+		case 2:
+			return (key | ((tt & 0xff) << 16));
+		}
+		break;
+	default:
+		switch (gti) {
+		case 1:
+			return (key | (nai & 0x7f));
+		case 2:
+			return (key | ((tt & 0xff) << 16));
+		case 3:
+			return (key | ((tt & 0xff) << 16) | ((nplan & 0x0f) << 8));
+		case 4:
+			return (key | ((tt & 0xff) << 16) | ((nplan & 0x0f) << 8) | (nai & 0x7f));
+		}
+		break;
+	}
+	return (key);
+}
+
+static void
+sccp_gtt_free(struct gtt *g)
+{
+	uint i;
+
+	if (g == NULL)
+		return;
+	for (i = 0; i < g->nblk; i++) {
+		if (g->node)
+			kfree(g->node[i]);
+		if (g->best)
+			kfree(g->best[i]);
+		if (g->res)
+			kfree(g->res[i]);
+	}
+	kfree(g->node);
+	kfree(g->best);
+	kfree(g->res);
+	kfree(g);
+}
+static void
+sccp_gtt_free_rcu(struct rcu_head *rcu)
+{
+	sccp_gtt_free(container_of(rcu, struct gtt, rcu));
+}
+
+/*
+ *  Allocate the next node, filled with the result inherited from the slot it replaces.
+ *  Returns the node index, or zero when out of memory (node zero is always a root and is never
+ *  a child).
+ */
+static uint32_t
+sccp_gtt_node(struct gtt *g, uint32_t inherit)
+{
+	uint32_t i = g->nnode, d;
+	struct gtt_node *n;
+
+	if ((i & GTT_MASK) == 0) {
+		if ((i >> GTT_SHIFT) >= g->nblk)
+			return (0);
+		if (!(g->node[i >> GTT_SHIFT] = kmalloc(GTT_BLOCK * sizeof(*n), GFP_ATOMIC)))
+			return (0);
+		if (!(g->best[i >> GTT_SHIFT] = kmalloc(GTT_BLOCK * sizeof(uint32_t), GFP_ATOMIC)))
+			return (0);
+	}
+	n = gtt_node(g, i);
+	for (d = 0; d < 16; d++)
+		n->slot[d] = GTT_LEAF | inherit;
+	gtt_best(g, i) = inherit;
+	g->nnode++;
+	return (i);
+}
+
+/*
+ *  Insert the prefix of translation entry @e as result @r.  Entries must be inserted in order of
+ *  increasing prefix length, so that every node is created after all of the shorter prefixes
+ *  above it, and the result that it inherits is final.
+ */
+static int
+sccp_gtt_insert(struct gtt *g, struct gtt_tab *t, const struct sccp_conf_gt *e, uint32_t r)
+{
+	struct gtt_node *n;
+	uint32_t idx = t->root, s, c;
+	uint i, d;
+
+	if (e->plen == 0) {
+		/* table default: the root has no longer prefixes below it yet */
+		n = gtt_node(g, idx);
+		for (d = 0; d < 16; d++)
+			n->slot[d] = GTT_LEAF | r;
+		gtt_best(g, idx) = r;
+		return (0);
+	}
+	for (i = 0; i < e->plen - 1; i++) {
+		d = e->digits[i] & 0x0f;
+		s = gtt_node(g, idx)->slot[d];
+		if (s & GTT_LEAF) {
+			if (!(c = sccp_gtt_node(g, s & ~GTT_LEAF)))
+				return (-ENOMEM);
+			gtt_node(g, idx)->slot[d] = c;
+			s = c;
+		}
+		idx = s;
+	}
+	d = e->digits[i] & 0x0f;
+	n = gtt_node(g, idx);
+	if (!(n->slot[d] & GTT_LEAF)) {
+		/* cannot happen when inserted in order of length */
+		swerr();
+		return (-EFAULT);
+	}
+	n->slot[d] = GTT_LEAF | r;
+	return (0);
+}
+
+/*
+ *  Compile the translation entries of the signalling point, other than @skip (an entry about to be
+ *  deleted), into a new struct gtt and swap it in.  When there are no entries, translation reverts
+ *  to the GTT streams.
+ */
+static int
+sccp_gtt_compile(struct sp *sp, struct gte *skip)
+{
+	struct gtt *g = NULL, *old;
+	struct gte *gte;
+	uint32_t nnode = 0, r;
+	uint i, len;
+	int err = -ENOMEM;
+
+	if (sp->gte.numb == (skip ? 1 : 0))
+		goto swap;
+	/* upper bound on nodes: one root per table, at most one node per prefix digit */
+	for (gte = sp->gte.list; gte; gte = gte->next)
+		nnode += gte->config.plen;
+	if (!(g = kmalloc(sizeof(*g), GFP_ATOMIC)))
+		goto error;
+	bzero(g, sizeof(*g));
+	nnode += SCCP_GT_MAX_TABLES;
+	g->nblk = (max(nnode, (uint32_t) sp->gte.numb + 1) + GTT_MASK) >> GTT_SHIFT;
+	g->node = kmalloc(g->nblk * sizeof(*g->node), GFP_ATOMIC);
+	g->best = kmalloc(g->nblk * sizeof(*g->best), GFP_ATOMIC);
+	g->res = kmalloc(g->nblk * sizeof(*g->res), GFP_ATOMIC);
+	if (!g->node || !g->best || !g->res) {
+		g->nblk = 0;
+		goto error;
+	}
+	bzero(g->node, g->nblk * sizeof(*g->node));
+	bzero(g->best, g->nblk * sizeof(*g->best));
+	bzero(g->res, g->nblk * sizeof(*g->res));
+	/* result zero is no translation */
+	g->nres = 1;
+	if (!(g->res[0] = kmalloc(GTT_BLOCK * sizeof(struct gtt_res), GFP_ATOMIC)))
+		goto error;
+	/* tables, each with its root node */
+	for (gte = sp->gte.list; gte; gte = gte->next) {
+		struct sccp_conf_gt *c = &gte->config;
+		uint32_t key = sccp_gtt_key(sp->proto.pvar, c->gtt, c->tt, c->nplan, c->nai);
+
+		if (gte == skip)
+			continue;
+		for (i = 0; i < g->ntab && g->tab[i].key != key; i++) ;
+		if (i < g->ntab)
+			continue;
+		if (g->ntab >= SCCP_GT_MAX_TABLES) {
+			err = -ENOSPC;
+			goto error;
+		}
+		g->tab[i].key = key;
+		g->tab[i].root = g->nnode;
+		sccp_gtt_node(g, 0);
+		if (g->nnode == g->tab[i].root)
+			goto error;
+		g->ntab++;
+	}
+	/* prefixes in order of increasing length */
+	for (len = 0; len <= SCCP_GT_MAX_DIGITS; len++) {
+		for (gte = sp->gte.list; gte; gte = gte->next) {
+			struct sccp_conf_gt *c = &gte->config;
+			uint32_t key;
+			struct gtt_res *res;
+
+			if (c->plen != len || gte == skip)
+				continue;
+			key = sccp_gtt_key(sp->proto.pvar, c->gtt, c->tt, c->nplan, c->nai);
+			for (i = 0; i < g->ntab && g->tab[i].key != key; i++) ;
+			r = g->nres;
+			if ((r & GTT_MASK) == 0
+			    && !(g->res[r >> GTT_SHIFT] =
+				 kmalloc(GTT_BLOCK * sizeof(*res), GFP_ATOMIC)))
+				goto error;
+			res = gtt_res(g, r);
+			bzero(res, sizeof(*res));
+			res->mode = c->mode;
+			res->ndest = c->ndest;
+			bcopy(c->dest, res->dest, c->ndest * sizeof(c->dest[0]));
+			g->nres++;
+			if ((err = sccp_gtt_insert(g, &g->tab[i], c, r)))
+				goto error;
+		}
+	}
+      swap:
+	old = xchg(&sp->gtt, g);
+	if (old)
+		call_rcu(&old->rcu, sccp_gtt_free_rcu);
+	return (0);
+      error:
+	sccp_gtt_free(g);
+	return (err);
+}
+
+/*
+ *  Is a translation destination available to the local signalling point?
+ */
+static int
+sccp_gtt_avail(struct sp *sp, const struct sccp_gt_dest *d)
+{
+	struct sp *dst;
+	struct sr *sr;
+
+	if ((dst = sccp_lookup_sp(sp->add.ni, d->pc, 0))) {
+		struct ss *ss;
+
+		if (dst->flags & (SCCPF_PROHIBITED | SCCPF_UNEQUIPPED | SCCPF_INACCESSIBLE))
+			return (0);
+		if (d->ssn && (ss = sccp_lookup_ss(dst, d->ssn, 0))
+		    && (ss->flags & SCCPF_PROHIBITED))
+			return (0);
+		return (1);
+	}
+	if ((sr = sccp_lookup_sr(sp, d->pc, 0))) {
+		struct rs *rs;
+
+		if (sr->flags & (SCCPF_PROHIBITED | SCCPF_UNEQUIPPED | SCCPF_INACCESSIBLE))
+			return (0);
+		if (d->ssn && (rs = sccp_lookup_rs(sr, d->ssn, 0)) && (rs->flags & SCCPF_PROHIBITED))
+			return (0);
+		return (1);
+	}
+	return (0);
+}
+
+/*
+ *  Translate the called party global title of a message.  On success the called party address and
+ *  routing label are rewritten to the selected destination.  Returns 1 when translated, 0 when the
+ *  signalling point has no compiled translations (translation is left to a GTT stream), -ENOENT
+ *  when there is no table for the type of global title, -ESRCH when there is no translation for
+ *  the address, -ELOOP on hop counter violation.
+ */
+static int
+sccp_gtt_translate(struct sp *sp, struct sccp_msg *m)
+{
+	struct sccp_addr *a = &m->cdpa;
+	const struct sccp_gt_dest *d;
+	const struct gtt_res *res;
+	struct gtt *g;
+	uint32_t key, idx, s;
+	uint i, n, k, avail;
+	int rtn = 0;
+
+	rcu_read_lock();
+	if (!(g = rcu_dereference(sp->gtt)))
+		goto unlock;
+	key = sccp_gtt_key(sp->proto.pvar, a->gtt, a->tt, a->nplan, a->nai);
+	for (i = 0; i < g->ntab && g->tab[i].key != key; i++) ;
+	if (i == g->ntab) {
+		m->flags |= SCCPF_XLAT_FAILURE;
+		rtn = -ENOENT;
+		goto unlock;
+	}
+	idx = g->tab[i].root;
+	n = min(a->alen, (np_ulong) SCCP_MAX_ADDR_LENGTH) << 1;
+	if (a->es == 1 && n)
+		/* BCD, odd number of digits */
+		n--;
+	for (i = 0; i < n; i++) {
+		s = gtt_node(g, idx)->slot[(a->addr[i >> 1] >> ((i & 1) << 2)) & 0x0f];
+		if (s & GTT_LEAF) {
+			s &= ~GTT_LEAF;
+			goto found;
+		}
+		idx = s;
+	}
+	s = gtt_best(g, idx);
+      found:
+	if (s == 0 || (res = gtt_res(g, s))->ndest == 0) {
+		rtn = -ESRCH;
+		goto unlock;
+	}
+	d = &res->dest[0];
+	switch (res->mode) {
+	case SCCP_GT_MODE_DOMINANT:
+		/* first available in order of preference, otherwise the primary */
+		for (k = 0; k < res->ndest; k++)
+			if (sccp_gtt_avail(sp, &res->dest[k])) {
+				d = &res->dest[k];
+				break;
+			}
+		break;
+	case SCCP_GT_MODE_LOADSHARE:
+		/* by SLS over available destinations, so sequenced traffic stays together */
+		for (avail = 0, k = 0; k < res->ndest; k++)
+			if (sccp_gtt_avail(sp, &res->dest[k]))
+				avail |= (1 << k);
+		if (avail) {
+			uint pick = m->rl.sls % hweight32(avail);
+
+			for (k = 0; k < res->ndest; k++)
+				if ((avail & (1 << k)) && pick-- == 0)
+					break;
+			d = &res->dest[k];
+		}
+		break;
+	}
+	if (m->hopc && --m->hopc == 0) {
+		m->flags |= SCCPF_HOPC_VIOLATION;
+		rtn = -ELOOP;
+		goto unlock;
+	}
+	a->pc = d->pc;
+	if (d->ssn)
+		a->ssn = d->ssn;
+	a->ri = d->ri;
+	m->rl.dpc = d->pc;
+	m->flags |= SCCPF_GT_TRANSLATED;
+	rtn = 1;
+      unlock:
+	rcu_read_unlock();
+	return (rtn);
+}
+
 /*
  *  SCCP GTT ROUTING
  *  -------------------------------------------------------------------------
@@ -11225,6 +12021,7 @@ sccp_orte_cr(struct sp *src, queue_t *q, mblk_t *bp, mblk_t *mp, struct sccp_msg
 	int err, refc;
 	np_ulong dpc, smi = 0, cong = 0;
 
+      route:
 	if ((dpc = m->cdpa.pc) != -1 || (dpc = m->rl.dpc) != -1) {
 		struct sp *dst;
 
@@ -11305,6 +12102,18 @@ sccp_orte_cr(struct sp *src, queue_t *q, mblk_t *bp, mblk_t *mp, struct sccp_msg
 		if (m->cdpa.ri == SCCP_RI_DPC_SSN)
 			goto access_failure;
 	      do_gtt:
+		if (!(m->flags & SCCPF_GT_TRANSLATED)) {
+			switch (sccp_gtt_translate(src, m)) {
+			case 1:
+				goto route;
+			case -ENOENT:
+				goto no_address_type_translation;
+			case -ESRCH:
+				goto destination_address_unknown;
+			case -ELOOP:
+				goto hop_counter_violation;
+			}
+		}
 		if (!(sc = src->gt.list))
 			goto access_failure;
 		if (!canput(sc->oq))
@@ -11352,6 +12161,14 @@ sccp_orte_cr(struct sp *src, queue_t *q, mblk_t *bp, mblk_t *mp, struct sccp_msg
 	refc = SCCP_REFC_ACCESS_CONGESTION;
 	mi_strlog(q, 0, SL_TRACE, "refusal: access congestion");
 	goto do_refc;
+      no_address_type_translation:
+	refc = SCCP_REFC_NO_ADDRESS_TYPE_TRANSLATION;
+	mi_strlog(q, 0, SL_TRACE, "refusal: no address type translation");
+	goto do_refc;
+      hop_counter_violation:
+	refc = SCCP_REFC_SCCP_HOP_COUNTER_VIOLATION;
+	mi_strlog(q, 0, SL_TRACE, "refusal: hop counter violation");
+	goto do_refc;
       do_ssc:
 	if ((err =
 	     sccp_send_ssc(src, q, bp, m->rl.opc, &m->cdpa,
@@ -11455,6 +12272,7 @@ sccp_orte_cl(struct sp *src, queue_t *q, mblk_t *bp, mblk_t *mp, struct sccp_msg
 	int err, retc;
 	np_ulong dpc, smi = 0, cong = 0;
 
+      route:
 	if ((dpc = m->cdpa.pc) != -1 || (dpc = m->rl.dpc) != -1) {
 		struct sp *dst;
 
@@ -11539,6 +12357,18 @@ sccp_orte_cl(struct sp *src, queue_t *q, mblk_t *bp, mblk_t *mp, struct sccp_msg
 		if (m->cdpa.ri == SCCP_RI_DPC_SSN)
 			goto mtp_failure;
 	      do_gtt:
+		if (!(m->flags & SCCPF_GT_TRANSLATED)) {
+			switch (sccp_gtt_translate(src, m)) {
+			case 1:
+				goto route;
+			case -ENOENT:
+				goto no_address_type_translation;
+			case -ESRCH:
+				goto no_address_translation;
+			case -ELOOP:
+				goto hop_counter_violation;
+			}
+		}
 		if (!(sc = src->gt.list))
 			goto no_address_translation;
 		if (!canput(sc->oq))
@@ -11576,10 +12406,18 @@ sccp_orte_cl(struct sp *src, queue_t *q, mblk_t *bp, mblk_t *mp, struct sccp_msg
 	retc = SCCP_RETC_NETWORK_CONGESTION;
 	printd(("%s: ERROR: network congestion\n", DRV_NAME));
 	goto do_retc;
+      no_address_type_translation:
+	retc = SCCP_RETC_NO_ADDRESS_TYPE_TRANSLATION;
+	printd(("%s: ERROR: no address type translation\n", DRV_NAME));
+	goto do_retc;
       no_address_translation:
 	retc = SCCP_RETC_NO_ADDRESS_TRANSLATION;
 	printd(("%s: ERROR: no address translation\n", DRV_NAME));
 	goto do_retc;
+      hop_counter_violation:
+	retc = SCCP_RETC_SCCP_HOP_COUNTER_VIOLATION;
+	printd(("%s: ERROR: hop counter violation\n", DRV_NAME));
+	goto do_retc;
       unqualified:
 	retc = SCCP_RETC_UNQUALIFIED;
 	printd(("%s: ERROR: unqualified\n", DRV_NAME));
@@ -11689,6 +12527,11 @@ sccp_irte_cr(struct sp *sp, queue_t *q, mblk_t *bp, mblk_t *mp, struct sccp_msg
 
 	switch (m->cdpa.ri) {
 	case SCCP_RI_DPC_SSN:
+		/* a connection section already has this remote reference */
+		if (sccp_rr_lookup(sp, m->rl.opc, m->slr)) {
+			mi_strlog(q, 0, SL_TRACE, "discard: duplicate CR");
+			return (QR_DONE);
+		}
 		smi = 0;
 		cong = 0;
 		if (!(ss = sccp_lookup_ss(sp, m->cdpa.ssn, 0)))
@@ -11704,6 +12547,16 @@ sccp_irte_cr(struct sp *sp, queue_t *q, mblk_t *bp, mblk_t *mp, struct sccp_msg
 		ss7_oput(sc->oq, mp);
 		return (QR_DONE);
 	case SCCP_RI_GT:
+		switch (sccp_gtt_translate(sp, m)) {
+		case 1:
+			return sccp_orte_cr(sp, q, bp, mp, m);
+		case -ENOENT:
+			goto no_address_type_translation;
+		case -ESRCH:
+			goto destination_address_unknown;
+		case -ELOOP:
+			goto hop_counter_violation;
+		}
 		if (!(sc = sp->gt.list))
 			goto access_failure;
 		if (!canput(sc->oq))
@@ -11735,6 +12588,18 @@ sccp_irte_cr(struct sp *sp, queue_t *q, mblk_t *bp, mblk_t *mp, struct sccp_msg
 	refc = SCCP_REFC_ACCESS_CONGESTION;
 	mi_strlog(q, 0, SL_TRACE, "refusal: GT translation congested");
 	goto do_refc;
+      no_address_type_translation:
+	refc = SCCP_REFC_NO_ADDRESS_TYPE_TRANSLATION;
+	mi_strlog(q, 0, SL_TRACE, "refusal: no GT translation table");
+	goto do_refc;
+      destination_address_unknown:
+	refc = SCCP_REFC_DESTINATION_ADDRESS_UNKNOWN;
+	mi_strlog(q, 0, SL_TRACE, "refusal: no GT translation");
+	goto do_refc;
+      hop_counter_violation:
+	refc = SCCP_REFC_SCCP_HOP_COUNTER_VIOLATION;
+	mi_strlog(q, 0, SL_TRACE, "refusal: hop counter violation");
+	goto do_refc;
       do_ssc:
 	if ((err =
 	     sccp_send_ssc(sp, q, bp, m->rl.opc, &m->cdpa,
@@ -11804,6 +12669,16 @@ sccp_irte_cl(struct sp *sp, queue_t *q, mblk_t *bp, mblk_t *mp, struct sccp_msg
 		ss7_oput(sc->oq, mp);
 		return (QR_DONE);
 	case SCCP_RI_GT:
+		switch (sccp_gtt_translate(sp, m)) {
+		case 1:
+			return sccp_orte_cl(sp, q, bp, mp, m);
+		case -ENOENT:
+			goto no_address_type_translation;
+		case -ESRCH:
+			goto no_address_translation;
+		case -ELOOP:
+			goto hop_counter_violation;
+		}
 		if (!(sc = sp->gt.list))
 			goto no_address_translation;
 		if (!canputnext(sc->oq))
@@ -11837,10 +12712,18 @@ sccp_irte_cl(struct sp *sp, queue_t *q, mblk_t *bp, mblk_t *mp, struct sccp_msg
 	retc = SCCP_RETC_SUBSYSTEM_CONGESTION;
 	mi_strlog(q, 0, SL_TRACE, "message returned: GT Translation congested");
 	goto do_retc;
+      no_address_type_translation:
+	retc = SCCP_RETC_NO_ADDRESS_TYPE_TRANSLATION;
+	mi_strlog(q, 0, SL_TRACE, "message returned: no GT Translation table");
+	goto do_retc;
       no_address_translation:
 	retc = SCCP_RETC_NO_ADDRESS_TRANSLATION;
 	mi_strlog(q, 0, SL_TRACE, "message returned: GT Translation unavailable");
 	goto do_retc;
+      hop_counter_violation:
+	retc = SCCP_RETC_SCCP_HOP_COUNTER_VIOLATION;
+	mi_strlog(q, 0, SL_TRACE, "message returned: hop counter violation");
+	goto do_retc;
       do_ssc:
 	if ((err =
 	     sccp_send_ssc(sp, q, bp, m->rl.opc, &m->cdpa,
@@ -11905,16 +12788,33 @@ sccp_irte_cl(struct sp *sp, queue_t *q, mblk_t *bp, mblk_t *mp, struct sccp_msg
  *  SCCP ROUTING Connection Oriented Messages (other than CR) only
  *  -------------------------------------------------------------------------
  */
-static struct sc **
+static inline struct sc *
 sccp_co_lookup(struct sp *sp, np_ulong slr)
 {
-	swerr();
-	return (NULL);
+	return sccp_lr_lookup(sp, slr);
 }
 static int
 sccp_irte_co(struct sp *sp, queue_t *q, mblk_t *bp, mblk_t *mp, struct sccp_msg *m)
 {
+	struct sc *sc;
+	queue_t *oq;
+
+	/* these are always route on DLR */
+	if (!(sc = sccp_co_lookup(sp, m->dlr))) {
+		/* unassigned or frozen local reference */
+		mi_strlog(q, 0, SL_TRACE, "discard: unassigned DLR %06lx", (ulong) m->dlr);
+		return (QR_DONE);
+	}
+	if (!(oq = sc->oq) || !canput(oq)) {
+		sccp_put(sc);
+		mi_strlog(q, 0, SL_TRACE, "discard: flow controlled");
+		return (QR_DONE);
+	}
 	/* pass message to SCCP user */
+	if (bp)
+		freeb(bp);
+	ss7_oput(oq, mp);
+	sccp_put(sc);
 	return (QR_DONE);
 }
 
@@ -11925,10 +12825,10 @@ sccp_irte_co(struct sp *sp, queue_t *q, mblk_t *mp, struct sccp_msg *m)
 	int err;
 	np_ulong relc;
 	struct sr *sr;
-	struct sc *sc, **scp;
+	struct sc *sc;
 
 	/* these are always route on DLR */
-	if (!(scp = sccp_co_lookup(sp, m->dlr)) || !(sc = *scp))
+	if (!(sc = sccp_co_lookup(sp, m->dlr)))
 		goto unassigned_dlr;
 	/* we have a connected segment */
 	if (((sc->pcl != 2) || (1 << m->type) & ~(SCCP_MTM_PCLS2))
@@ -12183,6 +13083,8 @@ sccp_unbind_req(struct sc *sc, queue_t *q)
 	}
 	/* remove from established hash */
 	if (sc->sp.sp) {
+		sccp_lr_free(sc->sp.sp, sc);
+		sccp_rr_unlink(sc->sp.sp, sc);
 		if ((*sc->sp.prev = sc->sp.next))
 			sc->sp.next->sp.prev = &sc->sp.next;
 		sc->sp.next = NULL;
@@ -12199,15 +13101,11 @@ sccp_unbind_req(struct sc *sc, queue_t *q)
  *  Launching a connection request is like a subsequent bind to a DLRN.  We select a new LRN for the connection and
  *  place ourselves in the LRN hashes for the MTP provider and send a Connection Request.
  */
-#define SCCP_SLR_MAX_TRIES	10
 static int
 sccp_conn_req(struct sc *sc, queue_t *q, struct sccp_addr *dst, np_ulong *sls, np_ulong *pri,
 	      np_ulong *pcl, np_ulong *imp, mblk_t *dp)
 {
 	int err = 0;
-	int tries;
-	unsigned short slr = 0;		/* just to shut up compiler */
-	struct sc **scp = NULL;		/* just to shut up compiler */
 	struct sp *sp;
 
 	if (sccp_get_state(sc) != SS_IDLE)
@@ -12226,23 +13124,12 @@ sccp_conn_req(struct sc *sc, queue_t *q, struct sccp_addr *dst, np_ulong *sls, n
 			goto enomem;
 		/* Figure C.2/Q.714: Figure 2A/T1.112.4-2000 1of4: Assign a local reference and an
 		   SLS to the connection section. Determine proposed protocol class and credit. */
-		for (tries = SCCP_SLR_MAX_TRIES; tries; tries--) {
-			/* IMPLEMENTAION NOTE: This is where we would do labelling and offset for
-			   SUA.  There would need to be a fixed SLR portion mask and value.  We
-			   would then only select SLRs which are within the variable portion.  For
-			   now, this uses the entire SLR numbering space. */
-			slr = (sp->sccp_next_slr++) & 0xffff;
-			if ((scp = sccp_co_lookup(sp, slr)) && !(*scp))
-				break;
-		}
-		if (*scp)
+		/* IMPLEMENTAION NOTE: This is where we would do labelling and offset for SUA.
+		   There would need to be a fixed SLR portion mask and value.  We would then only
+		   select SLRs which are within the variable portion.  For now, this uses the entire
+		   SLR numbering space. */
+		if ((err = sccp_lr_alloc(sp, sc, 0)))
 			goto eagain2;
-		/* we have CO slot, use it */
-		if ((sc->sp.next = *scp))
-			sc->sp.next->sp.prev = &sc->sp.next;
-		sc->sp.prev = scp;
-		*scp = sccp_get(sc);
-		sc->sp.sp = sp_get(sp);
 		/* connect to remote signalling point */
 		if ((sc->sr.next = sr->sc.list))
 			sc->sr.next->sr.prev = &sc->sr.next;
@@ -12283,27 +13170,26 @@ sccp_conn_req(struct sc *sc, queue_t *q, struct sccp_addr *dst, np_ulong *sls, n
 		fixme(("Set selected slr\n"));
 		if ((err =
 		     sccp_send_cr(sp, q, NULL, sp->add.pc, sc->mp, sc->sls, sc->slr, sc->pcl,
-				  &sc->dst, &sc->credit, &sc->src, dp, NULL, imp)))
+				  &sc->dst, &sc->credit, &sc->src, dp, NULL, imp))) {
+			sccp_lr_free(sp, sc);
 			return (err);
+		}
 	} else {
 		/* Request Type 1 or Request Type 2 */
 		/* Figure 2A/T1.112.4-2000 1of4: Request Type 1 has SLR, DLR, DPC, PCLASS and
 		   credit already assigned (for permanent or semi-permanent connection). */
 		/* Figure 2A/T1.112.4-2000 1of2: Request Type 2 has SLR, DLR, DPC, PCLASS and
 		   credit already assigned (for permanent or semi-permanent connection). */
-		slr = sc->slr;
-		scp = sccp_co_lookup(sp, slr);
-		if (scp && (*scp))
+		if ((err = sccp_lr_alloc(sp, sc, sc->slr)))
 			goto eisconn;
 	}
 	sccp_timer_start(sc, tcon);
 	sccp_set_state(sc, SS_WCON_CREQ);
-	/* we have a blind slot, use it */
-	sc->slr = slr;
-	if ((sc->sp.next = *scp))
+	/* connected to local signalling point */
+	if ((sc->sp.next = sp->sc.list))
 		sc->sp.next->sp.prev = &sc->sp.next;
-	sc->sp.prev = scp;
-	*scp = sccp_get(sc);
+	sc->sp.prev = &sp->sc.list;
+	sp->sc.list = sccp_get(sc);
 	sc->sp.sp = sp_get(sp);
 	return (0);
       enomem:
@@ -12311,11 +13197,11 @@ sccp_conn_req(struct sc *sc, queue_t *q, struct sccp_addr *dst, np_ulong *sls, n
 	mi_strlog(q, 0, SL_TRACE, "ERROR: insufficient memory");
 	goto error;
       eagain2:
-	err = -EAGAIN;
 	mi_strlog(q, 0, SL_TRACE, "ERROR: could not assign SLR");
 	goto error;
       eisconn:
-	err = -EISCONN;
+	if (!err)
+		err = -EISCONN;
 	mi_strlog(q, 0, SL_TRACE, "ERROR: user already connected");
 	goto error;
       efault:
@@ -12334,9 +13220,6 @@ static int
 sccp_conn_res(struct sc *sc, queue_t *q, mblk_t *cp, struct sc *ap, mblk_t *dp)
 {
 	int err;
-	int tries;
-	unsigned short slr;
-	struct sc **scp = NULL;		/* just to shut up compiler */
 	struct sccp_msg *m = (struct sccp_msg *) cp->b_rptr;
 	struct sp *sp;
 	struct sr *sr;
@@ -12356,22 +13239,17 @@ sccp_conn_res(struct sc *sc, queue_t *q, mblk_t *cp, struct sc *ap, mblk_t *dp)
 	   active state. */
 	fixme(("We should really get the user's protocol class and\n"
 	       "credit preferences from the N_CONN_RES options\n"));
-	for (tries = 0; tries < SCCP_SLR_MAX_TRIES; tries++) {
-		slr = (sp->sccp_next_slr++) & 0xffff;
-		if ((scp = sccp_co_lookup(sp, slr)) && !(*scp))
-			break;
-	}
-	if (*scp)
-		goto eagain2;
 	if (ap->sp.sp)
 		goto eisconn2;
 	if (!(sr = sccp_lookup_sr(sp, sc->sp.sp->add.pc, 1)))
 		goto enomem;
-	/* we have CO slot, use it */
-	if ((ap->sp.next = *scp))
+	if ((err = sccp_lr_alloc(sp, ap, 0)))
+		goto eagain2;
+	/* connected to local signalling point */
+	if ((ap->sp.next = sp->sc.list))
 		ap->sp.next->sp.prev = &ap->sp.next;
-	ap->sp.prev = scp;
-	*scp = sccp_get(ap);
+	ap->sp.prev = &sp->sc.list;
+	sp->sc.list = sccp_get(ap);
 	ap->sp.sp = sp_get(sp);
 	/* connect to remote signalling point */
 	if ((ap->sr.next = sr->sc.list))
@@ -12381,7 +13259,7 @@ sccp_conn_res(struct sc *sc, queue_t *q, mblk_t *cp, struct sc *ap, mblk_t *dp)
 	ap->sr.sr = sr_get(sr);
 	if ((ap->pcl = m->pcl) == 3)
 		ap->p_cred = m->cred;
-	ap->dlr = m->slr;
+	sccp_rr_link(sp, ap, m->rl.opc, m->slr);
 	fixme(("copy more stuff and rebind ap if necessary"));
 	switch (ap->proto.pvar & SS7_PVAR_MASK) {
 	case SS7_PVAR_ANSI:
@@ -12411,8 +13289,7 @@ sccp_conn_res(struct sc *sc, queue_t *q, mblk_t *cp, struct sc *ap, mblk_t *dp)
 	mi_strlog(q, 0, SL_TRACE, "CONN_RES: user already connected");
 	goto error;
       eagain2:
-	mi_strlog(q, 0, SL_TRACE, "CONN_RES: slr assignment timed out");
-	return (-EAGAIN);
+	mi_strlog(q, 0, SL_TRACE, "CONN_RES: could not assign SLR");
 	goto error;
       eisconn:
 	err = -EISCONN;
@@ -13261,6 +14138,7 @@ mtp_addr_ack(struct mt *mt, queue_t *q, mblk_t *mp)
 	sp->mt = mtp_get(mt);
 	unless(mt->sp, goto efault);	/* FIXME */
 	mt->sp = sp_get(sp);	/* FIXME */
+	sccp_lr_sweep(sp, true);
 	fixme(("Set proper state for SR and SP\n"));
 	return (QR_DONE);
       notfound:
@@ -13365,6 +14243,7 @@ mtp_info_ack(struct mt *mt, queue_t *q, mblk_t *mp)
 	unless(mt->sp, goto efault);	/* FIXME */
 	sp->mt = mtp_get(mt);
 	mt->sp = sp_get(sp);	/* FIXME */
+	sccp_lr_sweep(sp, true);
 	fixme(("Set proper state for SR and SP\n"));
 	return (QR_DONE);
       notfound:
@@ -16229,6 +17108,72 @@ sp_tgtt_timeout(struct sp *sp, queue_t *q)
 	return (0);
 }
 
+/*
+ *  TIMEOUT Inactivity Sweep
+ *  -----------------------------------
+ *  Walk the local reference table of the signalling point and, for each connection section whose
+ *  receive or send inactivity timer has expired, fire the timer message onto the Stream of the
+ *  connection section.  The timeout itself is run from there by sc_tiar_expiry() or
+ *  sc_tias_expiry().  An expiry that is still pending is simply fired again on the next sweep.
+ */
+static int
+sp_tsweep_timeout(struct sp *sp, queue_t *q)
+{
+	struct sc *sc;
+	psw_t flags;
+	uint idx;
+
+	spin_lock_irqsave(&sp->lock, flags);
+	for (idx = 1; idx < sp->lr.next; idx++) {
+		if (!(sc = sccp_lre(sp, idx)->sc))
+			continue;
+		if (sc->tiar_exp && !time_before(jiffies, sc->tiar_exp)) {
+			/* connection section will probably be released */
+			mi_timer(sc->iq, sc->timers.tiar, 0);
+			continue;
+		}
+		if (sc->tias_exp && !time_before(jiffies, sc->tias_exp))
+			mi_timer(sc->iq, sc->timers.tias, 0);
+	}
+	if (sp->lr.numb)
+		sp_timer_start(sp, tsweep);
+	spin_unlock_irqrestore(&sp->lock, flags);
+	return (0);
+}
+
+/*
+ *  TIMEOUT Inactivity (expiry from sweep)
+ *  -----------------------------------
+ *  Run on the Stream of the connection section.  The inactivity timer might have been restarted or
+ *  stopped since the sweep fired it, so check the expiry time again.
+ */
+static int
+sc_tias_expiry(struct sc *sc, queue_t *q)
+{
+	unsigned long exp = sc->tias_exp;
+	int err;
+
+	if (!exp || time_before(jiffies, exp))
+		return (0);
+	sc->tias_exp = 0;
+	if ((err = sc_tias_timeout(sc, q)) && !sc->tias_exp)
+		sc->tias_exp = exp;
+	return (err);
+}
+static int
+sc_tiar_expiry(struct sc *sc, queue_t *q)
+{
+	unsigned long exp = sc->tiar_exp;
+	int err;
+
+	if (!exp || time_before(jiffies, exp))
+		return (0);
+	sc->tiar_exp = 0;
+	if ((err = sc_tiar_timeout(sc, q)) && !sc->tiar_exp)
+		sc->tiar_exp = exp;
+	return (err);
+}
+
 /*
  *  TIMEOUT Attack
  *  -----------------------------------
@@ -16563,6 +17508,16 @@ sccp_get_df(struct sccp_config *arg, struct df *df, int size)
 	return (QR_DONE);
 }
 static int
+sccp_get_gt(struct sccp_config *arg, struct gte *gte, int size)
+{
+	struct sccp_conf_gt *cnf = (typeof(cnf)) (arg + 1);
+
+	if (!gte || (size -= sizeof(*cnf)) < 0)
+		return (-EINVAL);
+	*cnf = gte->config;
+	return (QR_DONE);
+}
+static int
 sccp_get_conf(struct sccp_config *arg, int size)
 {
 	switch (arg->type) {
@@ -16584,6 +17539,8 @@ sccp_get_conf(struct sccp_config *arg, int size)
 		return sccp_get_mt(arg, mtp_lookup(arg->id), size);
 	case SCCP_OBJ_TYPE_DF:
 		return sccp_get_df(arg, &master, size);
+	case SCCP_OBJ_TYPE_GT:
+		return sccp_get_gt(arg, gte_lookup(arg->id), size);
 	default:
 		rare();
 		return -EINVAL;
@@ -16782,6 +17739,7 @@ sccp_add_mt(struct sccp_config *arg, struct mt *mt, int size, int force, int tes
 		} else {
 			mt->sp = sp_get(sp);
 			sp->mt = mtp_get(mt);
+			sccp_lr_sweep(sp, true);
 		}
 		mt->proto = cnf->proto;
 		arg->id = mt->id;
@@ -16797,6 +17755,82 @@ sccp_add_df(struct sccp_config *arg, struct df *df, int size, int force, int tes
 		return (-EINVAL);
 	return (-EINVAL);
 }
+/*
+ *  Check a global title translation for validity and uniqueness within its signalling point.
+ *  @gte is the entry being changed (if any).
+ */
+static int
+sccp_chk_gt(struct sp *sp, struct sccp_conf_gt *cnf, struct gte *gte)
+{
+	struct gte *other;
+	uint32_t key;
+	uint i;
+
+	if (cnf->gtt < 1 || cnf->gtt > 4)
+		return (-EINVAL);
+	if (cnf->plen > SCCP_GT_MAX_DIGITS)
+		return (-EINVAL);
+	for (i = 0; i < cnf->plen; i++)
+		if (cnf->digits[i] > 0x0f)
+			return (-EINVAL);
+	if (cnf->ndest < 1 || cnf->ndest > SCCP_GT_MAX_DEST)
+		return (-EINVAL);
+	for (i = 0; i < cnf->ndest; i++)
+		if (cnf->dest[i].ri != SCCP_RI_DPC_SSN && cnf->dest[i].ri != SCCP_RI_GT)
+			return (-EINVAL);
+	switch (cnf->mode) {
+	case SCCP_GT_MODE_SOLITARY:
+		if (cnf->ndest != 1)
+			return (-EINVAL);
+		break;
+	case SCCP_GT_MODE_DOMINANT:
+	case SCCP_GT_MODE_LOADSHARE:
+		break;
+	default:
+		return (-EINVAL);
+	}
+	/* prefix must be unique within its translation table */
+	key = sccp_gtt_key(sp->proto.pvar, cnf->gtt, cnf->tt, cnf->nplan, cnf->nai);
+	for (other = sp->gte.list; other; other = other->next) {
+		struct sccp_conf_gt *c = &other->config;
+
+		if (other == gte || c->plen != cnf->plen)
+			continue;
+		if (sccp_gtt_key(sp->proto.pvar, c->gtt, c->tt, c->nplan, c->nai) != key)
+			continue;
+		if (memcmp(c->digits, cnf->digits, cnf->plen) == 0)
+			return (-EBUSY);
+	}
+	return (0);
+}
+static int
+sccp_add_gt(struct sccp_config *arg, struct gte *gte, int size, int force, int test)
+{
+	struct sp *sp = NULL;
+	struct sccp_conf_gt *cnf = (typeof(cnf)) (arg + 1);
+	int err;
+
+	if (gte || (size -= sizeof(*cnf)) < 0)
+		return (-EINVAL);
+	if (cnf->spid)
+		sp = sp_lookup(cnf->spid);
+	if (!sp)
+		return (-EINVAL);
+	if ((err = sccp_chk_gt(sp, cnf, NULL)))
+		return (err);
+	if (!force) {
+	}
+	if (!test) {
+		if (!(gte = sccp_alloc_gte(gte_get_id(arg->id), sp, cnf)))
+			return (-ENOMEM);
+		if (!(cnf->flags & SCCP_GTF_DEFER) && (err = sccp_gtt_compile(sp, NULL))) {
+			sccp_free_gte(gte);
+			return (err);
+		}
+		arg->id = gte->id;
+	}
+	return (QR_DONE);
+}
 static int
 sccp_add_conf(struct sccp_config *arg, int size, const int force, const int test)
 {
@@ -16819,6 +17853,8 @@ sccp_add_conf(struct sccp_config *arg, int size, const int force, const int test
 		return sccp_add_mt(arg, mtp_lookup(arg->id), size, force, test);
 	case SCCP_OBJ_TYPE_DF:
 		return sccp_add_df(arg, &master, size, force, test);
+	case SCCP_OBJ_TYPE_GT:
+		return sccp_add_gt(arg, gte_lookup(arg->id), size, force, test);
 	default:
 		rare();
 		return -EINVAL;
@@ -16884,6 +17920,33 @@ sccp_cha_df(struct sccp_config *arg, struct df *df, int size, int force, int tes
 	return (-EFAULT);
 }
 static int
+sccp_cha_gt(struct sccp_config *arg, struct gte *gte, int size, int force, int test)
+{
+	struct sccp_conf_gt *cnf = (typeof(cnf)) (arg + 1);
+	struct sccp_conf_gt old;
+	int err;
+
+	if (!gte || (size -= sizeof(*cnf)) < 0)
+		return (-EINVAL);
+	/* translations cannot move between signalling points */
+	if (cnf->spid && cnf->spid != gte->sp->id)
+		return (-EINVAL);
+	if ((err = sccp_chk_gt(gte->sp, cnf, gte)))
+		return (err);
+	if (!force) {
+	}
+	if (!test) {
+		old = gte->config;
+		gte->config = *cnf;
+		gte->config.spid = gte->sp->id;
+		if (!(cnf->flags & SCCP_GTF_DEFER) && (err = sccp_gtt_compile(gte->sp, NULL))) {
+			gte->config = old;
+			return (err);
+		}
+	}
+	return (QR_DONE);
+}
+static int
 sccp_cha_conf(struct sccp_config *arg, int size, const int force, const int test)
 {
 	switch (arg->type) {
@@ -16905,6 +17968,8 @@ sccp_cha_conf(struct sccp_config *arg, int size, const int force, const int test
 		return sccp_cha_mt(arg, mtp_lookup(arg->id), size, force, test);
 	case SCCP_OBJ_TYPE_DF:
 		return sccp_cha_df(arg, &master, size, force, test);
+	case SCCP_OBJ_TYPE_GT:
+		return sccp_cha_gt(arg, gte_lookup(arg->id), size, force, test);
 	default:
 		rare();
 		return -EINVAL;
@@ -17068,6 +18133,23 @@ sccp_del_df(struct sccp_config *arg, struct df *df, int size, int force, int tes
 	return (QR_DONE);
 }
 static int
+sccp_del_gt(struct sccp_config *arg, struct gte *gte, int size, int force, int test)
+{
+	int err;
+
+	if (!gte)
+		return (-EINVAL);
+	if (!force) {
+	}
+	if (!test) {
+		/* stop translating with the entry before freeing it */
+		if ((err = sccp_gtt_compile(gte->sp, gte)))
+			return (err);
+		sccp_free_gte(gte);
+	}
+	return (QR_DONE);
+}
+static int
 sccp_del_conf(struct sccp_config *arg, int size, const int force, const int test)
 {
 	switch (arg->type) {
@@ -17089,6 +18171,8 @@ sccp_del_conf(struct sccp_config *arg, int size, const int force, const int test
 		return sccp_del_mt(arg, mtp_lookup(arg->id), size, force, test);
 	case SCCP_OBJ_TYPE_DF:
 		return sccp_del_df(arg, &master, size, force, test);
+	case SCCP_OBJ_TYPE_GT:
+		return sccp_del_gt(arg, gte_lookup(arg->id), size, force, test);
 	default:
 		rare();
 		return -EINVAL;
@@ -19579,10 +20663,10 @@ do_timeout(queue_t *q, mblk_t *mp)
 		return sc_tcon_timeout(t->sc, q);
 	case tias:
 		mi_strlog(q, STRLOGTO, SL_TRACE, "tias expiry at %lu", jiffies);
-		return sc_tias_timeout(t->sc, q);
+		return sc_tias_expiry(t->sc, q);
 	case tiar:
 		mi_strlog(q, STRLOGTO, SL_TRACE, "tiar expiry at %lu", jiffies);
-		return sc_tiar_timeout(t->sc, q);
+		return sc_tiar_expiry(t->sc, q);
 	case trel:
 		mi_strlog(q, STRLOGTO, SL_TRACE, "trel expiry at %lu", jiffies);
 		return sc_trel_timeout(t->sc, q);
@@ -19628,6 +20712,9 @@ do_timeout(queue_t *q, mblk_t *mp)
 	case trsst:
 		mi_strlog(q, STRLOGTO, SL_TRACE, "trsst expiry at %lu", jiffies);
 		return rs_trsst_timeout(t->rs, q);
+	case tsweep:
+		mi_strlog(q, STRLOGTO, SL_TRACE, "tsweep expiry at %lu", jiffies);
+		return sp_tsweep_timeout(t->sp, q);
 	default:
 		mi_strlog(q, 0, SL_ERROR, "unknown timer %u", t->timer);
 		return 0;
@@ -20299,8 +21386,22 @@ sccp_alloc_priv(queue_t *q, struct sc **scp, dev_t *devp, cred_t *crp, minor_t b
 	struct sc *sc;
 
 	if ((sc = kmem_cache_alloc(sccp_sc_cachep, GFP_ATOMIC))) {
+		struct sc_timer *t;
+
 		printd(("%s: %p: allocated sc private structure\n", DRV_NAME, sc));
 		bzero(sc, sizeof(*sc));
+		/* inactivity timers: fired by the signalling point sweep */
+		if (!(sc->timers.tias = mi_timer_alloc(sizeof(*t)))
+		    || !(sc->timers.tiar = mi_timer_alloc(sizeof(*t)))) {
+			mi_timer_free(sc->timers.tias);
+			kmem_cache_free(sccp_sc_cachep, sc);
+			ptrace(("%s: ERROR: Could not allocate sc timers\n", DRV_NAME));
+			return (NULL);
+		}
+		(t = (typeof(t)) sc->timers.tias->b_rptr)->timer = tias;
+		t->sc = sc;
+		(t = (typeof(t)) sc->timers.tiar->b_rptr)->timer = tiar;
+		t->sc = sc;
 		sc->priv_put = &sccp_put;
 		sc->u.dev.cmajor = getmajor(*devp);
 		sc->u.dev.cminor = getminor(*devp);
@@ -20392,6 +21493,19 @@ sccp_free_priv(struct sc *sc)
 	psw_t flags;
 
 	ensure(sc, return);
+	/* stop the inactivity timers and remove the connection section from the signalling point
+	   references before the timer messages and queues go away: master.lock is held */
+	sccp_timer_stop(sc, tall);
+	if (sc->sp.sp) {
+		sccp_lr_free(sc->sp.sp, sc);
+		sccp_rr_unlink(sc->sp.sp, sc);
+		if ((*(sc->sp.prev) = sc->sp.next))
+			sc->sp.next->sp.prev = sc->sp.prev;
+		sc->sp.next = NULL;
+		sc->sp.prev = &sc->sp.next;
+		sp_put(xchg(&sc->sp.sp, NULL));
+		sccp_put(sc);
+	}
 	spin_lock_irqsave(&sc->lock, flags);
 	{
 		ss7_unbufcall((str_t *) sc);
@@ -20428,6 +21542,8 @@ sccp_free_priv(struct sc *sc)
 		sc->iq->q_ptr = NULL;
 		flushq(sc->iq, FLUSHDATA);
 		sc->iq = NULL;
+		mi_timer_free(xchg(&sc->timers.tias, NULL));
+		mi_timer_free(xchg(&sc->timers.tiar, NULL));
 	}
 	spin_unlock_irqrestore(&sc->lock, flags);
 	sccp_put(sc);		/* final put */
@@ -21091,7 +22207,18 @@ sccp_alloc_sp(uint id, struct na *na, mtp_addr_t * add)
 
 	printd(("%s: %s: create sp->id = %u\n", DRV_NAME, __FUNCTION__, id));
 	if ((sp = kmem_cache_alloc(sccp_sp_cachep, GFP_ATOMIC))) {
+		struct sc_timer *t;
+
 		bzero(sp, sizeof(*sp));
+		/* inactivity sweep timer: queued to the MTP Stream when started */
+		if (!(sp->timers.tsweep = mi_timer_alloc(sizeof(*t)))) {
+			kmem_cache_free(sccp_sp_cachep, sp);
+			printd(("%s: %s: ERROR: failed to allocate sp timers %u\n", DRV_NAME,
+				__FUNCTION__, id));
+			return (NULL);
+		}
+		(t = (typeof(t)) sp->timers.tsweep->b_rptr)->timer = tsweep;
+		t->sp = sp;
 		sp_get(sp);	/* first get */
 		spin_lock_init(&sp->lock);	/* "sp-lock" */
 		sp->id = id;
@@ -21124,6 +22251,14 @@ sccp_free_sp(struct sp *sp)
 	spin_lock_irqsave(&sp->lock, flags);
 	{
 		sp_timer_stop(sp, tall);
+		/* freeing all global title translations */
+		while (sp->gte.list)
+			sccp_free_gte(sp->gte.list);
+		if (sp->gtt)
+			call_rcu(&xchg(&sp->gtt, NULL)->rcu, sccp_gtt_free_rcu);
+		mi_timer_free(xchg(&sp->timers.tsweep, NULL));
+		/* free local reference table */
+		sccp_lr_destroy(sp);
 		/* freeing all signalling relations */
 		while (sp->sr.list)
 			sccp_free_sr(sp->sr.list);
@@ -21228,6 +22363,69 @@ sccp_lookup_sp(uint ni, uint pc, const int create)
 	return (sp);
 }
 
+/*
+ *  GTE allocation and deallocation
+ *  -------------------------------------------------------------------------
+ *  Translation entries are only used by management: routing uses the compiled struct gtt, so
+ *  entries need neither locks nor reference counts of their own.
+ */
+static struct gte *
+sccp_alloc_gte(uint id, struct sp *sp, struct sccp_conf_gt *cnf)
+{
+	struct gte *gte;
+
+	printd(("%s: %s: create gte->id = %u\n", DRV_NAME, __FUNCTION__, id));
+	if ((gte = kmalloc(sizeof(*gte), GFP_ATOMIC))) {
+		bzero(gte, sizeof(*gte));
+		gte->id = id;
+		gte->sp = sp;
+		gte->config = *cnf;
+		gte->config.spid = sp->id;
+		/* add to signalling point list of translations */
+		if ((gte->next = sp->gte.list))
+			gte->next->prev = &gte->next;
+		gte->prev = &sp->gte.list;
+		sp->gte.list = gte;
+		sp->gte.numb++;
+	} else
+		printd(("%s: %s: ERROR: failed to allocate gte structure %u\n", DRV_NAME,
+			__FUNCTION__, id));
+	return (gte);
+}
+static void
+sccp_free_gte(struct gte *gte)
+{
+	ensure(gte, return);
+	printd(("%s: %s: %p free gte->id = %ld\n", DRV_NAME, __FUNCTION__, gte, gte->id));
+	if ((*gte->prev = gte->next))
+		gte->next->prev = gte->prev;
+	assure(gte->sp->gte.numb > 0);
+	gte->sp->gte.numb--;
+	kfree(gte);
+}
+static struct gte *
+gte_lookup(uint id)
+{
+	struct sp *sp;
+	struct gte *gte = NULL;
+
+	if (id)
+		for (sp = master.sp.list; sp; sp = sp->next)
+			for (gte = sp->gte.list; gte; gte = gte->next)
+				if (gte->id == id)
+					return (gte);
+	return (gte);
+}
+static uint
+gte_get_id(uint id)
+{
+	static uint sequence = 0;
+
+	if (!id)
+		id = ++sequence;
+	return (id);
+}
+
 /*
  *  MT allocation and deallocation
  *  -------------------------------------------------------------------------
@@ -21314,6 +22512,7 @@ sccp_free_link(struct mt *mt)
 				}
 #endif
 			}
+			sccp_lr_sweep(mt->sp, false);
 			mtp_put(xchg(&mt->sp->mt, NULL));
 			sp_put(xchg(&mt->sp, NULL));
 		}
@@ -21514,6 +22713,12 @@ sccpterminate(void)
 
 	if ((err = unregister_strdev(&sccp_cdev, major)))
 		cmn_err(CE_PANIC, "%s: cannot unregister major %d", DRV_NAME, major);
+	/* wait for global title translation tries retired by call_rcu() to be freed */
+#if defined HAVE_KFUNC_RCU_BARRIER
+	rcu_barrier();
+#else
+	synchronize_rcu();
+#endif
 	if ((err = sccp_term_caches()))
 		cmn_err(CE_WARN, "%s: could not terminate caches", DRV_NAME);
 	if (major)
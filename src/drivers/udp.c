@@ -4051,6 +4051,10 @@ tp_ip_queue_xmit(struct sk_buff *skb)
 #endif				/* defined HAVE_KFUNC_DST_OUTPUT */
 
 #if 1
+/* The owning private structure is stashed in the page pointer of the last page fragment slot of
+   transmitted socket buffers: linear socket buffers never use it and msgskballoc() leaves it free. */
+#define TP_SKB_SLOT (MAX_SKB_FRAGS - 1)
+
 noinline fastcall __hot void
 tp_skb_destructor_slow(struct tp *tp, struct sk_buff *skb)
 {
@@ -4069,9 +4073,9 @@ tp_skb_destructor_slow(struct tp *tp, struct sk_buff *skb)
 	}
 #if 0				/* destructor is nulled by skb_orphan */
 #ifdef HAVE_KMEMB_STRUCT_SKB_FRAG_STRUCT_PAGE_P
-	skb_shinfo(skb)->frags[0].page.p = NULL;
+	skb_shinfo(skb)->frags[TP_SKB_SLOT].page.p = NULL;
 #else
-	skb_shinfo(skb)->frags[0].page = NULL;
+	skb_shinfo(skb)->frags[TP_SKB_SLOT].page = NULL;
 #endif
 	skb->destructor = NULL;
 #endif
@@ -4100,9 +4104,9 @@ tp_skb_destructor(struct sk_buff *skb)
 	unsigned long flags;
 
 #ifdef HAVE_KMEMB_STRUCT_SKB_FRAG_STRUCT_PAGE_P
-	tp = (typeof(tp)) skb_shinfo(skb)->frags[0].page.p;
+	tp = (typeof(tp)) skb_shinfo(skb)->frags[TP_SKB_SLOT].page.p;
 #else
-	tp = (typeof(tp)) skb_shinfo(skb)->frags[0].page;
+	tp = (typeof(tp)) skb_shinfo(skb)->frags[TP_SKB_SLOT].page;
 #endif
 	dassert(tp != NULL);
 	if (likely(tp->sndblk == 0)) {
@@ -4113,9 +4117,9 @@ tp_skb_destructor(struct sk_buff *skb)
 		spin_unlock_irqrestore(&tp->qlock, flags);
 #if 0				/* destructor is nulled by skb_orphan */
 #ifdef HAVE_KMEMB_STRUCT_SKB_FRAG_STRUCT_PAGE_P
-		skb_shinfo(skb)->frags[0].page.p = NULL;
+		skb_shinfo(skb)->frags[TP_SKB_SLOT].page.p = NULL;
 #else
-		skb_shinfo(skb)->frags[0].page = NULL;
+		skb_shinfo(skb)->frags[TP_SKB_SLOT].page = NULL;
 #endif
 		skb->destructor = NULL;
 #endif
@@ -4164,13 +4168,13 @@ tp_alloc_skb_slow(struct tp *tp, mblk_t *mp, unsigned int headroom, int gfp)
 		}
 		freemsg(mp);	/* must absorb */
 #if 1
-		/* we never have any page fragments, so we can steal a pointer from the page
-		   fragement list. */
+		/* we never have any page fragments, so we can steal a pointer from the last page
+		   fragment slot. */
 		assert(skb_shinfo(skb)->nr_frags == 0);
 #ifdef HAVE_KMEMB_STRUCT_SKB_FRAG_STRUCT_PAGE_P
-		skb_shinfo(skb)->frags[0].page.p = (struct page *) tp_get(tp);
+		skb_shinfo(skb)->frags[TP_SKB_SLOT].page.p = (struct page *) tp_get(tp);
 #else
-		skb_shinfo(skb)->frags[0].page = (struct page *) tp_get(tp);
+		skb_shinfo(skb)->frags[TP_SKB_SLOT].page = (struct page *) tp_get(tp);
 #endif
 		skb->destructor = tp_skb_destructor;
 		spin_lock_irqsave(&tp->qlock, flags);
@@ -4333,13 +4337,13 @@ tp_alloc_skb_old(struct tp *tp, mblk_t *mp, unsigned int headroom, int gfp)
 	freemsg(mp);
 
 #if 1
-	/* we never have any page fragments, so we can steal a pointer from the page fragement
-	   list. */
+	/* we never have any page fragments, so we can steal a pointer from the last page
+	   fragment slot. */
 	assert(skb_shinfo(skb)->nr_frags == 0);
 #ifdef HAVE_KMEMB_STRUCT_SKB_FRAG_STRUCT_PAGE_P
-	skb_shinfo(skb)->frags[0].page.p = (struct page *) tp_get(tp);
+	skb_shinfo(skb)->frags[TP_SKB_SLOT].page.p = (struct page *) tp_get(tp);
 #else
-	skb_shinfo(skb)->frags[0].page = (struct page *) tp_get(tp);
+	skb_shinfo(skb)->frags[TP_SKB_SLOT].page = (struct page *) tp_get(tp);
 #endif
 	skb->destructor = tp_skb_destructor;
 	spin_lock_irqsave(&tp->qlock, flags);
@@ -4390,12 +4394,47 @@ tp_alloc_skb_old(struct tp *tp, mblk_t *mp, unsigned int headroom, int gfp)
 }
 #endif
 
+/**
+ * tp_alloc_skb_frag - allocate a paged socket buffer from a message
+ * @tp: private pointer
+ * @mp: the message
+ * @headroom: header room for resulting sk_buff
+ * @gfp: general fault protection
+ *
+ * Leading message blocks are copied into the linear area of the socket buffer, but page fragment
+ * data blocks that follow (as are passed upstream for non-linear received sk_buffs) are attached to
+ * the socket buffer as page fragments without copying.  When the message cannot be represented this
+ * way, fall back to copying the whole message.
+ */
+noinline fastcall struct sk_buff *
+tp_alloc_skb_frag(struct tp *tp, mblk_t *mp, unsigned int headroom, int gfp)
+{
+	struct sk_buff *skb;
+	unsigned long flags;
+
+	if (unlikely((skb = msgskballoc(mp, headroom, BPRI_MED)) == NULL))
+		return tp_alloc_skb_slow(tp, mp, headroom, gfp);
+	/* msgskballoc() never uses the last page fragment slot */
+#ifdef HAVE_KMEMB_STRUCT_SKB_FRAG_STRUCT_PAGE_P
+	skb_shinfo(skb)->frags[TP_SKB_SLOT].page.p = (struct page *) tp_get(tp);
+#else
+	skb_shinfo(skb)->frags[TP_SKB_SLOT].page = (struct page *) tp_get(tp);
+#endif
+	skb->destructor = tp_skb_destructor;
+	spin_lock_irqsave(&tp->qlock, flags);
+	tp->sndmem += skb->truesize;
+	spin_unlock_irqrestore(&tp->qlock, flags);
+	return (skb);
+}
+
 STATIC INLINE fastcall __hot_out struct sk_buff *
 tp_alloc_skb(struct tp *tp, mblk_t *mp, unsigned int headroom, int gfp)
 {
 	struct sk_buff *skb;
 	unsigned long flags;
 
+	if (unlikely(mp->b_cont != NULL))
+		goto go_frag;
 	if (unlikely((mp->b_datap->db_flag & (DB_SKBUFF)) == 0))
 		goto old_way;
 	if (unlikely((mp->b_rptr < mp->b_datap->db_base + headroom)))
@@ -4406,13 +4445,13 @@ tp_alloc_skb(struct tp *tp, mblk_t *mp, unsigned int headroom, int gfp)
 	skb_reserve(skb, mp->b_rptr - skb->data);
 	skb_put(skb, mp->b_wptr - mp->b_rptr);
 #if 1
-	/* we never have any page fragments, so we can steal a pointer from the page fragement
-	   list. */
+	/* we never have any page fragments, so we can steal a pointer from the last page
+	   fragment slot. */
 	assert(skb_shinfo(skb)->nr_frags == 0);
 #ifdef HAVE_KMEMB_STRUCT_SKB_FRAG_STRUCT_PAGE_P
-	skb_shinfo(skb)->frags[0].page.p = (struct page *) tp_get(tp);
+	skb_shinfo(skb)->frags[TP_SKB_SLOT].page.p = (struct page *) tp_get(tp);
 #else
-	skb_shinfo(skb)->frags[0].page = (struct page *) tp_get(tp);
+	skb_shinfo(skb)->frags[TP_SKB_SLOT].page = (struct page *) tp_get(tp);
 #endif
 	skb->destructor = tp_skb_destructor;
 	spin_lock_irqsave(&tp->qlock, flags);
@@ -4427,6 +4466,8 @@ tp_alloc_skb(struct tp *tp, mblk_t *mp, unsigned int headroom, int gfp)
 #endif
       go_slow:
 	return tp_alloc_skb_slow(tp, mp, headroom, gfp);
+      go_frag:
+	return tp_alloc_skb_frag(tp, mp, headroom, gfp);
 }
 
 noinline fastcall int
@@ -8883,10 +8924,8 @@ tp_v4_rcv(struct sk_buff *skb)
 		goto linear_fail;
 #endif				/* HAVE_KFUNC_SKB_LINEARIZE_1_ARG */
 #else
-	if (unlikely(skb_is_nonlinear(skb))) {
-		_ptrace(("Non-linear sk_buff encountered!\n"));
-		goto linear_fail;
-	}
+	if (unlikely(skb_is_nonlinear(skb)))
+		goto nonlinear;
 #endif
 #if 0
 	/* Before passing the message up, check that there is room in the receive buffer.  Allows
@@ -8957,6 +8996,26 @@ tp_v4_rcv(struct sk_buff *skb)
 		return (0);
 	}
 #endif
+      nonlinear:
+	{
+		mblk_t *mp;
+
+		/* Place the linear area and each page fragment in a data block of its own and pass the
+		   chain up without copying.  The IP and UDP headers are always in the linear area. */
+		__skb_push(skb, skb->data - skb_network_header(skb));
+		if (unlikely((mp = skbmsgalloc(skb, BPRI_MED)) == NULL))
+			goto no_buffers;
+		_ptrace(("Allocated page fragment message %p\n", mp));
+		if (unlikely(!canput(tp->oq))) {
+			np_rstat.ms_ccnt++;
+			freemsg(mp);	/* will take sk_buff with it */
+			tp_put(tp);
+			return (0);
+		}
+		put(tp->oq, mp);
+		tp_put(tp);
+		return (0);
+	}
       bad_checksum:
 //      UDP_INC_STATS_BH(UdpInErrors);
 //      IP_INC_STATS_BH(IpInDiscards);
@@ -8965,8 +9024,8 @@ tp_v4_rcv(struct sk_buff *skb)
       no_buffers:
 #if 0
       flow_controlled:
-#endif
       linear_fail:
+#endif
 	if (tp)
 		tp_put(tp);
 	kfree_skb(skb);
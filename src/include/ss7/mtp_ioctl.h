@@ -477,6 +477,8 @@ typedef union mtp_conf_obj {
 #define SS7_POPT_TFRB	0x00020000	/* new broadcast method - no regulation */
 #define SS7_POPT_TFRR	0x00040000	/* new responsive method - regulated */
 #define SS7_POPT_MCSTA	0x00080000	/* multiple congestion states */
+#define SS7_POPT_SLSR	0x00100000	/* SLS bit rotation (default ANSI) */
+#define SS7_POPT_NOSLSR	0x00200000	/* no SLS bit rotation (default ITU-T) */
 
 #define MTP_GET		0	/* get options or configuration */
 #define MTP_ADD		1	/* add configuration */
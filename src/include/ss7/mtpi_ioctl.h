@@ -443,6 +443,8 @@ typedef struct mtp_conf_na {
 #define SS7_POPT_TFRB	0x00020000	/* new broadcast method - no regulation */
 #define SS7_POPT_TFRR	0x00040000	/* new responsive method - regulated */
 #define SS7_POPT_MCSTA	0x00080000	/* multiple congestion states */
+#define SS7_POPT_SLSR	0x00100000	/* SLS bit rotation (default ANSI) */
+#define SS7_POPT_NOSLSR	0x00200000	/* no SLS bit rotation (default ITU-T) */
 
 /*
  *  Default configuration
@@ -930,6 +932,10 @@ typedef struct mtp_statem {
  *  Signalling link statistics
  */
 typedef struct mtp_stats_sl {
+	mtp_ulong sl_local_msus;	/* MSUs originated at the local sp */
+	mtp_ulong sl_local_octets;	/* SIO and SIF octets originated at the local sp */
+	mtp_ulong sl_xfer_msus;		/* MSUs transferred onto the link */
+	mtp_ulong sl_xfer_octets;	/* SIO and SIF octets transferred onto the link */
 } mtp_stats_sl_t;
 
 /*
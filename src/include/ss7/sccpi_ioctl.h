@@ -65,6 +65,7 @@
 #define SCCP_OBJ_TYPE_SR	    6	/* Signalling Relation */
 #define SCCP_OBJ_TYPE_SP	    7	/* Signalling Point */
 #define SCCP_OBJ_TYPE_MT	    8	/* Message Transfer Part */
+#define SCCP_OBJ_TYPE_GT	    9	/* Global Title Translation */
 
 #ifdef __KERNEL__
 typedef mblk_t *sccp_timer_t;
@@ -83,6 +84,8 @@ typedef struct sccp_opt_conf_mt {
  */
 typedef struct sccp_opt_conf_sp {
 	np_ulong tgtt;
+	np_ulong tfrz;			/* local reference freeze time */
+	np_ulong tsweep;		/* inactivity sweep interval */
 } sccp_opt_conf_sp_t;
 
 /*
@@ -239,6 +242,39 @@ typedef struct sccp_conf_df {
 	lmi_option_t proto;		/* protocol variant and options */
 } sccp_conf_df_t;
 
+/*
+ *  Global title translation configuration
+ */
+#define SCCP_GT_MAX_DIGITS	32	/* maximum digits in a translation prefix */
+#define SCCP_GT_MAX_DEST	4	/* maximum destinations for a translation */
+#define SCCP_GT_MAX_TABLES	64	/* maximum translation tables per signalling point */
+
+typedef struct sccp_gt_dest {
+	np_ulong pc;			/* destination point code */
+	np_ulong ssn;			/* destination subsystem number (0 unchanged) */
+	np_ulong ri;			/* routing indicator after translation */
+} sccp_gt_dest_t;
+
+typedef struct sccp_conf_gt {
+	np_ulong spid;			/* local signalling point identifier */
+	np_ulong gtt;			/* global title indicator */
+	np_ulong tt;			/* translation type */
+	np_ulong nplan;			/* numbering plan */
+	np_ulong nai;			/* nature of address indicator */
+	np_ulong mode;			/* destination selection mode */
+	np_ulong flags;			/* translation flags */
+	np_ulong ndest;			/* number of destinations */
+	sccp_gt_dest_t dest[SCCP_GT_MAX_DEST];	/* destinations in order of preference */
+	np_ulong plen;			/* number of prefix digits */
+	unsigned char digits[SCCP_GT_MAX_DIGITS];	/* prefix digits, one per octet */
+} sccp_conf_gt_t;
+
+#define SCCP_GT_MODE_SOLITARY	0	/* single destination */
+#define SCCP_GT_MODE_DOMINANT	1	/* primary, then backups in order */
+#define SCCP_GT_MODE_LOADSHARE	2	/* share by SLS over available destinations */
+
+#define SCCP_GTF_DEFER		0x01	/* stage the change; recompile on a later change */
+
 /*
    additional SCCP protocol options 
  */
@@ -256,6 +292,7 @@ typedef union sccp_conf_obj {
 	struct sccp_conf_sr sr;
 	struct sccp_conf_sp sp;
 	struct sccp_conf_mt mt;
+	struct sccp_conf_gt gt;
 } sccp_conf_obj_t;
 
 typedef struct sccp_config {
@@ -290,6 +327,7 @@ typedef struct sccp_statem_mt {
  */
 typedef struct sccp_timers_sp {
 	sccp_timer_t tgtt;
+	sccp_timer_t tsweep;		/* inactivity sweep timer */
 } sccp_timers_sp_t;
 typedef struct sccp_statem_sp {
 	struct sccp_timers_sp timers;
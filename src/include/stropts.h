@@ -100,6 +100,12 @@ extern int putmsg(int fd, const struct strbuf *ctlptr, const struct strbuf *datp
 extern int putpmsg(int fd, const struct strbuf *ctlptr, const struct strbuf *datptr,
 		   int band, int flags);
 
+/** Receive up to vlen messages from a STREAMS file in one call. */
+extern int getmsgv(int fd, struct strmmsg *msgv, int vlen);
+
+/** Send up to vlen messages on a STREAMS file in one call. */
+extern int putmsgv(int fd, struct strmmsg *msgv, int vlen);
+
 /** Attach a STREAMS-based file descriptor, fd, to a file, path, in the file system name space. */
 extern int fattach(int fd, const char *path);
 
@@ -122,12 +128,14 @@ extern int __streams_fdetach(const char *path);
 extern int __streams_getmsg(int fd, struct strbuf *ctlptr, struct strbuf *datptr, int *flagsp);
 extern int __streams_getpmsg(int fd, struct strbuf *ctlptr, struct strbuf *datptr, int *bandp,
 			     int *flagsp);
+extern int __streams_getmsgv(int fd, struct strmmsg *msgv, int vlen);
 extern int __streams_isastream(int fd);
 extern int __streams_pipe(int fds[2]);
 extern int __streams_putmsg(int fd, const struct strbuf *ctlptr, const struct strbuf *datptr,
 			    int flags);
 extern int __streams_putpmsg(int fd, const struct strbuf *ctlptr, const struct strbuf *datptr,
 			     int band, int flags);
+extern int __streams_putmsgv(int fd, struct strmmsg *msgv, int vlen);
 /** @} */
 
 /** @name STREAMS System Calls - Thread-Safe
@@ -138,12 +146,14 @@ extern int __streams_fdetach_r(const char *path);
 extern int __streams_getmsg_r(int fd, struct strbuf *ctlptr, struct strbuf *datptr, int *flagsp);
 extern int __streams_getpmsg_r(int fd, struct strbuf *ctlptr, struct strbuf *datptr, int *bandp,
 			       int *flagsp);
+extern int __streams_getmsgv_r(int fd, struct strmmsg *msgv, int vlen);
 extern int __streams_isastream_r(int fd);
 extern int __streams_pipe_r(int fds[2]);
 extern int __streams_putmsg_r(int fd, const struct strbuf *ctlptr, const struct strbuf *datptr,
 			      int flags);
 extern int __streams_putpmsg_r(int fd, const struct strbuf *ctlptr, const struct strbuf *datptr,
 			       int band, int flags);
+extern int __streams_putmsgv_r(int fd, struct strmmsg *msgv, int vlen);
 /** @} */
 
 /** @} */
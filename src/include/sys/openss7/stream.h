@@ -247,6 +247,8 @@ typedef struct datab {
 #define DB_WASDUPED	0x01	/* UnixWare */
 #define DB_2PIECE	0x02	/* UnixWare */
 #define DB_SKBUFF	0x04	/* LfS */
+#define DB_BUFCACHE	0x08	/* LfS */
+#define DB_SKBFRAG	0x10	/* LfS */
 
 /* 
  *  Message type compatibility:
@@ -494,6 +496,13 @@ typedef struct queue {
 	struct queue *q_nbsrv;		/* next backward queue with qi_srvp */
 	qi_putp_t q_putp;		/* put procedure cache pointer */
 	qi_srvp_t q_srvp;		/* srv procedure cache pointer */
+	struct qband **q_bandv;		/* q_bandp indexed by band number */
+	unsigned long q_bandmap[NBAND / (8 * sizeof(unsigned long))];	/* bands with messages */
+	unsigned long long q_target;	/* sojourn target (nsec), zero for byte flow control */
+	unsigned long long q_interval;	/* time (nsec) above target before flow control */
+	unsigned long long q_above;	/* time (nsec) flow control applies, zero when below target */
+	unsigned long long q_sojourn;	/* last head-of-line sojourn time (nsec) */
+	unsigned long long q_maxsojourn;	/* maximum head-of-line sojourn time (nsec) */
 #if 0
 	/* these are just a waste of space */
 	struct queue *q_other;		/* LiS, OSF */
@@ -536,6 +545,7 @@ typedef struct queue {
 #define QBLKING_BIT	18	/* */
 #define QSRVP_BIT	19	/* */
 #define QSHEAD_BIT	20	/* */
+#define QDELAY_BIT	21	/* */
 
 #if 0
 /* paraphenalia */
@@ -588,6 +598,7 @@ typedef struct queue {
 #define QBLKING		(1<<QBLKING_BIT		)	/* queue procedure can block */
 #define QSRVP		(1<<QSRVP_BIT		)	/* queue has service procedure */
 #define QSHEAD		(1<<QSHEAD_BIT		)	/* queue actively belongs to a Stream head */
+#define QDELAY		(1<<QDELAY_BIT		)	/* sojourn-time (delay) flow control */
 
 #if 0
 /* different names for the same things */
@@ -701,7 +712,7 @@ struct fmodsw {
 
 struct fmodsw {
 	struct list_head f_list;	/* list of all structures */
-	struct list_head f_hash;	/* list of module hashes in slot */
+	struct hlist_node f_hash;	/* list of module hashes in slot */
 	const char *f_name;		/* module name */
 	struct streamtab *f_str;	/* pointer to streamtab for module */
 	uint f_flag;			/* module flags */
@@ -711,13 +722,14 @@ struct fmodsw {
 	const char *f_sqinfo;		/* elsewhere synchornization info */
 	struct syncq *f_syncq;		/* synchronization queue */
 	struct module *f_kmod;		/* kernel module */
+	struct hlist_node f_nhash;	/* list of module name hashes in slot */
 };
 
 struct cdev;				/* just in case */
 
 struct cdevsw {
 	struct list_head d_list;	/* list of all structures */
-	struct list_head d_hash;	/* list of module hashes in slot */
+	struct hlist_node d_hash;	/* list of module hashes in slot */
 	const char *d_name;		/* driver name */
 	struct streamtab *d_str;	/* pointer to streamtab for driver */
 	uint d_flag;			/* driver flags */
@@ -739,11 +751,12 @@ struct cdevsw {
 	struct stdata *d_plinks;	/* permanent links for this device */
 	struct list_head d_stlist;	/* stream head list for this device */
 	struct cdev *d_cdev;		/* character device structure */
+	struct hlist_node d_nhash;	/* list of driver name hashes in slot */
 };
 
 struct devnode {
 	struct list_head n_list;	/* list of all nodes for this device */
-	struct list_head n_hash;	/* list of major hashes in slot */
+	struct hlist_node n_hash;	/* list of major hashes in slot */
 	const char *n_name;		/* node name */
 	struct streamtab *n_str;	/* streamtab for node */
 	uint n_flag;			/* node flags */
@@ -760,6 +773,7 @@ struct devnode {
 	/* above must match cdevsw */
 	int n_minor;			/* node minor device number */
 	struct cdevsw *n_dev;		/* character device */
+	struct hlist_node n_nhash;	/* list of node name hashes in slot */
 };
 
 #define N_MAJOR		0x01	/* major device node */
@@ -1007,6 +1021,10 @@ typedef enum qfields {
 	QFIRST,				/* first message in queue */
 	QLAST,				/* last message in queue */
 	QFLAG,				/* state */
+	QTARGET,			/* LfS: sojourn target (usec), zero for byte flow control */
+	QINTERVAL,			/* LfS: time (usec) above target before flow control */
+	QSOJOURN,			/* LfS: last head-of-line sojourn time (usec) */
+	QMAXSOJOURN,			/* LfS: maximum head-of-line sojourn time (usec) */
 	QBAD,				/* last (AIX and SUPER-UX) */
 } qfields_t;
 
@@ -1014,21 +1032,32 @@ typedef enum qfields {
 
 __STREAMS_EXTERN int adjmsg(mblk_t *mp, register ssize_t length);
 __STREAMS_EXTERN mblk_t *allocb(size_t size, unsigned int priority);
+__STREAMS_EXTERN mblk_t *allocb_room(size_t headroom, size_t size, size_t tailroom,
+				     unsigned int priority);
 __STREAMS_EXTERN mblk_t *copyb(register mblk_t *mp);
 __STREAMS_EXTERN void freeb(mblk_t *bp);
 __STRUTIL_EXTERN_INLINE void freemsg(mblk_t *mp);
+__STREAMS_EXTERN void freemsgchain(mblk_t *mp);
 __STRUTIL_EXTERN_INLINE mblk_t *copymsg(register mblk_t *mp);
 __STREAMS_EXTERN int ctlmsg(unsigned char type);
 __STREAMS_EXTERN int datamsg(unsigned char type);
 __STREAMS_EXTERN mblk_t *dupb(mblk_t *mp);
 __STRUTIL_EXTERN_INLINE mblk_t *dupmsg(mblk_t *mp);
 __STREAMS_EXTERN mblk_t *skballoc(struct sk_buff *skb, uint priority);
+__STREAMS_EXTERN mblk_t *skbmsgalloc(struct sk_buff *skb, uint priority);
+__STREAMS_EXTERN struct sk_buff *msgskballoc(mblk_t *mp, unsigned int headroom, uint priority);
 __STREAMS_EXTERN mblk_t *esballoc(unsigned char *base, size_t size, uint priority,
 				  frtn_t *freeinfo);
 __STRUTIL_EXTERN_INLINE int isdatablk(dblk_t *db);
 __STRUTIL_EXTERN_INLINE int isdatamsg(mblk_t *mp);
 __STRUTIL_EXTERN_INLINE void linkb(register mblk_t *mp1, register mblk_t *mp2);
 __STRUTIL_EXTERN_INLINE mblk_t *linkmsg(mblk_t *mp1, mblk_t *mp2);
+__STRUTIL_EXTERN_INLINE ssize_t mblk_headroom(mblk_t *mp);
+__STRUTIL_EXTERN_INLINE ssize_t mblk_tailroom(mblk_t *mp);
+__STRUTIL_EXTERN_INLINE void mblk_reserve(mblk_t *mp, size_t len);
+__STRUTIL_EXTERN_INLINE unsigned char *mblk_push(mblk_t *mp, size_t len);
+__STRUTIL_EXTERN_INLINE unsigned char *mblk_pull(mblk_t *mp, size_t len);
+__STRUTIL_EXTERN_INLINE unsigned char *mblk_put(mblk_t *mp, size_t len);
 __STRUTIL_EXTERN_INLINE size_t msgdsize(register mblk_t *mp);
 __STREAMS_EXTERN mblk_t *msgpullup(mblk_t *mp, ssize_t length);
 __STRUTIL_EXTERN_INLINE size_t msgsize(mblk_t *mp);
@@ -1266,6 +1295,63 @@ unlinkmsg(register mblk_t *mp, register mblk_t *bp)
 	return (mp);
 }
 
+/* Header room functions (LfS). */
+
+/*
+ *  These let a protocol module add its header to a message block in the room reserved ahead of the
+ *  data (see allocb_room()) instead of allocating a new message block for the header, and strip a
+ *  header without pulling the message up.  A data block that is shared (db_ref > 1) must not be
+ *  written, so mblk_push() and mblk_put() fail on them as they do when there is not enough room.
+ */
+__STRUTIL_EXTERN_INLINE ssize_t
+mblk_headroom(mblk_t *mp)
+{
+	return (mp->b_rptr - mp->b_datap->db_base);
+}
+
+__STRUTIL_EXTERN_INLINE ssize_t
+mblk_tailroom(mblk_t *mp)
+{
+	return (mp->b_datap->db_lim - mp->b_wptr);
+}
+
+__STRUTIL_EXTERN_INLINE void
+mblk_reserve(mblk_t *mp, size_t len)
+{
+	mp->b_rptr += len;
+	mp->b_wptr += len;
+}
+
+__STRUTIL_EXTERN_INLINE unsigned char *
+mblk_push(mblk_t *mp, size_t len)
+{
+	if (unlikely(mp->b_datap->db_ref > 1) || unlikely(mblk_headroom(mp) < (ssize_t) len))
+		return (NULL);
+	return ((mp->b_rptr -= len));
+}
+
+__STRUTIL_EXTERN_INLINE unsigned char *
+mblk_pull(mblk_t *mp, size_t len)
+{
+	unsigned char *hdr = mp->b_rptr;
+
+	if (unlikely(mp->b_wptr - hdr < (ssize_t) len))
+		return (NULL);
+	mp->b_rptr += len;
+	return (hdr);
+}
+
+__STRUTIL_EXTERN_INLINE unsigned char *
+mblk_put(mblk_t *mp, size_t len)
+{
+	unsigned char *tail = mp->b_wptr;
+
+	if (unlikely(mp->b_datap->db_ref > 1) || unlikely(mblk_tailroom(mp) < (ssize_t) len))
+		return (NULL);
+	mp->b_wptr += len;
+	return (tail);
+}
+
 /* Queue functions. */
 
 __STRUTIL_EXTERN_INLINE int
@@ -162,12 +162,7 @@ typedef unsigned long int t_uscalar_t;
 
 #ifdef __NOT_IMPLEMENTED__
 #define __I_PUSH_NOCTTY		(__SID |39)	/* Solaris  *//**< Internal. */
-#define I_STRFT			(__SID |40)	/* Solaris  *//**< Internal. */
-#define I_STRFTON		(__SID |41)	/* Solaris  *//**< Internal. */
-#define I_STRFTOFF		(__SID |42)	/* Solaris  *//**< Internal. */
-#define I_STRFTSTR		(__SID |43)	/* Solaris  *//**< Internal. */
-#define I_STRFTALL		(__SID |44)	/* Solaris  *//**< Internal. */
-#define I_STRFTZERO		(__SID |45)	/* Solaris  *//**< Internal. */
+/* Solaris I_STRFT (40) through I_STRFTZERO (45) collide with I_GETMSG through I_FIFO: see below. */
 #define _I_MUXID2FD		(__SID |46)	/* Solaris  *//**< Internal. */
 #define _I_INSERT		(__SID |47)	/* Solaris  *//**< Internal. */
 #define _I_REMOVE		(__SID |48)	/* Solaris  *//**< Internal. */
@@ -278,6 +273,27 @@ typedef unsigned long int t_uscalar_t;
 #define I_GET_LOWAT		(__SID | 98)	/* HPUX     *//**< */
 /** @} */
 
+/**
+  * @name Linux Fast-STREAMS specific Input-Output Controls
+  *
+  * Memory-mapped message ring Stream head (see struct strring) and multiple
+  * message getpmsg()/putpmsg() emulation (see struct strmsgv).  Solaris style
+  * STREAMS flow trace (see struct strftbuf), renumbered because the Solaris
+  * numbers are used by the HP-UX/OSF system call emulation controls.
+  *
+  * @{ */
+#define I_RINGSETUP		(__SID |100)	/* LfS      *//**< Allocate rings for mmap(2). */
+#define I_RINGSYNC		(__SID |101)	/* LfS      *//**< Exchange messages with the rings. */
+#define I_GETMSGV		(__SID |102)	/* LfS      *//**< getpmsg() of several messages. */
+#define I_PUTMSGV		(__SID |103)	/* LfS      *//**< putpmsg() of several messages. */
+#define I_STRFT			(__SID |104)	/* LfS      *//**< Test if flow trace is on. */
+#define I_STRFTON		(__SID |105)	/* LfS      *//**< Turn flow trace on. */
+#define I_STRFTOFF		(__SID |106)	/* LfS      *//**< Turn flow trace off. */
+#define I_STRFTSTR		(__SID |107)	/* LfS      *//**< Get flow trace events for Stream. */
+#define I_STRFTALL		(__SID |108)	/* LfS      *//**< Get flow trace events for all Streams. */
+#define I_STRFTZERO		(__SID |109)	/* LfS      *//**< Discard flow trace events for Stream. */
+/** @} */
+
 /**
   * @name LiS specific Input-Output Controls
   *
@@ -629,6 +645,113 @@ struct strpmsg {
 	int flags;		/**< flagsp or flags argument (long under Mac OT). */
 };
 
+/**
+  * STREAMS multiple message vector element.
+  * For use in the vector of a struct strmsgv.  The message is described as
+  * for #I_GETPMSG or #I_PUTPMSG and the result for the message is returned in
+  * mm_status: the non-negative return value of getpmsg() or putpmsg() for
+  * the message, or a negative error number.
+  */
+struct strmmsg {
+	struct strpmsg mm_msg;	/**< Message arguments. */
+	int mm_status;		/**< Per-message result. */
+};
+
+/**
+  * STREAMS multiple message structure.
+  * For use as the argument to the #I_GETMSGV or #I_PUTMSGV input-output control
+  * commands, which retrieve or send up to sv_vlen messages in one call.
+  */
+struct strmsgv {
+	struct strmmsg *sv_msgv;	/**< Vector of messages. */
+	int sv_vlen;		/**< Number of elements in the vector. */
+};
+
+/**
+  * @name STREAMS flow trace events
+  * Values for fe_evnt in struct strftevnt.  FTEV_READ is or'ed in for events on
+  * a read queue.
+  * @{ */
+#define FTEV_PUT	0x0001	/**< Message passed to put procedure by put(9) or putnext(9). */
+#define FTEV_PUTQ	0x0002	/**< Message placed on queue by putq(9). */
+#define FTEV_GETQ	0x0003	/**< Message taken from queue by getq(9). */
+#define FTEV_SRVP	0x0004	/**< Service procedure invoked (fe_msgid is zero). */
+#define FTEV_MASK	0x00ff	/**< Mask for event type. */
+#define FTEV_READ	0x8000	/**< Event occured on a read queue. */
+/** @} */
+
+/**
+  * STREAMS flow trace event.
+  * The message trace identifier, fe_msgid, is derived from the address of the
+  * message and so is constant while the message exists.  The events for one
+  * message, taken in order of fe_ts, show the time at which the message reached
+  * each module.
+  */
+struct strftevnt {
+	unsigned long long fe_ts;	/**< Time of event in nanoseconds. */
+	unsigned int fe_dev;	/**< Device number of the Stream. */
+	unsigned int fe_msgid;	/**< Message trace identifier. */
+	unsigned short fe_mid;	/**< Module id of the queue (mi_idnum). */
+	unsigned short fe_evnt;	/**< Event type (FTEV_*). */
+	unsigned int fe_count;	/**< Queue count (q_count) after the event. */
+};
+
+/**
+  * STREAMS flow trace buffer.
+  * For use as the argument to the #I_STRFTSTR and #I_STRFTALL input-output
+  * control commands.  The caller sets fb_count to the number of elements in
+  * fb_evnt; on return fb_count is the number of events copied, oldest first, and
+  * fb_lost is the number of events overwritten since the last fetch.
+  */
+struct strftbuf {
+	int fb_count;		/**< Number of events (in and out). */
+	int fb_lost;		/**< Events lost to overwrite. */
+	struct strftevnt fb_evnt[1];	/**< Events (actually fb_count of them). */
+};
+
+/**
+  * STREAMS message ring request structure.
+  * For use as the argument to the #I_RINGSETUP input-output control command.
+  * Both rings have the same number of slots of the same size.
+  */
+struct strringreq {
+	int rr_slots;		/**< Number of slots per ring (power of 2). */
+	int rr_slotsize;	/**< Size of each slot including struct strslot. */
+};
+
+#define STRRING_MAXSIZE	(4 << 20)	/**< Maximum bytes per ring (slots * slotsize). */
+
+/**
+  * STREAMS message ring control structure.
+  * The page at offset zero of the mapping contains two of these: the receive
+  * ring (messages read from the Stream) followed by the transmit ring (messages
+  * to be written to the Stream).  Indices run freely and the slot for an index
+  * is the index modulo sr_slots.  The producer fills the slot at sr_head and
+  * then advances sr_head; the consumer empties the slot at sr_tail and then
+  * advances sr_tail.  The ring is empty when sr_head equals sr_tail.
+  */
+struct strring {
+	volatile unsigned int sr_head;	/**< Producer index. */
+	volatile unsigned int sr_tail;	/**< Consumer index. */
+	unsigned int sr_slots;		/**< Number of slots. */
+	unsigned int sr_slotsize;	/**< Size of each slot. */
+	unsigned int sr_offset;		/**< Offset of slot zero in the mapping. */
+	unsigned int sr_pad[11];	/**< Pad to 64 bytes. */
+};
+
+/**
+  * STREAMS message ring slot header.
+  * Each slot starts with this header, followed by ss_ctllen bytes of control
+  * part and then ss_datlen bytes of data part.  A length of -1 means the part
+  * is absent, as for struct strbuf.
+  */
+struct strslot {
+	int ss_flags;		/**< MSG_HIPRI or MSG_BAND. */
+	int ss_band;		/**< Priority band. */
+	int ss_ctllen;		/**< Length of control part. */
+	int ss_datlen;		/**< Length of data part. */
+};
+
 #if 0
 /* this approach might be better (not)! */
 struct strgetpmsg {
@@ -117,4 +117,14 @@ struct strpmsg32 {
 	int32_t flags;			/* actually long for Mac OT */
 };
 
+struct strmmsg32 {
+	struct strpmsg32 mm_msg;
+	int32_t mm_status;
+};
+
+struct strmsgv32 {
+	uint32_t sv_msgv;
+	int32_t sv_vlen;
+};
+
 #endif				/* __SYS_OPENSS7_STROPTS32_H__ */
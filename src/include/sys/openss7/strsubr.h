@@ -133,6 +133,8 @@ struct strevent {
 			void streamscall (*func) (long);
 			long arg;
 			size_t size;
+			int priority;	/* buffer priority (BPRI_LO, BPRI_MED, BPRI_HI) */
+			unsigned long armed;	/* time armed in jiffies */
 		} b;			/* bufcall event */
 		struct {
 			queue_t *queue;
@@ -141,7 +143,10 @@ struct strevent {
 			caddr_t arg;
 			int pl;
 			int cpu;
-			struct timer_list timer;
+			unsigned long expires;	/* expiry time in jiffies */
+			struct strevent *tw_next;	/* timer wheel slot list */
+			struct strevent **tw_prev;	/* timer wheel slot list */
+			int tw_slot;	/* timer wheel slot index */
 		} t;			/* timeout event */
 		struct {
 			queue_t *queue;
@@ -186,6 +191,8 @@ typedef struct syncq {
 	spinlock_t sq_lock;		/* spin lock for this structure */
 	int sq_count;			/* no of threads inside (negative for exclusive) */
 	struct task_struct *sq_owner;	/* exclusive owner */
+	int *sq_readers;		/* per-cpu counts of threads inside shared */
+	int sq_xwant;			/* exclusive held or wanted: shared entry takes lock */
 #if 0
 	int sq_nest;			/* lock nesting */
 #endif
@@ -275,6 +282,7 @@ struct stdata {
 	int sd_nstrpush;		/* cached sysctl_str_nstrpush */
 	int sd_pushcnt;			/* number of modules pushed */
 	int sd_nanchor;			/* number of modules anchored */
+	int sd_node;			/* NUMA node for write side allocations (-1 for none) */
 	unsigned long sd_sigflags;	/* signal flags */
 	struct strevent *sd_siglist;	/* list of procs for SIGPOLL */
 	struct fasync_struct *sd_fasync;	/* list of procs for SIGIO */
@@ -300,6 +308,7 @@ struct stdata {
 	struct stdata *sd_link_next;	/* next linked stream */
 	struct linkblk *sd_linkblk;	/* link block for this stream */
 	struct wantio *sd_directio;	/* direct io for this stream head */
+	struct strmring *sd_mring;	/* memory-mapped message rings */
 };
 
 typedef struct stdata stdata_t;
@@ -351,6 +360,7 @@ enum {
 	STRCSUM_BIT,
 	STRCRC32C_BIT,
 	STRSKBUFF_BIT,
+	STRFTRACE_BIT,
 };
 
 #define IOCWAIT	    (1<<IOCWAIT_BIT)	/* ioctl in progress */
@@ -377,6 +387,7 @@ enum {
 #define STRCSUM	    (1<<STRCSUM_BIT)	/* checksum on copyin for write (UDP/TCP) */
 #define STRCRC32C   (1<<STRCRC32C_BIT)	/* checksum on copyin for write (CRC32C) */
 #define STRSKBUFF   (1<<STRSKBUFF_BIT)	/* allocated sk_buffs for data at stream head */
+#define STRFTRACE   (1<<STRFTRACE_BIT)	/* flow trace on (I_STRFTON) */
 
 /* unfortunately AIX appears to mix read and write option flags with stream head flags */
 #if 0				/* AIX compatible flags */
@@ -427,6 +438,19 @@ struct strinfo {
 
 extern struct strinfo Strinfo[];
 
+#define STRBUF_CLASSES	7		/* data buffer size classes: 64 128 272 512 1024 2048 4096 */
+#define STRBUF_MAXSIZE	4096		/* largest data buffer size class */
+#define STRBUF_MAGSIZE	32		/* per-cpu data buffers cached per size class */
+#define STRNUMA_BATCH	32		/* remote node mdbblocks freed per batch */
+
+/* bufcall waiters are listed by size class (fast buffer, data buffer classes, larger) and priority */
+#define STRBC_CLASSES	(STRBUF_CLASSES + 2)
+#define STRBC_BANDS	3		/* BPRI_HI, BPRI_MED, BPRI_LO */
+#define STRBC_LISTS	(STRBC_CLASSES * STRBC_BANDS)
+#define STRBC_STARVE	(HZ)		/* bufcall waiter run regardless of frees after waiting */
+
+extern struct strinfo Strbufinfo[];
+
 enum {
 	DYN_STREAM,			/* struct shinfo */
 	DYN_QUEUE,			/* struct queinfo */
@@ -444,6 +468,29 @@ enum {
 	DYN_SIZE,			/* size */
 };
 
+#define STEALQ_SIZE	64		/* slots in work-stealing deque (power of 2) */
+
+#define STRWHEEL_L0_BITS	8	/* bits resolved by the first wheel level */
+#define STRWHEEL_LN_BITS	6	/* bits resolved by each further wheel level */
+#define STRWHEEL_LEVELS		4	/* levels in the timer wheel */
+#define STRWHEEL_L0_SIZE	(1 << STRWHEEL_L0_BITS)
+#define STRWHEEL_LN_SIZE	(1 << STRWHEEL_LN_BITS)
+#define STRWHEEL_L0_MASK	(STRWHEEL_L0_SIZE - 1)
+#define STRWHEEL_LN_MASK	(STRWHEEL_LN_SIZE - 1)
+#define STRWHEEL_SLOTS		(STRWHEEL_L0_SIZE + (STRWHEEL_LEVELS - 1) * STRWHEEL_LN_SIZE)
+
+struct strwheel {
+	spinlock_t lock;		/* wheel lock */
+	int cpu;			/* cpu owning the wheel */
+	unsigned long clock;		/* next tick to process */
+	unsigned long count;		/* timeout events on the wheel */
+	unsigned long expired;		/* timeout events expired */
+	unsigned long batches;		/* expiry batches */
+	struct timer_list timer;	/* kernel timer driving the wheel */
+	unsigned long map[STRWHEEL_L0_SIZE / BITS_PER_LONG];	/* occupied first level slots */
+	struct strevent *slot[STRWHEEL_SLOTS];	/* slot lists */
+};
+
 struct strthread {
 	volatile unsigned long flags;	/* flags */
 	struct task_struct *proc;	/* task */
@@ -452,9 +499,18 @@ struct strthread {
 	mblk_t *freemblk_head;		/* head of free mdbblocks cached */
 	mblk_t **freemblk_tail;		/* tail of free mdbblocks cached */
 	int freemblks;			/* number of mblks on the free list */
+	mblk_t *freeremote_head;	/* head of free mdbblocks homed on other nodes */
+	mblk_t **freeremote_tail;	/* tail of free mdbblocks homed on other nodes */
+	int freeremotes;		/* number of mblks on the remote free list */
 #endif
+	unsigned char *bufmag_head[STRBUF_CLASSES];	/* heads of free data buffers cached */
+	int bufmags[STRBUF_CLASSES];	/* number of data buffers cached per class */
 	queue_t *qhead;			/* first queue in scheduled queues */
 	queue_t **qtail;		/* last queue in scheduled queues */
+	atomic_t stealq_top;		/* work-stealing deque take index */
+	atomic_t stealq_bot;		/* work-stealing deque push index */
+	queue_t *stealq[STEALQ_SIZE];	/* work-stealing deque of scheduled queues */
+	struct strwheel *wheel;		/* timeout timer wheel */
 #if defined CONFIG_STREAMS_SYNCQS
 	struct syncq_cookie *syncq_cookie;	/* open/close syncrhonization queue cookie */
 	syncq_t *sqhead;		/* first syncq in scheduled syncqs */
@@ -464,8 +520,10 @@ struct strthread {
 #endif
 	struct strevent *freeevnt_head;	/* head of free stream events cached */
 	struct strevent **freeevnt_tail;	/* tail of free stream events cached */
-	struct strevent *strbcalls_head;	/* head of bufcalls pending exec */
-	struct strevent **strbcalls_tail;	/* tail of bufcalls pending exec */
+	struct strevent *strbcalls_head[STRBC_LISTS];	/* heads of bufcalls by class and priority */
+	struct strevent **strbcalls_tail[STRBC_LISTS];	/* tails of bufcalls by class and priority */
+	atomic_t strbcredit[STRBC_CLASSES];	/* buffers freed per class for waiting bufcalls */
+	int strbcactive;		/* running a buffer callback */
 	struct strevent *strtimout_head;	/* head of timeouts pending exec */
 	struct strevent **strtimout_tail;	/* tail of timeouts pending exec */
 	struct strevent *strevents_head;	/* head of strevent pending exec */
@@ -474,6 +532,16 @@ struct strthread {
 	queue_t **scanqtail;		/* tail of STREAMS scan queue */
 	mblk_t *freemsg_head;		/* head of flushed messages to free */
 	mblk_t **freemsg_tail;		/* tail of flushed messages to free */
+	unsigned long runq_passes;	/* scheduler passes */
+	unsigned long runq_overruns;	/* passes that exceeded the time budget */
+	unsigned long runq_leftover;	/* queues left over by budgeted passes */
+	unsigned long runq_handoffs;	/* backlogs handed from softirq to kstreamd */
+	unsigned long runq_busy;	/* consecutive passes that left a backlog */
+	unsigned long bc_wakeups;	/* bufcalls run for a freed buffer */
+	unsigned long bc_retries;	/* bufcalls armed again from a buffer callback */
+	unsigned long bc_starved;	/* bufcalls run after waiting STRBC_STARVE */
+	unsigned long long runq_nsecs;	/* total time in scheduler passes (ns) */
+	unsigned long long runq_maxns;	/* longest scheduler pass (ns) */
 } __attribute__ ((__aligned__(SMP_CACHE_BYTES)));
 
 #ifndef BIG_COMPILE
@@ -496,6 +564,7 @@ enum {
 	strmfuncs,			/* m_func's can be run */
 	qsyncflag,			/* at least 1 syncq to run */
 	qwantrun,			/* runqueues() wanted to run */
+	qstealflag,			/* steal queues from busy threads */
 };
 
 #define QRUNFLAG	(1 << qrunflag	)	/* 0x00000001 */
@@ -509,8 +578,29 @@ enum {
 #define STRMFUNCS	(1 << strmfuncs )	/* 0x00000100 */
 #define QSYNCFLAG	(1 << qsyncflag )	/* 0x00000200 */
 #define QWANTRUN	(1 << qwantrun  )	/* 0x00000400 */
+#define QSTEALFLAG	(1 << qstealflag)	/* 0x00000800 */
+
+#define QRUNFLAGS	(QRUNFLAG|STRMFUNCS|STRBCFLAG|FLUSHWORK|FREEBLKS|STRTIMOUT|SCANQFLAG|STREVENTS|QSTEALFLAG)
+
+/* log2 histograms for a queue pair (sys.streams.qhist), bucket b counts values in [2^(b-1),2^b) */
+#define QH_BUCKETS 32
+
+struct qhbuckets {
+	unsigned long qh_delay[QH_BUCKETS];	/* queue enabled to service procedure (nsec) */
+	unsigned long qh_runtime[QH_BUCKETS];	/* service procedure runtime (nsec) */
+	unsigned long qh_depth[QH_BUCKETS];	/* q_count on entry to put procedure (bytes) */
+};
+
+struct qhcpu {
+	struct qhbuckets qh_side[2];	/* read side [0] and write side [1] */
+};
 
-#define QRUNFLAGS	(QRUNFLAG|STRMFUNCS|STRBCFLAG|FLUSHWORK|FREEBLKS|STRTIMOUT|SCANQFLAG|STREVENTS)
+struct qhist {
+	struct list_head qh_list;	/* list of all queue pair histograms */
+	queue_t *qh_rq;			/* read queue of queue pair */
+	unsigned long long qh_enabled[2];	/* time (nsec) each side was last enabled */
+	struct qhcpu *qh_cpu;		/* per-cpu buckets (alloc_percpu) */
+};
 
 struct queinfo {
 	queue_t rq;			/* read queue */
@@ -518,6 +608,7 @@ struct queinfo {
 	struct stdata *qu_str;		/* stream head for this queue pair */
 	wait_queue_head_t qu_qwait;	/* wait queue for qwait */
 	atomic_t qu_refs;		/* references to this structure */
+	struct qhist *qu_hist;		/* histograms or NULL */
 #if defined CONFIG_STREAMS_DEBUG
 	struct list_head qu_list;
 #endif
@@ -553,7 +644,11 @@ struct mbinfo {
 	mblk_t m_mblock;
 	void (*m_func) (void);		/* allocating function SVR4 compatible */
 	queue_t *m_queue;		/* last queue for this block */
-	void *m_private;		/* private information for deferral */
+	/* a message is never deferred on a syncq and on a queue at the same time */
+	union {
+		void *m_private;	/* private information for deferral */
+		unsigned long m_tstamp;	/* time queued (1024 nsec units) for sojourn flow control */
+	};
 #if defined CONFIG_STREAMS_DEBUG
 	struct list_head m_list;
 #endif
@@ -597,6 +692,16 @@ struct qbinfo {
 #endif
 };
 
+/* number of q_bandv entries allocated for a queue with nband bands (index 0 unused) */
+static inline int
+qbandv_size(int nband)
+{
+	int size;
+
+	for (size = 8; size <= nband; size <<= 1) ;
+	return (size);
+}
+
 struct apinfo {
 	struct strapush api_sap;
 	struct list_head api_more;
@@ -657,10 +762,14 @@ __STREAMS_EXTERN bcid_t __bufcall(queue_t *q, unsigned size, int priority,
 				  void streamscall (*function) (long), long arg);
 __STREAMS_EXTERN toid_t __timeout(queue_t *q, timo_fcn_t *timo_fcn, caddr_t arg, long ticks,
 				  unsigned long pl, int cpu);
+__STREAMS_EXTERN toid_t __retimeout(toid_t toid, long ticks);
 
 __STREAMS_EXTERN int setsq(queue_t *q, struct fmodsw *fmod);
 __STREAMS_EXTERN void qscan(queue_t *q);
 
+/* from strutil.c */
+__STREAMS_EXTERN mblk_t *allocb_node(size_t size, uint priority, int node);
+
 /* from strlookup.c */
 extern struct list_head cdevsw_list;	/* Drivers go here */
 extern struct list_head fmodsw_list;	/* Modules go here */
@@ -369,12 +369,19 @@ bufq_freehead(bufq_t * q)
 static __inline__ streamscall void
 bufq_purge(bufq_t * q)
 {
+	mblk_t *mp;
 	psw_t pl;
 
 	pl = bufq_lock(q);
-	while (q->q_head)
-		freemsg(__bufq_dequeue(q));
+	mp = q->q_head;
+	q->q_head = NULL;
+	q->q_tail = NULL;
+	q->q_msgs = 0;
+	q->q_count = 0;
 	bufq_unlock(q, pl);
+	/* free the whole list at once, outside the lock */
+	if (mp != NULL)
+		freemsgchain(mp);
 }
 
 __OS7_EXTERN_INLINE void
@@ -65,9 +65,11 @@ static char const ident[] = "src/kernel/mpscompat.c (" PACKAGE_ENVR ") " PACKAGE
 #define _MPS_SOURCE
 
 #include "sys/os7/compat.h"
+#include <sys/strsubr.h>	/* for __retimeout */
 
 #include <linux/types.h>	/* for ptrdiff_t */
 #include <linux/ctype.h>	/* for isdigit */
+#include <linux/idr.h>		/* for idr_alloc */
 #include <asm/div64.h>		/* for do_div */
 
 #define MPSCOMP_DESCRIP		"Mentat Portable STREAMS Compatibility for Linux Fast-STREAMS"
@@ -162,6 +164,7 @@ struct mi_comm {
 	struct mi_comm **mi_prev;	/* must be first */
 	struct mi_comm **mi_head;
 	struct mi_comm *mi_next;
+	dev_t mi_key;			/* device number on head list (sort and IDR key) */
 	size_t mi_size;			/* size of this structure plus private data */
 	unsigned short mi_mid;		/* module identifier */
 	unsigned short mi_sid;		/* stream identifier */
@@ -512,6 +515,114 @@ static spinlock_t mi_list_lock = SPIN_LOCK_UNLOCKED;
 #error cannot initialize spin locks
 #endif
 
+/*
+ * The head list is a single static pointer supplied by the caller, so per-head state is kept in a
+ * small hash of head information structures keyed by the address of the head.  mi_list_lock now
+ * only protects the hash; each head list is protected by its own lock.  An entry is never freed:
+ * when a module is unloaded its (empty) entry is harmlessly reused by any head later found at the
+ * same address.
+ *
+ * The list is kept sorted by device number (mi_key, as mi_dev can be overwritten by the user of the
+ * union).  Where the kernel has an IDR, the IDR maps each device number on the list to its element,
+ * so that the lowest free minor at or above the requested one, and the element before which to
+ * insert, are found without walking the list.  Device numbers from makedevice() are 32 bits with a
+ * major number below 4096, so they are always valid (non-negative) IDR identifiers.
+ */
+#if defined HAVE_KFUNC_IDR_ALLOC && defined HAVE_KFUNC_IDR_GET_NEXT && defined HAVE_KFUNC_IDR_PRELOAD
+#define MI_USE_IDR 1
+#endif
+
+#define MI_HEAD_HASH_SIZE 64
+
+struct mi_head {
+	struct mi_head *hi_next;	/* hash chain */
+	caddr_t *hi_head;		/* head list */
+	spinlock_t hi_lock;		/* head list lock */
+	struct mi_comm **hi_tail;	/* last mi_next pointer (or head) on list */
+#ifdef MI_USE_IDR
+	struct idr hi_idr;		/* device number to element */
+#endif
+};
+
+static struct mi_head *mi_head_hash[MI_HEAD_HASH_SIZE];
+
+#define mi_head_hashval(head) ((((unsigned long) (head)) >> 3) & (MI_HEAD_HASH_SIZE - 1))
+
+static inline struct mi_head *
+__mi_head_find(caddr_t *mi_head)
+{
+	struct mi_head *hi;
+
+	for (hi = mi_head_hash[mi_head_hashval(mi_head)]; hi && hi->hi_head != mi_head;
+	     hi = hi->hi_next) ;
+	return (hi);
+}
+
+static struct mi_head *
+mi_head_find(caddr_t *mi_head)
+{
+	struct mi_head *hi;
+
+	spin_lock(&mi_list_lock);
+	hi = __mi_head_find(mi_head);
+	spin_unlock(&mi_list_lock);
+	return (hi);
+}
+
+/**
+ * mi_head_get: - find or create the head information for a head list
+ * @mi_head: head list
+ */
+static struct mi_head *
+mi_head_get(caddr_t *mi_head)
+{
+	struct mi_head *hi, *hn;
+
+	if (likely((hi = mi_head_find(mi_head)) != NULL))
+		return (hi);
+	if ((hn = kmem_zalloc(sizeof(*hn), KM_SLEEP)) == NULL)
+		return (NULL);
+	hn->hi_head = mi_head;
+	spin_lock_init(&hn->hi_lock);
+#ifdef MI_USE_IDR
+	idr_init(&hn->hi_idr);
+#endif
+	spin_lock(&mi_list_lock);
+	if ((hi = __mi_head_find(mi_head)) == NULL) {
+		hi = hn;
+		hn = NULL;
+		hi->hi_tail = (struct mi_comm **) mi_head;
+		hi->hi_next = mi_head_hash[mi_head_hashval(mi_head)];
+		mi_head_hash[mi_head_hashval(mi_head)] = hi;
+	}
+	spin_unlock(&mi_list_lock);
+	if (hn != NULL) {
+#ifdef MI_USE_IDR
+		idr_destroy(&hn->hi_idr);
+#endif
+		kmem_free(hn, sizeof(*hn));
+	}
+	return (hi);
+}
+
+/**
+ * __mi_link_before: - link an element into a head list before another
+ * @hi: head information
+ * @mi: element to link
+ * @next: element before which to link, or NULL to link at the tail
+ */
+static inline void
+__mi_link_before(struct mi_head *hi, struct mi_comm *mi, struct mi_comm *next)
+{
+	struct mi_comm **mip = next ? next->mi_prev : hi->hi_tail;
+
+	if ((mi->mi_next = next))
+		next->mi_prev = &mi->mi_next;
+	else
+		hi->hi_tail = &mi->mi_next;
+	mi->mi_prev = mip;
+	*mip = mi;
+}
 
 /**
  * mi_open_link: - link a private structure into head list
@@ -521,13 +632,20 @@ static spinlock_t mi_list_lock = SPIN_LOCK_UNLOCKED;
  * @flag: open flags from qi_qopen()
  * @sflag: STREAMS flag from qi_qopen()
  * @credp: credentials pointer from qi_qopen()
+ *
+ * The list is sorted by device number (major, then minor).  A driver open (DRVOPEN) fails with
+ * ENXIO when the device number is already on the list.  A clone or module open takes the lowest
+ * free minor number at or above the requested one within the major, failing with EAGAIN when none
+ * is left.
  */
 __MPS_EXTERN int
 mi_open_link(caddr_t *mi_head, caddr_t ptr, dev_t *devp, int flag, int sflag, cred_t *credp)
 {
-	struct mi_comm *mi, **mip;
+	struct mi_comm *mi, *next;
+	struct mi_head *hi;
 	major_t cmajor = devp ? getmajor(*devp) : 0;
 	minor_t cminor = devp ? getminor(*devp) : 0;
+	dev_t dev, last;
 
 	if (mi_head == NULL || (mi = ptr_to_mi(ptr)) == NULL)
 		return (EINVAL);
@@ -555,47 +673,61 @@ mi_open_link(caddr_t *mi_head, caddr_t ptr, dev_t *devp, int flag, int sflag, cr
 		/* invalid sflag */
 		return (EINVAL);
 	}
+	dev = makedevice(cmajor, cminor);
+	last = (sflag == DRVOPEN) ? dev : makedevice(cmajor, getminor((dev_t) -1));
+
+	if ((hi = mi_head_get(mi_head)) == NULL)
+		return (ENOMEM);
 
 	mi_grab(mi);
-	spin_lock(&mi_list_lock);
-	for (mip = (struct mi_comm **) mi_head; *mip; mip = &(*mip)->mi_next) {
-		if (cmajor != (*mip)->mi_mid)
-			break;
-		if (cmajor == (*mip)->mi_mid) {
-			if (cminor < (*mip)->mi_sid)
-				break;
-			if (cminor > (*mip)->mi_sid)
-				continue;
-			if (cminor == (*mip)->mi_sid) {
-				if (sflag == DRVOPEN) {
-					/* conflicting device number */
-					spin_unlock(&mi_list_lock);
-					mi_put(mi);
-					return (ENXIO);
-				}
-				if (getminor(makedevice(0, ++cminor)) == 0) {
-					/* no minor device numbers left */
-					spin_unlock(&mi_list_lock);
-					mi_put(mi);
-					return (EAGAIN);
-				}
-				continue;
-			}
+#ifdef MI_USE_IDR
+	{
+		int id, nid;
+
+		idr_preload(GFP_KERNEL);
+		spin_lock(&hi->hi_lock);
+		id = idr_alloc(&hi->hi_idr, mi, (int) dev, (int) last + 1, GFP_NOWAIT);
+		if (id >= 0) {
+			dev = id;
+			nid = id + 1;
+			next = idr_get_next(&hi->hi_idr, &nid);
+		}
+		if (id < 0) {
+			spin_unlock(&hi->hi_lock);
+			idr_preload_end();
+			mi_put(mi);
+			if (id == -ENOMEM)
+				return (ENOMEM);
+			/* conflicting device number, or no minor device numbers left */
+			return ((sflag == DRVOPEN) ? ENXIO : EAGAIN);
 		}
 	}
-
-	mi->mi_dev = makedevice(cmajor, cminor);
-	mi->mi_mid = cmajor;
-	mi->mi_sid = cminor;
-	if ((mi->mi_next = *mip))
-		mi->mi_next->mi_prev = &mi;
-	mi->mi_prev = mip;
-	*mip = mi;
+#else				/* MI_USE_IDR */
+	spin_lock(&hi->hi_lock);
+	for (next = *(struct mi_comm **) mi_head; next && next->mi_key < dev; next = next->mi_next) ;
+	for (; next && next->mi_key == dev; next = next->mi_next) {
+		if (dev == last) {
+			spin_unlock(&hi->hi_lock);
+			mi_put(mi);
+			/* conflicting device number, or no minor device numbers left */
+			return ((sflag == DRVOPEN) ? ENXIO : EAGAIN);
+		}
+		dev++;
+	}
+#endif				/* MI_USE_IDR */
+	mi->mi_key = dev;
+	mi->mi_dev = dev;
+	mi->mi_mid = getmajor(dev);
+	mi->mi_sid = getminor(dev);
 	mi->mi_head = (struct mi_comm **) mi_head;
-	spin_unlock(&mi_list_lock);
+	__mi_link_before(hi, mi, next);
+	spin_unlock(&hi->hi_lock);
+#ifdef MI_USE_IDR
+	idr_preload_end();
+#endif
 	if (sflag == CLONEOPEN)
 		/* must return unique device number */
-		*devp = makedevice(cmajor, cminor);
+		*devp = dev;
 	return (0);
 }
 
@@ -658,13 +790,24 @@ mi_close_unlink(caddr_t *mi_head, caddr_t ptr)
 	struct mi_comm *mi = ptr_to_mi(ptr);
 
 	if (mi) {
-		spin_lock(&mi_list_lock);
-		if ((*mi->mi_prev = mi->mi_next))
-			mi->mi_next->mi_prev = mi->mi_prev;
-		mi->mi_next = NULL;
-		mi->mi_prev = &mi->mi_next;
-		mi->mi_head = NULL;
-		spin_unlock(&mi_list_lock);
+		struct mi_head *hi;
+
+		/* an unlinked structure has mi_head NULL or pointing to itself */
+		if (mi->mi_head != NULL && mi->mi_head != &mi->mi_next
+		    && (hi = mi_head_find((caddr_t *) mi->mi_head)) != NULL) {
+			spin_lock(&hi->hi_lock);
+#ifdef MI_USE_IDR
+			idr_remove(&hi->hi_idr, (int) mi->mi_key);
+#endif
+			if (hi->hi_tail == &mi->mi_next)
+				hi->hi_tail = mi->mi_prev;
+			if ((*mi->mi_prev = mi->mi_next))
+				mi->mi_next->mi_prev = mi->mi_prev;
+			mi->mi_next = NULL;
+			mi->mi_prev = &mi->mi_next;
+			mi->mi_head = NULL;
+			spin_unlock(&hi->hi_lock);
+		}
 		mi_put(mi);
 	}
 }
@@ -2035,6 +2178,19 @@ mi_timer_ticks(mblk_t *mp, clock_t ticks)
 	unsigned long flags;
 	toid_t tid;
 
+	if (ticks > 0) {
+		/* Re-arming a running timer is the common case: move it on the timer wheel in place
+		   rather than cancelling and reallocating the timeout. */
+		spin_lock_irqsave(&tb->tb_lock, flags);
+		if (tb->tb_state == TB_ACTIVE && tb->tb_tid != (toid_t) 0
+		    && __retimeout(tb->tb_tid, ticks) != (toid_t) 0) {
+			tb->tb_time = jiffies + ticks;
+			spin_unlock_irqrestore(&tb->tb_lock, flags);
+			return;
+		}
+		spin_unlock_irqrestore(&tb->tb_lock, flags);
+	}
+
 	if ((tid = xchg(&tb->tb_tid, 0)))
 		untimeout(tid);
 
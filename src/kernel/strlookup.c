@@ -66,6 +66,8 @@ static char const ident[] = "src/kernel/strlookup.c (" PACKAGE_ENVR ") " PACKAGE
 #include <linux/poll.h>
 #include <linux/fs.h>
 #include <linux/mount.h>	/* for vfsmount stuff */
+#include <linux/rcupdate.h>	/* for rcu_read_lock */
+#include <linux/seqlock.h>	/* for seqcount_t */
 #ifdef HAVE_KINC_LINUX_HARDIRQ_H
 #include <linux/hardirq.h>	/* for in_irq() and friends */
 #endif
@@ -98,6 +100,10 @@ static char const ident[] = "src/kernel/strlookup.c (" PACKAGE_ENVR ") " PACKAGE
 #include "src/kernel/strspecfs.h"	/* for spec_snode */
 #include "src/kernel/strlookup.h"	/* extern verification */
 
+#ifndef HAVE_KFUNC_SYNCHRONIZE_RCU
+#define synchronize_rcu() synchronize_kernel()
+#endif
+
 #if defined HAVE_KFUNC_IN_ATOMIC || defined in_atomic
 #define can_sleep() (!in_interrupt()&&!in_atomic())
 #else				/* defined HAVE_KFUNC_IN_ATOMIC || defined in_atomic */
@@ -115,28 +121,42 @@ static char const ident[] = "src/kernel/strlookup.c (" PACKAGE_ENVR ") " PACKAGE
 #undef makedevice
 #define makedevice(__maj,__min) ((((__maj)<<16)&0xffff0000)|(((__min)<<0)&0x0000ffff))
 
-/* these don't need to be so big */
-
-#define STRMOD_HASH_ORDER 5
-#define STRDEV_HASH_ORDER 5
-#define STRNOD_HASH_ORDER 5
-
-#define STRMOD_HASH_SIZE (1 << STRMOD_HASH_ORDER)
-#define STRDEV_HASH_SIZE (1 << STRDEV_HASH_ORDER)
-#define STRNOD_HASH_SIZE (1 << STRNOD_HASH_ORDER)
-
-#define STRMOD_HASH_MASK ((unsigned long)(STRMOD_HASH_SIZE-1))
-#define STRDEV_HASH_MASK ((unsigned long)(STRDEV_HASH_SIZE-1))
-#define STRNOD_HASH_MASK ((unsigned long)(STRNOD_HASH_SIZE-1))
-
-#define strmod_hash_slot(_modid) \
-	(fmodsw_hash + (((_modid) + ((_modid) >> STRMOD_HASH_ORDER) + ((_modid) >> 2 * STRMOD_HASH_ORDER)) & STRMOD_HASH_MASK))
-
-#define strdev_hash_slot(_major) \
-	(cdevsw_hash + (((_major) + ((_major) >> STRDEV_HASH_ORDER) + ((_major) >> 2 * STRDEV_HASH_ORDER)) & STRDEV_HASH_MASK))
+/*
+ *  The module, driver and node tables are hashed both by number and by name.  Lookups in these
+ *  hashes are performed under rcu_read_lock() rather than the cdevsw_lock or fmodsw_lock, so that
+ *  opens, clone opens, I_PUSH and autopush do not take these locks.  Updaters hold the appropriate
+ *  write lock for the registration lists as before, and also take the per-hash spin lock.  Each
+ *  hash doubles its number of slots when the average chain length exceeds two and halves it when it
+ *  drops below a quarter.  Because entries move between slots when the hash is resized, a lookup
+ *  that misses is retried when the sequence count shows that the hash changed underneath it.
+ *  Chains are NULL terminated hlists so that a lookup that wanders onto another chain during a
+ *  resize still terminates.  Unregistration waits for a grace period before returning, so that a
+ *  lookup never references an entry whose kernel module has gone away.
+ */
 
-#define strnod_hash_slot(_minor) \
-	(cminsw_hash + (((_minor) + ((_minor) >> STRNOD_HASH_ORDER) + ((_minor) >> 2 * STRNOD_HASH_ORDER)) & STRNOD_HASH_MASK))
+#define STRHASH_MIN_ORDER 5
+#define STRHASH_MAX_ORDER 10
+
+struct strhtab {
+	struct rcu_head t_rcu;		/* deferred free */
+	unsigned int t_order;		/* log2 of the number of slots */
+	struct hlist_head t_slot[0];	/* hash slots */
+};
+
+struct strhash {
+	struct strhtab *h_tab;		/* current slots (rcu) */
+	seqcount_t h_seq;		/* changes underneath lookups */
+	spinlock_t h_lock;		/* serializes updaters */
+	unsigned int h_count;		/* number of entries */
+	unsigned long (*h_key) (struct hlist_node *);	/* key of entry for rehashing */
+};
+
+STATIC struct strhash strmod_hash;	/* fmods and cdevs by module id */
+STATIC struct strhash strdev_hash;	/* major devnodes by major */
+STATIC struct strhash strnod_hash;	/* minor devnodes by cdev and minor */
+STATIC struct strhash fmodname_hash;	/* fmods by name */
+STATIC struct strhash cdevname_hash;	/* cdevs by name */
+STATIC struct strhash cminname_hash;	/* minor devnodes by cdev and name */
 
 #if	defined DEFINE_RWLOCK
 DEFINE_RWLOCK(cdevsw_lock);
@@ -172,10 +192,6 @@ EXPORT_SYMBOL_GPL(cminsw_lock);
 EXPORT_SYMBOL_GPL(cminsw_list);
 #endif
 
-struct list_head fmodsw_hash[STRMOD_HASH_SIZE] __cacheline_aligned = { {NULL,}, };
-struct list_head cdevsw_hash[STRDEV_HASH_SIZE] __cacheline_aligned = { {NULL,}, };
-struct list_head cminsw_hash[STRNOD_HASH_SIZE] __cacheline_aligned = { {NULL,}, };
-
 int cdev_count = 0;
 int fmod_count = 0;
 int cmin_count = 0;
@@ -191,42 +207,216 @@ EXPORT_SYMBOL_GPL(cmin_count);
  *
  *  -------------------------------------------------------------------------
  */
+
+static inline unsigned long
+strhash_fold(unsigned long key, unsigned int order)
+{
+	return ((key + (key >> order) + (key >> 2 * order)) & ((1UL << order) - 1));
+}
+
+static inline struct hlist_head *
+strhash_slot(struct strhtab *t, unsigned long key)
+{
+	return (t->t_slot + strhash_fold(key, t->t_order));
+}
+
 /**
- *  init_fmod_hash: - initialize the list_head structures in the fmod hash
+ *  strhash_name: - hash a module, driver or node name
+ *  @name: the name to hash
+ *
+ *  Only the first FMNAMESZ characters are significant, as for the strncmp() in the searches.
  */
-STATIC void
-init_fmod_hash(void)
+static inline unsigned long
+strhash_name(const char *name)
 {
+	unsigned long hash = 0;
 	int i;
 
-	for (i = 0; i < STRMOD_HASH_SIZE; i++)
-		INIT_LIST_HEAD((fmodsw_hash + i));
+	for (i = 0; i < FMNAMESZ && name[i]; i++)
+		hash = (hash << 5) - hash + (unsigned char) name[i];
+	return (hash);
+}
+
+static inline unsigned long
+strhash_cdev(const struct cdevsw *cdev)
+{
+	return ((unsigned long) cdev / sizeof(*cdev));
+}
+
+/*
+ *  Keys of the entries in each hash for rehashing on resize.  Note that the module id hash holds
+ *  both fmodsw and cdevsw structures: f_hash and d_hash, and f_modid and d_modid, are at the same
+ *  offsets in both.
+ */
+STATIC unsigned long
+strmod_key(struct hlist_node *node)
+{
+	return (hlist_entry(node, struct fmodsw, f_hash)->f_modid);
+}
+STATIC unsigned long
+strdev_key(struct hlist_node *node)
+{
+	return (hlist_entry(node, struct devnode, n_hash)->n_major);
+}
+STATIC unsigned long
+strnod_key(struct hlist_node *node)
+{
+	struct devnode *cmin = hlist_entry(node, struct devnode, n_hash);
+
+	return (strhash_cdev(cmin->n_dev) + cmin->n_minor);
+}
+STATIC unsigned long
+fmodname_key(struct hlist_node *node)
+{
+	return (strhash_name(hlist_entry(node, struct fmodsw, f_nhash)->f_name));
+}
+STATIC unsigned long
+cdevname_key(struct hlist_node *node)
+{
+	return (strhash_name(hlist_entry(node, struct cdevsw, d_nhash)->d_name));
+}
+STATIC unsigned long
+cminname_key(struct hlist_node *node)
+{
+	struct devnode *cmin = hlist_entry(node, struct devnode, n_nhash);
+
+	return (strhash_cdev(cmin->n_dev) + strhash_name(cmin->n_name));
+}
+
+STATIC struct strhtab *
+strhash_alloc(unsigned int order, int flags)
+{
+	struct strhtab *t;
+	int i;
+
+	if ((t = kmalloc(sizeof(*t) + (sizeof(struct hlist_head) << order), flags))) {
+		t->t_order = order;
+		for (i = 0; i < (1 << order); i++)
+			INIT_HLIST_HEAD(t->t_slot + i);
+	}
+	return (t);
+}
+
+STATIC void
+strhash_free(struct rcu_head *rcu)
+{
+	kfree(container_of(rcu, struct strhtab, t_rcu));
+}
+
+STATIC int
+strhash_init(struct strhash *h, unsigned long (*key) (struct hlist_node *))
+{
+	if (!(h->h_tab = strhash_alloc(STRHASH_MIN_ORDER, GFP_KERNEL)))
+		return (-ENOMEM);
+	seqcount_init(&h->h_seq);
+	spin_lock_init(&h->h_lock);
+	h->h_count = 0;
+	h->h_key = key;
+	return (0);
+}
+
+STATIC void
+strhash_term(struct strhash *h)
+{
+	kfree(XCHG(&h->h_tab, NULL));
+}
+
+/* like hlist_del_init_rcu(), which is not available on all kernels */
+static inline void
+strhash_unlink(struct hlist_node *node)
+{
+	if (!hlist_unhashed(node)) {
+		__hlist_del(node);
+		node->pprev = NULL;
+	}
 }
 
 /**
- *  init_cdev_hash: - initialize the list_head structures in the cdev hash
+ *  strhash_resize: - move all entries into a hash with a new number of slots
+ *  @h: the hash
+ *  @order: log2 of the new number of slots
+ *
+ *  Locking: called with the hash spin lock held and within the sequence count write section.  When
+ *  the new slots cannot be allocated the hash is simply left as it was.
  */
 STATIC void
-init_cdev_hash(void)
+strhash_resize(struct strhash *h, unsigned int order)
 {
+	struct strhtab *old = h->h_tab, *new;
+	struct hlist_node *node;
 	int i;
 
-	for (i = 0; i < STRDEV_HASH_SIZE; i++)
-		INIT_LIST_HEAD((cdevsw_hash + i));
+	if (!(new = strhash_alloc(order, GFP_ATOMIC)))
+		return;
+	for (i = 0; i < (1 << old->t_order); i++) {
+		while ((node = old->t_slot[i].first)) {
+			strhash_unlink(node);
+			hlist_add_head_rcu(node, strhash_slot(new, h->h_key(node)));
+		}
+	}
+	rcu_assign_pointer(h->h_tab, new);
+	call_rcu(&old->t_rcu, strhash_free);
 }
 
 /**
- *  init_cmin_hash: - initialize the list_head structures in the cmin hash
+ *  strhash_add: - add an entry to a hash
+ *  @h: the hash
+ *  @node: the hash node of the entry, whose key must already be set
  */
 STATIC void
-init_cmin_hash(void)
+strhash_add(struct strhash *h, struct hlist_node *node)
 {
-	int i;
+	struct strhtab *t;
 
-	for (i = 0; i < STRNOD_HASH_SIZE; i++)
-		INIT_LIST_HEAD((cminsw_hash + i));
+	spin_lock(&h->h_lock);
+	write_seqcount_begin(&h->h_seq);
+	t = h->h_tab;
+	hlist_add_head_rcu(node, strhash_slot(t, h->h_key(node)));
+	if (++h->h_count > (2U << t->t_order) && t->t_order < STRHASH_MAX_ORDER)
+		strhash_resize(h, t->t_order + 1);
+	write_seqcount_end(&h->h_seq);
+	spin_unlock(&h->h_lock);
 }
 
+/**
+ *  strhash_del: - remove an entry from a hash
+ *  @h: the hash
+ *  @node: the hash node of the entry
+ *
+ *  The entry cannot be reused or freed until a grace period has elapsed.
+ */
+STATIC void
+strhash_del(struct strhash *h, struct hlist_node *node)
+{
+	struct strhtab *t;
+
+	spin_lock(&h->h_lock);
+	write_seqcount_begin(&h->h_seq);
+	if (!hlist_unhashed(node)) {
+		strhash_unlink(node);
+		t = h->h_tab;
+		if (--h->h_count < (1U << t->t_order) / 4 && t->t_order > STRHASH_MIN_ORDER)
+			strhash_resize(h, t->t_order - 1);
+	}
+	write_seqcount_end(&h->h_seq);
+	spin_unlock(&h->h_lock);
+}
+
+/*
+ *  Lookups walk a chain with strhash_first() and strhash_next() and, when nothing is found, check
+ *  strhash_retry() to see whether the hash changed during the walk.  They must be called within
+ *  rcu_read_lock().
+ */
+static inline struct hlist_node *
+strhash_first(struct strhash *h, unsigned long key, unsigned int *seqp)
+{
+	*seqp = read_seqcount_begin(&h->h_seq);
+	return (rcu_dereference(strhash_slot(rcu_dereference(h->h_tab), key)->first));
+}
+
+#define strhash_next(__node) rcu_dereference((__node)->next)
+#define strhash_retry(__h, __seq) read_seqcount_retry(&(__h)->h_seq, (__seq))
+
 /**
  *  __cmaj_lookup: - look up a cmaj by major device number in cmaj hashes
  *  @major: major device number to look up
@@ -238,21 +428,18 @@ init_cmin_hash(void)
 streams_fastcall struct devnode *
 __cmaj_lookup(major_t major)
 {
-	struct list_head *pos, *slot = strdev_hash_slot(major);
-
-	list_for_each(pos, slot) {
-		struct devnode *cmaj = list_entry(pos, struct devnode, n_hash);
+	struct devnode *cmaj = NULL;
+	struct hlist_node *pos;
+	unsigned int seq;
 
-		if (cmaj->n_major == major) {
-#if 0
-			/* cache to front */
-			list_del_init(&cmaj->n_hash);
-			list_add(&cmaj->n_hash, slot);
-#endif
-			return (cmaj);
-		}
-	}
-	return (NULL);
+	rcu_read_lock();
+	do {
+		for (pos = strhash_first(&strdev_hash, major, &seq); pos; pos = strhash_next(pos))
+			if ((cmaj = hlist_entry(pos, struct devnode, n_hash))->n_major == major)
+				break;
+	} while (!pos && strhash_retry(&strdev_hash, seq));
+	rcu_read_unlock();
+	return (pos ? cmaj : NULL);
 }
 
 EXPORT_SYMBOL_GPL(__cmaj_lookup);
@@ -288,21 +475,18 @@ EXPORT_SYMBOL_GPL(__cdev_lookup);
 streams_fastcall struct cdevsw *
 __cdrv_lookup(modID_t modid)
 {
-	struct list_head *pos, *slot = strmod_hash_slot(modid);
-
-	list_for_each(pos, slot) {
-		struct cdevsw *cdev = list_entry(pos, struct cdevsw, d_hash);
+	struct cdevsw *cdev = NULL;
+	struct hlist_node *pos;
+	unsigned int seq;
 
-		if (cdev->d_modid == modid) {
-#if 0
-			/* cache to front */
-			list_del_init(&cdev->d_hash);
-			list_add(&cdev->d_hash, slot);
-#endif
-			return (cdev);
-		}
-	}
-	return (NULL);
+	rcu_read_lock();
+	do {
+		for (pos = strhash_first(&strmod_hash, modid, &seq); pos; pos = strhash_next(pos))
+			if ((cdev = hlist_entry(pos, struct cdevsw, d_hash))->d_modid == modid)
+				break;
+	} while (!pos && strhash_retry(&strmod_hash, seq));
+	rcu_read_unlock();
+	return (pos ? cdev : NULL);
 }
 
 EXPORT_SYMBOL_GPL(__cdrv_lookup);
@@ -315,21 +499,21 @@ EXPORT_SYMBOL_GPL(__cdrv_lookup);
 streams_fastcall struct devnode *
 __cmin_lookup(struct cdevsw *cdev, minor_t minor)
 {
-	struct list_head *pos, *slot = strnod_hash_slot(minor);
-
-	list_for_each(pos, slot) {
-		struct devnode *cmin = list_entry(pos, struct devnode, n_hash);
-
-		if (cmin->n_dev == cdev && cmin->n_minor == minor) {
-#if 0
-			/* pull to head of slot */
-			list_del_init(&cmin->n_hash);
-			list_add(&cmin->n_hash, slot);
-#endif
-			return (cmin);
+	struct devnode *cmin = NULL;
+	struct hlist_node *pos;
+	unsigned long key = strhash_cdev(cdev) + minor;
+	unsigned int seq;
+
+	rcu_read_lock();
+	do {
+		for (pos = strhash_first(&strnod_hash, key, &seq); pos; pos = strhash_next(pos)) {
+			cmin = hlist_entry(pos, struct devnode, n_hash);
+			if (cmin->n_dev == cdev && cmin->n_minor == minor)
+				break;
 		}
-	}
-	return (NULL);
+	} while (!pos && strhash_retry(&strnod_hash, seq));
+	rcu_read_unlock();
+	return (pos ? cmin : NULL);
 }
 
 EXPORT_SYMBOL_GPL(__cmin_lookup);
@@ -345,89 +529,95 @@ EXPORT_SYMBOL_GPL(__cmin_lookup);
 streams_fastcall struct fmodsw *
 __fmod_lookup(modID_t modid)
 {
-	struct list_head *pos, *slot = strmod_hash_slot(modid);
-
-	list_for_each(pos, slot) {
-		struct fmodsw *fmod = list_entry(pos, struct fmodsw, f_hash);
+	struct fmodsw *fmod = NULL;
+	struct hlist_node *pos;
+	unsigned int seq;
 
-		if (fmod->f_modid == modid) {
-#if 0
-			/* pull to front of slot */
-			list_del_init(&fmod->f_hash);
-			list_add(&fmod->f_hash, slot);
-#endif
-			return (fmod);
-		}
-	}
-	return (NULL);
+	rcu_read_lock();
+	do {
+		for (pos = strhash_first(&strmod_hash, modid, &seq); pos; pos = strhash_next(pos))
+			if ((fmod = hlist_entry(pos, struct fmodsw, f_hash))->f_modid == modid)
+				break;
+	} while (!pos && strhash_retry(&strmod_hash, seq));
+	rcu_read_unlock();
+	return (pos ? fmod : NULL);
 }
 
 EXPORT_SYMBOL_GPL(__fmod_lookup);
 
+/**
+ *  __cdev_search: - look up a cdev by name in the cdev name hashes
+ *  @name: name to look up
+ */
 streams_fastcall struct cdevsw *
 __cdev_search(const char *name)
 {
-	struct list_head *pos, *slot = &cdevsw_list;
-
-	list_for_each(pos, slot) {
-		struct cdevsw *cdev = list_entry(pos, struct cdevsw, d_list);
-
-		if (!strncmp(cdev->d_name, name, FMNAMESZ)) {
-#if 0
-			/* pull to front of slot */
-			list_del_init(&cdev->d_list);
-			list_add(&cdev->d_list, slot);
-#endif
-			return (cdev);
-		}
-	}
-	return (NULL);
+	struct cdevsw *cdev = NULL;
+	struct hlist_node *pos;
+	unsigned long key = strhash_name(name);
+	unsigned int seq;
+
+	rcu_read_lock();
+	do {
+		for (pos = strhash_first(&cdevname_hash, key, &seq); pos; pos = strhash_next(pos))
+			if (!strncmp((cdev = hlist_entry(pos, struct cdevsw, d_nhash))->d_name, name,
+				     FMNAMESZ))
+				break;
+	} while (!pos && strhash_retry(&cdevname_hash, seq));
+	rcu_read_unlock();
+	return (pos ? cdev : NULL);
 }
 
 EXPORT_SYMBOL_GPL(__cdev_search);
 
+/**
+ *  __fmod_search: - look up a fmod by name in the fmod name hashes
+ *  @name: name to look up
+ */
 streams_fastcall struct fmodsw *
 __fmod_search(const char *name)
 {
-	struct list_head *pos, *slot = &fmodsw_list;
-
-	list_for_each(pos, slot) {
-		struct fmodsw *fmod = list_entry(pos, struct fmodsw, f_list);
-
-		if (!strncmp(fmod->f_name, name, FMNAMESZ)) {
-#if 0
-			/* pull to front of slot */
-			list_del_init(&fmod->f_list);
-			list_add(&fmod->f_list, slot);
-#endif
-			return (fmod);
-		}
-	}
-	return (NULL);
+	struct fmodsw *fmod = NULL;
+	struct hlist_node *pos;
+	unsigned long key = strhash_name(name);
+	unsigned int seq;
+
+	rcu_read_lock();
+	do {
+		for (pos = strhash_first(&fmodname_hash, key, &seq); pos; pos = strhash_next(pos))
+			if (!strncmp((fmod = hlist_entry(pos, struct fmodsw, f_nhash))->f_name, name,
+				     FMNAMESZ))
+				break;
+	} while (!pos && strhash_retry(&fmodname_hash, seq));
+	rcu_read_unlock();
+	return (pos ? fmod : NULL);
 }
 
 EXPORT_SYMBOL_GPL(__fmod_search);
 
+/**
+ *  __cmin_search: - look up a minor device node by cdev and name in the node name hashes
+ *  @cdev: character device major structure
+ *  @name: name to look up
+ */
 streams_fastcall struct devnode *
 __cmin_search(struct cdevsw *cdev, const char *name)
 {
-	struct list_head *pos, *slot = &cdev->d_minors;
-
-	ensure(cdev->d_minors.next, INIT_LIST_HEAD(&cdev->d_minors));
-
-	list_for_each(pos, slot) {
-		struct devnode *cmin = list_entry(pos, struct devnode, n_list);
-
-		if (!strncmp(cmin->n_name, name, FMNAMESZ)) {
-#if 0
-			/* pull to head of slot */
-			list_del_init(&cmin->n_list);
-			list_add(&cmin->n_list, slot);
-#endif
-			return (cmin);
+	struct devnode *cmin = NULL;
+	struct hlist_node *pos;
+	unsigned long key = strhash_cdev(cdev) + strhash_name(name);
+	unsigned int seq;
+
+	rcu_read_lock();
+	do {
+		for (pos = strhash_first(&cminname_hash, key, &seq); pos; pos = strhash_next(pos)) {
+			cmin = hlist_entry(pos, struct devnode, n_nhash);
+			if (cmin->n_dev == cdev && !strncmp(cmin->n_name, name, FMNAMESZ))
+				break;
 		}
-	}
-	return (NULL);
+	} while (!pos && strhash_retry(&cminname_hash, seq));
+	rcu_read_unlock();
+	return (pos ? cmin : NULL);
 }
 
 EXPORT_SYMBOL_GPL(__cmin_search);
@@ -501,7 +691,7 @@ cdev_lookup(major_t major, int load)
 #if defined(CONFIG_KMOD) || defined(CONFIG_MODULES)
 	int reload;
 
-	read_lock(&cdevsw_lock);
+	rcu_read_lock();
 	for (reload = load ? 0 : 1; reload < 2; reload++) {
 		do {
 			char devname[64];
@@ -510,34 +700,34 @@ cdev_lookup(major_t major, int load)
 				break;
 			if (!load)
 				break;
-			read_unlock(&cdevsw_lock);
+			rcu_read_unlock();
 			snprintf(devname, sizeof(devname), "char-major-%d", major);
 			request_module(devname);
-			read_lock(&cdevsw_lock);
+			rcu_read_lock();
 			if ((cdev = __cdev_lookup(major)))
 				break;
-			read_unlock(&cdevsw_lock);
+			rcu_read_unlock();
 			snprintf(devname, sizeof(devname), "streams-major-%d", major);
 			request_module(devname);
-			read_lock(&cdevsw_lock);
+			rcu_read_lock();
 #if defined CONFIG_DEVFS || 1
 			if ((cdev = __cdev_lookup(major)))
 				break;
-			read_unlock(&cdevsw_lock);
+			rcu_read_unlock();
 			snprintf(devname, sizeof(devname), "/dev/streams/%d", major);
 			request_module(devname);
-			read_lock(&cdevsw_lock);
+			rcu_read_lock();
 #endif				/* CONFIG_DEVFS */
 		} while (0);
 		/* try to acquire the module */
 		if ((cdev = cdev_grab(cdev)))
 			break;
 	}
-	read_unlock(&cdevsw_lock);
+	rcu_read_unlock();
 #else
-	read_lock(&cdevsw_lock);
+	rcu_read_lock();
 	cdev = __cdev_lookup(major);
-	read_unlock(&cdevsw_lock);
+	rcu_read_unlock();
 #endif				/* defined(CONFIG_KMOD) || defined(CONFIG_MODULES) */
 	return (cdev);
 }
@@ -555,7 +745,7 @@ cdrv_lookup(modID_t modid, int load)
 #if defined(CONFIG_KMOD) || defined(CONFIG_MODULES)
 	int reload;
 
-	read_lock(&fmodsw_lock);
+	rcu_read_lock();
 	for (reload = load ? 0 : 1; reload < 2; reload++) {
 		do {
 			char modname[64];
@@ -564,10 +754,10 @@ cdrv_lookup(modID_t modid, int load)
 				break;
 			if (!load)
 				break;
-			read_unlock(&fmodsw_lock);
+			rcu_read_unlock();
 			snprintf(modname, sizeof(modname), "streams-modid-%d", modid);
 			request_module(modname);
-			read_lock(&fmodsw_lock);
+			rcu_read_lock();
 			if ((cdev = __cdrv_lookup(modid)))
 				break;
 		} while (0);
@@ -575,11 +765,11 @@ cdrv_lookup(modID_t modid, int load)
 		if ((cdev = cdev_grab(cdev)))
 			break;
 	}
-	read_unlock(&fmodsw_lock);
+	rcu_read_unlock();
 #else
-	read_lock(&fmodsw_lock);
+	rcu_read_lock();
 	cdev = __cdrv_lookup(modid);
-	read_unlock(&fmodsw_lock);
+	rcu_read_unlock();
 #endif				/* defined(CONFIG_KMOD) || defined(CONFIG_MODULES) */
 	return (cdev);
 }
@@ -597,7 +787,7 @@ fmod_lookup(modID_t modid, int load)
 #if defined(CONFIG_KMOD) || defined(CONFIG_MODULES)
 	int reload;
 
-	read_lock(&fmodsw_lock);
+	rcu_read_lock();
 	for (reload = load ? 0 : 1; reload < 2; reload++) {
 		do {
 			char modname[64];
@@ -606,10 +796,10 @@ fmod_lookup(modID_t modid, int load)
 				break;
 			if (!load)
 				break;
-			read_unlock(&fmodsw_lock);
+			rcu_read_unlock();
 			snprintf(modname, sizeof(modname), "streams-modid-%d", modid);
 			request_module(modname);
-			read_lock(&fmodsw_lock);
+			rcu_read_lock();
 			if ((fmod = __fmod_lookup(modid)))
 				break;
 		} while (0);
@@ -617,11 +807,11 @@ fmod_lookup(modID_t modid, int load)
 		if ((fmod = fmod_grab(fmod)))
 			break;
 	}
-	read_unlock(&fmodsw_lock);
+	rcu_read_unlock();
 #else
-	read_lock(&fmodsw_lock);
+	rcu_read_lock();
 	fmod = __fmod_lookup(modid);
-	read_unlock(&fmodsw_lock);
+	rcu_read_unlock();
 #endif				/* defined(CONFIG_KMOD) || defined(CONFIG_MODULES) */
 	return (fmod);
 }
@@ -634,24 +824,10 @@ fmod_lookup(modID_t modid, int load)
 STATIC struct devnode *
 cmaj_lookup(const struct cdevsw *cdev, major_t major)
 {
-	struct devnode *cmaj = NULL;
-
-	ensure(cdev->d_majors.next, return (cmaj));
-
-	read_lock(&cdevsw_lock);
-	if (cdev) {
-		register struct list_head *pos;
-
-		list_for_each(pos, &cdev->d_majors) {
-			struct devnode *d = list_entry(pos, struct devnode, n_list);
+	struct devnode *cmaj;
 
-			if (d->n_major == major) {
-				cmaj = d;
-				break;
-			}
-		}
-	}
-	read_unlock(&cdevsw_lock);
+	if ((cmaj = __cmaj_lookup(major)) && cmaj->n_dev != cdev)
+		cmaj = NULL;
 	return (cmaj);
 }
 
@@ -663,25 +839,7 @@ cmaj_lookup(const struct cdevsw *cdev, major_t major)
 STATIC struct devnode *
 cmin_lookup(const struct cdevsw *cdev, minor_t minor)
 {
-	struct devnode *cmin = NULL;
-
-	ensure(cdev->d_minors.next, return (cmin));
-
-	read_lock(&cdevsw_lock);
-	if (cdev) {
-		register struct list_head *pos;
-
-		list_for_each(pos, &cdev->d_minors) {
-			struct devnode *n = list_entry(pos, struct devnode, n_list);
-
-			if (n->n_minor == minor) {
-				cmin = n;
-				break;
-			}
-		}
-	}
-	read_unlock(&cdevsw_lock);
-	return (cmin);
+	return __cmin_lookup((struct cdevsw *) cdev, minor);
 }
 
 /**
@@ -689,7 +847,7 @@ cmin_lookup(const struct cdevsw *cdev, minor_t minor)
  *  @name: name to look up
  *  @load: whether to demand load kernel modules
  *
- *  The search is exhaustive.  If this function is called multiple times with the same name, the
+ *  The search is hashed by name.  If this function is called multiple times with the same name, the
  *  peformance impact will be minimal.  If the device is not found by name, an attempt will be made
  *  to demand load the kernel module "streams-%s" and then "/dev/streams/%s".
  */
@@ -701,7 +859,7 @@ cdev_search(const char *name, int load)
 #if defined(CONFIG_KMOD) || defined(CONFIG_MODULES)
 	int reload;
 #endif
-	read_lock(&cdevsw_lock);
+	rcu_read_lock();
 #if defined(CONFIG_KMOD) || defined(CONFIG_MODULES)
 	for (reload = load ? 0 : 1; reload < 2; reload++) {
 		do {
@@ -711,17 +869,17 @@ cdev_search(const char *name, int load)
 				break;
 			if (!load)
 				break;
-			read_unlock(&cdevsw_lock);
+			rcu_read_unlock();
 			snprintf(devname, sizeof(devname), "streams-%s", name);
 			request_module(devname);
-			read_lock(&cdevsw_lock);
+			rcu_read_lock();
 #if defined CONFIG_DEVFS || 1
 			if ((cdev = __cdev_search(name)))
 				break;
-			read_unlock(&cdevsw_lock);
+			rcu_read_unlock();
 			snprintf(devname, sizeof(devname), "/dev/streams/%s", name);
 			request_module(devname);
-			read_lock(&cdevsw_lock);
+			rcu_read_lock();
 #endif				/* CONFIG_DEVFS */
 		} while (0);
 		/* try to acquire the module */
@@ -739,7 +897,7 @@ cdev_search(const char *name, int load)
 #else				/* defined(CONFIG_KMOD) || defined(CONFIG_MODULES) */
 	cdev = __cdev_search(name);
 #endif				/* defined(CONFIG_KMOD) || defined(CONFIG_MODULES) */
-	read_unlock(&cdevsw_lock);
+	rcu_read_unlock();
 	return (cdev);
 }
 
@@ -748,7 +906,7 @@ cdev_search(const char *name, int load)
  *  @name: name to look up
  *  @load: whether to demand load kernel modules
  *
- *  The search is exhaustive.  If this function is called multiple times with the same name, the
+ *  The search is hashed by name.  If this function is called multiple times with the same name, the
  *  peformance impact will be minimal.  If the module is not found by name, an attempt will be made
  *  to demand load the kernel module "streams-%s".
  */
@@ -760,7 +918,7 @@ fmod_search(const char *name, int load)
 #if defined(CONFIG_KMOD) || defined(CONFIG_MODULES)
 	int reload;
 #endif
-	read_lock(&fmodsw_lock);
+	rcu_read_lock();
 #if defined(CONFIG_KMOD) || defined(CONFIG_MODULES)
 	for (reload = load ? 0 : 1; reload < 2; reload++) {
 		do {
@@ -770,10 +928,10 @@ fmod_search(const char *name, int load)
 				break;
 			if (!load)
 				break;
-			read_unlock(&fmodsw_lock);
+			rcu_read_unlock();
 			snprintf(devname, sizeof(devname), "streams-%s", name);
 			request_module(devname);
-			read_lock(&fmodsw_lock);
+			rcu_read_lock();
 		} while (0);
 		/* try to acquire the module */
 		if (fmod && fmod->f_str)
@@ -787,7 +945,7 @@ fmod_search(const char *name, int load)
 #else				/* defined(CONFIG_KMOD) || defined(CONFIG_MODULES) */
 	fmod = __fmod_search(name);
 #endif				/* defined(CONFIG_KMOD) || defined(CONFIG_MODULES) */
-	read_unlock(&fmodsw_lock);
+	rcu_read_unlock();
 	return (fmod);
 }
 
@@ -797,7 +955,7 @@ fmod_search(const char *name, int load)
  *  @name: name to look up
  *  @load: whether to demand load kernel modules
  *
- *  The search is exhaustive.  If this function is called multiple times with the same name, the
+ *  The search is hashed by name.  If this function is called multiple times with the same name, the
  *  peformance impact will be minimal.  If the device is not found by name, an attempt will be made
  *  to demand load the kernel module "streams-%s-%s" and then "/dev/streams/%s/%s".
  *
@@ -814,7 +972,7 @@ cmin_search(struct cdevsw *cdev, const char *name, int load)
 #if defined(CONFIG_KMOD) || defined(CONFIG_MODULES)
 	int reload;
 #endif				/* defined(CONFIG_KMOD) || defined(CONFIG_MODULES) */
-	read_lock(&cdevsw_lock);
+	rcu_read_lock();
 #if defined(CONFIG_KMOD) || defined(CONFIG_MODULES)
 	for (reload = load ? 0 : 1; reload < 2; reload++) {
 		do {
@@ -825,42 +983,42 @@ cmin_search(struct cdevsw *cdev, const char *name, int load)
 					break;
 				if (!load)
 					break;
-				read_unlock(&cdevsw_lock);
+				rcu_read_unlock();
 				snprintf(devname, sizeof(devname), "streams-%s", name);
 				request_module(devname);
-				read_lock(&cdevsw_lock);
+				rcu_read_lock();
 #if defined CONFIG_DEVFS || 1
 				if ((cmin = __cmin_search(cdev, name)))
 					break;
-				read_unlock(&cdevsw_lock);
+				rcu_read_unlock();
 				snprintf(devname, sizeof(devname), "/dev/streams/%s", name);
 				request_module(devname);
-				read_lock(&cdevsw_lock);
+				rcu_read_lock();
 #endif				/* CONFIG_DEVFS */
 			}
 			if ((cmin = __cmin_search(cdev, name)))
 				break;
 			if (!load)
 				break;
-			read_unlock(&cdevsw_lock);
+			rcu_read_unlock();
 			snprintf(devname, sizeof(devname), "streams-%s-%s", cdev->d_name, name);
 			request_module(devname);
-			read_lock(&cdevsw_lock);
+			rcu_read_lock();
 #if defined CONFIG_DEVFS || 1
 			if ((cmin = __cmin_search(cdev, name)))
 				break;
-			read_unlock(&cdevsw_lock);
+			rcu_read_unlock();
 			snprintf(devname, sizeof(devname), "/dev/streams/%s/%s", cdev->d_name,
 				 name);
 			request_module(devname);
-			read_lock(&cdevsw_lock);
+			rcu_read_lock();
 #endif				/* CONFIG_DEVFS */
 		} while (0);
 	}
 #else				/* defined(CONFIG_KMOD) || defined(CONFIG_MODULES) */
 	cmin = __cmin_search(cdev, name);
 #endif				/* defined(CONFIG_KMOD) || defined(CONFIG_MODULES) */
-	read_unlock(&cdevsw_lock);
+	rcu_read_unlock();
 	return (cmin);
 }
 
@@ -1155,12 +1313,15 @@ fmod_add(struct fmodsw *fmod, modID_t modid)
 
 	assert(!fmod->f_list.next || list_empty(&fmod->f_list));
 	INIT_LIST_HEAD(&fmod->f_list);
-	assert(!fmod->f_hash.next || list_empty(&fmod->f_hash));
-	INIT_LIST_HEAD(&fmod->f_hash);
+	assert(hlist_unhashed(&fmod->f_hash));
+	INIT_HLIST_NODE(&fmod->f_hash);
+	assert(hlist_unhashed(&fmod->f_nhash));
+	INIT_HLIST_NODE(&fmod->f_nhash);
 
 	fmod->f_modid = modid;
 	list_add(&fmod->f_list, &fmodsw_list);
-	list_add(&fmod->f_hash, strmod_hash_slot(modid));
+	strhash_add(&strmod_hash, &fmod->f_hash);
+	strhash_add(&fmodname_hash, &fmod->f_nhash);
 	fmod_count++;
 }
 
@@ -1171,7 +1332,8 @@ fmod_del(struct fmodsw *fmod)
 {
 	/* remove from list and hash */
 	list_del_init(&fmod->f_list);
-	list_del_init(&fmod->f_hash);
+	strhash_del(&strmod_hash, &fmod->f_hash);
+	strhash_del(&fmodname_hash, &fmod->f_nhash);
 }
 
 EXPORT_SYMBOL_GPL(fmod_del);
@@ -1194,8 +1356,10 @@ sdev_ini(struct cdevsw *cdev, modID_t modid)
 
 	assert(!cdev->d_list.next || list_empty(&cdev->d_list));
 	INIT_LIST_HEAD(&cdev->d_list);
-	assert(!cdev->d_hash.next || list_empty(&cdev->d_hash));
-	INIT_LIST_HEAD(&cdev->d_hash);
+	assert(hlist_unhashed(&cdev->d_hash));
+	INIT_HLIST_NODE(&cdev->d_hash);
+	assert(hlist_unhashed(&cdev->d_nhash));
+	INIT_HLIST_NODE(&cdev->d_nhash);
 	assert(!cdev->d_majors.next || list_empty(&cdev->d_majors));
 	INIT_LIST_HEAD(&cdev->d_majors);
 	assert(!cdev->d_minors.next || list_empty(&cdev->d_minors));
@@ -1237,7 +1401,8 @@ sdev_add(struct cdevsw *cdev)
 #endif
 	/* add to list and hash */
 	list_add(&cdev->d_list, &cdevsw_list);
-	list_add(&cdev->d_hash, strmod_hash_slot(cdev->d_modid));
+	strhash_add(&strmod_hash, &cdev->d_hash);
+	strhash_add(&cdevname_hash, &cdev->d_nhash);
 	cdev_count++;
 	return (0);
 }
@@ -1261,7 +1426,8 @@ sdev_del(struct cdevsw *cdev)
 #endif
 	/* remove from list and hash */
 	list_del_init(&cdev->d_list);
-	list_del_init(&cdev->d_hash);
+	strhash_del(&strmod_hash, &cdev->d_hash);
+	strhash_del(&cdevname_hash, &cdev->d_nhash);
 	cdev_count--;
 }
 
@@ -1294,7 +1460,7 @@ cmaj_add(struct devnode *cmaj, struct cdevsw *cdev, major_t major)
 	if (list_empty(&cdev->d_majors))
 		cdev->d_major = major;
 	list_add_tail(&cmaj->n_list, &cdev->d_majors);
-	list_add_tail(&cmaj->n_hash, strdev_hash_slot(major));
+	strhash_add(&strdev_hash, &cmaj->n_hash);
 }
 
 EXPORT_SYMBOL_GPL(cmaj_add);
@@ -1305,7 +1471,7 @@ cmaj_del(struct devnode *cmaj, struct cdevsw *cdev)
 	ensure(cdev->d_majors.next, INIT_LIST_HEAD(&cdev->d_majors));
 
 	list_del_init(&cmaj->n_list);
-	list_del_init(&cmaj->n_hash);
+	strhash_del(&strdev_hash, &cmaj->n_hash);
 	if (list_empty(&cdev->d_majors))
 		cdev->d_major = 0;
 }
@@ -1324,6 +1490,8 @@ cmin_ini(struct devnode *cmin, struct cdevsw *cdev, minor_t minor)
 		_ptrace(("couldn't get specfs inode\n"));
 		return PTR_ERR(inode);
 	}
+	INIT_HLIST_NODE(&cmin->n_hash);
+	INIT_HLIST_NODE(&cmin->n_nhash);
 	cmin->n_inode = inode;
 	cmin->n_dev = cdev;
 	cmin->n_modid = cdev->d_modid;
@@ -1355,7 +1523,8 @@ cmin_add(struct devnode *cmin, struct cdevsw *cdev)
 #endif
 	/* add to list and hash */
 	list_add(&cmin->n_list, &cdev->d_minors);
-	list_add(&cmin->n_hash, strnod_hash_slot(cmin->n_minor));
+	strhash_add(&strnod_hash, &cmin->n_hash);
+	strhash_add(&cminname_hash, &cmin->n_nhash);
 	cmin_count++;
 #if 0
 #ifdef HAVE_KFUNC_DEVICE_CREATE
@@ -1379,7 +1548,8 @@ cmin_del(struct devnode *cmin, struct cdevsw *cdev)
 #endif
 	/* remove from list and hash */
 	list_del_init(&cmin->n_list);
-	list_del_init(&cmin->n_hash);
+	strhash_del(&strnod_hash, &cmin->n_hash);
+	strhash_del(&cminname_hash, &cmin->n_nhash);
 	cmin_count--;
 #if 0
 #ifdef HAVE_KFUNC_DEVICE_DESTROY
@@ -1764,15 +1934,38 @@ EXPORT_SYMBOL(streams_module_address);
 BIG_STATIC int
 strlookup_init(void)
 {
-	init_fmod_hash();
-	init_cdev_hash();
-	init_cmin_hash();
+	int err;
+
+	if ((err = strhash_init(&strmod_hash, strmod_key)))
+		goto no_strmod;
+	if ((err = strhash_init(&strdev_hash, strdev_key)))
+		goto no_strdev;
+	if ((err = strhash_init(&strnod_hash, strnod_key)))
+		goto no_strnod;
+	if ((err = strhash_init(&fmodname_hash, fmodname_key)))
+		goto no_fmodname;
+	if ((err = strhash_init(&cdevname_hash, cdevname_key)))
+		goto no_cdevname;
+	if ((err = strhash_init(&cminname_hash, cminname_key)))
+		goto no_cminname;
 #if 0
 #if defined(HAVE_KFUNC_CLASS_CREATE) || defined(HAVE_KMACRO_CLASS_CREATE)
 	streams_class = class_create(THIS_MODULE, "streams");
 #endif
 #endif
 	return (0);
+      no_cminname:
+	strhash_term(&cdevname_hash);
+      no_cdevname:
+	strhash_term(&fmodname_hash);
+      no_fmodname:
+	strhash_term(&strnod_hash);
+      no_strnod:
+	strhash_term(&strdev_hash);
+      no_strdev:
+	strhash_term(&strmod_hash);
+      no_strmod:
+	return (err);
 }
 
 BIG_STATIC void
@@ -1783,5 +1976,17 @@ strlookup_exit(void)
 	class_destroy(streams_class);
 #endif
 #endif
+	/* wait for hashes retired by resizing to be freed */
+#if defined HAVE_KFUNC_RCU_BARRIER
+	rcu_barrier();
+#else
+	synchronize_rcu();
+#endif
+	strhash_term(&cminname_hash);
+	strhash_term(&cdevname_hash);
+	strhash_term(&fmodname_hash);
+	strhash_term(&strnod_hash);
+	strhash_term(&strdev_hash);
+	strhash_term(&strmod_hash);
 	return;
 }
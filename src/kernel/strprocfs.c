@@ -496,6 +496,16 @@ STATIC char *dyn_name[DYN_SIZE] = {
 #endif
 };
 
+STATIC char *strbuf_dyn_name[STRBUF_CLASSES] = {
+	"DYN_BUF64:",
+	"DYN_BUF128:",
+	"DYN_BUF272:",
+	"DYN_BUF512:",
+	"DYN_BUF1024:",
+	"DYN_BUF2048:",
+	"DYN_BUF4096:",
+};
+
 static int
 seq_streams_strinfo_show(struct seq_file *m, void *v)
 {
@@ -504,6 +514,9 @@ seq_streams_strinfo_show(struct seq_file *m, void *v)
 	for (j = 0; j < DYN_SIZE; j++)
 		seq_printf(m, "%14s %012d %012d\n", dyn_name[j], atomic_read(&Strinfo[j].si_cnt),
 			   Strinfo[j].si_hwl);
+	for (j = 0; j < STRBUF_CLASSES; j++)
+		seq_printf(m, "%14s %012d %012d\n", strbuf_dyn_name[j],
+			   atomic_read(&Strbufinfo[j].si_cnt), Strbufinfo[j].si_hwl);
 	return (0);
 }
 
@@ -520,6 +533,118 @@ static const struct file_operations streams_strinfo_proc_fops = {
 	.release = seq_release,
 };
 
+/* --------------------------- */
+
+static int
+seq_streams_strsched_show(struct seq_file *m, void *v)
+{
+	int cpu;
+
+	seq_printf(m, "%5s %12s %12s %12s %12s %16s %12s %10s %12s %12s %12s %12s %12s\n", "CPU",
+		   "passes", "overruns", "leftover", "handoffs", "nsecs", "maxns", "timers", "expired",
+		   "batches", "bcwakeups", "bcretries", "bcstarved");
+	for (cpu = 0; cpu < NR_CPUS; cpu++) {
+		struct strthread *t = &strthreads[cpu];
+		struct strwheel *w = t->wheel;
+
+		if (!cpu_online(cpu) || w == NULL)
+			continue;
+		seq_printf(m,
+			   "%5d %12lu %12lu %12lu %12lu %16llu %12llu %10lu %12lu %12lu %12lu %12lu %12lu\n",
+			   cpu, t->runq_passes, t->runq_overruns, t->runq_leftover, t->runq_handoffs,
+			   t->runq_nsecs, t->runq_maxns, w->count, w->expired, w->batches, t->bc_wakeups,
+			   t->bc_retries, t->bc_starved);
+	}
+	return (0);
+}
+
+static int
+streams_strsched_proc_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, seq_streams_strsched_show, NULL);
+}
+
+static const struct file_operations streams_strsched_proc_fops = {
+	.open = streams_strsched_proc_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+/* --------------------------- */
+
+#if defined alloc_percpu
+#define HAVE_STREAMS_QHIST_PROC 1
+#endif
+
+#if defined HAVE_STREAMS_QHIST_PROC
+STATIC void
+seq_streams_qhist_line(struct seq_file *m, struct qhist *qh, const char *name, int side,
+		       const char *what, size_t off)
+{
+	unsigned long sum[QH_BUCKETS] = { 0, };
+	int cpu, b, any = 0;
+
+	for_each_possible_cpu(cpu) {
+		struct qhbuckets *qb = &per_cpu_ptr(qh->qh_cpu, cpu)->qh_side[side];
+		unsigned long *v = (unsigned long *) ((char *) qb + off);
+
+		for (b = 0; b < QH_BUCKETS; b++)
+			if ((sum[b] += v[b]) != 0)
+				any = 1;
+	}
+	if (!any)
+		return;
+	seq_printf(m, "%p %-16s %c %-7s", qh->qh_rq, name, side ? 'W' : 'R', what);
+	for (b = 0; b < QH_BUCKETS; b++)
+		if (sum[b] != 0)
+			seq_printf(m, " %d:%lu", b, sum[b]);
+	seq_printf(m, "\n");
+}
+
+static int
+seq_streams_qhist_show(struct seq_file *m, void *v)
+{
+	struct qhist *qh;
+	unsigned long flags;
+
+	seq_printf(m, "# queue pair, module, side, histogram, log2 bucket:count ...\n");
+	spin_lock_irqsave(&qhist_lock, flags);
+	list_for_each_entry(qh, &qhist_list, qh_list) {
+		queue_t *q = qh->qh_rq;
+		const char *name = "-";
+		int side;
+
+		if (q->q_qinfo != NULL && q->q_qinfo->qi_minfo != NULL
+		    && q->q_qinfo->qi_minfo->mi_idname != NULL)
+			name = q->q_qinfo->qi_minfo->mi_idname;
+		for (side = 0; side < 2; side++) {
+			seq_streams_qhist_line(m, qh, name, side, "delay",
+					       offsetof(struct qhbuckets, qh_delay));
+			seq_streams_qhist_line(m, qh, name, side, "runtime",
+					       offsetof(struct qhbuckets, qh_runtime));
+			seq_streams_qhist_line(m, qh, name, side, "depth",
+					       offsetof(struct qhbuckets, qh_depth));
+		}
+	}
+	spin_unlock_irqrestore(&qhist_lock, flags);
+	return (0);
+}
+
+static int
+streams_qhist_proc_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, seq_streams_qhist_show, NULL);
+}
+
+static const struct file_operations streams_qhist_proc_fops = {
+	.open = streams_qhist_proc_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+#endif				/* defined HAVE_STREAMS_QHIST_PROC */
+
 /* -------------------------- */
 
 #if defined _DEBUG
@@ -1114,7 +1239,7 @@ seq_streams_strevent_hdr(struct seq_file *m)
 	seq_printf(m, ", x.t.func");
 	seq_printf(m, ", x.t.arg");
 	seq_printf(m, ", x.t.cpu");
-	seq_printf(m, ", x.t.timer.expires }");
+	seq_printf(m, ", x.t.expires }");
 	seq_printf(m, ", se_id");
 }
 
@@ -1136,7 +1261,7 @@ seq_streams_strevent(struct seq_file *m, int type, struct strevent *se)
 		seq_printf(m, ", %p", se->x.t.func);
 		seq_printf(m, ", %p", se->x.t.arg);
 		seq_printf(m, ", %d", se->x.t.cpu);
-		seq_printf(m, ", %lu }", se->x.t.timer.expires);
+		seq_printf(m, ", %lu }", se->x.t.expires);
 	}
 	seq_printf(m, ", %ld", se->se_id);
 }
@@ -1953,6 +2078,16 @@ STATIC char *dyn_name[DYN_SIZE] = {
 #endif
 };
 
+STATIC char *strbuf_dyn_name[STRBUF_CLASSES] = {
+	"DYN_BUF64:",
+	"DYN_BUF128:",
+	"DYN_BUF272:",
+	"DYN_BUF512:",
+	"DYN_BUF1024:",
+	"DYN_BUF2048:",
+	"DYN_BUF4096:",
+};
+
 /* list the strinfo structure counts */
 STATIC int
 get_streams_strinfo_data(char *page, int maxlen)
@@ -1964,6 +2099,10 @@ get_streams_strinfo_data(char *page, int maxlen)
 		len +=
 		    snprintf(page + len, maxlen - len, "%14s %012d %012d\n", dyn_name[j],
 			     atomic_read(&Strinfo[j].si_cnt), Strinfo[j].si_hwl);
+	for (j = 0; j < STRBUF_CLASSES; j++)
+		len +=
+		    snprintf(page + len, maxlen - len, "%14s %012d %012d\n", strbuf_dyn_name[j],
+			     atomic_read(&Strbufinfo[j].si_cnt), Strbufinfo[j].si_hwl);
 	return len;
 }
 
@@ -1992,6 +2131,56 @@ get_streams_strinfo_list(char *page, char **start, off_t offset, int length)
 	}
 }
 
+/* list the per-CPU STREAMS scheduler pass and timer wheel accounting */
+STATIC int
+get_streams_strsched_data(char *page, int maxlen)
+{
+	int cpu, len = 0;
+
+	len += snprintf(page + len, maxlen - len,
+			"%5s %12s %12s %12s %12s %16s %12s %10s %12s %12s %12s %12s %12s\n", "CPU",
+			"passes", "overruns", "leftover", "handoffs", "nsecs", "maxns", "timers",
+			"expired", "batches", "bcwakeups", "bcretries", "bcstarved");
+	for (cpu = 0; cpu < NR_CPUS; cpu++) {
+		struct strthread *t = &strthreads[cpu];
+		struct strwheel *w = t->wheel;
+
+		if (!cpu_online(cpu) || w == NULL)
+			continue;
+		len += snprintf(page + len, maxlen - len,
+				"%5d %12lu %12lu %12lu %12lu %16llu %12llu %10lu %12lu %12lu %12lu %12lu %12lu\n",
+				cpu, t->runq_passes, t->runq_overruns, t->runq_leftover, t->runq_handoffs,
+				t->runq_nsecs, t->runq_maxns, w->count, w->expired, w->batches,
+				t->bc_wakeups, t->bc_retries, t->bc_starved);
+	}
+	return len;
+}
+
+#ifndef HAVE_KFUNC_CREATE_PROC_INFO_ENTRY
+STATIC int
+get_streams_strsched_list(char *page, char **start, off_t offset, int length, int *eof, void *data)
+#else
+STATIC int
+get_streams_strsched_list(char *page, char **start, off_t offset, int length)
+#endif
+{
+	int len;
+
+	len = get_streams_strsched_data(page, length + 1);
+	if (offset >= len) {
+		*start = page;
+		return (0);
+	} else {
+		*start = page + offset;
+		len -= offset;
+		if (len > length)
+			len = length;
+		if (len < 0)
+			len = 0;
+		return (len);
+	}
+}
+
 #if defined _DEBUG
 STATIC int
 get_streams_stdata_hdr(char *page, int maxlen)
@@ -2635,7 +2824,7 @@ get_streams_strevent_hdr(char *page, int maxlen)
 	len += snprintf(page + len, maxlen - len, ", x.t.func");
 	len += snprintf(page + len, maxlen - len, ", x.t.arg");
 	len += snprintf(page + len, maxlen - len, ", x.t.cpu");
-	len += snprintf(page + len, maxlen - len, ", x.t.timer.expires }");
+	len += snprintf(page + len, maxlen - len, ", x.t.expires }");
 	len += snprintf(page + len, maxlen - len, ", se_id");
 	return (len);
 }
@@ -2662,7 +2851,7 @@ get_streams_strevent(char *page, int maxlen, int type, struct strevent *se)
 		len += snprintf(page + len, maxlen - len, ", %p", se->x.t.func);
 		len += snprintf(page + len, maxlen - len, ", %p", se->x.t.arg);
 		len += snprintf(page + len, maxlen - len, ", %d", se->x.t.cpu);
-		len += snprintf(page + len, maxlen - len, ", %lu }", se->x.t.timer.expires);
+		len += snprintf(page + len, maxlen - len, ", %lu }", se->x.t.expires);
 	}
 	len += snprintf(page + len, maxlen - len, ", %ld", se->se_id);
       done:
@@ -2987,6 +3176,10 @@ strprocfs_init(void)
 	proc_create_data("fmodsw", 0444, proc_str, &streams_fmodsw_proc_fops, NULL);
 #endif
 	proc_create_data("strinfo", 0444, proc_str, &streams_strinfo_proc_fops, NULL);
+	proc_create_data("strsched", 0444, proc_str, &streams_strsched_proc_fops, NULL);
+#if defined HAVE_STREAMS_QHIST_PROC
+	proc_create_data("qhist", 0444, proc_str, &streams_qhist_proc_fops, NULL);
+#endif
 #if defined _DEBUG
 #if 0
 	proc_create_data("cdevsw", 0444, proc_str, &streams_cdevsw_proc_fops, NULL);
@@ -3010,6 +3203,7 @@ strprocfs_init(void)
 	create_proc_info_entry("fmodsw", 0444, proc_str, get_streams_fmodsw_list);
 #endif
 	create_proc_info_entry("strinfo", 0444, proc_str, get_streams_strinfo_list);
+	create_proc_info_entry("strsched", 0444, proc_str, get_streams_strsched_list);
 #if defined _DEBUG
 #if 0
 	create_proc_info_entry("cdevsw", 0444, proc_str, get_streams_cdevsw_list);
@@ -3041,6 +3235,10 @@ strprocfs_exit(void)
 	remove_proc_entry("fmodsw", proc_str);
 #endif
 	remove_proc_entry("strinfo", proc_str);
+	remove_proc_entry("strsched", proc_str);
+#if defined HAVE_STREAMS_QHIST_PROC
+	remove_proc_entry("qhist", proc_str);
+#endif
 #if defined _DEBUG
 #if 0
 	remove_proc_entry("cdevsw", proc_str);
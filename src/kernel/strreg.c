@@ -67,6 +67,7 @@ static char const ident[] = "src/kernel/strreg.c (" PACKAGE_ENVR ") " PACKAGE_DA
 #include <linux/poll.h>
 #include <linux/fs.h>
 #include <linux/mount.h>	/* for vfsmount and friends */
+#include <linux/rcupdate.h>	/* for synchronize_rcu */
 #include <asm/hardirq.h>
 
 #ifdef HAVE_KINC_LINUX_CDEV_H
@@ -88,6 +89,10 @@ static char const ident[] = "src/kernel/strreg.c (" PACKAGE_ENVR ") " PACKAGE_DA
 #define module_refcount(__m) atomic_read(&(__m)->uc.usecount)
 #endif
 
+#ifndef HAVE_KFUNC_SYNCHRONIZE_RCU
+#define synchronize_rcu() synchronize_kernel()
+#endif
+
 #include "sys/config.h"
 #include "src/modules/sth.h"	/* for stream operations */
 #include "src/kernel/strsched.h"	/* for sq_alloc */
@@ -471,6 +476,8 @@ unregister_strmod(struct fmodsw *fmod)
 	fmod_del(fmod);
 	unregister_strsync(fmod);
 	write_unlock(&fmodsw_lock);
+	/* wait for lookups that might still see the module */
+	synchronize_rcu();
 	/* At this point we notify any STREAMS regsitration notifier chain
 	 * that a STREAMS module has deregistered. */
 	streams_notify(STREAMS_NTFY_DEREG, STR_IS_MODULE, modid);
@@ -651,6 +658,8 @@ unregister_strdrv(struct cdevsw *cdev)
 	unregister_strsync((struct fmodsw *) cdev);
 	sdev_del(cdev);
 	write_unlock(&cdevsw_lock);
+	/* wait for lookups that might still see the driver */
+	synchronize_rcu();
 	sdev_rel(cdev);
 	/* At this point we notify any STREAMS registration notifier chain
 	 * that a STREAMS driver has de-registered. */
@@ -874,6 +883,9 @@ unregister_xinode(struct cdevsw *cdev, struct devnode *cmaj, major_t major)
 		err = 0;
 	} while (0);
 	write_unlock(&cdevsw_lock);
+	/* wait for lookups that might still see the major device nodes */
+	if (err == 0)
+		synchronize_rcu();
 	return (err);
 }
 
@@ -912,7 +924,7 @@ register_cmajor(struct cdevsw *cdev, major_t major, struct file_operations *fops
 		goto no_cmaj;
 	memset(cmaj, 0, sizeof(*cmaj));
 	INIT_LIST_HEAD(&cmaj->n_list);
-	INIT_LIST_HEAD(&cmaj->n_hash);
+	INIT_HLIST_NODE(&cmaj->n_hash);
 	cmaj->n_name = cdev->d_name;
 	cmaj->n_str = cdev->d_str;
 	cmaj->n_flag = cdev->d_flag;
@@ -1066,6 +1078,7 @@ unregister_strnod(struct cdevsw *cdev, minor_t minor)
 				break;
 			cmin_del(cmin, cdev);
 			write_unlock(&cdevsw_lock);
+			synchronize_rcu();
 			cmin_rel(cmin);
 			return (0);
 		} else {
@@ -1079,6 +1092,7 @@ unregister_strnod(struct cdevsw *cdev, minor_t minor)
 
 				cmin_del(cmin, cdev);
 				write_unlock(&cdevsw_lock);
+				synchronize_rcu();
 				cmin_rel(cmin);
 				write_lock(&cdevsw_lock);
 			}
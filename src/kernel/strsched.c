@@ -134,15 +134,34 @@ struct strinfo Strinfo[DYN_SIZE] ____cacheline_aligned;
 
 EXPORT_SYMBOL_GPL(Strinfo);
 
+struct strinfo Strbufinfo[STRBUF_CLASSES] ____cacheline_aligned;
+
+EXPORT_SYMBOL_GPL(Strbufinfo);
+
 #if defined CONFIG_STREAMS_KTHREADS
 
+/*
+ *  When the runq_burst sysctl is non-zero, short bursts of STREAMS work are run in softirq context
+ *  from a per-CPU tasklet.  Once a backlog has survived runq_burst consecutive scheduler passes,
+ *  the work is handed to kstreamd so that it is scheduled fairly against application threads, and
+ *  stays there until kstreamd completes a pass without leaving a backlog.  When runq_burst is zero,
+ *  all work is run by kstreamd.
+ */
+STATIC struct tasklet_struct strtasklets[NR_CPUS];
+
 streams_fastcall void
 __raise_streams(void)
 {
-	struct strthread *t = this_thread;
+	int cpu = get_cpu();
+	struct strthread *t = &strthreads[cpu];
 
-	if (atomic_read(&t->lock) == 0)
-		wake_up_process(t->proc);
+	if (atomic_read(&t->lock) == 0) {
+		if (t->runq_busy < sysctl_str_runq_burst)
+			tasklet_schedule(&strtasklets[cpu]);
+		else
+			wake_up_process(t->proc);
+	}
+	put_cpu();
 }
 
 STATIC streams_fastcall void
@@ -292,6 +311,11 @@ __freebands(queue_t *rq)
 				prefetchw(qb_next);
 				freeqb(qb);
 			}
+			if (q->q_bandv != NULL) {
+				kmem_free(q->q_bandv, qbandv_size(q->q_nband) * sizeof(*q->q_bandv));
+				q->q_bandv = NULL;
+			}
+			bzero(q->q_bandmap, sizeof(q->q_bandmap));
 			q->q_nband = 0;
 			q->q_blocked = 0;
 		}
@@ -639,6 +663,131 @@ modi_put(struct mdlinfo *mi)
 }
 #endif
 
+/* 
+ *  -------------------------------------------------------------------------
+ *
+ *  QUEUE histograms
+ *
+ *  -------------------------------------------------------------------------
+ *  When sys.streams.qhist is set, queue pairs allocated by allocq() and allocstr() are given log2
+ *  histograms of enable-to-service delay, service procedure runtime and queue depth on put, kept in
+ *  per-cpu buckets so that the data path never shares a cache line.  Queue pairs allocated while
+ *  the sysctl is clear cost one pointer test per put and service procedure call.  The histograms
+ *  are summed across processors and displayed in /proc/streams/qhist.
+ */
+
+#if defined alloc_percpu
+struct list_head qhist_list = LIST_HEAD_INIT(qhist_list);
+
+#if	defined DEFINE_SPINLOCK
+DEFINE_SPINLOCK(qhist_lock);
+#elif	defined __SPIN_LOCK_UNLOCKED
+spinlock_t qhist_lock = __SPIN_LOCK_UNLOCKED(qhist_lock);
+#elif	defined SPIN_LOCK_UNLOCKED
+spinlock_t qhist_lock = SPIN_LOCK_UNLOCKED;
+#else
+#error cannot initialize spin locks
+#endif
+
+STATIC __unlikely void
+qhist_alloc(struct queinfo *qu)
+{
+	struct qhist *qh;
+	unsigned long flags;
+
+	if (likely(sysctl_str_qhist == 0))
+		return;
+	if ((qh = kmem_zalloc(sizeof(*qh), KM_SLEEP)) == NULL)
+		return;
+	if ((qh->qh_cpu = alloc_percpu(struct qhcpu)) == NULL) {
+		kmem_free(qh, sizeof(*qh));
+		return;
+	}
+	qh->qh_rq = &qu->rq;
+	spin_lock_irqsave(&qhist_lock, flags);
+	list_add_tail(&qh->qh_list, &qhist_list);
+	spin_unlock_irqrestore(&qhist_lock, flags);
+	qu->qu_hist = qh;
+}
+
+STATIC __unlikely void
+qhist_free(struct queinfo *qu)
+{
+	struct qhist *qh;
+	unsigned long flags;
+
+	if (likely((qh = xchg(&qu->qu_hist, NULL)) == NULL))
+		return;
+	/* can be called from __freeq() in the STREAMS scheduler softirq */
+	spin_lock_irqsave(&qhist_lock, flags);
+	list_del_init(&qh->qh_list);
+	spin_unlock_irqrestore(&qhist_lock, flags);
+	free_percpu(qh->qh_cpu);
+	kmem_free(qh, sizeof(*qh));
+}
+
+STATIC streams_inline streams_fastcall int
+qhist_bucket(unsigned long long val)
+{
+	int b = (val >> 32) ? 32 + fls((unsigned int) (val >> 32)) : fls((unsigned int) val);
+
+	return (b < QH_BUCKETS ? b : QH_BUCKETS - 1);
+}
+
+#define qhside(__q) (test_bit(QREADR_BIT, &(__q)->q_flag) ? 0 : 1)
+
+/*
+ *  The buckets are only updated with preemption disabled on the local processor.  An update can
+ *  still be lost to an interrupt on the same processor updating the same queue; that is acceptable
+ *  for a histogram and avoids atomic operations on the data path.
+ */
+STATIC streams_noinline streams_fastcall __unlikely void
+qhist_put(struct qhist *qh, queue_t *q)
+{
+	struct qhbuckets *b = &per_cpu_ptr(qh->qh_cpu, get_cpu())->qh_side[qhside(q)];
+
+	b->qh_depth[qhist_bucket(q->q_count)]++;
+	put_cpu();
+}
+
+BIG_STATIC streams_fastcall __unlikely void
+qhist_enable(struct qhist *qh, queue_t *q)
+{
+	qh->qh_enabled[qhside(q)] = str_clock();
+}
+
+STATIC streams_noinline streams_fastcall __unlikely unsigned long long
+qhist_srvp_start(struct qhist *qh, queue_t *q)
+{
+	unsigned long long now = str_clock(), then;
+	int side = qhside(q);
+
+	if ((then = xchg(&qh->qh_enabled[side], 0)) != 0 && now >= then) {
+		struct qhbuckets *b = &per_cpu_ptr(qh->qh_cpu, get_cpu())->qh_side[side];
+
+		b->qh_delay[qhist_bucket(now - then)]++;
+		put_cpu();
+	}
+	return (now);
+}
+
+STATIC streams_noinline streams_fastcall __unlikely void
+qhist_srvp_end(struct qhist *qh, queue_t *q, unsigned long long start)
+{
+	unsigned long long now = str_clock();
+	struct qhbuckets *b = &per_cpu_ptr(qh->qh_cpu, get_cpu())->qh_side[qhside(q)];
+
+	b->qh_runtime[qhist_bucket(now - start)]++;
+	put_cpu();
+}
+#else				/* defined alloc_percpu */
+#define qhist_alloc(__qu) do { } while (0)
+#define qhist_free(__qu) do { } while (0)
+#define qhist_put(__qh, __q) do { } while (0)
+#define qhist_srvp_start(__qh, __q) (0ULL)
+#define qhist_srvp_end(__qh, __q, __start) do { } while (0)
+#endif				/* defined alloc_percpu */
+
 /* 
  *  -------------------------------------------------------------------------
  *
@@ -707,6 +856,7 @@ allocq(void)
 			si->si_hwl = atomic_read(&si->si_cnt);
 		rq->q_flag = QUSE | QREADR;
 		wq->q_flag = QUSE;
+		qhist_alloc(qu);
 	}
 	return (rq);
 }
@@ -744,6 +894,7 @@ __freeq(queue_t *rq)
 	assert(!waitqueue_active(&qu->qu_qwait));
 	/* Put Stream head */
 	sd_release(&qu->qu_str);
+	qhist_free(qu);
 	/* clean it good */
 	queinfo_init(qu);
 	/* put back in cache */
@@ -928,7 +1079,7 @@ STATIC streams_inline streams_fastcall __hot mblk_t *
 #else
 streams_noinline streams_fastcall __hot_out mblk_t *
 #endif
-mdbblock_alloc_slow(uint priority, void *func)
+mdbblock_alloc_slow(uint priority, void *func, int node)
 {
 	struct strinfo *sdi = &Strinfo[DYN_MDBBLOCK];
 
@@ -960,7 +1111,13 @@ mdbblock_alloc_slow(uint priority, void *func)
 		}
 #endif
 		_trace();
-		if (likely((mp = kmem_cache_alloc(sdi->si_cache, slab_flags)) != NULL)) {
+#if defined HAVE_KFUNC_KMEM_CACHE_ALLOC_NODE && defined CONFIG_NUMA
+		if (unlikely(node >= 0))
+			mp = kmem_cache_alloc_node(sdi->si_cache, slab_flags, node);
+		else
+#endif
+			mp = kmem_cache_alloc(sdi->si_cache, slab_flags);
+		if (likely(mp != NULL)) {
 #ifdef DOUBLE_CHECK_MBLKS
 			struct mdbblock *md = (struct mdbblock *) mp;
 #endif
@@ -1118,28 +1275,52 @@ mdbblock_alloc(uint priority, void *func)
 		streams_local_restore(flags);
 	}
 #endif				/* !defined CONFIG_STREAMS_NORECYCLE */
-	return mdbblock_alloc_slow(priority, func);
+	return mdbblock_alloc_slow(priority, func, -1);
+}
+
+/**
+ *  mdbblock_alloc_node: - allocate a combined message/data block on a NUMA node
+ *  @priority: the priority of the allocation
+ *  @func: allocating function pointer
+ *  @node: the node from which to allocate (-1 for the local node)
+ *
+ *  Blocks for the local node come from the per-cpu free list as usual.  Blocks for a remote node
+ *  are taken directly from that node's slabs.
+ */
+BIG_STATIC streams_fastcall __hot_write mblk_t *
+mdbblock_alloc_node(uint priority, void *func, int node)
+{
+	if (likely(node < 0) || node == numa_node_id())
+		return mdbblock_alloc(priority, func);
+	return mdbblock_alloc_slow(priority, func, node);
 }
 
-#if !defined CONFIG_STREAMS_NORECYCLE
 /*
  *  raise_local_bufcalls: - raise buffer callbacks on the local STREAMS scheduler thread.
+ *  @class:	bufcall size class of the freed buffers
+ *  @count:	number of buffers freed
+ *
+ *  The freed buffers are credited to their size class so that bufcalls() only runs as many waiting
+ *  buffer callbacks as the buffers can satisfy.
  */
 STATIC streams_inline streams_fastcall void
-raise_local_bufcalls(void)
+raise_local_bufcalls(int class, int count)
 {
 	struct strthread *t = this_thread;
 
-	if (unlikely(test_bit(strbcwait, &t->flags) != 0))
+	if (unlikely(test_bit(strbcwait, &t->flags) != 0)) {
+		atomic_add(count, &t->strbcredit[class]);
 		if (!test_and_set_bit(strbcflag, &t->flags))
 			__raise_streams();
+	}
 }
-#endif				/* !defined CONFIG_STREAMS_NORECYCLE */
 
 /*
  *  raise_bufcalls: - raise buffer callbacks on all STREAMS scheduler threads
+ *  @class:	bufcall size class of the freed memory
  *
- *  Raise buffer callbacks on all STREAMS scheduler threads.
+ *  Raise buffer callbacks on all STREAMS scheduler threads, crediting each with one buffer of the
+ *  size class.
  *
  *  NOTICES: Unfortunately, more recent 2.6 kernels have gotten rid of the cpu_raise_softirq() so
  *  that it is not easy to raise a softirq to schedule a STREAMS sheduler thread on a differnt CPU.
@@ -1155,7 +1336,7 @@ raise_local_bufcalls(void)
  *  for bufcalls.
  */
 STATIC streams_fastcall __hot_in void
-raise_bufcalls(void)
+raise_bufcalls(int class)
 {
 	register struct strthread *t = &strthreads[0];
 
@@ -1164,9 +1345,11 @@ raise_bufcalls(void)
 		register int cpu = 0;
 
 		do {
-			if (unlikely(test_bit(strbcwait, &t->flags) != 0))
+			if (unlikely(test_bit(strbcwait, &t->flags) != 0)) {
+				atomic_inc(&t->strbcredit[class]);
 				if (!test_and_set_bit(strbcflag, &t->flags))
 					cpu_raise_streams(cpu);
+			}
 			t++;
 			cpu++;
 			prefetchw(t);
@@ -1174,6 +1357,50 @@ raise_bufcalls(void)
 	}
 }
 
+/*
+ *  __mdbblock_clean: - reset the state of a combined message/data block being freed
+ *  @md:    the mdbblock
+ */
+STATIC streams_inline streams_fastcall __hot_in void
+__mdbblock_clean(struct mdbblock *md)
+{
+	mblk_t *mp = &md->msgblk.m_mblock;
+	dblk_t *db = &md->datablk.d_dblock;
+
+	// unsigned char *base = md->databuf;
+
+	/* clean the state before putting it back, save mutlitple initializations elsewhere and
+	   reduces code paths.  Optimized for FASTBUFS (all fields completed). */
+	/* these are strung on the free list using the b_next pointer */
+	mp->b_next = NULL;
+	mp->b_prev = NULL;
+	mp->b_cont = NULL;
+	// mp->b_rptr = base;
+	// mp->b_wptr = base;
+#ifdef DOUBLE_CHECK_MBLKS
+	__assure(mp->b_datap == NULL);
+#else
+	mp->b_datap = db;
+#endif
+	mp->b_band = 0;
+	mp->b_pad1 = 0;
+	mp->b_flag = 0;
+	mp->b_csum = 0;
+	md->msgblk.m_tstamp = 0;
+
+	db->db_frtnp = NULL;
+	// db->db_base = base;
+	// db->db_lim = base + FASTBUF;
+#ifdef DOUBLE_CHECK_MBLKS
+	__assure(db->db_ref == 0);
+#else
+	db->db_ref = 1;
+#endif
+	db->db_type = M_DATA;
+	db->db_flag = 0;
+	// db->db_size = FASTBUF;
+}
+
 /**
  *  mdbblock_free: - free a combined message/data block
  *  @mp:    the mdbblock to free
@@ -1211,53 +1438,30 @@ mdbblock_free(mblk_t *mp)
 	dassert(mp->b_next == NULL);	/* check double free */
 	// mp->b_next = NULL;
 #endif				/* !defined CONFIG_STREAMS_NORECYCLE */
-	{
-		struct mdbblock *md = (struct mdbblock *) mp;
-		dblk_t *db = &md->datablk.d_dblock;
-
-		// unsigned char *base = md->databuf;
-
-		/* clean the state before putting it back, save mutlitple initializations elsewhere and
-		   reduces code paths.  Optimized for FASTBUFS (all fields completed). */
-		/* these are strung on the free list using the b_next pointer */
-		mp->b_next = NULL;
-		mp->b_prev = NULL;
-		mp->b_cont = NULL;
-		// mp->b_rptr = base;
-		// mp->b_wptr = base;
-#ifdef DOUBLE_CHECK_MBLKS
-		__assure(mp->b_datap == NULL);
-#else
-		mp->b_datap = db;
-#endif
-		mp->b_band = 0;
-		mp->b_pad1 = 0;
-		mp->b_flag = 0;
-		mp->b_csum = 0;
-
-		db->db_frtnp = NULL;
-		// db->db_base = base;
-		// db->db_lim = base + FASTBUF;
-#ifdef DOUBLE_CHECK_MBLKS
-		__assure(db->db_ref == 0);
-#else
-		db->db_ref = 1;
-#endif
-		db->db_type = M_DATA;
-		db->db_flag = 0;
-		// db->db_size = FASTBUF;
-	}
+	__mdbblock_clean((struct mdbblock *) mp);
 #if !defined CONFIG_STREAMS_NORECYCLE
 	{
 		unsigned long flags;
 
-		/* Originally freed blocks were added to the end of the list but this does not keep mblks
-		   hot, so now a push-down pop-up stack is used instead. */
 		streams_local_save(flags);
-		if (unlikely((mp->b_next = t->freemblk_head) == NULL))
-			t->freemblk_tail = &mp->b_next;
-		t->freemblk_head = mp;
-		t->freemblks++;
+#if defined CONFIG_NUMA
+		if (unlikely(page_to_nid(virt_to_page(mp)) != numa_node_id())) {
+			/* Blocks homed on another node are not recycled on this one, where they would
+			   be remote memory for every subsequent user.  They are queued and returned to
+			   the memory cache, and thus to their home node, in batches. */
+			mp->b_next = NULL;
+			*XCHG(&t->freeremote_tail, &mp->b_next) = mp;
+			t->freeremotes++;
+		} else
+#endif
+		{
+			/* Originally freed blocks were added to the end of the list but this does not
+			   keep mblks hot, so now a push-down pop-up stack is used instead. */
+			if (unlikely((mp->b_next = t->freemblk_head) == NULL))
+				t->freemblk_tail = &mp->b_next;
+			t->freemblk_head = mp;
+			t->freemblks++;
+		}
 		streams_local_restore(flags);
 	}
 #endif				/* !defined CONFIG_STREAMS_NORECYCLE */
@@ -1282,17 +1486,290 @@ mdbblock_free(mblk_t *mp)
 	/* Decide when to invoke freeblocks.  Current policy is to free blocks when then number of blocks on
 	   the free list exceeds some (per-cpu) threshold.  Currently I set this to just 1/16th of the
 	   maximum.  That should be ok for now.  I will create a sysctl for it later... */
-	if (unlikely((t->freemblks > (sysctl_str_nstrmsgs >> 4))
+	if (unlikely((t->freemblks > (sysctl_str_nstrmsgs >> 4) || t->freeremotes >= STRNUMA_BATCH)
 		     && test_and_set_bit(freeblks, &t->flags) == 0))
 		__raise_streams();
-	raise_local_bufcalls();
+	raise_local_bufcalls(0, 1);
 	/* other processors will just have to fight over the remaining memory */
 #else				/* !defined CONFIG_STREAMS_NORECYCLE */
 	/* raise global bufcalls if we free anything to the cache */
-	raise_bufcalls();
+	raise_bufcalls(0);
 #endif				/* !defined CONFIG_STREAMS_NORECYCLE */
 }
 
+/**
+ *  mdbblock_free_batch: - free a list of combined message/data blocks
+ *  @mp:    the first mdbblock to free, the rest linked by b_next
+ *
+ *  This is not exported but is called by freemsgchain() to free all of the blocks released from
+ *  a chain of messages at once.  Each block is cleaned as by mdbblock_free(), but the list is
+ *  pushed onto the per-cpu free list with local interrupts suppressed only once, and the counts
+ *  and the freeblocks() policy are applied once for the batch instead of once per block.
+ */
+BIG_STATIC streams_fastcall void
+mdbblock_free_batch(mblk_t *mp)
+{
+#if !defined CONFIG_STREAMS_NORECYCLE
+	struct strthread *t = this_thread;
+	mblk_t *b, *b_next, *head = NULL, **tail = &head;
+	int n = 0;
+
+#if defined CONFIG_NUMA
+	mblk_t *rhead = NULL, **rtail = &rhead;
+	int nr = 0, nid = numa_node_id();
+#endif
+
+	prefetchw(t);
+	for (b = mp; b != NULL; b = b_next) {
+		b_next = b->b_next;
+		prefetchw(b_next);
+		__mdbblock_clean((struct mdbblock *) b);
+#if defined CONFIG_NUMA
+		if (unlikely(page_to_nid(virt_to_page(b)) != nid)) {
+			*rtail = b;
+			rtail = &b->b_next;
+			nr++;
+			continue;
+		}
+#endif
+		*tail = b;
+		tail = &b->b_next;
+		n++;
+	}
+	{
+		unsigned long flags;
+
+		streams_local_save(flags);
+		if (likely(head != NULL)) {
+			if (unlikely((*tail = t->freemblk_head) == NULL))
+				t->freemblk_tail = tail;
+			t->freemblk_head = head;
+			t->freemblks += n;
+		}
+#if defined CONFIG_NUMA
+		if (unlikely(rhead != NULL)) {
+			*XCHG(&t->freeremote_tail, rtail) = rhead;
+			t->freeremotes += nr;
+		}
+		n += nr;
+#endif
+		streams_local_restore(flags);
+	}
+	{
+		struct strinfo *sdi = &Strinfo[DYN_MDBBLOCK];
+
+#if defined CONFIG_STREAMS_DEBUG
+		struct strinfo *smi = &Strinfo[DYN_MSGBLOCK];
+
+		atomic_sub(n, &smi->si_cnt);
+#endif
+#if !defined _OPTIMIZE_SPEED
+		atomic_sub(n, &sdi->si_cnt);
+#else
+		(void) sdi;
+#endif				/* !defined _OPTIMIZE_SPEED */
+	}
+	if (unlikely((t->freemblks > (sysctl_str_nstrmsgs >> 4) || t->freeremotes >= STRNUMA_BATCH)
+		     && test_and_set_bit(freeblks, &t->flags) == 0))
+		__raise_streams();
+	raise_local_bufcalls(0, n);
+#else				/* !defined CONFIG_STREAMS_NORECYCLE */
+	mblk_t *b, *b_next;
+
+	for (b = mp; b != NULL; b = b_next) {
+		b_next = b->b_next;
+		b->b_next = NULL;
+		mdbblock_free(b);
+	}
+#endif				/* !defined CONFIG_STREAMS_NORECYCLE */
+}
+
+/* 
+ *  -------------------------------------------------------------------------
+ *
+ *  DATA BUFFER size class caches
+ *
+ *  -------------------------------------------------------------------------
+ *  Data buffers for allocb() that are too large for the fast buffer internal to the mdbblock, but no
+ *  larger than STRBUF_MAXSIZE, are allocated from one of a set of size classed memory caches rather
+ *  than the general purpose kmalloc() allocator.  The size classes are chosen to fit common message
+ *  sizes (e.g. 272 for a maximum size MTP MSU).  In the same way as for mdbblocks on the per-cpu free
+ *  list, freed data buffers are pushed onto a per-cpu, per-class stack (magazine) so that
+ *  allocations and frees on the same processor do not touch the memory cache at all.  The magazines
+ *  are bounded by STRBUF_MAGSIZE: buffers freed to a full magazine are returned to the cache.
+ */
+
+STATIC const size_t strbuf_size[STRBUF_CLASSES] = { 64, 128, 272, 512, 1024, 2048, 4096 };
+
+STATIC const char *strbuf_name[STRBUF_CLASSES] = {
+	"DYN_BUF64", "DYN_BUF128", "DYN_BUF272", "DYN_BUF512", "DYN_BUF1024", "DYN_BUF2048", "DYN_BUF4096"
+};
+
+/*
+ *  strbuf_class: - determine the size class for a data buffer
+ *  @size:	the requested size (no larger than STRBUF_MAXSIZE)
+ */
+STATIC streams_inline streams_fastcall __hot int
+strbuf_class(size_t size)
+{
+	int class = 0;
+
+	while (unlikely(size > strbuf_size[class]))
+		class++;
+	return (class);
+}
+
+/*
+ *  bufcall_class: - determine the size class of a bufcall waiter or freed buffer
+ *  @size:	the size
+ *
+ *  Class zero is for the fast buffer internal to the mdbblock, the next STRBUF_CLASSES classes are
+ *  for the data buffer size classes, and the last is for anything larger.  A freed buffer of one
+ *  class can satisfy waiters of that class or any lower class.
+ */
+STATIC streams_inline streams_fastcall int
+bufcall_class(size_t size)
+{
+	if (likely(size <= FASTBUF))
+		return (0);
+	if (likely(size <= STRBUF_MAXSIZE))
+		return (1 + strbuf_class(size));
+	return (STRBC_CLASSES - 1);
+}
+
+/**
+ *  strbuf_alloc: - allocate a size classed data buffer
+ *  @size:	the requested size (no larger than STRBUF_MAXSIZE)
+ *  @priority:	the priority of the allocation
+ *  @limp:	where to return the limit of the usable buffer
+ *  @node:	the NUMA node from which to allocate (-1 for the local node)
+ *
+ *  Called by allocb() to allocate a data buffer.  The caller marks the data block with %DB_BUFCACHE
+ *  so that freeb() knows to return the buffer with strbuf_free().
+ */
+BIG_STATIC streams_fastcall __hot_write unsigned char *
+strbuf_alloc(size_t size, uint priority, unsigned char **limp, int node)
+{
+	int class = strbuf_class(size);
+	struct strinfo *si = &Strbufinfo[class];
+	struct strthread *t;
+	unsigned char *base;
+	unsigned long flags;
+
+#if defined HAVE_KFUNC_KMEM_CACHE_ALLOC_NODE && defined CONFIG_NUMA
+	if (unlikely(node >= 0) && node != numa_node_id()) {
+		/* buffers for a remote node come straight from that node's slabs */
+		base = kmem_cache_alloc_node(si->si_cache,
+					     (priority == BPRI_WAITOK) ? GFP_KERNEL : GFP_ATOMIC, node);
+		if (unlikely(base == NULL))
+			return (NULL);
+		goto done;
+	}
+#endif
+	streams_local_save(flags);
+	t = this_thread;
+	if (likely((base = t->bufmag_head[class]) != NULL)) {
+		t->bufmag_head[class] = *(unsigned char **) base;
+		t->bufmags[class]--;
+		streams_local_restore(flags);
+	} else {
+		streams_local_restore(flags);
+		base = kmem_cache_alloc(si->si_cache, (priority == BPRI_WAITOK) ? GFP_KERNEL : GFP_ATOMIC);
+		if (unlikely(base == NULL))
+			return (NULL);
+	}
+#if defined HAVE_KFUNC_KMEM_CACHE_ALLOC_NODE && defined CONFIG_NUMA
+      done:
+#endif
+	atomic_inc(&si->si_cnt);
+	if (atomic_read(&si->si_cnt) > si->si_hwl)
+		si->si_hwl = atomic_read(&si->si_cnt);
+	*limp = base + strbuf_size[class];
+	return (base);
+}
+
+/**
+ *  strbuf_free: - free a size classed data buffer
+ *  @base:	the data buffer
+ *  @size:	the size that was requested when the buffer was allocated
+ */
+BIG_STATIC streams_fastcall __hot_in void
+strbuf_free(unsigned char *base, size_t size)
+{
+	int class = strbuf_class(size);
+	struct strinfo *si = &Strbufinfo[class];
+	struct strthread *t;
+	unsigned long flags;
+
+	atomic_dec(&si->si_cnt);
+	raise_local_bufcalls(1 + class, 1);
+#if defined CONFIG_NUMA
+	/* buffers homed on another node are not cached here but go straight back to their node */
+	if (unlikely(page_to_nid(virt_to_page(base)) != numa_node_id())) {
+		kmem_cache_free(si->si_cache, base);
+		return;
+	}
+#endif
+	streams_local_save(flags);
+	t = this_thread;
+	if (likely(t->bufmags[class] < STRBUF_MAGSIZE)) {
+		*(unsigned char **) base = t->bufmag_head[class];
+		t->bufmag_head[class] = base;
+		t->bufmags[class]++;
+		streams_local_restore(flags);
+		return;
+	}
+	streams_local_restore(flags);
+	kmem_cache_free(si->si_cache, base);
+}
+
+/*
+ *  strbuf_drain: - return cached data buffers to the memory caches
+ *  @t:		the STREAMS executive thread
+ *  @keep:	the number of data buffers to leave in each magazine
+ */
+STATIC streams_fastcall __unlikely void
+strbuf_drain(struct strthread *t, int keep)
+{
+	int class;
+
+	for (class = 0; class < STRBUF_CLASSES; class++) {
+		struct strinfo *si = &Strbufinfo[class];
+		unsigned char *base, *base_next;
+		unsigned long flags;
+
+		base_next = NULL;
+		streams_local_save(flags);
+		if (t->bufmags[class] > keep) {
+			unsigned char **basep = &t->bufmag_head[class];
+			int count;
+
+			/* skip the buffers to keep, the link is in the first word of each buffer */
+			for (count = 0; count < keep; count++)
+				basep = (unsigned char **) *basep;
+			base_next = *basep;
+			*basep = NULL;
+			t->bufmags[class] = keep;
+		}
+		streams_local_restore(flags);
+		while ((base = base_next) != NULL) {
+			base_next = *(unsigned char **) base;
+			kmem_cache_free(si->si_cache, base);
+		}
+	}
+}
+
+/* When we terminate we need to free any remaining data buffers for all cpus. */
+STATIC __unlikely void
+term_strbufs(void)
+{
+	unsigned int cpu;
+
+	for (cpu = 0; cpu < NR_CPUS; cpu++)
+		strbuf_drain(&strthreads[cpu], 0);
+}
+
+
 #if !defined CONFIG_STREAMS_NORECYCLE
 /* 
  *  freeblocks: - free message blocks
@@ -1314,6 +1791,14 @@ freeblocks(struct strthread *t)
 
 		streams_local_save(flags);
 		clear_bit(freeblks, &t->flags);
+		if (t->freeremote_head != NULL) {
+			/* blocks homed on other nodes are returned in the same batch */
+			*t->freemblk_tail = t->freeremote_head;
+			t->freemblk_tail = t->freeremote_tail;
+			t->freeremote_head = NULL;
+			t->freeremote_tail = &t->freeremote_head;
+			t->freeremotes = 0;
+		}
 		if (likely((mp_next = t->freemblk_head) != NULL)) {
 			t->freemblk_head = NULL;
 			t->freemblk_tail = &t->freemblk_head;
@@ -1350,8 +1835,10 @@ freeblocks(struct strthread *t)
 			kmem_cache_free(sdi->si_cache, mp);
 		} while (likely((mp = mp_next) != NULL));
 		/* raise global bufcalls if we free anything to the cache */
-		raise_bufcalls();
+		raise_bufcalls(0);
 	}
+	/* memory is being returned, trim the data buffer magazines too */
+	strbuf_drain(t, STRBUF_MAGSIZE >> 1);
 }
 
 /* When we terminate we need to free any remaining mblks for all cpus. */
@@ -1516,6 +2003,10 @@ sq_alloc(void)
 	if (likely((sq = kmem_cache_alloc(si->si_cache, GFP_KERNEL)) != NULL)) {
 		_ptrace(("syncq %p is allocated\n", sq));
 		atomic_set(&sq->sq_refs, 1);
+#if defined alloc_percpu
+		/* without counts, shared entry always takes the lock */
+		sq->sq_readers = alloc_percpu(int);
+#endif
 #if defined CONFIG_STREAMS_DEBUG
 		write_lock(&si->si_rwlock);
 		list_add_tail(&sq->sq_list, &si->si_head);
@@ -1551,6 +2042,9 @@ sq_locate(const char *sq_info)
 	   context with no locks held, therefore we use GFP_KERNEL instead of GFP_ATOMIC. */
 	if (likely((sq = kmem_cache_alloc(si->si_cache, GFP_KERNEL)) != NULL)) {
 		_ptrace(("syncq %p is allocated\n", sq));
+#if defined alloc_percpu
+		sq->sq_readers = alloc_percpu(int);
+#endif
 
 		spin_lock(&elsewhere_lock);
 
@@ -1572,6 +2066,10 @@ sq_locate(const char *sq_info)
 			write_unlock(&si->si_rwlock);
 #endif
 		} else {
+#if defined alloc_percpu
+			if (sq->sq_readers != NULL)
+				free_percpu(XCHG(&sq->sq_readers, NULL));
+#endif
 			kmem_cache_free(si->si_cache, sq);
 			sq = sq_try;
 			atomic_inc(&sq->sq_refs);
@@ -1607,6 +2105,12 @@ sq_free(struct syncq *sq)
 	assert(spin_trylock(&sq->sq_lock));
 	spin_lock_init(&sq->sq_lock);
 
+#if defined alloc_percpu
+	if (sq->sq_readers != NULL)
+		free_percpu(XCHG(&sq->sq_readers, NULL));
+#endif
+	sq->sq_xwant = 0;
+
 	assert(sq->sq_ehead == NULL);
 	sq->sq_ehead = NULL;
 	sq->sq_etail = &sq->sq_ehead;
@@ -1840,6 +2344,17 @@ find_event(long id)
 	return (se);
 }
 
+STATIC struct strevent *
+peek_event(long id)
+{
+	struct strevent *se;
+
+	for (se = event_hash[id & EVENT_HASH_MASK]; se; se = se->se_next)
+		if (se->se_id == id)
+			break;
+	return (se);
+}
+
 /**
  *  sealloc:	- allocate a stream event structure
  */
@@ -1967,27 +2482,45 @@ strsched_event(struct strevent *se)
  * @se:			the buffer callback to schedule
  *
  * This function schedules a buffer callback for future execution.  All buffer callbacks invoked on
- * the current processor are kept in a list against the current STREAMS scheduler thread.  Whenever,
- * kmem_free() frees memory of @size or greater, it sets the flag to run buffer callbacks and wakes
- * the scheduler thread.
+ * the current processor are kept in lists, by size class and priority, against the current STREAMS
+ * scheduler thread.  Whenever a buffer of a size class that can satisfy the callback is freed, the
+ * flag to run buffer callbacks is set and the scheduler thread is woken.
  */
 STATIC streams_fastcall long
 strsched_bufcall(struct strevent *se)
 {
 	long id;
 	struct strthread *t;
+	int list, band;
 
 	prefetchw(se);
 	t = this_thread;
 	prefetchw(t);
 	id = event_export(se);
 
+	switch (se->x.b.priority & 0xff) {
+	case BPRI_HI:
+	case BPRI_FT:
+	case BPRI_WAITOK:
+		band = 0;
+		break;
+	case BPRI_MED:
+		band = 1;
+		break;
+	default:
+		band = 2;
+		break;
+	}
+	list = band * STRBC_CLASSES + bufcall_class(se->x.b.size);
+
 	se->se_link = NULL;
 	{
 		unsigned long flags;
 
 		streams_local_save(flags);
-		*XCHG(&t->strbcalls_tail, &se->se_link) = se;
+		*XCHG(&t->strbcalls_tail[list], &se->se_link) = se;
+		if (unlikely(t->strbcactive != 0))
+			t->bc_retries++;
 		streams_local_restore(flags);
 	}
 	set_bit(strbcwait, &t->flags);
@@ -2005,48 +2538,277 @@ static spinlock_t timeout_list_lock = SPIN_LOCK_UNLOCKED;
 #endif
 
 /*
- *  timeout_function: - execute a linux kernel timer timeout
- *  @arg:	a pointer to the STREAMS event structure
+ *  STREAMS timer wheel
+ *  -------------------
+ *  Rather than arming a Linux kernel timer for each timeout event, timeout events are hashed into a
+ *  per-CPU hierarchical timer wheel.  The first level resolves individual ticks across
+ *  STRWHEEL_L0_SIZE slots; each further level resolves STRWHEEL_LN_BITS more bits of the expiry
+ *  time and is cascaded down into the lower levels as the wheel clock turns over.  Events are held
+ *  on doubly linked slot lists so that arming, cancelling and re-arming are all O(1).  A single
+ *  kernel timer per wheel is programmed for the next occupied first level slot (or the next cascade
+ *  boundary) and, when it fires, all expired events are spliced onto the STREAMS scheduler timeout
+ *  list in one batch with a single raise of the scheduler.
+ */
+
+/*
+ *  strwheel_slot: - determine the wheel slot for an expiry time
+ *  @w:		the timer wheel
+ *  @expires:	the expiry time in jiffies
  *
- *  When a kernel timer times out we link the original timer STREAMS event structure into the cpu
- *  list on the invoking cpu and wake up the STREAMS scheduler on that cpu.  The only problem with
- *  this approach is that recent 2.6 kernels no longer provide the ability to raise a soft irq on a
- *  different cpu.
+ *  Expiry times that have already passed are placed in the current slot.  Expiry times beyond the
+ *  range of the wheel are clamped into the last level and are cascaded again as the wheel turns.
+ */
+STATIC streams_inline streams_fastcall __hot int
+strwheel_slot(struct strwheel *w, unsigned long expires)
+{
+	unsigned long idx = expires - w->clock;
+	int lvl, shift;
+
+	if ((long) idx < 0)
+		return (w->clock & STRWHEEL_L0_MASK);
+	if (idx < STRWHEEL_L0_SIZE)
+		return (expires & STRWHEEL_L0_MASK);
+	for (lvl = 1;; lvl++) {
+		shift = STRWHEEL_L0_BITS + lvl * STRWHEEL_LN_BITS;
+		if (idx < (1UL << shift))
+			break;
+		if (lvl == STRWHEEL_LEVELS - 1) {
+			expires = w->clock + (1UL << shift) - 1;
+			break;
+		}
+	}
+	return (STRWHEEL_L0_SIZE + (lvl - 1) * STRWHEEL_LN_SIZE +
+		((expires >> (shift - STRWHEEL_LN_BITS)) & STRWHEEL_LN_MASK));
+}
+
+/*
+ *  __strwheel_link: - link a timeout event into the wheel
+ *  @w:		the timer wheel (locked)
+ *  @se:	the timeout event
+ */
+STATIC streams_inline streams_fastcall __hot void
+__strwheel_link(struct strwheel *w, struct strevent *se)
+{
+	int slot = strwheel_slot(w, se->x.t.expires);
+
+	se->x.t.tw_slot = slot;
+	if ((se->x.t.tw_next = w->slot[slot]))
+		se->x.t.tw_next->x.t.tw_prev = &se->x.t.tw_next;
+	se->x.t.tw_prev = &w->slot[slot];
+	w->slot[slot] = se;
+	if (slot < STRWHEEL_L0_SIZE)
+		__set_bit(slot, w->map);
+}
+
+/*
+ *  __strwheel_unlink: - unlink a timeout event from the wheel
+ *  @w:		the timer wheel (locked)
+ *  @se:	the timeout event
+ */
+STATIC streams_inline streams_fastcall __hot void
+__strwheel_unlink(struct strwheel *w, struct strevent *se)
+{
+	int slot = se->x.t.tw_slot;
+
+	if ((*se->x.t.tw_prev = se->x.t.tw_next))
+		se->x.t.tw_next->x.t.tw_prev = se->x.t.tw_prev;
+	se->x.t.tw_next = NULL;
+	se->x.t.tw_prev = NULL;
+	if (slot < STRWHEEL_L0_SIZE && w->slot[slot] == NULL)
+		__clear_bit(slot, w->map);
+}
+
+/*
+ *  __strwheel_program: - program the kernel timer driving the wheel
+ *  @w:		the timer wheel (locked)
+ *  @force:	reprogram even when the timer is already pending for an earlier time
  *
- *  Invoking the STREAMS scheduler in this way causes the timeout to be handled within the STREAMS
- *  scheduler environment.  Further deferral of the timeout callback might occur if processing of
- *  the timeout fails to enter the synchronization queues, if any.
+ *  The driving timer is set for the next occupied first level slot.  When no first level slot is
+ *  occupied ahead of the wheel clock, the timer is set for the next cascade boundary.  The timer is
+ *  only ever moved earlier, except from the timer function itself.
  */
-STATIC void
-timeout_function(unsigned long arg)
+STATIC streams_inline streams_fastcall void
+__strwheel_program(struct strwheel *w, int force)
 {
-	struct strevent *se = (struct strevent *) arg;
+	unsigned long idx = w->clock & STRWHEEL_L0_MASK;
+	unsigned long next;
+
+	next = w->clock + (find_next_bit(w->map, STRWHEEL_L0_SIZE, idx) - idx);
+	if (force || !timer_pending(&w->timer) || time_before(next, w->timer.expires))
+		mod_timer(&w->timer, next);
+}
 
+/*
+ *  strwheel_cascade: - cascade higher wheel levels into lower levels
+ *  @w:		the timer wheel (locked)
+ *
+ *  Called when the first level of the wheel turns over.  The current slot of each higher level is
+ *  redistributed relative to the wheel clock, proceeding to the next level only when the current
+ *  level has itself turned over.
+ */
+STATIC streams_noinline streams_fastcall void
+strwheel_cascade(struct strwheel *w)
+{
+	struct strevent *se, *se_next;
+	int lvl, idx, shift;
+
+	for (lvl = 1; lvl < STRWHEEL_LEVELS; lvl++) {
+		shift = STRWHEEL_L0_BITS + (lvl - 1) * STRWHEEL_LN_BITS;
+		idx = (w->clock >> shift) & STRWHEEL_LN_MASK;
+		se = XCHG(&w->slot[STRWHEEL_L0_SIZE + (lvl - 1) * STRWHEEL_LN_SIZE + idx], NULL);
+		for (; se; se = se_next) {
+			se_next = se->x.t.tw_next;
+			__strwheel_link(w, se);
+		}
+		if (idx != 0)
+			break;
+	}
+}
+
+/*
+ *  strwheel_function: - execute a linux kernel timer timeout for a timer wheel
+ *  @arg:	a pointer to the timer wheel
+ *
+ *  Turns the wheel up to the current time and links all expired timer STREAMS event structures onto
+ *  the cpu list on the wheel's cpu and wakes up the STREAMS scheduler on that cpu.  The only problem
+ *  with this approach is that recent 2.6 kernels no longer provide the ability to raise a soft irq
+ *  on a different cpu.
+ *
+ *  Invoking the STREAMS scheduler in this way causes the timeouts to be handled within the STREAMS
+ *  scheduler environment.  Further deferral of a timeout callback might occur if processing of the
+ *  timeout fails to enter the synchronization queues, if any.
+ */
+STATIC void
+strwheel_function(unsigned long arg)
+{
+	struct strwheel *w = (struct strwheel *) arg;
+	struct strevent *se, *se_next, *head = NULL, **tail = &head;
+	unsigned long flags, now = jiffies, idx, nxt;
+
+	spin_lock_irqsave(&w->lock, flags);
+	while (w->count != 0 && !time_after(w->clock, now)) {
+		if ((idx = w->clock & STRWHEEL_L0_MASK) == 0)
+			strwheel_cascade(w);
+		if (!test_bit(idx, w->map)) {
+			/* skip empty slots up to the next occupied slot or cascade boundary */
+			nxt = find_next_bit(w->map, STRWHEEL_L0_SIZE, idx);
+			if (time_after(w->clock + (nxt - idx), now)) {
+				w->clock = now + 1;
+				break;
+			}
+			w->clock += (nxt - idx);
+			continue;
+		}
+		__clear_bit(idx, w->map);
+		se = XCHG(&w->slot[idx], NULL);
+		for (; se; se = se_next) {
+			se_next = se->x.t.tw_next;
+			se->x.t.tw_next = NULL;
+			se->x.t.tw_prev = NULL;
+			se->se_link = NULL;
+			*tail = se;
+			tail = &se->se_link;
+			w->count--;
+			w->expired++;
+		}
+		w->clock++;
+	}
+	if (w->count != 0)
+		__strwheel_program(w, 1);
+	if (head != NULL)
+		w->batches++;
+	spin_unlock_irqrestore(&w->lock, flags);
+
+	if (head != NULL) {
 #if !defined CONFIG_STREAMS_KTHREADS || defined HAVE_KFUNC_CPU_RAISE_SOFTIRQ
-	struct strthread *t = &strthreads[se->x.t.cpu];
+		struct strthread *t = &strthreads[w->cpu];
 #else
-	struct strthread *t = this_thread;
+		struct strthread *t = this_thread;
 #endif
 
-	prefetchw(t);
-
-	se->se_link = NULL;
-	{
-		unsigned long flags;
-
-		/* Spin lock here to keep multiple processors from appending to the list at the same time.
-		   Stealing the list for processing is MP safe. */
+		prefetchw(t);
+		/* Spin lock here to keep multiple processors from appending to the list at the same
+		   time.  Stealing the list for processing is MP safe. */
 		streams_spin_lock(&timeout_list_lock, flags);
-		*XCHG(&t->strtimout_tail, &se->se_link) = se;
+		*XCHG(&t->strtimout_tail, tail) = head;
 		streams_spin_unlock(&timeout_list_lock, flags);
-	}
-	if (!test_and_set_bit(strtimout, &t->flags))
+		if (!test_and_set_bit(strtimout, &t->flags))
 #if !defined CONFIG_STREAMS_KTHREADS || defined HAVE_KFUNC_CPU_RAISE_SOFTIRQ
-		/* bind timeout back to the CPU that called for it */
-		cpu_raise_streams(se->x.t.cpu);
+			/* bind timeouts back to the CPU that called for them */
+			cpu_raise_streams(w->cpu);
 #else
-		__raise_streams();
+			__raise_streams();
 #endif
+	}
+}
+
+/*
+ *  strwheel_add: - add a timeout event to a timer wheel
+ *  @w:		the timer wheel
+ *  @se:	the timeout event
+ */
+STATIC streams_fastcall __hot void
+strwheel_add(struct strwheel *w, struct strevent *se)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&w->lock, flags);
+	if (w->count++ == 0)
+		w->clock = jiffies;
+	__strwheel_link(w, se);
+	__strwheel_program(w, 0);
+	spin_unlock_irqrestore(&w->lock, flags);
+}
+
+/*
+ *  strwheel_del: - remove a timeout event from a timer wheel
+ *  @w:		the timer wheel
+ *  @se:	the timeout event
+ *
+ *  Returns true when the event was removed from the wheel before it expired, false when the event
+ *  has already been passed to the STREAMS scheduler.  This has the same sense as del_timer().
+ */
+STATIC streams_fastcall __hot int
+strwheel_del(struct strwheel *w, struct strevent *se)
+{
+	unsigned long flags;
+	int ret = 0;
+
+	spin_lock_irqsave(&w->lock, flags);
+	if (se->x.t.tw_prev != NULL) {
+		__strwheel_unlink(w, se);
+		w->count--;
+		ret = 1;
+	}
+	spin_unlock_irqrestore(&w->lock, flags);
+	return (ret);
+}
+
+/*
+ *  strwheel_mod: - move a timeout event on a timer wheel
+ *  @w:		the timer wheel
+ *  @se:	the timeout event
+ *  @expires:	the new expiry time in jiffies
+ *
+ *  Returns true when the event was still on the wheel and has been moved, false when the event has
+ *  already been passed to the STREAMS scheduler.
+ */
+STATIC streams_fastcall __hot int
+strwheel_mod(struct strwheel *w, struct strevent *se, unsigned long expires)
+{
+	unsigned long flags;
+	int ret = 0;
+
+	spin_lock_irqsave(&w->lock, flags);
+	if (se->x.t.tw_prev != NULL) {
+		__strwheel_unlink(w, se);
+		se->x.t.expires = expires;
+		__strwheel_link(w, se);
+		__strwheel_program(w, 0);
+		ret = 1;
+	}
+	spin_unlock_irqrestore(&w->lock, flags);
+	return (ret);
 }
 
 /*
@@ -2059,9 +2821,7 @@ strsched_timeout(struct strevent *se)
 	long id;
 
 	id = event_export(se);
-	se->x.t.timer.data = (long) se;
-	se->x.t.timer.function = timeout_function;
-	add_timer(&se->x.t.timer);
+	strwheel_add(strthreads[se->x.t.cpu].wheel, se);
 	return (id);
 }
 
@@ -2093,6 +2853,8 @@ defer_bufcall_event(queue_t *q, unsigned size, int priority, void streamscall (*
 		se->x.b.func = func;
 		se->x.b.arg = arg;
 		se->x.b.size = size;
+		se->x.b.priority = priority;
+		se->x.b.armed = jiffies;
 		id = strsched_bufcall(se);
 	}
 	return (id);
@@ -2110,8 +2872,9 @@ defer_timeout_event(queue_t *q, timo_fcn_t *func, caddr_t arg, long ticks, unsig
 		se->x.t.arg = arg;
 		se->x.t.pl = pl;
 		se->x.t.cpu = cpu;
-		init_timer(&se->x.t.timer);
-		se->x.t.timer.expires = jiffies + ticks;
+		se->x.t.expires = jiffies + ticks;
+		se->x.t.tw_next = NULL;
+		se->x.t.tw_prev = NULL;
 		id = strsched_timeout(se);
 	}
 	return (id);
@@ -2336,7 +3099,7 @@ untimeout(toid_t toid)
 		return (-1);
 	spin_lock_irqsave(&event_hash_lock, flags);
 	if (likely(! !(se = find_event(toid)))) {
-		if ((rem = se->x.t.timer.expires - jiffies) < 0)
+		if ((rem = se->x.t.expires - jiffies) < 0)
 			rem = 0;
 		switch (__builtin_expect((state = se->se_state), SE_ARMED)) {
 		case SE_ARMED:
@@ -2356,7 +3119,7 @@ untimeout(toid_t toid)
 #endif
 			if (unlikely(! !q))
 				qput(&q);
-			if (likely(del_timer(&se->x.t.timer))) {
+			if (likely(strwheel_del(strthreads[se->x.t.cpu].wheel, se))) {
 				/* Cancellation before timeout function could schedule event against
 				   processor, the streams scheduler will never see the cancellation so we
 				   will have to terminate it. */
@@ -2393,6 +3156,36 @@ untimeout(toid_t toid)
 
 EXPORT_SYMBOL(untimeout);	/* include/sys/openss7/stream.h */
 
+/**
+ *  __retimeout: - re-arm a pending timeout callback
+ *  @toid:	timeout identifier
+ *  @ticks:	the number of clock ticks to wait from now
+ *
+ *  Moves a timeout that has not yet expired to a new expiry time on the timer wheel without
+ *  releasing and reallocating its event structure.  Returns @toid when the timeout was re-armed, or
+ *  zero when the timeout has already expired, is being processed or was cancelled, in which case the
+ *  caller must fall back to untimeout() and timeout().
+ */
+streams_fastcall toid_t
+__retimeout(toid_t toid, long ticks)
+{
+	struct strevent *se;
+	unsigned long flags;
+	toid_t rval = 0;
+
+	if (unlikely(toid == 0))
+		return (0);
+	spin_lock_irqsave(&event_hash_lock, flags);
+	if (likely(! !(se = peek_event(toid))) && ((struct seinfo *) se)->s_type == SE_TIMEOUT
+	    && se->se_state == SE_ARMED)
+		if (strwheel_mod(strthreads[se->x.t.cpu].wheel, se, jiffies + ticks))
+			rval = toid;
+	spin_unlock_irqrestore(&event_hash_lock, flags);
+	return (rval);
+}
+
+EXPORT_SYMBOL_GPL(__retimeout);	/* include/sys/openss7/strsubr.h */
+
 /*
  *  __weldq:	- weld two queue pairs together
  *  @q1:	first queue to weld
@@ -2623,6 +3416,143 @@ freezechk(queue_t *q)
 }
 #endif
 
+/*
+ *  -------------------------------------------------------------------------
+ *
+ *  STREAMS flow trace
+ *
+ *  -------------------------------------------------------------------------
+ *  When flow trace is on for a Stream (I_STRFTON), each put procedure, putq(9), getq(9) and service
+ *  procedure hop appends an event with the module id and a str_clock() timestamp to a global ring
+ *  of events.  The ring holds the most recent STRFT_NEVNTS events for all traced Streams and is read
+ *  with I_STRFTSTR or I_STRFTALL.  When no Stream is traced, the cost of a hop is one atomic_read().
+ */
+
+#define STRFT_NEVNTS	1024	/* power of 2 */
+
+atomic_t strft_active = ATOMIC_INIT(0);
+
+EXPORT_SYMBOL_GPL(strft_active);	/* src/kernel/strsched.h */
+
+static struct strftevnt strft_ring[STRFT_NEVNTS];
+static unsigned int strft_head;		/* next event to write */
+static unsigned int strft_tail;		/* oldest event not yet fetched */
+
+#if	defined DEFINE_SPINLOCK
+static DEFINE_SPINLOCK(strft_lock);
+#elif	defined __SPIN_LOCK_UNLOCKED
+static spinlock_t strft_lock = __SPIN_LOCK_UNLOCKED(strft_lock);
+#elif	defined SPIN_LOCK_UNLOCKED
+static spinlock_t strft_lock = SPIN_LOCK_UNLOCKED;
+#else
+#error cannot initialize spin locks
+#endif
+
+/**
+ *  strft_event: - record a flow trace event
+ *  @sd:	Stream head of the queue
+ *  @q:		queue at which the event occured
+ *  @mp:	message (or NULL for FTEV_SRVP)
+ *  @ev:	event type (FTEV_*)
+ *
+ *  Called by strftrace() only when some Stream has flow trace on.  The message identifier is the
+ *  low order bits of the message block address: it is constant for the life of the message and
+ *  costs no space in the message block (adding to struct mbinfo would shrink FASTBUF).
+ */
+streams_fastcall __unlikely void
+strft_event(struct stdata *sd, queue_t *q, mblk_t *mp, int ev)
+{
+	struct strftevnt *fe;
+	unsigned long flags;
+
+	if (likely(sd == NULL || !test_bit(STRFTRACE_BIT, &sd->sd_flag)))
+		return;
+	if (test_bit(QREADR_BIT, &q->q_flag))
+		ev |= FTEV_READ;
+	spin_lock_irqsave(&strft_lock, flags);
+	fe = &strft_ring[strft_head & (STRFT_NEVNTS - 1)];
+	fe->fe_ts = str_clock();
+	fe->fe_dev = sd->sd_dev;
+	fe->fe_msgid = (unsigned int) (unsigned long) mp;
+	fe->fe_mid = q->q_qinfo->qi_minfo->mi_idnum;
+	fe->fe_evnt = ev;
+	fe->fe_count = q->q_count;
+	strft_head++;
+	spin_unlock_irqrestore(&strft_lock, flags);
+}
+
+EXPORT_SYMBOL_GPL(strft_event);	/* src/kernel/strsched.h */
+
+/**
+ *  strft_fetch: - fetch flow trace events
+ *  @dev:	device number of the Stream
+ *  @all:	fetch events for all Streams instead of @dev
+ *  @buf:	kernel buffer for events
+ *  @count:	number of events that fit in @buf
+ *  @lostp:	where to return the number of events lost to overwrite
+ *
+ *  Copies the matching unfetched events, oldest first, and returns the number copied.  Events that
+ *  are copied are consumed; events for other Streams remain for their own I_STRFTSTR or for
+ *  I_STRFTALL.
+ */
+streams_fastcall __unlikely int
+strft_fetch(dev_t dev, int all, struct strftevnt *buf, int count, int *lostp)
+{
+	unsigned int i;
+	unsigned long flags;
+	int n = 0, lost = 0;
+
+	spin_lock_irqsave(&strft_lock, flags);
+	if (strft_head - strft_tail > STRFT_NEVNTS) {
+		lost = strft_head - strft_tail - STRFT_NEVNTS;
+		strft_tail = strft_head - STRFT_NEVNTS;
+	}
+	for (i = strft_tail; i != strft_head && n < count; i++) {
+		struct strftevnt *fe = &strft_ring[i & (STRFT_NEVNTS - 1)];
+
+		if (fe->fe_evnt == 0)
+			continue;
+		if (!all && fe->fe_dev != dev)
+			continue;
+		buf[n++] = *fe;
+		fe->fe_evnt = 0;
+	}
+	/* advance past the consumed prefix */
+	while (strft_tail != strft_head && strft_ring[strft_tail & (STRFT_NEVNTS - 1)].fe_evnt == 0)
+		strft_tail++;
+	spin_unlock_irqrestore(&strft_lock, flags);
+	*lostp = lost;
+	return (n);
+}
+
+EXPORT_SYMBOL_GPL(strft_fetch);	/* src/kernel/strsched.h */
+
+/**
+ *  strft_zero: - discard flow trace events
+ *  @dev:	device number of the Stream
+ */
+streams_fastcall __unlikely void
+strft_zero(dev_t dev)
+{
+	unsigned int i;
+	unsigned long flags;
+
+	spin_lock_irqsave(&strft_lock, flags);
+	if (strft_head - strft_tail > STRFT_NEVNTS)
+		strft_tail = strft_head - STRFT_NEVNTS;
+	for (i = strft_tail; i != strft_head; i++) {
+		struct strftevnt *fe = &strft_ring[i & (STRFT_NEVNTS - 1)];
+
+		if (fe->fe_dev == dev)
+			fe->fe_evnt = 0;
+	}
+	while (strft_tail != strft_head && strft_ring[strft_tail & (STRFT_NEVNTS - 1)].fe_evnt == 0)
+		strft_tail++;
+	spin_unlock_irqrestore(&strft_lock, flags);
+}
+
+EXPORT_SYMBOL_GPL(strft_zero);	/* src/kernel/strsched.h */
+
 /*
  *  putp_fast:	- execute a queue's put procedure
  *  @q:		the queue onto which to put the message
@@ -2670,6 +3600,13 @@ putp_fast(queue_t *q, mblk_t *mp)
 		if (likely(q->q_qinfo->qi_mstat != NULL))
 			q->q_qinfo->qi_mstat->ms_pcnt++;
 #endif
+		strftrace(sd, q, mp, FTEV_PUT);
+		{
+			struct qhist *qh;
+
+			if (unlikely((qh = qhist(q)) != NULL))
+				qhist_put(qh, q);
+		}
 		/* some weirdness in older compilers */
 		(*q->q_putp) (q, mp);
 		qwakeup(q);
@@ -2753,9 +3690,17 @@ srvp_fast(queue_t *q)
 			if (unlikely(q->q_qinfo->qi_mstat != NULL))
 				q->q_qinfo->qi_mstat->ms_scnt++;
 #endif
+			strftrace(sd, q, NULL, FTEV_SRVP);
 			set_bit(QSVCBUSY_BIT, &q->q_flag);
-			/* some weirdness in older compilers */
-			(*q->q_srvp) (q);
+			if (unlikely(qhist(q) != NULL)) {
+				struct qhist *qh = qhist(q);
+				unsigned long long start = qhist_srvp_start(qh, q);
+
+				(*q->q_srvp) (q);
+				qhist_srvp_end(qh, q, start);
+			} else
+				/* some weirdness in older compilers */
+				(*q->q_srvp) (q);
 			clear_bit(QSVCBUSY_BIT, &q->q_flag);
 			qwakeup(q);
 		}
@@ -2874,21 +3819,104 @@ void runsyncq(struct syncq *);
  *  clear_backlog:	- clear the syncrhonization task backlog on a synchronization queue.
  *  @sq:		the synchronization queue to clear
  *
- *  CONTEXT: This function can be called from any context, and we do, but only from leave_syncq().
- *  The backlog can only be cleared when the caller is in_streams() context, otherwise we might make
- *  the mistake of clearing the backlog at interrupt or, worse, on the ICS.
+ *  CONTEXT: This function can be called from any context, and we do, but only from leave_syncq().
+ *  The backlog can only be cleared when the caller is in_streams() context, otherwise we might make
+ *  the mistake of clearing the backlog at interrupt or, worse, on the ICS.
+ *
+ *  NOTICES: It is questionable whether it is better to service the backlog from the exiting thread
+ *  or to simply schedule the synchronization queue to have its backlog cleared.  Clearing it now
+ *  could have some latency advantages because we do not have to task switch, however, it might fail
+ *  to take advantage of some inherent paralellisms.
+ */
+STATIC void
+clear_backlog(syncq_t *sq)
+{
+	runsyncq(sq);
+}
+#endif
+
+#if defined alloc_percpu
+/*
+ *  Shared entry fast path.
+ *
+ *  Threads entering a synchronization queue shared count themselves in the per-CPU sq_readers
+ *  counts instead of in sq_count, and do so without taking the synchronization queue lock when no
+ *  exclusive entry is held or wanted (sq_xwant is clear).  For such a synchronization queue,
+ *  sq_count is only ever zero or -1.  An exclusive entrant sets sq_xwant under the lock, diverting
+ *  new shared entrants to the lock, and then sums the per-CPU counts: it can only enter when the sum
+ *  is zero, otherwise it defers or blocks as it always did against shared entrants.  The last shared
+ *  thread to leave while sq_xwant is set takes the lock and picks up any backlog.  The full barriers
+ *  on both sides ensure that either the shared entrant sees sq_xwant or the exclusive entrant sees
+ *  the shared count.  A thread can enter on one processor and leave on another, so that individual
+ *  counts can go negative: only the sum means anything.
+ */
+STATIC streams_inline streams_fastcall void
+sq_readers_add(syncq_t *sq, int val)
+{
+	unsigned long flags;
+
+	streams_local_save(flags);
+	*per_cpu_ptr(sq->sq_readers, smp_processor_id()) += val;
+	streams_local_restore(flags);
+}
+
+STATIC streams_fastcall int
+sq_readers_sum(syncq_t *sq)
+{
+	int cpu, sum = 0;
+
+	for_each_possible_cpu(cpu)
+		sum += *per_cpu_ptr(sq->sq_readers, cpu);
+	return (sum);
+}
+
+/*
+ *  sq_enter_fast: - count a shared entry and check for exclusive entrants
+ *  @sq:	synchronization queue with per-CPU counts
+ *
+ *  Returns true when the synchronization queue was entered shared without the lock.  When false is
+ *  returned the shared entry remains counted, and the caller must take the lock and check sq_count.
+ */
+STATIC streams_inline streams_fastcall __hot int
+sq_enter_fast(syncq_t *sq)
+{
+	sq_readers_add(sq, 1);
+	smp_mb();
+	return (likely(sq->sq_xwant == 0));
+}
+
+/*
+ *  sq_exclus_ok: - check that there are no shared entrants counted per-CPU
+ *  @sq:	synchronization queue with a zero sq_count
  *
- *  NOTICES: It is questionable whether it is better to service the backlog from the exiting thread
- *  or to simply schedule the synchronization queue to have its backlog cleared.  Clearing it now
- *  could have some latency advantages because we do not have to task switch, however, it might fail
- *  to take advantage of some inherent paralellisms.
+ *  Called with the synchronization queue lock held.  Leaves sq_xwant set so that new shared
+ *  entrants take the lock; it is cleared again when the synchronization queue is finally unlocked.
  */
-STATIC void
-clear_backlog(syncq_t *sq)
+STATIC streams_inline streams_fastcall int
+sq_exclus_ok(syncq_t *sq)
 {
-	runsyncq(sq);
+	if (sq->sq_readers == NULL)
+		return (1);
+	sq->sq_xwant = 1;
+	smp_mb();
+	return (sq_readers_sum(sq) == 0);
 }
+#else				/* defined alloc_percpu */
+#define sq_exclus_ok(sq) (1)
+#endif				/* defined alloc_percpu */
+
+/* enter shared with the synchronization queue lock held and sq_count not negative */
+STATIC streams_inline streams_fastcall void
+sq_enter_shared_locked(syncq_t *sq)
+{
+#if defined alloc_percpu
+	if (sq->sq_readers != NULL) {
+		sq_readers_add(sq, 1);
+		return;
+	}
 #endif
+	sq->sq_count++;
+}
 
 /**
  *  sqsched - schedule a synchronization queue
@@ -2938,12 +3966,38 @@ leave_syncq(syncq_t *sq)
 {
 	unsigned long flags;
 
+#if defined alloc_percpu
+	if (likely(sq->sq_readers != NULL) && likely(sq->sq_owner != current)) {
+		/* leaving shared: only the last one out with an exclusive entrant waiting locks */
+		sq_readers_add(sq, -1);
+		smp_mb();
+		if (likely(sq->sq_xwant == 0))
+			return;
+		spin_lock_irqsave(&sq->sq_lock, flags);
+		if (sq->sq_count == 0 && sq_readers_sum(sq) == 0) {
+			if (likely(!sq->sq_ehead) && likely(!sq->sq_qhead) && likely(!sq->sq_mhead)) {
+				sq->sq_xwant = 0;
+				/* blocking exclusive entrants wait for the shared entrants to drain */
+				if (unlikely(waitqueue_active(&sq->sq_waitq)))
+					wake_up_all(&sq->sq_waitq);
+			} else {
+				sq->sq_xwant = 1;
+				sq->sq_owner = current;
+				sq->sq_count = -1;
+				sqsched(sq);
+			}
+		}
+		spin_unlock_irqrestore(&sq->sq_lock, flags);
+		return;
+	}
+#endif
 	spin_lock_irqsave(&sq->sq_lock, flags);
 	if ((sq->sq_count < 0 && sq->sq_owner == current)
 	    || (sq->sq_count >= 0 && --sq->sq_count <= 0)) {
 		if (likely(!sq->sq_ehead) && likely(!sq->sq_qhead) && likely(!sq->sq_mhead)) {
 			sq->sq_owner = NULL;
 			sq->sq_count = 0;
+			sq->sq_xwant = 0;
 		} else {
 			sq->sq_owner = current;
 			sq->sq_count = -1;
@@ -2984,7 +4038,7 @@ enter_syncq_exclus(struct syncq_cookie *sc)
 
 	spin_lock_irqsave(&sq->sq_lock, flags);
 	/* Note that syncrhonization queues are always left exclusively locked when there is a backlog. */
-	if (likely(sq->sq_count == 0)) {
+	if (likely(sq->sq_count == 0) && likely(sq_exclus_ok(sq))) {
 		sq->sq_count = -1;
 		sq->sq_owner = current;
 	} else {
@@ -3009,6 +4063,20 @@ enter_syncq_shared(struct syncq_cookie *sc)
 	syncq_t *sq = sc->sc_sq;
 	unsigned long flags;
 
+#if defined alloc_percpu
+	if (likely(sq->sq_readers != NULL)) {
+		if (likely(sq_enter_fast(sq)))
+			return (1);
+		spin_lock_irqsave(&sq->sq_lock, flags);
+		/* keep the count unless the barrier is held exclusive */
+		if (unlikely(sq->sq_count < 0)) {
+			sq_readers_add(sq, -1);
+			rval = defer_syncq(sc);
+		}
+		spin_unlock_irqrestore(&sq->sq_lock, flags);
+		return (rval);
+	}
+#endif
 	spin_lock_irqsave(&sq->sq_lock, flags);
 	/* Note that syncrhonization queues are always left exclusively locked when there is a backlog. */
 	if (likely(sq->sq_count >= 0)) {
@@ -3181,11 +4249,12 @@ enter_syncq_shared_blocking_slow(struct syncq_cookie *sc)
 		if (likely(osq->sq_count >= 0)) {
 			/* Now try to get through second barrier. */
 			spin_lock(&isq->sq_lock);
-			if (isq->sq_count == 0 || (isq->sq_count == -1 && isq->sq_owner == NULL)) {
+			if ((isq->sq_count == 0 && sq_exclus_ok(isq))
+			    || (isq->sq_count == -1 && isq->sq_owner == NULL)) {
 				isq->sq_count = -1;
 				isq->sq_owner = current;
 				spin_unlock(&isq->sq_lock);
-				osq->sq_count++;
+				sq_enter_shared_locked(osq);
 				sc->sc_sq = isq;
 				break;
 			}
@@ -3229,11 +4298,11 @@ enter_syncq_shared_blocking(struct syncq_cookie *sc)
 	spin_lock(&osq->sq_lock);
 	if (likely(osq->sq_count >= 0)) {
 		spin_lock(&isq->sq_lock);
-		if (likely(isq->sq_count == 0)) {
+		if (likely(isq->sq_count == 0) && likely(sq_exclus_ok(isq))) {
 			isq->sq_count = -1;
 			isq->sq_owner = current;
 			spin_unlock(&isq->sq_lock);
-			osq->sq_count++;
+			sq_enter_shared_locked(osq);
 			spin_unlock(&osq->sq_lock);
 			sc->sc_sq = isq;
 			local_irq_restore(flags);
@@ -3257,7 +4326,8 @@ enter_syncq_exclus_blocking_slow(struct syncq_cookie *sc)
 	add_wait_queue(&sq->sq_waitq, &wait);
 	spin_lock_irqsave(&sq->sq_lock, flags);
 	for (;;) {
-		if (sq->sq_count == 0 || (sq->sq_count == -1 && sq->sq_owner == NULL)) {
+		if ((sq->sq_count == 0 && sq_exclus_ok(sq))
+		    || (sq->sq_count == -1 && sq->sq_owner == NULL)) {
 			sq->sq_count = -1;
 			sq->sq_owner = current;
 			break;
@@ -3279,7 +4349,7 @@ enter_syncq_exclus_blocking(struct syncq_cookie *sc)
 	unsigned long flags;
 
 	spin_lock_irqsave(&sq->sq_lock, flags);
-	if (likely(sq->sq_count == 0)) {
+	if (likely(sq->sq_count == 0) && likely(sq_exclus_ok(sq))) {
 		sq->sq_count = -1;
 		sq->sq_owner = current;
 		spin_unlock_irqrestore(&sq->sq_lock, flags);
@@ -4719,7 +5789,7 @@ kmem_free(void *addr, size_t size)
 {
 	kfree(addr);
 	if (likely(size >= 0))
-		raise_bufcalls();
+		raise_bufcalls(bufcall_class(size));
 }
 
 EXPORT_SYMBOL(kmem_free);	/* include/sys/openss7/kmem.h */
@@ -4732,12 +5802,18 @@ EXPORT_SYMBOL(kmem_free);	/* include/sys/openss7/kmem.h */
  *  kmem_alloc_node: - allocate memory
  *  @size:	amount of memory to allocate in bytes
  *  @flags:	either %KM_SLEEP or %KM_NOSLEEP
- *  @node:
+ *  @node:	the NUMA node from which to allocate (-1 for any node)
  */
 streams_fastcall void *
 kmem_alloc_node(size_t size, int flags, cnodeid_t node)
 {
-	return kmalloc(size, GFP_KERNEL);
+	int gfp = ((flags & KM_NOSLEEP) ? GFP_ATOMIC : GFP_KERNEL) | ((flags & KM_DMA) ? GFP_DMA : 0);
+
+#if defined HAVE_KFUNC_KMALLOC_NODE && defined CONFIG_NUMA
+	if (node >= 0)
+		return kmalloc_node(size, gfp, node);
+#endif
+	return kmalloc(size, gfp);
 }
 
 EXPORT_SYMBOL(kmem_alloc_node);	/* include/sys/openss7/kmem.h */
@@ -4746,14 +5822,14 @@ EXPORT_SYMBOL(kmem_alloc_node);	/* include/sys/openss7/kmem.h */
  *  kmem_zalloc: - allocate and zero memory
  *  @size:	amount of memory to allocate in bytes
  *  @flags:	either %KM_SLEEP or %KM_NOSLEEP
- *  @node:
+ *  @node:	the NUMA node from which to allocate (-1 for any node)
  */
 streams_fastcall void *
 kmem_zalloc_node(size_t size, int flags, cnodeid_t node)
 {
 	void *mem;
 
-	if ((mem = kmalloc(size, GFP_KERNEL)))
+	if ((mem = kmem_alloc_node(size, flags, node)))
 		memset(mem, 0, size);
 	return (mem);
 }
@@ -5089,8 +6165,10 @@ runsyncq(struct syncq *sq)
 	   pick it up, the others will wait some more */
 	if (unlikely(waitqueue_active(&sq->sq_waitq)))
 		wake_up_all(&sq->sq_waitq);
-	else
+	else {
 		sq->sq_count = 0;
+		sq->sq_xwant = 0;
+	}
 	spin_unlock_irqrestore(&sq->sq_lock, flags);
 }
 
@@ -5145,42 +6223,324 @@ backlog(struct strthread *t)
  *  onto their memory and blocks, and request more, and fail on allocation, then the streams
  *  subsystem will hang until an external event kicks it.  Therefore, we kick the chain every time
  *  an allocation is successful.
+ *
+ *  Rather than retrying every waiting callback whenever anything is freed, each buffer freed since
+ *  the last pass credits its size class, and each credit runs one waiting callback of that class or
+ *  of a lower one (charging the smallest class with credit), highest priority first and then in
+ *  order of arrival.  A callback that has waited STRBC_STARVE is run whether or not there is credit
+ *  for it.  Credit that cannot satisfy any waiting callback is discarded.
  */
 streams_noinline streams_fastcall __unlikely void
 bufcalls(struct strthread *t)
 {
-	struct strevent *se, *se_link;
+	int credit[STRBC_CLASSES];
+	struct strevent *se;
 	unsigned long flags;
-	int runs = 0;
+	int band, class, list;
 
-	do {
-		prefetchw(t);
-		streams_local_save(flags);
-		clear_bit(strbcwait, &t->flags);
-		clear_bit(strbcflag, &t->flags);
-		se_link = XCHG(&t->strbcalls_head, NULL);
-		t->strbcalls_tail = &t->strbcalls_head;
-		streams_local_restore(flags);
-		if (likely(se_link != NULL)) {
-			se = se_link;
-			do {
-				se_link = se->se_link;
+	prefetchw(t);
+	clear_bit(strbcflag, &t->flags);
+	for (class = 0; class < STRBC_CLASSES; class++) {
+		credit[class] = atomic_read(&t->strbcredit[class]);
+		atomic_sub(credit[class], &t->strbcredit[class]);
+	}
+	for (band = 0; band < STRBC_BANDS; band++) {
+		for (class = 0; class < STRBC_CLASSES; class++) {
+			list = band * STRBC_CLASSES + class;
+			/* only this processor removes waiters, so the head can be read unlocked */
+			while ((se = t->strbcalls_head[list]) != NULL) {
+				if (likely(se->se_state != SE_CANCELLED)) {
+					int k;
+
+					for (k = class; k < STRBC_CLASSES && credit[k] == 0; k++) ;
+					if (k < STRBC_CLASSES) {
+						credit[k]--;
+						t->bc_wakeups++;
+					} else if (time_after_eq(jiffies, se->x.b.armed + STRBC_STARVE))
+						t->bc_starved++;
+					else
+						break;
+				}
+				streams_local_save(flags);
+				if ((t->strbcalls_head[list] = se->se_link) == NULL)
+					t->strbcalls_tail[list] = &t->strbcalls_head[list];
+				streams_local_restore(flags);
 				se->se_link = NULL;
+				t->strbcactive = 1;
 				/* this might further defer against a synchronization queue */
 				do_bufcall_event(se);
-			} while (unlikely((se = se_link) != NULL));
+				t->strbcactive = 0;
+			}
+		}
+	}
+	streams_local_save(flags);
+	for (list = 0; list < STRBC_LISTS && t->strbcalls_head[list] == NULL; list++) ;
+	if (list == STRBC_LISTS)
+		clear_bit(strbcwait, &t->flags);
+	streams_local_restore(flags);
+}
+
+/*
+ *  Work-stealing deque.
+ *
+ *  When the wsteal sysctl is set, qschedule() places queues on a bounded deque in the scheduling
+ *  thread instead of its run list.  Only the owning CPU pushes onto the deque (with local
+ *  interrupts suppressed, as for the run list), but any CPU can take from it: the owner from
+ *  queuerun() and idle threads from queuesteal().  Takers claim a slot by advancing the take index
+ *  with a compare-and-exchange, so no lock is required.  When the deque is full, queues simply
+ *  overflow onto the normal run list.
+ */
+
+/*
+ *  stealq_busy:	- check whether a queue should be left to its owning thread
+ *  @q:		queue to check
+ *
+ *  A thief must not take a queue whose service procedure is already running elsewhere, nor one
+ *  whose synchronization queue is currently entered: it would only block or defer against the
+ *  perimeter on the thief's processor.  This is a hint checked without locks.  Queue structures
+ *  are type-stable under rcu_read_lock() when the caches are created with SLAB_DESTROY_BY_RCU.
+ */
+STATIC streams_inline streams_fastcall int
+stealq_busy(queue_t *q)
+{
+	if (test_bit(QSVCBUSY_BIT, &q->q_flag))
+		return (1);
+#ifdef CONFIG_STREAMS_SYNCQS
+	if (test_bit(QSYNCH_BIT, &q->q_flag)) {
+		struct syncq *sq;
+
+		if ((sq = q->q_syncq) != NULL && sq->sq_count != 0)
+			return (1);
+	}
+#endif
+	return (0);
+}
+
+/*
+ *  stealq_take:	- take a queue from the front of a work-stealing deque
+ *  @t:		STREAMS execution thread owning the deque
+ *  @thief:	true when not called by the owning thread
+ *
+ *  Returns the queue (with the reference acquired in stealq_push()) or NULL when the deque is
+ *  empty or, for a thief, the queue at the front is busy.
+ */
+STATIC streams_fastcall queue_t *
+stealq_take(struct strthread *t, int thief)
+{
+	queue_t *q;
+	int top, bot;
+
+	for (;;) {
+		top = atomic_read(&t->stealq_top);
+		smp_rmb();
+		bot = atomic_read(&t->stealq_bot);
+		if ((int) (bot - top) <= 0)
+			return (NULL);
+		smp_rmb();
+		q = t->stealq[top & (STEALQ_SIZE - 1)];
+		if (thief) {
+			int busy;
+
+			rcu_read_lock();
+			busy = stealq_busy(q);
+			rcu_read_unlock();
+			if (busy)
+				return (NULL);
+		}
+		if (atomic_cmpxchg(&t->stealq_top, top, top + 1) == top)
+			return (q);
+	}
+}
+
+/*
+ *  runq_cpu_ok:	- check whether a processor may run queue service procedures
+ *  @cpu:	the processor
+ *
+ *  The runq_cpus sysctl masks the first BITS_PER_LONG processors.  Processors beyond the mask are
+ *  always permitted.
+ */
+STATIC streams_inline streams_fastcall int
+runq_cpu_ok(int cpu)
+{
+	return (cpu >= BITS_PER_LONG || (sysctl_str_runq_cpus & (1UL << cpu)) != 0);
+}
+
+/*
+ *  stealq_target:	- find a processor to run the queues of an excluded processor
+ *  @t:		STREAMS execution thread of the excluded processor
+ *
+ *  Returns the next online permitted processor whose STREAMS thread is idle, otherwise the first
+ *  online permitted processor, or -1 when there is none.
+ */
+STATIC streams_noinline streams_fastcall __unlikely int
+stealq_target(struct strthread *t)
+{
+	int self = t - strthreads, first = -1, i;
+
+	for (i = 1; i < NR_CPUS; i++) {
+		int cpu = (self + i) % NR_CPUS;
+		struct strthread *o;
+
+		if (!cpu_online(cpu) || !runq_cpu_ok(cpu))
+			continue;
+		o = &strthreads[cpu];
+		if (((volatile unsigned long) o->flags & (QRUNFLAGS)) == 0
+		    && atomic_read(&o->lock) == 0)
+			return (cpu);
+		if (first < 0)
+			first = cpu;
+	}
+	return (first);
+}
+
+/*
+ *  stealq_kick:	- wake an idle STREAMS thread to steal work
+ *  @t:		STREAMS execution thread with the backlog
+ *
+ *  Finds the next online permitted processor whose STREAMS thread has nothing to do and is not
+ *  running, and raises its scheduler with the qstealflag set.
+ */
+STATIC streams_noinline streams_fastcall __unlikely void
+stealq_kick(struct strthread *t)
+{
+	int self = t - strthreads, i;
+
+	for (i = 1; i < NR_CPUS; i++) {
+		int cpu = (self + i) % NR_CPUS;
+		struct strthread *o;
+
+		if (!cpu_online(cpu) || !runq_cpu_ok(cpu))
+			continue;
+		o = &strthreads[cpu];
+		if (((volatile unsigned long) o->flags & (QRUNFLAGS)) != 0)
+			continue;
+		if (atomic_read(&o->lock) != 0)
+			continue;
+		if (!test_and_set_bit(qstealflag, &o->flags))
+			cpu_raise_streams(cpu);
+		break;
+	}
+}
+
+/**
+ *  stealq_push:	- place a queue on the local work-stealing deque
+ *  @t:		STREAMS execution thread (must be this_thread)
+ *  @q:		the queue to schedule
+ *
+ *  Called by qschedule() with local interrupts suppressed.  Returns true when the queue was placed
+ *  on the deque and false if the deque is full, in which case the caller must place the queue on
+ *  the run list.  A processor excluded by the runq_cpus sysctl always uses the deque and hands each
+ *  queue to a permitted processor; when no permitted processor is online, the queue is left to the
+ *  run list.
+ */
+BIG_STATIC streams_fastcall int
+stealq_push(struct strthread *t, queue_t *q)
+{
+	int bot, top, cpu = -1;
+
+	if (unlikely(!runq_cpu_ok(t - strthreads))) {
+		if ((cpu = stealq_target(t)) < 0)
+			return (0);
+	} else if (sysctl_str_wsteal == 0)
+		return (0);
+	bot = atomic_read(&t->stealq_bot);
+	top = atomic_read(&t->stealq_top);
+	if (unlikely((int) (bot - top) >= STEALQ_SIZE))
+		return (0);
+	t->stealq[bot & (STEALQ_SIZE - 1)] = qget(q);
+	smp_wmb();
+	atomic_set(&t->stealq_bot, bot + 1);
+	if (unlikely(cpu >= 0)) {
+		if (!test_and_set_bit(qstealflag, &strthreads[cpu].flags))
+			cpu_raise_streams(cpu);
+	} else if (unlikely((ulong) (bot + 1 - top) > sysctl_str_wsteal_thresh))
+		stealq_kick(t);
+	return (1);
+}
+
+/*
+ *  queuesteal:	- steal service procedures from busy STREAMS threads
+ *  @t:		STREAMS execution thread
+ *
+ *  Invoked when an idle thread has been kicked by a busy one.  Takes up to half of the backlog from
+ *  the first other processor that has one, and runs the service procedures locally.  Stealing
+ *  stops as soon as local work is scheduled.  The whole backlog of any processor excluded by the
+ *  runq_cpus sysctl is also taken, regardless of the wsteal sysctl, as that processor does not run
+ *  it itself.
+ */
+streams_noinline streams_fastcall __unlikely void
+queuesteal(struct strthread *t)
+{
+	int self = smp_processor_id(), i;
+
+	clear_bit(qstealflag, &t->flags);
+	for (i = 1; i < NR_CPUS; i++) {
+		int cpu = (self + i) % NR_CPUS, n, away;
+		struct strthread *o;
+		queue_t *q;
+
+		if (!cpu_online(cpu))
+			continue;
+		away = !runq_cpu_ok(cpu);
+		if (!away && sysctl_str_wsteal == 0)
+			continue;
+		o = &strthreads[cpu];
+		n = atomic_read(&o->stealq_bot) - atomic_read(&o->stealq_top);
+		if (!away)
+			n = (n + 1) >> 1;
+		if (n <= 0)
+			continue;
+		while (n-- > 0 && (q = stealq_take(o, !away)) != NULL) {
+#ifdef CONFIG_STREAMS_SYNCQS
+			qsrvp(q);
+#else
+			srvp_fast(q);
+#endif
+			if (!away && unlikely(test_bit(qrunflag, &t->flags) != 0))
+				return;
 		}
-	} while (unlikely(test_bit(strbcflag, &t->flags) != 0) && ++runs < 10);
+		if (!away)
+			break;
+	}
+}
+
+/*
+ *  queueleft:	- return queues left over at the end of a budgeted pass
+ *  @t:		STREAMS execution thread
+ *  @q_link:	the remaining chain of scheduled queues
+ *
+ *  Places the chain back at the head of the run list so that the queues are the first serviced on
+ *  the next pass, and accounts for them in the leftover counter.
+ */
+STATIC streams_noinline streams_fastcall __unlikely void
+queueleft(struct strthread *t, queue_t *q_link)
+{
+	queue_t **qp;
+	unsigned long flags;
+	int count = 0;
+
+	for (qp = &q_link; (*qp); qp = &(*qp)->q_link)
+		count++;
+	streams_local_save(flags);
+	if ((*qp = t->qhead) == NULL)
+		t->qtail = qp;
+	t->qhead = q_link;
+	streams_local_restore(flags);
+	set_bit(qrunflag, &t->flags);
+	t->runq_leftover += count;
 }
 
 /**
  *  queuerun:	- process service procedures
  *  @t:		STREAMS execution thread
+ *  @deadline:	str_clock() time at which the pass must stop, or zero
  *
- *  Run queue service procedures.
+ *  Run queue service procedures: first those on the run list and then those on the work-stealing
+ *  deque that have not been stolen by other threads.  When a deadline is given, the run stops after
+ *  the service procedure that passes it and the remaining queues are left for the next pass.
  */
 STATIC streams_fastcall __hot_in void
-queuerun(struct strthread *t)
+queuerun(struct strthread *t, unsigned long long deadline)
 {
 	queue_t *q, *q_link;
 	unsigned long flags;
@@ -5203,9 +6563,31 @@ queuerun(struct strthread *t)
 				srvp_fast(q);
 #endif
 				prefetchw(q_link);
+				if (unlikely(deadline != 0) && q_link != NULL && str_clock() >= deadline) {
+					queueleft(t, q_link);
+					return;
+				}
 			} while (unlikely((q = q_link) != NULL));
 			prefetchw(t->qhead);
 		}
+		/* the deque of an excluded processor is left to permitted ones */
+		while (likely(runq_cpu_ok(t - strthreads))
+		       && unlikely((q = stealq_take(t, 0)) != NULL)) {
+#ifdef CONFIG_STREAMS_SYNCQS
+			qsrvp(q);
+#else
+			srvp_fast(q);
+#endif
+			if (unlikely(deadline != 0) && str_clock() >= deadline) {
+				int left = atomic_read(&t->stealq_bot) - atomic_read(&t->stealq_top);
+
+				if (left > 0) {
+					t->runq_leftover += left;
+					set_bit(qrunflag, &t->flags);
+				}
+				return;
+			}
+		}
 	} while (unlikely(test_bit(qrunflag, &t->flags) != 0) && ++runs < 10);
 }
 
@@ -5219,7 +6601,7 @@ queuerun(struct strthread *t)
 streams_noinline streams_fastcall __unlikely void
 freechains(struct strthread *t)
 {
-	mblk_t *mp, *mp_next;
+	mblk_t *mp_next;
 	unsigned long flags;
 
 	prefetchw(t);
@@ -5229,15 +6611,8 @@ freechains(struct strthread *t)
 	t->freemsg_tail = &t->freemsg_head;
 	streams_local_restore(flags);
 
-	if (likely(mp_next != NULL)) {
-		mp = mp_next;
-		do {
-			mp_next = mp->b_next;
-			mp->b_next = NULL;
-			mp->b_next = mp->b_prev = NULL;
-			freemsg(mp);
-		} while (unlikely((mp = mp_next) != NULL));
-	}
+	if (likely(mp_next != NULL))
+		freemsgchain(mp_next);
 }
 
 /*
@@ -5253,16 +6628,10 @@ freechains(struct strthread *t)
 BIG_STATIC streams_fastcall void
 freechain(mblk_t *mp, mblk_t **mpp)
 {
-	mblk_t *b, *b_next = mp;
-
 	dassert(mp);
 	dassert(mpp != &mp);
 
-	while ((b = b_next)) {
-		b_next = b->b_next;
-		b->b_next = b->b_prev = NULL;
-		freemsg(b);
-	}
+	freemsgchain(mp);
 }
 
 streams_noinline streams_fastcall __unlikely void
@@ -5315,7 +6684,8 @@ __runqueues(struct softirq_action *unused)
 #endif
 {				/* PROFILED */
 	struct strthread *t;
-	int runs = 0;
+	unsigned long long start, deadline, elapsed;
+	int runs = 0, overrun = 0;
 
 	_trace();
 	t = this_thread;
@@ -5331,25 +6701,62 @@ __runqueues(struct softirq_action *unused)
 
 	atomic_inc(&t->lock);
 
+	start = str_clock();
+	deadline = sysctl_str_runq_budget ? start + sysctl_str_runq_budget : 0;
+
 	do {
 		++runs;
 		/* run queue service procedures if necessary */
 		if (likely(test_bit(qrunflag, &t->flags) != 0))	/* PROFILED */
-			queuerun(t);
+			queuerun(t, deadline);
+		/* steal service procedures from other threads if kicked */
+		if (unlikely(test_bit(qstealflag, &t->flags) != 0))
+			queuesteal(t);
 		if (unlikely
 		    (((volatile unsigned long) t->flags &
 		      (FLUSHWORK | FREEBLKS | STRMFUNCS | QSYNCFLAG | STRTIMOUT | SCANQFLAG | STREVENTS |
 		       STRBCFLAG | STRBCWAIT)) != 0))
 			__runqueues_slow(t);
 		clear_bit(qwantrun, &t->flags);
+		if (unlikely(deadline != 0) && str_clock() >= deadline) {
+			overrun = 1;
+			break;
+		}
 	} while (unlikely(((volatile unsigned long) t->flags & (QRUNFLAGS)) != 0 && runs < 10));
 
-	if (runs >= 10)
+	elapsed = str_clock() - start;
+	t->runq_passes++;
+	t->runq_nsecs += elapsed;
+	if (unlikely(elapsed > t->runq_maxns))
+		t->runq_maxns = elapsed;
+
+	if (unlikely(overrun))
+		t->runq_overruns++;
+	else if (runs >= 10)
 		printk(KERN_WARNING "CPU#%d: STREAMS scheduler looping: flags = 0x%08lx\n",
 		       smp_processor_id(), (volatile unsigned long) t->flags);
 
+#if defined CONFIG_STREAMS_KTHREADS
+	/* count consecutive passes leaving a backlog: this decides between softirq and kstreamd */
+	if (unlikely(((volatile unsigned long) t->flags & (QRUNFLAGS)) != 0)) {
+		if (++t->runq_busy == sysctl_str_runq_burst)
+			t->runq_handoffs++;
+	} else
+		t->runq_busy = 0;
+#endif
+
 	atomic_dec(&t->lock);
 
+#if defined CONFIG_STREAMS_KTHREADS
+	/* a backlog is run on a later pass, in softirq for a short burst and then by kstreamd */
+	if (unlikely(t->runq_busy != 0))
+		__raise_streams();
+#else
+	/* leftover work from a budgeted pass is run on a later pass, letting other work in first */
+	if (unlikely(overrun) && ((volatile unsigned long) t->flags & (QRUNFLAGS)) != 0)
+		__raise_streams();
+#endif
+
       done:
 	return;
 
@@ -5387,6 +6794,19 @@ runqueues(void)
 
 EXPORT_SYMBOL_GPL(runqueues);	/* include/sys/openss7/strsubr.h */
 
+#if defined CONFIG_STREAMS_KTHREADS
+/*
+ *  strsched_tasklet:	- run a burst of STREAMS work in softirq context
+ *  @data:	the processor (unused)
+ */
+STATIC void
+strsched_tasklet(unsigned long data)
+{
+	if (likely(((volatile unsigned long) this_thread->flags & (QRUNFLAGS)) != 0))
+		__runqueues();
+}
+#endif				/* defined CONFIG_STREAMS_KTHREADS */
+
 /* 
  *  -------------------------------------------------------------------------
  *
@@ -5414,6 +6834,7 @@ clear_shinfo(struct shinfo *sh)
 	sd->sd_strmsgsz = sysctl_str_strmsgsz;	/* maximum message size */
 	sd->sd_strctlsz = sysctl_str_strctlsz;	/* maximum control message size */
 	sd->sd_nstrpush = sysctl_str_nstrpush;	/* maximum push count */
+	sd->sd_node = -1;	/* no allocation node until the read side is driven */
 //      init_waitqueue_head(&sd->sd_waitq);     /* waiters */
 	init_waitqueue_head(&sd->sd_rwaitq);	/* waiters on read */
 	init_waitqueue_head(&sd->sd_wwaitq);	/* waiters on write */
@@ -5485,6 +6906,7 @@ allocstr(void)
 			qsi->si_hwl = atomic_read(&qsi->si_cnt);
 		rq->q_flag = QSHEAD | QWANTR | QUSE | QREADR;
 		wq->q_flag = QSHEAD | QWANTR | QUSE;
+		qhist_alloc(qu);
 #ifdef CONFIG_STREAMS_DEBUG
 		write_lock(&ssi->si_rwlock);
 		list_add_tail(&sh->sh_list, &ssi->si_head);
@@ -5510,8 +6932,8 @@ __freestr(struct stdata *sd)
 	struct shinfo *sh = (struct shinfo *) sd;
 	struct queinfo *qu = &sh->sh_queinfo;
 
-	(void) qu;
 	assert(!waitqueue_active(&qu->qu_qwait));
+	qhist_free(qu);
 #if defined CONFIG_STREAMS_DEBUG
 	write_lock(&qsi->si_rwlock);
 	list_del_init(&qu->qu_list);
@@ -5703,6 +7125,20 @@ str_term_caches(void)
 		printk(KERN_ERR "%s: could not destroy %s cache\n", __FUNCTION__, ci->name);
 #else				/* HAVE_KTYPE_KMEM_CACHE_T_P */
 		kmem_cache_destroy(cache);
+#endif				/* HAVE_KTYPE_KMEM_CACHE_T_P */
+	}
+	for (j = 0, si = Strbufinfo; j < STRBUF_CLASSES; j++, si++) {
+		kmem_cachep_t cache;
+
+		if (unlikely((cache = si->si_cache) == NULL))
+			continue;
+		si->si_cache = NULL;
+#ifdef HAVE_KTYPE_KMEM_CACHE_T_P
+		if (kmem_cache_destroy(cache) == 0)
+			continue;
+		printk(KERN_ERR "%s: could not destroy %s cache\n", __FUNCTION__, strbuf_name[j]);
+#else				/* HAVE_KTYPE_KMEM_CACHE_T_P */
+		kmem_cache_destroy(cache);
 #endif				/* HAVE_KTYPE_KMEM_CACHE_T_P */
 	}
 }
@@ -5746,6 +7182,21 @@ str_init_caches(void)
 		str_term_caches();
 		return (-ENOMEM);
 	}
+	/* data buffers need neither constructors nor type stability */
+	for (j = 0, si = Strbufinfo; j < STRBUF_CLASSES; j++, si++) {
+		rwlock_init(&si->si_rwlock);
+		atomic_set(&si->si_cnt, 0);
+		si->si_hwl = 0;
+		if (si->si_cache != NULL)
+			continue;
+		si->si_cache =
+		    kmem_create_cache(strbuf_name[j], strbuf_size[j], 0, SLAB_HWCACHE_ALIGN, NULL, NULL);
+		if (si->si_cache != NULL)
+			continue;
+		printk(KERN_ERR "%s: could not allocate %s cache\n", __FUNCTION__, strbuf_name[j]);
+		str_term_caches();
+		return (-ENOMEM);
+	}
 	return (0);
 }
 
@@ -5768,6 +7219,14 @@ takeover_strsched(unsigned int cpu)
 		o->qhead = NULL;
 		o->qtail = &o->qhead;
 	}
+	{
+		queue_t *q;
+
+		while ((q = stealq_take(o, 0)) != NULL) {
+			q->q_link = NULL;
+			*XCHG(&t->qtail, &q->q_link) = q;
+		}
+	}
 #ifdef CONFIG_STREAMS_SYNCQS
 	if (o->sqhead) {
 		*XCHG(&t->sqtail, o->sqtail) = o->sqhead;
@@ -5780,10 +7239,18 @@ takeover_strsched(unsigned int cpu)
 		o->strmfuncs_tail = &o->strmfuncs_head;
 	}
 #endif				/* CONFIG_STREAMS_SYNCQS */
-	if (o->strbcalls_head) {
-		*XCHG(&t->strbcalls_tail, o->strbcalls_tail) = o->strbcalls_head;
-		o->strbcalls_head = NULL;
-		o->strbcalls_tail = &o->strbcalls_head;
+	{
+		int list;
+
+		for (list = 0; list < STRBC_LISTS; list++) {
+			if (o->strbcalls_head[list]) {
+				*XCHG(&t->strbcalls_tail[list], o->strbcalls_tail[list]) =
+				    o->strbcalls_head[list];
+				o->strbcalls_head[list] = NULL;
+				o->strbcalls_tail[list] = &o->strbcalls_head[list];
+				set_bit(strbcwait, &t->flags);
+			}
+		}
 	}
 	if (o->strtimout_head) {
 		*xchg(&t->strtimout_tail, o->strtimout_tail) = o->strtimout_head;
@@ -5813,7 +7280,16 @@ takeover_strsched(unsigned int cpu)
 		t->freemblks += o->freemblks;
 		o->freemblks = 0;
 	}
+	if (o->freeremote_head) {
+		*XCHG(&t->freeremote_tail, o->freeremote_tail) = o->freeremote_head;
+		o->freeremote_head = NULL;
+		o->freeremote_tail = &o->freeremote_head;
+		t->freeremotes += o->freeremotes;
+		o->freeremotes = 0;
+	}
 #endif				/* !defined CONFIG_STREAMS_NORECYCLE */
+	/* cached data buffers of the dead processor go back to the memory caches */
+	strbuf_drain(o, 0);
 	if (o->freeevnt_head) {
 		*XCHG(&t->freeevnt_tail, o->freeevnt_tail) = o->freeevnt_head;
 		o->freeevnt_head = NULL;
@@ -6098,6 +7574,14 @@ takeover_strsched(unsigned int cpu)
 		o->qhead = NULL;
 		o->qtail = &o->qhead;
 	}
+	{
+		queue_t *q;
+
+		while ((q = stealq_take(o, 0)) != NULL) {
+			q->q_link = NULL;
+			*XCHG(&t->qtail, &q->q_link) = q;
+		}
+	}
 #ifdef CONFIG_STREAMS_SYNCQS
 	if (o->sqhead) {
 		*XCHG(&t->sqtail, o->sqtail) = o->sqhead;
@@ -6110,10 +7594,18 @@ takeover_strsched(unsigned int cpu)
 		o->strmfuncs_tail = &o->strmfuncs_head;
 	}
 #endif				/* CONFIG_STREAMS_SYNCQS */
-	if (o->strbcalls_head) {
-		*XCHG(&t->strbcalls_tail, o->strbcalls_tail) = o->strbcalls_head;
-		o->strbcalls_head = NULL;
-		o->strbcalls_tail = &o->strbcalls_head;
+	{
+		int list;
+
+		for (list = 0; list < STRBC_LISTS; list++) {
+			if (o->strbcalls_head[list]) {
+				*XCHG(&t->strbcalls_tail[list], o->strbcalls_tail[list]) =
+				    o->strbcalls_head[list];
+				o->strbcalls_head[list] = NULL;
+				o->strbcalls_tail[list] = &o->strbcalls_head[list];
+				set_bit(strbcwait, &t->flags);
+			}
+		}
 	}
 	if (o->strtimout_head) {
 		*xchg(&t->strtimout_tail, o->strtimout_tail) = o->strtimout_head;
@@ -6143,7 +7635,16 @@ takeover_strsched(unsigned int cpu)
 		t->freemblks += o->freemblks;
 		o->freemblks = 0;
 	}
+	if (o->freeremote_head) {
+		*XCHG(&t->freeremote_tail, o->freeremote_tail) = o->freeremote_head;
+		o->freeremote_head = NULL;
+		o->freeremote_tail = &o->freeremote_head;
+		t->freeremotes += o->freeremotes;
+		o->freeremotes = 0;
+	}
 #endif				/* !defined CONFIG_STREAMS_NORECYCLE */
+	/* cached data buffers of the dead processor go back to the memory caches */
+	strbuf_drain(o, 0);
 	if (o->freeevnt_head) {
 		*XCHG(&t->freeevnt_tail, o->freeevnt_tail) = o->freeevnt_head;
 		o->freeevnt_head = NULL;
@@ -6435,6 +7936,10 @@ kill_kstreamd(void)
 STATIC __unlikely void
 init_strsched(void)
 {
+	int cpu;
+
+	for (cpu = 0; cpu < NR_CPUS; cpu++)
+		tasklet_init(&strtasklets[cpu], strsched_tasklet, (unsigned long) cpu);
 	spawn_kstreamd();
 	return;
 }
@@ -6442,7 +7947,11 @@ init_strsched(void)
 STATIC __unlikely void
 term_strsched(void)
 {
+	int cpu;
+
 	kill_kstreamd();
+	for (cpu = 0; cpu < NR_CPUS; cpu++)
+		tasklet_kill(&strtasklets[cpu]);
 	return;
 }
 
@@ -6491,10 +8000,28 @@ term_strsched(void)
  *  This is an initialization function for STREAMS scheduler items in this file.  It is invoked by
  *  the STREAMS kernel module or kernel initialization function.
  */
+/*
+ *  strwheel_free: - free the per-CPU timer wheels
+ */
+STATIC __unlikely void
+strwheel_free(void)
+{
+	int i;
+
+	for (i = 0; i < NR_CPUS; i++) {
+		struct strwheel *w;
+
+		if ((w = XCHG(&strthreads[i].wheel, NULL))) {
+			del_timer_sync(&w->timer);
+			kmem_free(w, sizeof(*w));
+		}
+	}
+}
+
 BIG_STATIC __unlikely int
 strsched_init(void)
 {
-	int result, i;
+	int result, i, j;
 
 	if ((result = str_init_caches()) < 0)
 		return (result);
@@ -6521,15 +8048,33 @@ strsched_init(void)
 		t->sqtail = &t->sqhead;
 		t->strmfuncs_tail = &t->strmfuncs_head;
 #endif
-		t->strbcalls_tail = &t->strbcalls_head;
+		for (j = 0; j < STRBC_LISTS; j++)
+			t->strbcalls_tail[j] = &t->strbcalls_head[j];
 		t->strtimout_tail = &t->strtimout_head;
 		t->strevents_tail = &t->strevents_head;
 		t->scanqtail = &t->scanqhead;
 		t->freemsg_tail = &t->freemsg_head;
 #if !defined CONFIG_STREAMS_NORECYCLE
 		t->freemblk_tail = &t->freemblk_head;
+		t->freeremote_tail = &t->freeremote_head;
 #endif				/* !defined CONFIG_STREAMS_NORECYCLE */
 		t->freeevnt_tail = &t->freeevnt_head;
+		if (cpu_possible(i)) {
+			struct strwheel *w;
+
+			if (!(w = kmem_zalloc(sizeof(*w), KM_SLEEP))) {
+				strwheel_free();
+				str_term_caches();
+				return (-ENOMEM);
+			}
+			spin_lock_init(&w->lock);
+			w->cpu = i;
+			w->clock = jiffies;
+			init_timer(&w->timer);
+			w->timer.data = (long) w;
+			w->timer.function = strwheel_function;
+			t->wheel = w;
+		}
 	}
 	init_timer(&scan_timer);
 	scan_timer.data = 0;
@@ -6549,9 +8094,11 @@ strsched_exit(void)
 {
 	del_timer(&scan_timer);
 	term_strsched();
+	strwheel_free();
 #if !defined CONFIG_STREAMS_NORECYCLE
 	term_freemblks();
 #endif
+	term_strbufs();
 #if defined CONFIG_STREAMS_SYNCQS
 	sq_put(&global_inner_syncq);
 	sq_put(&global_outer_syncq);
@@ -80,6 +80,19 @@
 #include <linux/hardirq.h>	/* for in_irq() and friends */
 #endif
 
+#if defined HAVE_KINC_LINUX_SCHED_CLOCK_H
+#include <linux/sched/clock.h>	/* for local_clock() */
+#endif
+
+/* nanosecond clock used for scheduler accounting */
+#if defined HAVE_KFUNC_LOCAL_CLOCK
+#define str_clock() ((unsigned long long) local_clock())
+#elif defined HAVE_KFUNC_SCHED_CLOCK
+#define str_clock() ((unsigned long long) sched_clock())
+#else
+#define str_clock() ((unsigned long long) jiffies * (1000000000ULL / HZ))
+#endif
+
 #ifndef STREAMS_SOFTIRQ
 #define STREAMS_SOFTIRQ (TASKLET_SOFTIRQ+1)
 #endif
@@ -87,6 +100,11 @@
 /* ctors and dtors for mdbblocks */
 BIG_STATIC mblk_t *streams_fastcall mdbblock_alloc(uint priority, void *func);
 BIG_STATIC void streams_fastcall mdbblock_free(mblk_t *mp);
+BIG_STATIC void streams_fastcall mdbblock_free_batch(mblk_t *mp);
+BIG_STATIC mblk_t *streams_fastcall mdbblock_alloc_node(uint priority, void *func, int node);
+BIG_STATIC unsigned char *streams_fastcall strbuf_alloc(size_t size, uint priority,
+							unsigned char **limp, int node);
+BIG_STATIC void streams_fastcall strbuf_free(unsigned char *base, size_t size);
 
 /* queue gets and puts */
 BIG_STATIC queue_t *streams_fastcall qget(queue_t *q);
@@ -145,6 +163,9 @@ BIG_STATIC void streams_fastcall sq_release(struct syncq **sqp);
 /* freeing chains of message blocks */
 BIG_STATIC void streams_fastcall freechain(mblk_t *mp, mblk_t **mpp);
 
+/* work-stealing deque for scheduled queues */
+BIG_STATIC int streams_fastcall stealq_push(struct strthread *t, queue_t *q);
+
 /* force scheduling queues */
 // __STREAMS_EXTERN void qschedule(queue_t *q);
 
@@ -228,6 +249,29 @@ current_context(void)
 }
 #endif
 
+/* flow trace */
+extern atomic_t strft_active;
+__STREAMS_EXTERN void strft_event(struct stdata *sd, queue_t *q, mblk_t *mp, int ev);
+__STREAMS_EXTERN int strft_fetch(dev_t dev, int all, struct strftevnt *buf, int count, int *lostp);
+__STREAMS_EXTERN void strft_zero(dev_t dev);
+
+#define strftrace(__sd, __q, __mp, __ev) \
+	do { \
+		if (unlikely(atomic_read(&strft_active) != 0)) \
+			strft_event(__sd, __q, __mp, __ev); \
+	} while (0)
+
+/* queue pair histograms */
+#if defined alloc_percpu
+extern struct list_head qhist_list;
+extern spinlock_t qhist_lock;
+#define qhist(__q) (((struct queinfo *)RD(__q))->qu_hist)
+BIG_STATIC void streams_fastcall qhist_enable(struct qhist *qh, queue_t *q);
+#else
+#define qhist(__q) ((struct qhist *) NULL)
+#define qhist_enable(__qh, __q) do { } while (0)
+#endif
+
 /* for initialization */
 BIG_STATIC int strsched_init(void);
 BIG_STATIC void strsched_exit(void);
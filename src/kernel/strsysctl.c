@@ -96,6 +96,13 @@ BIG_STATIC ulong sysctl_str_max_strdev = MAX_STRDEV;	/* max no streams devices *
 BIG_STATIC ulong sysctl_str_max_strmod = MAX_STRMOD;	/* max no streams modules */
 BIG_STATIC ulong sysctl_str_max_mblk = 10;	/* max no of headers on free list */
 BIG_STATIC int sysctl_str_msg_priority = 0;	/* use priority on allocation if true */
+BIG_STATIC int sysctl_str_wsteal = 0;	/* steal queues across STREAMS threads */
+BIG_STATIC ulong sysctl_str_wsteal_thresh = 4;	/* queue backlog that wakes a thief */
+BIG_STATIC ulong sysctl_str_runq_budget = 0;	/* scheduler pass time budget (ns) */
+BIG_STATIC int sysctl_str_irqnode = 0;	/* pin Stream allocations to IRQ node */
+BIG_STATIC int sysctl_str_qhist = 0;	/* keep log2 histograms for new queue pairs */
+BIG_STATIC ulong sysctl_str_runq_burst = 0;	/* softirq passes before kstreamd takes over */
+BIG_STATIC ulong sysctl_str_runq_cpus = ~0UL;	/* processors permitted to run service procedures */
 
 EXPORT_SYMBOL_GPL(sysctl_str_strmsgsz);	/* always needed for drv_getparm */
 EXPORT_SYMBOL_GPL(sysctl_str_strctlsz);
@@ -105,6 +112,7 @@ EXPORT_SYMBOL_GPL(sysctl_str_maxpsz);
 EXPORT_SYMBOL_GPL(sysctl_str_minpsz);
 EXPORT_SYMBOL_GPL(sysctl_str_hiwat);
 EXPORT_SYMBOL_GPL(sysctl_str_lowat);
+EXPORT_SYMBOL_GPL(sysctl_str_irqnode);
 
 STATIC struct ctl_table_header *streams_sysctl_handle;
 
@@ -537,6 +545,146 @@ STATIC struct ctl_table streams_table[] = {
 #ifdef HAVE_KMEMB_STRUCT_CTL_TABLE_STRATEGY
 	 NULL,
 #endif
+#ifdef HAVE_KMEMB_STRUCT_CTL_TABLE_DE
+	 NULL,
+#endif
+	 NULL, NULL},
+	/* steal scheduled queues from busy threads when non-zero */
+	{
+#ifdef HAVE_KMEMB_STRUCT_CTL_TABLE_CTL_NAME
+	 STREAMS_WSTEAL,
+#endif
+	 "wsteal", &sysctl_str_wsteal, sizeof(int), 0644, NULL,
+#ifdef HAVE_KMEMB_STRUCT_CTL_TABLE_PARENT
+	 NULL,
+#endif
+	 &proc_dointvec,
+#ifdef HAVE_KMEMB_STRUCT_CTL_TABLE_POLL
+	 NULL,
+#endif
+#ifdef HAVE_KMEMB_STRUCT_CTL_TABLE_STRATEGY
+	 NULL,
+#endif
+#ifdef HAVE_KMEMB_STRUCT_CTL_TABLE_DE
+	 NULL,
+#endif
+	 NULL, NULL},
+	/* scheduled queue backlog at which an idle thread is woken to steal */
+	{
+#ifdef HAVE_KMEMB_STRUCT_CTL_TABLE_CTL_NAME
+	 STREAMS_WSTEAL_THRESH,
+#endif
+	 "wsteal_thresh", &sysctl_str_wsteal_thresh, sizeof(ulong), 0644, NULL,
+#ifdef HAVE_KMEMB_STRUCT_CTL_TABLE_PARENT
+	 NULL,
+#endif
+	 &proc_doulongvec_minmax,
+#ifdef HAVE_KMEMB_STRUCT_CTL_TABLE_POLL
+	 NULL,
+#endif
+#ifdef HAVE_KMEMB_STRUCT_CTL_TABLE_STRATEGY
+	 NULL,
+#endif
+#ifdef HAVE_KMEMB_STRUCT_CTL_TABLE_DE
+	 NULL,
+#endif
+	 NULL, NULL},
+	/* time budget for a STREAMS scheduler pass in nanoseconds, zero for none */
+	{
+#ifdef HAVE_KMEMB_STRUCT_CTL_TABLE_CTL_NAME
+	 STREAMS_RUNQ_BUDGET,
+#endif
+	 "runq_budget", &sysctl_str_runq_budget, sizeof(ulong), 0644, NULL,
+#ifdef HAVE_KMEMB_STRUCT_CTL_TABLE_PARENT
+	 NULL,
+#endif
+	 &proc_doulongvec_minmax,
+#ifdef HAVE_KMEMB_STRUCT_CTL_TABLE_POLL
+	 NULL,
+#endif
+#ifdef HAVE_KMEMB_STRUCT_CTL_TABLE_STRATEGY
+	 NULL,
+#endif
+#ifdef HAVE_KMEMB_STRUCT_CTL_TABLE_DE
+	 NULL,
+#endif
+	 NULL, NULL},
+	/* pin Stream head allocations to the node of the driver's interrupt processor */
+	{
+#ifdef HAVE_KMEMB_STRUCT_CTL_TABLE_CTL_NAME
+	 STREAMS_IRQNODE,
+#endif
+	 "irqnode", &sysctl_str_irqnode, sizeof(int), 0644, NULL,
+#ifdef HAVE_KMEMB_STRUCT_CTL_TABLE_PARENT
+	 NULL,
+#endif
+	 &proc_dointvec,
+#ifdef HAVE_KMEMB_STRUCT_CTL_TABLE_POLL
+	 NULL,
+#endif
+#ifdef HAVE_KMEMB_STRUCT_CTL_TABLE_STRATEGY
+	 NULL,
+#endif
+#ifdef HAVE_KMEMB_STRUCT_CTL_TABLE_DE
+	 NULL,
+#endif
+	 NULL, NULL},
+	/* keep log2 histograms for new queue pairs */
+	{
+#ifdef HAVE_KMEMB_STRUCT_CTL_TABLE_CTL_NAME
+	 STREAMS_QHIST,
+#endif
+	 "qhist", &sysctl_str_qhist, sizeof(int), 0644, NULL,
+#ifdef HAVE_KMEMB_STRUCT_CTL_TABLE_PARENT
+	 NULL,
+#endif
+	 &proc_dointvec,
+#ifdef HAVE_KMEMB_STRUCT_CTL_TABLE_POLL
+	 NULL,
+#endif
+#ifdef HAVE_KMEMB_STRUCT_CTL_TABLE_STRATEGY
+	 NULL,
+#endif
+#ifdef HAVE_KMEMB_STRUCT_CTL_TABLE_DE
+	 NULL,
+#endif
+	 NULL, NULL},
+	/* backlogged softirq passes before handing work to kstreamd, zero for always kstreamd */
+	{
+#ifdef HAVE_KMEMB_STRUCT_CTL_TABLE_CTL_NAME
+	 STREAMS_RUNQ_BURST,
+#endif
+	 "runq_burst", &sysctl_str_runq_burst, sizeof(ulong), 0644, NULL,
+#ifdef HAVE_KMEMB_STRUCT_CTL_TABLE_PARENT
+	 NULL,
+#endif
+	 &proc_doulongvec_minmax,
+#ifdef HAVE_KMEMB_STRUCT_CTL_TABLE_POLL
+	 NULL,
+#endif
+#ifdef HAVE_KMEMB_STRUCT_CTL_TABLE_STRATEGY
+	 NULL,
+#endif
+#ifdef HAVE_KMEMB_STRUCT_CTL_TABLE_DE
+	 NULL,
+#endif
+	 NULL, NULL},
+	/* mask of processors permitted to run queue service procedures */
+	{
+#ifdef HAVE_KMEMB_STRUCT_CTL_TABLE_CTL_NAME
+	 STREAMS_RUNQ_CPUS,
+#endif
+	 "runq_cpus", &sysctl_str_runq_cpus, sizeof(ulong), 0644, NULL,
+#ifdef HAVE_KMEMB_STRUCT_CTL_TABLE_PARENT
+	 NULL,
+#endif
+	 &proc_doulongvec_minmax,
+#ifdef HAVE_KMEMB_STRUCT_CTL_TABLE_POLL
+	 NULL,
+#endif
+#ifdef HAVE_KMEMB_STRUCT_CTL_TABLE_STRATEGY
+	 NULL,
+#endif
 #ifdef HAVE_KMEMB_STRUCT_CTL_TABLE_DE
 	 NULL,
 #endif
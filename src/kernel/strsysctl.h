@@ -87,6 +87,13 @@ enum {
 	STREAMS_MAX_STRMOD = 19,
 	STREAMS_MAX_MBLK = 20,
 	STREAMS_MSG_PRIORITY = 21,
+	STREAMS_WSTEAL = 22,
+	STREAMS_WSTEAL_THRESH = 23,
+	STREAMS_RUNQ_BUDGET = 24,
+	STREAMS_IRQNODE = 25,
+	STREAMS_QHIST = 26,
+	STREAMS_RUNQ_BURST = 27,
+	STREAMS_RUNQ_CPUS = 28,
 };
 #else				/* !defined(HAVE_SYSCTL_CHECK_TABLE_SYMBOL) */
 /* /proc/streams */
@@ -117,6 +124,13 @@ enum {
 	STREAMS_MAX_STRMOD = 0,
 	STREAMS_MAX_MBLK = 0,
 	STREAMS_MSG_PRIORITY = 0,
+	STREAMS_WSTEAL = 0,
+	STREAMS_WSTEAL_THRESH = 0,
+	STREAMS_RUNQ_BUDGET = 0,
+	STREAMS_IRQNODE = 0,
+	STREAMS_QHIST = 0,
+	STREAMS_RUNQ_BURST = 0,
+	STREAMS_RUNQ_CPUS = 0,
 };
 #endif				/* !defined(HAVE_SYSCTL_CHECK_TABLE_SYMBOL) */
 
@@ -162,6 +176,20 @@ BIG_STATIC ulong sysctl_str_max_mblk;	/* max of headers on free list */
 
 BIG_STATIC int sysctl_str_msg_priority;	/* observer message allocation priority */
 
+BIG_STATIC int sysctl_str_wsteal;	/* steal queues across STREAMS threads */
+
+BIG_STATIC ulong sysctl_str_wsteal_thresh;	/* queue backlog that wakes a thief */
+
+BIG_STATIC ulong sysctl_str_runq_budget;	/* scheduler pass time budget (ns) */
+
+BIG_STATIC int sysctl_str_irqnode;	/* pin Stream allocations to IRQ node */
+
+BIG_STATIC int sysctl_str_qhist;	/* keep log2 histograms for new queue pairs */
+
+BIG_STATIC ulong sysctl_str_runq_burst;	/* softirq passes before kstreamd takes over */
+
+BIG_STATIC ulong sysctl_str_runq_cpus;	/* processors permitted to run service procedures */
+
 /* initialization for main */
 BIG_STATIC int strsysctl_init(void);
 
@@ -76,6 +76,7 @@ static char const ident[] = "src/kernel/strutil.c (" PACKAGE_ENVR ") " PACKAGE_D
 
 #include <asm/atomic.h>		/* for atomic operations */
 #include <asm/bitops.h>		/* for atomic bit operations */
+#include <asm/div64.h>		/* for do_div */
 #include <linux/compiler.h>	/* for expected/unexpected */
 #include <linux/spinlock.h>	/* for spinlocks */
 
@@ -370,6 +371,221 @@ skballoc(struct sk_buff *skb, uint priority)
 
 EXPORT_SYMBOL_GPL(skballoc);
 
+/*
+ *  -------------------------------------------------------------------------
+ *
+ *  SOCKET BUFFER PAGE FRAGMENTS
+ *
+ *  -------------------------------------------------------------------------
+ *  Non-linear socket buffers are converted to message block chains without copying: one data block
+ *  for the linear area and one for each page fragment, each data block holding its own reference
+ *  to the socket buffer that owns the data.  Data blocks that reference a page fragment are marked
+ *  DB_SKBFRAG so that msgskballoc() can attach them to a transmitted socket buffer as page
+ *  fragments again rather than copying them.
+ */
+
+#ifndef HAVE_KFUNC_SKB_FRAG_PAGE
+#ifdef HAVE_KMEMB_STRUCT_SKB_FRAG_STRUCT_PAGE_P
+#define skb_frag_page(frag)	((frag)->page.p)
+#else
+#define skb_frag_page(frag)	((frag)->page)
+#endif
+#endif
+#ifndef HAVE_KFUNC_SKB_FRAG_OFF
+#define skb_frag_off(frag)	((frag)->page_offset)
+#endif
+#ifndef HAVE_KFUNC_SKB_FRAG_SIZE
+#define skb_frag_size(frag)	((frag)->size)
+#endif
+
+/**
+ *  skbfrag_alloc: - allocate a message block referencing part of a socket buffer
+ *  @skb:	socket buffer owning the data
+ *  @base:	start of the data
+ *  @len:	length of the data
+ *  @priority:	priority of message block header allocation
+ *  @flag:	data block flags
+ */
+STATIC streams_inline streams_fastcall __hot_in mblk_t *
+skbfrag_alloc(struct sk_buff *skb, unsigned char *base, size_t len, uint priority,
+	      unsigned char flag)
+{
+	mblk_t *mp;
+
+	if (likely((mp = mdbblock_alloc(priority, &skbmsgalloc)) != NULL)) {
+		struct mdbblock *md = mb_to_mdb(mp);
+		dblk_t *db = &md->datablk.d_dblock;
+		struct free_rtn *frtnp = (struct free_rtn *) md->databuf;
+
+		frtnp->free_func = &freeb_skb;
+		frtnp->free_arg = (caddr_t) skb_get(skb);
+		/* set up message block */
+		mp->b_rptr = base;
+		mp->b_wptr = base + len;
+		/* set up data block */
+		db->db_frtnp = frtnp;
+		db->db_base = base;
+		db->db_lim = base + len;
+		db->db_size = len;
+		db->db_flag = flag;
+	}
+	return (mp);
+}
+
+/**
+ *  skbfrag_chain: - append message blocks for the data in a socket buffer
+ *  @owner:	socket buffer owning the data (referenced by each data block)
+ *  @skb:	socket buffer (@owner or one on its frag_list)
+ *  @mpp:	where to link the first message block
+ *  @priority:	priority of message block header allocation
+ *
+ *  Returns a pointer to the b_cont field of the last message block appended, or NULL on allocation
+ *  failure.  Page fragments in high memory have no permanent kernel mapping and are copied.
+ */
+STATIC streams_fastcall __hot_in mblk_t **
+skbfrag_chain(struct sk_buff *owner, struct sk_buff *skb, mblk_t **mpp, uint priority)
+{
+	unsigned int off, len;
+	int i;
+
+	if ((len = skb_headlen(skb)) != 0) {
+		if (unlikely((*mpp = skbfrag_alloc(owner, skb->data, len, priority, 0)) == NULL))
+			return (NULL);
+		mpp = &(*mpp)->b_cont;
+	}
+	for (off = len, i = 0; i < skb_shinfo(skb)->nr_frags; i++, off += len) {
+		skb_frag_t *frag = &skb_shinfo(skb)->frags[i];
+		struct page *page = skb_frag_page(frag);
+
+		if ((len = skb_frag_size(frag)) == 0)
+			continue;
+		if (likely(!PageHighMem(page))) {
+			unsigned char *base = (unsigned char *) page_address(page) + skb_frag_off(frag);
+
+			*mpp = skbfrag_alloc(owner, base, len, priority, DB_SKBFRAG);
+		} else if ((*mpp = allocb(len, priority)) != NULL) {
+			if (unlikely(skb_copy_bits(skb, off, (*mpp)->b_wptr, len) != 0)) {
+				freeb(*mpp);
+				*mpp = NULL;
+			} else
+				(*mpp)->b_wptr += len;
+		}
+		if (unlikely(*mpp == NULL))
+			return (NULL);
+		mpp = &(*mpp)->b_cont;
+	}
+	return (mpp);
+}
+
+/**
+ *  skbmsgalloc: - allocate a message for a (possibly non-linear) socket buffer
+ *  @skb:	socket buffer
+ *  @priority:	priority of message block header allocation
+ *
+ *  A linear socket buffer results in a single message block as with skballoc().  A non-linear socket
+ *  buffer results in a chain of message blocks referencing the linear area, the page fragments and
+ *  the socket buffers on the frag_list, in order, without copying.  As with skballoc(), the caller's
+ *  reference to the socket buffer is consumed on success and left alone on failure.
+ */
+streams_fastcall __hot_in mblk_t *
+skbmsgalloc(struct sk_buff *skb, uint priority)
+{
+	mblk_t *mp = NULL, **mpp = &mp;
+	struct sk_buff *frag;
+
+	if (likely(!skb_is_nonlinear(skb)))
+		return skballoc(skb, priority);
+	if (unlikely((mpp = skbfrag_chain(skb, skb, mpp, priority)) == NULL))
+		goto error;
+	for (frag = skb_shinfo(skb)->frag_list; frag; frag = frag->next) {
+		/* nested frag lists are not generated by the IP stack */
+		if (unlikely(skb_shinfo(frag)->frag_list != NULL))
+			goto error;
+		if (unlikely((mpp = skbfrag_chain(skb, frag, mpp, priority)) == NULL))
+			goto error;
+	}
+	if (unlikely(mp == NULL))
+		goto error;
+	/* each data block holds its own reference */
+	kfree_skb(skb);
+	return (mp);
+      error:
+	freemsg(mp);
+	return (NULL);
+}
+
+EXPORT_SYMBOL_GPL(skbmsgalloc);	/* include/sys/openss7/stream.h */
+
+/**
+ *  msgskballoc: - allocate a socket buffer for a message
+ *  @mp:	the message
+ *  @headroom:	headroom to reserve ahead of the data
+ *  @priority:	priority of the allocation
+ *
+ *  Leading data blocks of the message are copied into the linear area of the socket buffer.  The
+ *  DB_SKBFRAG data blocks that follow them are attached to the socket buffer as page fragments
+ *  without copying.  NULL is returned when the message cannot be represented this way (a data
+ *  block that must be copied follows a page fragment, or there are too many page fragments) so
+ *  that the caller can fall back to copying the message.  The last page fragment slot of the socket
+ *  buffer is never used and is left for the caller.  The message is consumed on success.
+ */
+streams_fastcall __hot_out struct sk_buff *
+msgskballoc(mblk_t *mp, unsigned int headroom, uint priority)
+{
+#ifdef HAVE_KFUNC_SKB_FILL_PAGE_DESC
+	struct sk_buff *skb;
+	size_t hlen = 0, dlen = 0;
+	int i = 0;
+	mblk_t *b;
+
+	for (b = mp; b; b = b->b_cont) {
+		ssize_t blen;
+
+		if (unlikely((blen = b->b_wptr - b->b_rptr) <= 0))
+			continue;
+		if ((b->b_datap->db_flag & DB_SKBFRAG)
+		    && offset_in_page(b->b_rptr) + blen <= PAGE_SIZE) {
+			if (unlikely(++i >= MAX_SKB_FRAGS))
+				return (NULL);
+			dlen += blen;
+			continue;
+		}
+		if (unlikely(i != 0))
+			return (NULL);
+		hlen += blen;
+	}
+	if (unlikely((skb = alloc_skb(headroom + hlen,
+				      (priority == BPRI_WAITOK) ? GFP_KERNEL : GFP_ATOMIC)) == NULL))
+		return (NULL);
+	skb_reserve(skb, headroom);
+	for (i = 0, b = mp; b; b = b->b_cont) {
+		ssize_t blen;
+
+		if (unlikely((blen = b->b_wptr - b->b_rptr) <= 0))
+			continue;
+		if (skb->len < hlen) {
+			bcopy(b->b_rptr, skb_put(skb, blen), blen);
+			continue;
+		}
+		{
+			struct page *page = virt_to_page(b->b_rptr);
+
+			get_page(page);
+			skb_fill_page_desc(skb, i++, page, offset_in_page(b->b_rptr), blen);
+		}
+	}
+	skb->len += dlen;
+	skb->data_len = dlen;
+	skb->truesize += dlen;
+	freemsg(mp);
+	return (skb);
+#else				/* HAVE_KFUNC_SKB_FILL_PAGE_DESC */
+	return (NULL);
+#endif				/* HAVE_KFUNC_SKB_FILL_PAGE_DESC */
+}
+
+EXPORT_SYMBOL_GPL(msgskballoc);	/* include/sys/openss7/stream.h */
+
 /**
  *  esballoc:	- allocate a message block with an external buffer
  *  @base:	base address of message buffer
@@ -442,17 +658,25 @@ allocb_skb(const size_t size, uint priority)
 	return (NULL);
 }
 
+STATIC streams_fastcall __hot_write mblk_t *allocb_fast(const size_t size, uint priority);
+STATIC streams_fastcall __hot_write mblk_t *allocb_kmem(const size_t size, uint priority);
+
 /**
- *  allocb_fast:- allocate a message block with an internal FASTBUF
+ *  __allocb_fast:- allocate a message block with an internal FASTBUF
  *  @size:	size of message block in bytes (unused)
  *  @priority:	priority of the allocation
+ *  @node:	NUMA node from which to allocate (-1 for the local node)
  */
-STATIC streams_fastcall __hot_write mblk_t *
-allocb_fast(const size_t size, uint priority)
+STATIC streams_inline streams_fastcall __hot_write mblk_t *
+__allocb_fast(const size_t size, uint priority, int node)
 {
 	mblk_t *mp;
 
-	if (likely((mp = mdbblock_alloc(priority, &allocb_fast)) != NULL)) {
+	if (node < 0)
+		mp = mdbblock_alloc(priority, &allocb_fast);
+	else
+		mp = mdbblock_alloc_node(priority, &allocb_fast, node);
+	if (likely(mp != NULL)) {
 		struct mdbblock *md = mb_to_mdb(mp);
 		dblk_t *db = &md->datablk.d_dblock;
 		unsigned char *base = md->databuf;
@@ -480,6 +704,17 @@ allocb_fast(const size_t size, uint priority)
 	return (NULL);
 }
 
+/**
+ *  allocb_fast:- allocate a message block with an internal FASTBUF
+ *  @size:	size of message block in bytes (unused)
+ *  @priority:	priority of the allocation
+ */
+STATIC streams_fastcall __hot_write mblk_t *
+allocb_fast(const size_t size, uint priority)
+{
+	return __allocb_fast(size, priority, -1);
+}
+
 #ifndef nextpower
 #if !defined HAVE_KSIZE_SYMBOL || (!defined HAVE_KSIZE_SUPPORT && defined CONFIG_KERNEL_WEAK_SYMBOLS)
 /* Linux memory allocators always round up to the next power of 2.  We can use the slop. */
@@ -539,16 +774,27 @@ ktruesize(const void *obj, uint size)
 #endif
 
 /* Note that db_size is always the size that was requested.  db_lim represents the size that was
- * acrually allocated and is usable. */
-STATIC streams_fastcall __hot_write mblk_t *
-allocb_kmem(const size_t size, uint priority)
+ * acrually allocated and is usable.  Buffers no larger than STRBUF_MAXSIZE come from the per-cpu
+ * size class caches and are marked DB_BUFCACHE so that freeb() can return them there. */
+STATIC streams_inline streams_fastcall __hot_write mblk_t *
+__allocb_kmem(const size_t size, uint priority, int node)
 {
 	mblk_t *mp;
-	unsigned char *base;
+	unsigned char *base, *lim = NULL;
 	int allocation = (priority == BPRI_WAITOK) ? KM_SLEEP : KM_NOSLEEP;
-
-	if (likely((base = kmem_alloc(size, allocation)) != NULL)) {
-		if (likely((mp = mdbblock_alloc(priority, &allocb_kmem)) != NULL)) {
+	int cached = (size <= STRBUF_MAXSIZE);
+
+	if (likely(cached))
+		base = strbuf_alloc(size, priority, &lim, node);
+	else if (likely((base = (node < 0) ? kmem_alloc(size, allocation)
+			 : kmem_alloc_node(size, allocation, node)) != NULL))
+		lim = base + ktruesize(base, size);
+	if (likely(base != NULL)) {
+		if (node < 0)
+			mp = mdbblock_alloc(priority, &allocb_kmem);
+		else
+			mp = mdbblock_alloc_node(priority, &allocb_kmem, node);
+		if (likely(mp != NULL)) {
 			struct mdbblock *md = mb_to_mdb(mp);
 			dblk_t *db = &md->datablk.d_dblock;
 
@@ -565,18 +811,29 @@ allocb_kmem(const size_t size, uint priority)
 			/* set up data block */
 			// _ensure(db->db_frtnp == NULL, db->db_frtnp = NULL);
 			db->db_base = base;
-			db->db_lim = base + ktruesize(base, size);
+			db->db_lim = lim;
 			// _ensure(db->db_ref == 1, db->db_ref = 1);
 			// _ensure(db->db_type == M_DATA, db->db_type = M_DATA);
 			db->db_size = size;
 			// _ensure(db->db_flag == 0, db->db_flag = 0);
+			if (likely(cached))
+				db->db_flag = DB_BUFCACHE;
 			return (mp);
 		}
-		kmem_free(base, size);
+		if (likely(cached))
+			strbuf_free(base, size);
+		else
+			kmem_free(base, size);
 	}
 	return (NULL);
 }
 
+STATIC streams_fastcall __hot_write mblk_t *
+allocb_kmem(const size_t size, uint priority)
+{
+	return __allocb_kmem(size, priority, -1);
+}
+
 /**
  *  allocb:	- allocate a message block
  *  @size:	size of message block in bytes
@@ -602,6 +859,51 @@ allocb(size_t size, uint priority)
 
 EXPORT_SYMBOL(allocb);
 
+/**
+ *  allocb_node: - allocate a message block on a NUMA node
+ *  @size:	size of message block in bytes
+ *  @priority:	priority of the allocation
+ *  @node:	NUMA node from which to allocate (-1 for the local node)
+ *
+ *  Used by the Stream head to allocate write side messages from the node of the processor that
+ *  services the driver's interrupts (see sys.streams.irqnode).  Allocations for the local node (or
+ *  no particular node) are identical to allocb().
+ */
+streams_fastcall __hot_write mblk_t *
+allocb_node(size_t size, uint priority, int node)
+{
+	if (likely(node < 0) || node == numa_node_id() || unlikely((priority & BPRI_SKBUFF) != 0))
+		return allocb(size, priority);
+	if (size <= FASTBUF)
+		return __allocb_fast(size, priority & 0xff, node);
+	return __allocb_kmem(size, priority & 0xff, node);
+}
+
+EXPORT_SYMBOL_GPL(allocb_node);	/* include/sys/openss7/strsubr.h */
+
+/**
+ *  allocb_room: - allocate a message block with reserved head and tail room
+ *  @headroom:	bytes to reserve ahead of the data
+ *  @size:	size of the data in bytes
+ *  @tailroom:	bytes to reserve after the data
+ *  @priority:	priority of the allocation
+ *
+ *  The returned message block is empty with b_rptr and b_wptr positioned @headroom bytes into the
+ *  data buffer, so that modules further down the Stream can mblk_push() their headers in place
+ *  instead of allocating a message block of their own for each header.
+ */
+streams_fastcall __hot_write mblk_t *
+allocb_room(size_t headroom, size_t size, size_t tailroom, uint priority)
+{
+	mblk_t *mp;
+
+	if (likely((mp = allocb(headroom + size + tailroom, priority)) != NULL))
+		mblk_reserve(mp, headroom);
+	return (mp);
+}
+
+EXPORT_SYMBOL(allocb_room);	/* include/sys/openss7/stream.h */
+
 /**
  *  copyb:	- copy a message block
  *  @bp:	the message block to copy
@@ -723,6 +1025,27 @@ __STRUTIL_EXTERN_INLINE mblk_t *dupmsg(mblk_t *mp);
 
 EXPORT_SYMBOL(dupmsg);		/* include/sys/openss7/stream.h */
 
+/* release the data buffer of a data block whose last reference has gone */
+static streams_inline streams_fastcall __hot void
+__freedb_buf(dblk_t *db)
+{
+	if (unlikely(db->db_base != db_to_buf(db))) {
+		register struct free_rtn *frtnp;
+
+		/* handle external data buffer */
+		if (unlikely((frtnp = db->db_frtnp) != NULL)) {
+			register void streamscall (*free_func) (caddr_t);
+
+			if (likely((free_func = frtnp->free_func) != NULL)) {
+				free_func(frtnp->free_arg);
+			}
+		} else if (likely(db->db_flag & DB_BUFCACHE))
+			strbuf_free(db->db_base, db->db_size);
+		else
+			kmem_free(db->db_base, db->db_size);
+	}
+}
+
 static streams_inline streams_fastcall __hot void
 freedb(dblk_t *db)
 {
@@ -730,19 +1053,7 @@ freedb(dblk_t *db)
 		/* free data block */
 		mblk_t *mb = db_to_mb(db);
 
-		if (unlikely(db->db_base != db_to_buf(db))) {
-			register struct free_rtn *frtnp;
-
-			/* handle external data buffer */
-			if (unlikely((frtnp = db->db_frtnp) != NULL)) {
-				register void streamscall (*free_func) (caddr_t);
-
-				if (likely((free_func = frtnp->free_func) != NULL)) {
-					free_func(frtnp->free_arg);
-				}
-			} else
-				kmem_free(db->db_base, db->db_size);
-		}
+		__freedb_buf(db);
 		/* the entire mdbblock can go if the associated msgb is also unused */
 		if (likely(mb->b_datap == NULL))
 			mdbblock_free(mb);
@@ -803,6 +1114,65 @@ __STRUTIL_EXTERN_INLINE void freemsg(mblk_t *mp);
 
 EXPORT_SYMBOL(freemsg);
 
+/**
+ *  freemsgchain: - free a chain of messages
+ *  @mp:	the first message of the chain, further messages linked by b_next
+ *
+ *  Frees every message block of every message on the chain as freemsg(9) would, but collects the
+ *  combined message/data blocks that become unused and returns them to the per-cpu free list in
+ *  one batch with mdbblock_free_batch() instead of one block at a time.  The data block of the
+ *  next message block is prefetched while the current one is released so that the walk takes one
+ *  pass over each data block cache line.  The messages must not be on a queue; b_next and b_prev
+ *  are cleared as the chain is walked.
+ */
+streams_fastcall void
+freemsgchain(mblk_t *mp)
+{
+	mblk_t *m, *m_next, *b, *b_cont;
+	mblk_t *head = NULL, **tail = &head;
+
+	for (m = mp; m != NULL; m = m_next) {
+		m_next = m->b_next;
+		m->b_next = m->b_prev = NULL;
+		for (b = m; b != NULL; b = b_cont) {
+			dblk_t *db, *dp;
+
+			if ((b_cont = b->b_cont) != NULL)
+				prefetchw(b_cont->b_datap);
+			else
+				prefetchw(m_next);
+
+			db = b->b_datap;
+			b->b_datap = NULL;
+			/* check double free */
+			dassert(db != NULL);
+			dassert(db->db_ref > 0);
+
+			if (likely(db_dec_and_test(db) != 0)) {
+				mblk_t *mb = db_to_mb(db);
+
+				__freedb_buf(db);
+				/* the entire mdbblock can go if the associated msgb is also unused */
+				if (likely(mb->b_datap == NULL)) {
+					*tail = mb;
+					tail = &mb->b_next;
+				}
+			}
+			/* as for freeb(), the mdbblock can go if its own datab is also unused */
+			if (unlikely(db != (dp = mb_to_db(b)) && !dp->db_ref)) {
+				*tail = b;
+				tail = &b->b_next;
+			}
+		}
+	}
+	if (likely(head != NULL)) {
+		*tail = NULL;
+		mdbblock_free_batch(head);
+	}
+}
+
+EXPORT_SYMBOL(freemsgchain);	/* include/sys/openss7/stream.h */
+
 /**
  *  isdatablk:	- test data block for data type
  *  @dp:	data block to test
@@ -845,6 +1215,66 @@ __STRUTIL_EXTERN_INLINE mblk_t *linkmsg(mblk_t *mp1, mblk_t *mp2);
 
 EXPORT_SYMBOL(linkmsg);
 
+/**
+ *  mblk_headroom: - bytes available ahead of the data in a message block
+ *  @mp:	the message block
+ */
+__STRUTIL_EXTERN_INLINE ssize_t mblk_headroom(mblk_t *mp);
+
+EXPORT_SYMBOL(mblk_headroom);	/* include/sys/openss7/stream.h */
+
+/**
+ *  mblk_tailroom: - bytes available after the data in a message block
+ *  @mp:	the message block
+ */
+__STRUTIL_EXTERN_INLINE ssize_t mblk_tailroom(mblk_t *mp);
+
+EXPORT_SYMBOL(mblk_tailroom);	/* include/sys/openss7/stream.h */
+
+/**
+ *  mblk_reserve: - reserve headroom in an empty message block
+ *  @mp:	the message block
+ *  @len:	number of bytes to reserve
+ */
+__STRUTIL_EXTERN_INLINE void mblk_reserve(mblk_t *mp, size_t len);
+
+EXPORT_SYMBOL(mblk_reserve);	/* include/sys/openss7/stream.h */
+
+/**
+ *  mblk_push: - prepend a header into the headroom of a message block
+ *  @mp:	the message block
+ *  @len:	length of the header
+ *
+ *  Returns a pointer to the header (the new b_rptr), or NULL when there is insufficient headroom or
+ *  the data block is shared.
+ */
+__STRUTIL_EXTERN_INLINE unsigned char *mblk_push(mblk_t *mp, size_t len);
+
+EXPORT_SYMBOL(mblk_push);	/* include/sys/openss7/stream.h */
+
+/**
+ *  mblk_pull: - strip a header from a message block
+ *  @mp:	the message block
+ *  @len:	length of the header
+ *
+ *  Returns a pointer to the stripped header, or NULL when the block is shorter than the header.
+ */
+__STRUTIL_EXTERN_INLINE unsigned char *mblk_pull(mblk_t *mp, size_t len);
+
+EXPORT_SYMBOL(mblk_pull);	/* include/sys/openss7/stream.h */
+
+/**
+ *  mblk_put: - append data into the tailroom of a message block
+ *  @mp:	the message block
+ *  @len:	length of the data
+ *
+ *  Returns a pointer to the appended area (the old b_wptr), or NULL when there is insufficient
+ *  tailroom or the data block is shared.
+ */
+__STRUTIL_EXTERN_INLINE unsigned char *mblk_put(mblk_t *mp, size_t len);
+
+EXPORT_SYMBOL(mblk_put);	/* include/sys/openss7/stream.h */
+
 /**
  *  msgdsize:	- calculate size of data in message
  *  @mp:	message across which to calculate data bytes
@@ -1118,6 +1548,60 @@ __STRUTIL_EXTERN_INLINE queue_t *backq(register queue_t *q);
 
 EXPORT_SYMBOL(backq);
 
+/*
+ *  __find_qband:
+ *
+ *  Find a queue band.  This must be called with the queue read or write locked.  Queue bands are
+ *  looked up directly in the q_bandv index rather than by walking the q_bandp list, so that banded
+ *  messages do not pay for each band above them.
+ */
+STATIC streams_inline streams_fastcall struct qband *
+__find_qband(queue_t *q, unsigned char band)
+{
+	if (unlikely(band > q->q_nband) || unlikely(band == 0))
+		return (NULL);
+	return (q->q_bandv[band]);
+}
+
+/*
+ *  __qband_last:
+ *
+ *  Find the message after which a message for @band is to be linked: the last message of the
+ *  lowest non-empty band at or above @band, or the last high priority message, or NULL.  The
+ *  q_bandmap bitmap of non-empty bands makes this a single bit search except when there are no
+ *  banded messages above @band, when only high priority messages need be skipped.  This must be
+ *  called with the queue read or write locked.
+ */
+STATIC streams_inline streams_fastcall mblk_t *
+__qband_last(queue_t *q, int band)
+{
+	mblk_t *b, *b_prev = NULL;
+
+	if (unlikely((band = find_next_bit(q->q_bandmap, NBAND, band)) < NBAND))
+		return (q->q_bandv[band]->qb_last);
+	for (b = q->q_first; unlikely(b != NULL) && unlikely(b->b_datap->db_type >= QPCTL);
+	     b = b->b_next)
+		b_prev = b;
+	return (b_prev);
+}
+
+/*
+ *  __qband_highest:
+ *
+ *  Find the highest non-empty band.  Returns zero when no band has messages.  This must be called
+ *  with the queue read or write locked.
+ */
+STATIC streams_inline streams_fastcall int
+__qband_highest(queue_t *q)
+{
+	int i;
+
+	for (i = ARRAY_SIZE(q->q_bandmap) - 1; i >= 0; i--)
+		if (unlikely(q->q_bandmap[i] != 0))
+			return (i * BITS_PER_LONG + fls64(q->q_bandmap[i]) - 1);
+	return (0);
+}
+
 STATIC struct qband *__get_qband(queue_t *q, unsigned char band);
 
 streams_noinline streams_fastcall __unlikely void
@@ -1202,25 +1686,19 @@ EXPORT_SYMBOL_GPL(qbackenable);
  *  when to set the POLLRDBAND flags.  Also, bcangetany() returns the band number of the highest
  *  priority band with messages.
  *
- *  IMPLEMENTATION: The current implementation is much faster than the older method of walking the
- *  queue bands, even considering that there were probably few, if any, queue bands.
+ *  IMPLEMENTATION: The highest non-empty band is found in the q_bandmap bitmap without walking
+ *  either the queue bands or the messages on the queue.
  */
 streams_inline streams_fastcall __hot int
 bcangetany(queue_t *q)
 {
-	int found = 0;
-	mblk_t *b;
+	int found;
 	unsigned long pl;
 
 	dassert(q);
 
 	qrlock(q, pl);
-	b = q->q_first;
-	/* find normal messages */
-	for (; b && b->b_datap->db_type >= QPCTL; b = b->b_next) ;
-	/* did we find it? */
-	if (b)
-		found = b->b_band;
+	found = __qband_highest(q);
 	qrunlock(q, pl);
 	return (found);
 }
@@ -1232,11 +1710,9 @@ EXPORT_SYMBOL_GPL(bcangetany);
  *  @q:		queue to check
  *  @band:	band to check
  *
- *  IMPLEMENTATION: For banded checks, we are pretty much forced to either walk the message queue or
- *  walk the queue bands.  Because banded messages are rare, there are likely fewer banded messages
- *  on the queue than there are queue bands and walking the queue is probably faster.  Also, walking
- *  the queue works for band zero (0) messages as well as long as we always skip high priority
- *  messages. That is what we do.
+ *  IMPLEMENTATION: For banded checks, the q_bandmap bitmap records which bands have messages.  Band
+ *  zero (0) messages are always queued last, so there are band zero messages exactly when the last
+ *  message on the queue is a normal band zero message.  Neither check walks the queue.
  *
  *  NOTICES: The caller is responsible for the validity of the passed in queue pointer.
  *
@@ -1253,18 +1729,13 @@ bcanget(queue_t *q, unsigned char band)
 	dassert(q);
 
 	qrlock(q, pl);
-	{
+	if (likely(band == 0)) {
 		mblk_t *b;
 
-		b = q->q_first;
-		/* find normal messages */
-		for (; b && b->b_datap->db_type >= QPCTL; b = b->b_next) ;
-		/* find band we are looking for */
-		for (; b && b->b_band > band; b = b->b_next) ;
-		/* did we find it? */
-		if (b && b->b_band == band)
+		if ((b = q->q_last) != NULL && b->b_datap->db_type < QPCTL && b->b_band == 0)
 			found = 1;
-	}
+	} else if (test_bit(band, q->q_bandmap))
+		found = 1;
 	qrunlock(q, pl);
 	return (found);
 }
@@ -1372,22 +1843,6 @@ bcanputany(queue_t *q)
 
 EXPORT_SYMBOL_GPL(bcanputany);	/* include/sys/openss7/stream.h */
 
-/*
- *  __find_qband:
- *
- * Find a queue band.  This must be called with the queue read or write locked.
- */
-STATIC struct qband *
-__find_qband(queue_t *q, unsigned char band)
-{
-	struct qband *qb;
-	unsigned char q_nband;
-
-	for (q_nband = q->q_nband, qb = q->q_bandp; qb && q_nband > band;
-	     qb = qb->qb_next, q_nband--) ;
-	return (qb);
-}
-
 /*
  *  __get_qband:
  *
@@ -1415,6 +1870,18 @@ __get_qband(queue_t *q, unsigned char band)
 		qb = __find_qband(q, band);
 		dassert(qb);
 	} else {
+		if (q->q_bandv == NULL || qbandv_size(band) > qbandv_size(q->q_nband)) {
+			struct qband **qbv;
+
+			/* grow the band index */
+			if (!(qbv = kmem_zalloc(qbandv_size(band) * sizeof(*qbv), KM_NOSLEEP)))
+				return (NULL);
+			if (q->q_bandv != NULL) {
+				bcopy(q->q_bandv, qbv, (q->q_nband + 1) * sizeof(*qbv));
+				kmem_free(q->q_bandv, qbandv_size(q->q_nband) * sizeof(*qbv));
+			}
+			q->q_bandv = qbv;
+		}
 		do {
 			if (!(qb = allocqb()))
 				break;
@@ -1422,7 +1889,7 @@ __get_qband(queue_t *q, unsigned char band)
 			q->q_bandp = qb;
 			qb->qb_hiwat = q->q_hiwat;
 			qb->qb_lowat = q->q_lowat;
-			q->q_nband++;
+			q->q_bandv[++q->q_nband] = qb;
 		} while (band > q->q_nband);
 	}
 	return (qb);
@@ -1823,6 +2290,9 @@ qschedule(queue_t *q)
 	if (!test_and_set_bit(QENAB_BIT, &q->q_flag)) {
 		struct strthread *t = this_thread;
 
+		if (unlikely(qhist(q) != NULL))
+			qhist_enable(qhist(q), q);
+
 		/* put ourselves on the run list */
 		prefetchw(t);
 		q->q_link = NULL;
@@ -1830,7 +2300,9 @@ qschedule(queue_t *q)
 			unsigned long flags;
 
 			streams_local_save(flags);
-			*XCHG(&t->qtail, &q->q_link) = qget(q);
+			if ((likely(sysctl_str_wsteal == 0) && likely(sysctl_str_runq_cpus == ~0UL))
+			    || !stealq_push(t, q))
+				*XCHG(&t->qtail, &q->q_link) = qget(q);
 			streams_local_restore(flags);
 		}
 		setqsched();
@@ -1928,6 +2400,47 @@ noenable(queue_t *q)
 
 EXPORT_SYMBOL(noenable);	/* include/sys/openss7/stream.h */
 
+/*
+ *  Sojourn-time flow control.
+ *
+ *  When a queue has the %QDELAY flag set (see strqset(9) %QTARGET), messages are time stamped as
+ *  they are placed on the queue and normal (band zero) flow control follows the time that the
+ *  message at the head of the queue has waited rather than the number of bytes queued, in the
+ *  fashion of CoDel.  The queue is flow controlled once the head-of-line sojourn time has remained
+ *  at or above q_target for at least q_interval, and is released as soon as a message is retrieved
+ *  within target or the queue drains.  q_hiwat remains a hard limit on the bytes queued.
+ *
+ *  So as not to grow struct mbinfo, the time stamp shares the word used for syncq deferral and is
+ *  kept in units of 1024 nsec.  On 32-bit it wraps after about 73 minutes, which is far longer than
+ *  any sojourn time of interest.
+ */
+#define MB_TSHIFT 10
+#define mbtstamp(__mp) (((struct mbinfo *)(__mp))->m_tstamp)
+#define mbclock(__now) ((unsigned long) ((__now) >> MB_TSHIFT))
+#define mbdelta(__t1, __t2) ((unsigned long long) (unsigned long) ((__t1) - (__t2)) << MB_TSHIFT)
+
+/*
+ *  __qsojourn: - check head-of-line sojourn time
+ *  @q:		the queue (write locked)
+ *  @sojourn:	head-of-line sojourn time (nsec)
+ *  @now:	current time (nsec)
+ *
+ *  Returns true when the sojourn time has been at or above target for a whole interval.
+ */
+STATIC streams_inline streams_fastcall bool
+__qsojourn(queue_t *q, unsigned long long sojourn, unsigned long long now)
+{
+	if (likely(sojourn < q->q_target)) {
+		q->q_above = 0;
+		return (false);
+	}
+	if (q->q_above == 0) {
+		q->q_above = now + q->q_interval;
+		return (false);
+	}
+	return (now >= q->q_above);
+}
+
 /*
  *  __putbq_pri: - put a high priority message back onto a queue
  *  @q:		queue to which to return the message
@@ -1967,28 +2480,17 @@ __putbq_band(queue_t *q, mblk_t *mp)
 	mblk_t *b_next, *b_prev;
 	struct qband *qb;
 
-	b_prev = NULL;
-	b_next = q->q_first;
-	/* skip high priority */
-	while (unlikely(b_next && b_next->b_datap->db_type >= QPCTL)) {
-		b_prev = b_next;
-		b_next = b_prev->b_next;
-	}
-	/* skip higher bands */
-	while (unlikely(b_next && b_next->b_band > mp->b_band)) {
-		b_prev = b_next;
-		b_next = b_prev->b_next;
-	}
-
 	if (unlikely((qb = __get_qband(q, mp->b_band)) == NULL))
 		return (0);
-	if (likely(qb->qb_last == b_prev) || likely(qb->qb_last == NULL))
-		qb->qb_last = mp;
-	if (likely(qb->qb_first == b_next) || likely(qb->qb_first == NULL))
+	/* skip high priority and higher bands */
+	b_prev = __qband_last(q, mp->b_band + 1);
+	b_next = b_prev ? b_prev->b_next : q->q_first;
+
+	if (likely(qb->qb_msgs++ == 0)) {
+		qb->qb_first = qb->qb_last = mp;
+		__set_bit(mp->b_band, q->q_bandmap);
+	} else
 		qb->qb_first = mp;
-	dassert(qb->qb_first != NULL);
-	dassert(qb->qb_last != NULL);
-	qb->qb_msgs++;
 	if (unlikely((qb->qb_count += msgsize(mp)) > qb->qb_hiwat))
 		if (likely(!test_and_set_bit(QB_FULL_BIT, &qb->qb_flag)))
 			q->q_blocked++;
@@ -2059,6 +2561,9 @@ __putbq_norm(queue_t *q, mblk_t *mp)
 STATIC streams_inline streams_fastcall __hot int
 __putbq(queue_t *q, mblk_t *mp)
 {				/* IRQ DISABLED */
+	/* a message put back keeps the time it was first queued */
+	if (unlikely(test_bit(QDELAY_BIT, &q->q_flag)) && mbtstamp(mp) == 0)
+		mbtstamp(mp) = mbclock(str_clock());
 	/* fast path for normal messages */
 	if (likely(mp->b_datap->db_type < QPCTL))
 		return __putbq_norm(q, mp);
@@ -2292,27 +2797,17 @@ __putq_band(queue_t *q, mblk_t *mp)
 	mblk_t *b_prev, *b_next;
 	struct qband *qb;
 
-	/* find position of priority messages */
-	b_prev = NULL;
-	b_next = q->q_first;
-	while (unlikely(b_next && b_next->b_datap->db_type >= QPCTL)) {
-		b_prev = b_next;
-		b_next = b_prev->b_next;
-	}
 	if (unlikely((qb = __get_qband(q, mp->b_band)) == NULL))
 		return (0);
-	/* find position for our message */
-	while (unlikely(b_next && b_next->b_band >= mp->b_band)) {
-		b_prev = b_next;
-		b_next = b_prev->b_next;
-	}
-	if (likely(qb->qb_last == b_prev || qb->qb_last == NULL))
+	/* find position for our message: after high priority messages and our or higher bands */
+	b_prev = __qband_last(q, mp->b_band);
+	b_next = b_prev ? b_prev->b_next : q->q_first;
+
+	if (likely(qb->qb_msgs++ == 0)) {
+		qb->qb_first = qb->qb_last = mp;
+		__set_bit(mp->b_band, q->q_bandmap);
+	} else
 		qb->qb_last = mp;
-	if (unlikely(qb->qb_first == b_next || qb->qb_first == NULL))
-		qb->qb_first = mp;
-	dassert(qb->qb_first != NULL);
-	dassert(qb->qb_last != NULL);
-	qb->qb_msgs++;
 	if (unlikely((qb->qb_count += msgsize(mp)) > qb->qb_hiwat))
 		if (likely(!test_and_set_bit(QB_FULL_BIT, &qb->qb_flag)))
 			q->q_blocked++;
@@ -2343,6 +2838,12 @@ __putq_norm(queue_t *q, mblk_t *mp)
 		q->q_msgs++;
 		if (unlikely((q->q_count += msgsize(mp)) > q->q_hiwat))
 			set_bit(QFULL_BIT, &q->q_flag);
+		else if (unlikely(test_bit(QDELAY_BIT, &q->q_flag))) {
+			unsigned long long now = str_clock();
+
+			if (__qsojourn(q, mbdelta(mbtstamp(mp), mbtstamp(q->q_first)), now))
+				set_bit(QFULL_BIT, &q->q_flag);
+		}
 		/* success */
 		return (1 + (q->q_first == mp && !test_bit(QNOENB_BIT, &q->q_flag)
 			     && test_bit(QWANTR_BIT, &q->q_flag)));
@@ -2372,6 +2873,8 @@ __putq_norm(queue_t *q, mblk_t *mp)
 STATIC streams_inline streams_fastcall __hot int
 __putq(queue_t *q, mblk_t *mp)
 {
+	if (unlikely(test_bit(QDELAY_BIT, &q->q_flag)))
+		mbtstamp(mp) = mbclock(str_clock());
 	/* fast path for normal messages */
 	if (likely(mp->b_datap->db_type < QPCTL))
 		return __putq_norm(q, mp);
@@ -2381,6 +2884,8 @@ __putq(queue_t *q, mblk_t *mp)
 STATIC streams_inline streams_fastcall __hot int
 __putq_insq(queue_t *q, mblk_t *mp)
 {
+	if (unlikely(test_bit(QDELAY_BIT, &q->q_flag)))
+		mbtstamp(mp) = mbclock(str_clock());
 	/* fast path for normal messages */
 	if (likely(mp->b_datap->db_type < QPCTL))
 		return __putq_norm(q, mp);
@@ -2408,6 +2913,9 @@ putq(register queue_t *q, register mblk_t *mp)
 
 	qwlock(q, pl);
 	result = __putq(q, mp);
+	/* still queued: cannot be taken until unlocked */
+	if (likely(result != 0))
+		strftrace(qstream(q), q, mp, FTEV_PUTQ);
 	qwunlock(q, pl);
 	if (likely(result < 2))
 		return (result);
@@ -2441,12 +2949,15 @@ __insq_middle(queue_t *q, mblk_t *emp, mblk_t *nmp)
 		if (unlikely(nmp->b_band)) {
 			if (!(qb = __get_qband(q, nmp->b_band)))
 				goto enomem;
-			if (qb->qb_last == emp || qb->qb_last == NULL)
-				qb->qb_last = nmp;
-			if (qb->qb_first == emp->b_next || qb->qb_first == NULL)
-				qb->qb_first = nmp;
-			dassert(qb->qb_first != NULL);
-			dassert(qb->qb_last != NULL);
+			if (qb->qb_msgs == 0) {
+				qb->qb_first = qb->qb_last = nmp;
+				__set_bit(nmp->b_band, q->q_bandmap);
+			} else {
+				if (qb->qb_first == emp)
+					qb->qb_first = nmp;
+				if (qb->qb_last == emp->b_prev)
+					qb->qb_last = nmp;
+			}
 		}
 	}
 	if (likely(q->q_first == emp))
@@ -2486,6 +2997,8 @@ __insq(queue_t *q, mblk_t *emp, mblk_t *nmp)
 {
 	if (likely(emp == NULL))
 		return __putq_insq(q, nmp);
+	if (unlikely(test_bit(QDELAY_BIT, &q->q_flag)))
+		mbtstamp(nmp) = mbclock(str_clock());
 	return __insq_middle(q, emp, nmp);
 }
 
@@ -3177,16 +3690,12 @@ __rmvq_band(queue_t *q, mblk_t *mp)
 			q->q_last = b_prev;
 		q->q_msgs--;
 		dassert(q->q_msgs >= 0);
-		{
-			unsigned char q_nband, band;
-
-			for (band = mp->b_band, q_nband = q->q_nband, qb = q->q_bandp;
-			     qb && q_nband > band; qb = qb->qb_next, q_nband--) ;
-		}
+		qb = __find_qband(q, mp->b_band);
 		dassert(qb);
-		if (qb->qb_first == mp && qb->qb_last == mp)
+		if (qb->qb_first == mp && qb->qb_last == mp) {
 			qb->qb_first = qb->qb_last = NULL;
-		else {
+			__clear_bit(mp->b_band, q->q_bandmap);
+		} else {
 			if (qb->qb_first == mp)
 				qb->qb_first = b_next;
 			if (qb->qb_last == mp)
@@ -3380,6 +3889,7 @@ __flushband(queue_t *q, unsigned char band, int flag, mblk_t ***mppp)
 				assert(q->q_msgs >= 0);
 				qb->qb_msgs = 0;
 				qb->qb_first = qb->qb_last = NULL;
+				__clear_bit(band, q->q_bandmap);
 				if (unlikely(test_and_clear_bit(QB_FULL_BIT, &qb->qb_flag)))
 					q->q_blocked--;
 				clear_bit(QB_WANTW_BIT, &qb->qb_flag);
@@ -3514,6 +4024,7 @@ __flushq(queue_t *q, int flag, mblk_t ***mppp, unsigned long bands[])
 			q->q_first = q->q_last = NULL;
 			q->q_count = 0;
 			q->q_msgs = 0;
+			bzero(q->q_bandmap, sizeof(q->q_bandmap));
 			if (unlikely(test_and_clear_bit(QFULL_BIT, &q->q_flag)))
 				if (likely(test_and_clear_bit(QWANTW_BIT, &q->q_flag))) {
 					backenable = true;
@@ -3598,6 +4109,32 @@ flushq(register queue_t *q, int flag)
 
 EXPORT_SYMBOL(flushq);		/* include/sys/openss7/stream.h */
 
+/*
+ *  __getq_delay: - sojourn-time flow control on retrieving a normal message
+ *  @q:		the queue (write locked)
+ *  @mp:	the message retrieved
+ *  @be:	set when the queue is to be back-enabled
+ */
+streams_noinline streams_fastcall void
+__getq_delay(queue_t *q, mblk_t *mp, bool *be)
+{
+	unsigned long long now = str_clock();
+	unsigned long long sojourn = mbdelta(mbclock(now), mbtstamp(mp));
+
+	q->q_sojourn = sojourn;
+	if (unlikely(sojourn > q->q_maxsojourn))
+		q->q_maxsojourn = sojourn;
+	if (q->q_first != NULL && __qsojourn(q, sojourn, now))
+		set_bit(QFULL_BIT, &q->q_flag);
+	else if (q->q_count < q->q_hiwat) {
+		if (q->q_first == NULL)
+			q->q_above = 0;
+		if (unlikely(test_and_clear_bit(QFULL_BIT, &q->q_flag)))
+			if (likely(test_and_clear_bit(QWANTW_BIT, &q->q_flag)))
+				*be = true;
+	}
+}
+
 /*
  *  __getq:	- get next message off a queue
  *  @q:		the queue from which to get the message
@@ -3611,7 +4148,9 @@ EXPORT_SYMBOL(flushq);		/* include/sys/openss7/stream.h */
  *  implementations clear QFULL when q_count falls below q_hiwat, some wait until q_count falls
  *  below q_lowat before clearing QFULL.  All will only backenable the queue when QWANTW is set
  *  while the q_count falls below q_lowat.  We leave QFULL set until q_count falls below q_lowat to
- *  allow sufficient hysteresis, should canput() be checked before a backenable occurs.
+ *  allow sufficient hysteresis, should canput() be checked before a backenable occurs.  Queues in
+ *  sojourn-time flow control mode (%QDELAY) release QFULL on sojourn time instead (see
+ *  __getq_delay()).
  */
 STATIC streams_inline streams_fastcall __hot mblk_t *
 __getq(queue_t *q, bool *be)
@@ -3631,7 +4170,9 @@ __getq(queue_t *q, bool *be)
 		if (likely(mp->b_band == 0)) {
 			q->q_count -= msgsize(mp);
 			dassert(q->q_count >= 0);
-			if (q->q_count == 0 || q->q_count < q->q_lowat)
+			if (unlikely(test_bit(QDELAY_BIT, &q->q_flag)))
+				__getq_delay(q, mp, be);
+			else if (q->q_count == 0 || q->q_count < q->q_lowat)
 				if (unlikely(test_and_clear_bit(QFULL_BIT, &q->q_flag)))
 					if (likely(test_and_clear_bit(QWANTW_BIT, &q->q_flag)))
 						*be = true;
@@ -3640,9 +4181,11 @@ __getq(queue_t *q, bool *be)
 
 			qb = __find_qband(q, mp->b_band);
 			dassert(qb);
-			qb->qb_first = q->q_first;
-			if (likely(qb->qb_last == mp))
-				qb->qb_last = NULL;
+			if (likely(qb->qb_last == mp)) {
+				qb->qb_first = qb->qb_last = NULL;
+				__clear_bit(mp->b_band, q->q_bandmap);
+			} else
+				qb->qb_first = q->q_first;
 			qb->qb_msgs--;
 			dassert(qb->qb_msgs >= 0);
 			qb->qb_count -= msgsize(mp);
@@ -3686,6 +4229,8 @@ getq(register queue_t *q)
 	qwlock(q, pl);
 	mp = __getq(q, &backenable);
 	qwunlock(q, pl);
+	if (mp != NULL)
+		strftrace(qstream(q), q, mp, FTEV_GETQ);
 	if (likely(backenable == false))
 		return (mp);
 	qbackenable(q, mp->b_band, NULL);
@@ -3925,6 +4470,14 @@ setsq(queue_t *q, struct fmodsw *fmod)
 
 EXPORT_SYMBOL_GPL(setsq);	/* for stream head include/sys/openss7/strsubr.h */
 
+/* nanoseconds to microseconds without 64-bit division */
+STATIC __unlikely long
+__qusec(unsigned long long nsec)
+{
+	do_div(nsec, 1000);
+	return ((long) nsec);
+}
+
 /**
  *  strqget:	- get characteristics of a queue
  *  @q:		queue to query
@@ -3967,6 +4520,18 @@ strqget(register queue_t *q, qfields_t what, register unsigned char band, long *
 		case QFLAG:
 			*val = (volatile unsigned long) q->q_flag;
 			break;
+		case QTARGET:
+			*val = __qusec(q->q_target);
+			break;
+		case QINTERVAL:
+			*val = __qusec(q->q_interval);
+			break;
+		case QSOJOURN:
+			*val = __qusec(q->q_sojourn);
+			break;
+		case QMAXSOJOURN:
+			*val = __qusec(q->q_maxsojourn);
+			break;
 		default:
 			err = -EINVAL;
 			break;
@@ -4018,6 +4583,34 @@ strqget(register queue_t *q, qfields_t what, register unsigned char band, long *
 
 EXPORT_SYMBOL(strqget);
 
+/*
+ *  __qdelay: - set the sojourn target of a queue
+ *  @q:		the queue (write locked)
+ *  @target:	sojourn target (nsec), zero to revert to byte flow control
+ *
+ *  Messages already on the queue when sojourn-time flow control is switched on are stamped as
+ *  though they had just arrived.
+ */
+STATIC __unlikely void
+__qdelay(queue_t *q, unsigned long long target)
+{
+	q->q_target = target;
+	q->q_above = 0;
+	if (target == 0) {
+		clear_bit(QDELAY_BIT, &q->q_flag);
+		return;
+	}
+	if (q->q_interval == 0)
+		q->q_interval = 100 * 1000000ULL;	/* CoDel suggests 100 milliseconds */
+	if (!test_and_set_bit(QDELAY_BIT, &q->q_flag)) {
+		unsigned long long now = str_clock();
+		mblk_t *b;
+
+		for (b = q->q_first; b; b = b->b_next)
+			mbtstamp(b) = mbclock(now);
+	}
+}
+
 /**
  *  strqset:	- set characteristics of a queue
  *  @q:		queue to set
@@ -4052,10 +4645,33 @@ strqset(register queue_t *q, qfields_t what, register unsigned char band, long v
 		case QLOWAT:
 			q->q_lowat = val;
 			break;
+		case QTARGET:
+			if (val < 0) {
+				err = -EINVAL;
+				break;
+			}
+			__qdelay(q, (unsigned long long) val * 1000);
+			break;
+		case QINTERVAL:
+			if (val <= 0) {
+				err = -EINVAL;
+				break;
+			}
+			q->q_interval = (unsigned long long) val * 1000;
+			break;
+		case QMAXSOJOURN:
+			/* can only be reset */
+			if (val != 0) {
+				err = -EINVAL;
+				break;
+			}
+			q->q_maxsojourn = 0;
+			break;
 		case QCOUNT:
 		case QFIRST:
 		case QLAST:
 		case QFLAG:
+		case QSOJOURN:
 			err = -EPERM;
 			break;
 		default:
@@ -0,0 +1,152 @@
+/*****************************************************************************
+
+ @(#) File: src/lib/getmsgv.c
+
+ -----------------------------------------------------------------------------
+
+ Copyright (c) 2008-2015  Monavacon Limited <http://www.monavacon.com/>
+ Copyright (c) 2001-2008  OpenSS7 Corporation <http://www.openss7.com/>
+ Copyright (c) 1997-2001  Brian F. G. Bidulock <bidulock@openss7.org>
+
+ All Rights Reserved.
+
+ This program is free software: you can redistribute it and/or modify it under
+ the terms of the GNU Affero General Public License as published by the Free
+ Software Foundation, version 3 of the license.
+
+ This program is distributed in the hope that it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public License for more
+ details.
+
+ You should have received a copy of the GNU Affero General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>, or
+ write to the Free Software Foundation, Inc., 675 Mass Ave, Cambridge, MA
+ 02139, USA.
+
+ -----------------------------------------------------------------------------
+
+ U.S. GOVERNMENT RESTRICTED RIGHTS.  If you are licensing this Software on
+ behalf of the U.S. Government ("Government"), the following provisions apply
+ to you.  If the Software is supplied by the Department of Defense ("DoD"), it
+ is classified as "Commercial Computer Software" under paragraph 252.227-7014
+ of the DoD Supplement to the Federal Acquisition Regulations ("DFARS") (or any
+ successor regulations) and the Government is acquiring only the license rights
+ granted herein (the license rights customarily provided to non-Government
+ users).  If the Software is supplied to any unit or agency of the Government
+ other than DoD, it is classified as "Restricted Computer Software" and the
+ Government's rights in the Software are defined in paragraph 52.227-19 of the
+ Federal Acquisition Regulations ("FAR") (or any successor regulations) or, in
+ the cases of NASA, in paragraph 18.52.227-86 of the NASA Supplement to the FAR
+ (or any successor regulations).
+
+ -----------------------------------------------------------------------------
+
+ Commercial licensing and support of this software is available from OpenSS7
+ Corporation at a fee.  See http://www.openss7.com/
+
+ *****************************************************************************/
+
+static char const ident[] __attribute__ ((unused)) = "src/lib/getmsgv.c (" PACKAGE_ENVR ") " PACKAGE_DATE;
+
+/* This file can be processed with doxygen(1). */
+
+#include "streams.h"
+
+/** @weakgroup strcalls STREAMS System Calls
+  * @{ */
+
+/** @file
+  * STREAMS Library getmsgv() implementation file.  */
+
+/** @brief Handle errors appropriately.
+  * @param fd the file descriptor associated with the error.
+  *
+  * Checks the error in errno, and if the error is a set of errors that indicate
+  * that fd might not be a STREAMS character device special file, test the file
+  * descriptor with #I_ISASTREAM.  If fd is not a Stream, all errors that would
+  * indicate such are converted to {ENOSTR}.
+  */
+noinline __unlikely void
+__getmsgv_error(int fd)
+{
+	int __olderrno;
+
+	if ((__olderrno = errno) == EINVAL || __olderrno == EINTR || __olderrno == ENOTTY)
+		errno = (ioctl(fd, I_ISASTREAM) == -1) ? ENOSTR : __olderrno;
+}
+
+/** @brief Get several messages from a Stream.
+  * @param fd a file descriptor representing the Stream.
+  * @param msgv a vector of struct strmmsg structures, one for each message.
+  * @param vlen the number of elements in msgv.
+  *
+  * Each element of the vector is filled in as for getpmsg() and the return
+  * value of getpmsg() for the element, or a negative error number, is placed
+  * in its mm_status member.
+  */
+static __inline__ __hot int
+__getmsgv(int fd, struct strmmsg *msgv, int vlen)
+{
+	struct strmsgv args;
+
+	args.sv_msgv = msgv;
+	args.sv_vlen = vlen;
+
+	return ioctl(fd, I_GETMSGV, &args);
+}
+
+/** @brief Get several messages from a Stream.
+  * @param fd a file descriptor representing the Stream.
+  * @param msgv a vector of struct strmmsg structures, one for each message.
+  * @param vlen the number of elements in msgv.
+  * @version STREAMS_1.0
+  *
+  * This function is a non-thread-safe implementation of getmsgv().
+  */
+__hot int
+__streams_getmsgv(int fd, struct strmmsg *msgv, int vlen)
+{
+	int err;
+
+	if (unlikely((err = __getmsgv(fd, msgv, vlen)) == -1))
+		__getmsgv_error(fd);
+	return (err);
+}
+
+/** @brief Get several messages from a Stream.
+  * @param fd a file descriptor representing the Stream.
+  * @param msgv a vector of struct strmmsg structures, one for each message.
+  * @param vlen the number of elements in msgv.
+  * @version STREAMS_1.0 getmsgv()
+  *
+  * This function is a thread-safe implementation of getmsgv().  Like
+  * getpmsg(), getmsgv() contains a thread cancellation point.
+  */
+__hot int
+__streams_getmsgv_r(int fd, struct strmmsg *msgv, int vlen)
+{
+	int oldtype = 0;
+	int err;
+
+	pthread_setcanceltype(PTHREAD_CANCEL_DEFERRED, &oldtype);
+	if (unlikely((err = __getmsgv(fd, msgv, vlen)) == -1)) {
+		pthread_testcancel();
+		__getmsgv_error(fd);
+		pthread_testcancel();
+	}
+	pthread_setcanceltype(oldtype, NULL);
+	return (err);
+}
+
+/** @fn int getmsgv(int fd, struct strmmsg *msgv, int vlen)
+  * @param fd a file descriptor representing the Stream.
+  * @param msgv a vector of struct strmmsg structures, one for each message.
+  * @param vlen the number of elements in msgv.
+  * @version STREAMS_1.0 __streams_getmsgv_r()
+  */
+__asm__(".symver __streams_getmsgv_r,getmsgv@@STREAMS_1.0");
+
+/** @} */
+
+// vim: com=srO\:/**,mb\:*,ex\:*/,srO\:/*,mb\:*,ex\:*/,b\:TRANS
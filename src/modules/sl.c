@@ -1608,15 +1608,23 @@ sl_txc_bsnr_and_bibr(queue_t *q, struct sl *sl)
 	printd(("%s: %p: F.fsn = %x, R.bsn = %x, mask = %x\n", MOD_NAME, sl, sl->statem.tx.F.fsn,
 		sl->statem.tx.R.bsn, sl->statem.sn_mask));
 	if (sl->statem.tx.F.fsn != ((sl->statem.tx.R.bsn + 1) & sl->statem.sn_mask)) {
+		mblk_t *mp, *acked = NULL, **mpp = &acked;
+
 		if (sl->statem.sib_received) {
 			sl->statem.sib_received = 0;
 			sl_timer_stop(sl, t6);
 		}
 		do {
-			freemsg(bufq_dequeue(&sl->rtb));
+			/* collect acknowledged messages to free them in one batch */
+			if ((mp = bufq_dequeue(&sl->rtb)) != NULL) {
+				*mpp = mp;
+				mpp = &mp->b_next;
+			}
 			sl->statem.Ct--;
 			sl->statem.tx.F.fsn = (sl->statem.tx.F.fsn + 1) & sl->statem.sn_mask;
 		} while (sl->statem.tx.F.fsn != ((sl->statem.tx.R.bsn + 1) & sl->statem.sn_mask));
+		if (acked != NULL)
+			freemsgchain(acked);
 		if ((err = sl_check_congestion(q, sl)))
 			return (err);
 		sl_daedt_transmitter_wakeup(q, sl);
@@ -1734,10 +1742,20 @@ sl_txc_retrieval_request_and_fsnc(queue_t *q, struct sl *sl, sl_ulong fsnc)
 	 *
 	 *  (Tell the SIGTRAN working group and M2UA guys about this!)
 	 */
-	while (sl->rtb.q_count && sl->statem.tx.F.fsn != ((fsnc + 1) & sl->statem.sn_mask)) {
-		freemsg(bufq_dequeue(&sl->rtb));
-		sl->statem.Ct--;
-		sl->statem.tx.F.fsn = (sl->statem.tx.F.fsn + 1) & sl->statem.sn_mask;
+	{
+		mblk_t *acked = NULL, **mpp = &acked;
+
+		/* collect acknowledged messages to free them in one batch */
+		while (sl->rtb.q_count && sl->statem.tx.F.fsn != ((fsnc + 1) & sl->statem.sn_mask)) {
+			if ((mp = bufq_dequeue(&sl->rtb)) != NULL) {
+				*mpp = mp;
+				mpp = &mp->b_next;
+			}
+			sl->statem.Ct--;
+			sl->statem.tx.F.fsn = (sl->statem.tx.F.fsn + 1) & sl->statem.sn_mask;
+		}
+		if (acked != NULL)
+			freemsgchain(acked);
 	}
 	while ((mp = bufq_dequeue(&sl->tb))) {
 		sl->statem.Cm--;
@@ -73,6 +73,7 @@ static char const ident[] = "src/modules/sth.c (" PACKAGE_ENVR ") " PACKAGE_DATE
 #include <linux/poll.h>		/* for poll_wait */
 #include <linux/highmem.h>	/* for kmap, kunmap */
 #include <linux/uio.h>		/* for iovec */
+#include <linux/vmalloc.h>	/* for vmalloc_user, remap_vmalloc_range */
 
 #include <asm/ioctls.h>		/* for TGETS, etc. */
 #include <linux/termios.h>	/* for struct termios, etc. */
@@ -1723,12 +1724,18 @@ straccess_wakeup(struct stdata *sd, const int f_flags, unsigned long *timeo, con
  *  option to used sk_buff buffers as data buffers for the data blocks for streams that know that
  *  they need a sk_buff at the driver.  This feature can be set using the SO_SKBUFF option using an
  *  M_SETOPTS message sent upstream to the stream head from the driver.
+ *
+ *  When sys.streams.irqnode is set, the buffer is allocated from the NUMA node of the processor
+ *  that last delivered messages to the stream head from interrupt or STREAMS scheduler context,
+ *  which is normally the processor servicing the driver's interrupts.
  */
 STATIC streams_inline streams_fastcall __hot_write mblk_t *
 allocb_buf(struct stdata *sd, size_t size, uint priority)
 {
 	if (test_bit(STRSKBUFF_BIT, &sd->sd_flag))
 		priority |= BPRI_SKBUFF;
+	if (unlikely(sysctl_str_irqnode != 0))
+		return (allocb_node(size, priority, sd->sd_node));
 	return (allocb(size, priority));
 }
 
@@ -1793,6 +1800,51 @@ alloc_data(struct stdata *sd, ssize_t dlen, const void __user *dbuf)
 	return (ERR_PTR(-ENOSR));
 }
 
+#if defined HAVE_KMEMB_STRUCT_FILE_OPERATIONS_READ_ITER && defined HAVE_KFUNC_COPY_TO_ITER
+#define HAVE_STRREAD_ITER 1
+#endif
+#if defined HAVE_KMEMB_STRUCT_FILE_OPERATIONS_WRITE_ITER && defined HAVE_KFUNC_COPY_FROM_ITER
+#define HAVE_STRWRITE_ITER 1
+#endif
+
+#ifdef HAVE_STRWRITE_ITER
+/**
+ *  alloc_data_iter - allocate an M_DATA message block for write data from an iterator
+ *  @sd stream head
+ *  @dlen: M_DATA size
+ *  @from: iterator describing the source
+ *
+ *  As alloc_data(), but copies @dlen bytes from @from for write_iter() and splice(2).  The
+ *  iterator is advanced past the copied data.
+ */
+STATIC streams_inline streams_fastcall __hot_write mblk_t *
+alloc_data_iter(struct stdata *sd, ssize_t dlen, struct iov_iter *from)
+{
+	int sd_wroff = sd->sd_wroff;
+	mblk_t *dp;
+
+	dp = allocb_buf(sd, sd_wroff + dlen + sd->sd_wrpad, BPRI_WAITOK);
+	if (unlikely(dp == NULL))
+		return (ERR_PTR(-ENOSR));
+	if (sd_wroff) {
+		dp->b_rptr += sd_wroff;
+		dp->b_wptr += sd_wroff;
+	}
+	if (likely(dlen > 0)) {
+		if (unlikely(copy_from_iter(dp->b_rptr, dlen, from) != dlen)) {
+			freeb(dp);
+			return (ERR_PTR(-EFAULT));
+		}
+		if (unlikely(test_bit(STRCSUM_BIT, &sd->sd_flag))) {
+			dp->b_csum = csum_partial(dp->b_rptr, dlen, 0);
+			dp->b_flag |= MSGCSUM;
+		}
+		dp->b_wptr += dlen;
+	}
+	return (dp);
+}
+#endif				/* HAVE_STRWRITE_ITER */
+
 /**
  *  alloc_proto - allocate an M_(PC)PROTO and M_DATA message blocks for put(p)msg data
  *  @sd: stream head
@@ -3179,6 +3231,59 @@ strmcopyout(mblk_t **mpp, caddr_t uaddr, size_t len, bool protdis)
 	return (copied);
 }
 
+#ifdef HAVE_STRREAD_ITER
+/**
+ *  strmcopyout_iter: - copy out a buffer chain to an iterator
+ *  @mpp: buffer chain to copy out
+ *  @to: iterator to copy to
+ *  @len: maximum length to copy
+ *  @protodis: only M_DATA messages
+ *
+ *  Like strmcopyout(), but for read_iter().  The iterator may describe user memory (readv(2)) or
+ *  pipe buffers (splice(2)), in which case the copy stops short when the pipe is full.  A short
+ *  copy is only an error when nothing was copied.
+ */
+STATIC streams_inline streams_fastcall __hot_read ssize_t
+strmcopyout_iter(mblk_t **mpp, struct iov_iter *to, size_t len, bool protdis)
+{
+	mblk_t *b;
+	ssize_t copied = 0;
+	int err = 0;
+
+	if (likely((b = *mpp) != NULL)) {
+		mblk_t *b_cont = NULL;
+		ssize_t blen, dlen, n;
+
+		do {
+			prefetchw(b->b_cont);
+			if (unlikely((blen = b->b_wptr - b->b_rptr) <= 0))
+				goto unlink;
+			if (unlikely(protdis && b->b_datap->db_type != M_DATA))
+				goto unlink;
+			if (likely((dlen = min(blen, len - copied)) > 0)) {
+				n = copy_to_iter(b->b_rptr, dlen, to);
+				copied += n;
+				b->b_rptr += n;
+				if (unlikely(n < dlen)) {
+					if (copied == 0)
+						err = -EFAULT;
+					break;
+				}
+				if (b->b_rptr < b->b_wptr)
+					break;
+			}
+		      unlink:
+			b_cont = unlinkb(b);
+			freeb(b);
+		} while (unlikely((b = b_cont) != NULL));
+		*mpp = b;
+		if (err)
+			return (err);
+	}
+	return (copied);
+}
+#endif				/* HAVE_STRREAD_ITER */
+
 STATIC int
 strdoioctl_str(struct stdata *sd, struct strioctl *ic, const int access, const bool user, const uint model)
 {
@@ -3974,6 +4079,61 @@ strhangup(struct stdata *sd)
 	}
 }
 
+#if defined HAVE_KFUNC_VMALLOC_USER && defined HAVE_KFUNC_REMAP_VMALLOC_RANGE
+#define HAVE_STRMRING 1
+#endif
+
+/**
+ *  struct strmring: - memory-mapped message rings
+ *  @mr_base: vmalloc_user() area mapped by strmmap()
+ *  @mr_size: size of the area (a multiple of PAGE_SIZE)
+ *  @mr_slots: slots per ring (a power of 2)
+ *  @mr_slotsize: size of each slot
+ *  @mr_rx: receive ring control structure (in the mapping)
+ *  @mr_tx: transmit ring control structure (in the mapping)
+ *  @mr_rxslots: receive ring slot zero
+ *  @mr_txslots: transmit ring slot zero
+ *  @mr_rxhead: private copy of the receive producer index
+ *  @mr_txtail: private copy of the transmit consumer index
+ *  @mr_txbusy: serializes draining of the transmit ring
+ *
+ *  The indices owned by the kernel side are kept privately and only copied out to the mapping so
+ *  that nothing the user writes into the mapping can make the Stream head read or write outside of
+ *  the slots.  The receive ring is serialized by the QHLIST bit on the read queue just like
+ *  getpmsg(2); the transmit ring by @mr_txbusy.
+ */
+struct strmring {
+	void *mr_base;
+	size_t mr_size;
+	unsigned int mr_slots;
+	unsigned int mr_slotsize;
+	struct strring *mr_rx;
+	struct strring *mr_tx;
+	unsigned char *mr_rxslots;
+	unsigned char *mr_txslots;
+	unsigned int mr_rxhead;
+	unsigned int mr_txtail;
+	unsigned long mr_txbusy;
+};
+
+/**
+ *  strring_free: - free memory-mapped message rings
+ *  @sd: stream head
+ *
+ *  Pages of the area that are still mapped into a process hold a reference of their own and
+ *  remain until the process unmaps them.
+ */
+STATIC __unlikely void
+strring_free(struct stdata *sd)
+{
+	struct strmring *mr;
+
+	if ((mr = xchg(&sd->sd_mring, NULL)) != NULL) {
+		vfree(mr->mr_base);
+		kmem_free(mr, sizeof(*mr));
+	}
+}
+
 /**
  *  strlastclose: - do the last close of a stream
  *  @sd:	the STREAM head to close
@@ -4070,6 +4230,13 @@ strlastclose(struct stdata *sd, int oflag)
 	/* 3rd step: call the close routine of the driver and qdetach the driver */
 	_ctrace(strwaitclose(sd, oflag));
 
+	/* 4th step: release any memory-mapped message rings */
+	strring_free(sd);
+
+	/* 5th step: stop any flow trace (events already recorded remain for I_STRFTALL) */
+	if (test_and_clear_bit(STRFTRACE_BIT, &sd->sd_flag))
+		atomic_dec(&strft_active);
+
 	/* this balances holding the module in stralloc() and stropen() */
 	_ctrace(cdrv_put(sd->sd_cdevsw));
 	sd->sd_cdevsw = NULL;
@@ -4141,6 +4308,16 @@ strpoll_except(struct stdata *sd, unsigned int flag)
 				}
 			}
 			qwunlock(rq, pl);
+#ifdef HAVE_STRMRING
+			{
+				struct strmring *mr;
+
+				/* messages already in the receive ring are readable too */
+				if (unlikely((mr = sd->sd_mring) != NULL)
+				    && mr->mr_rxhead != mr->mr_rx->sr_tail)
+					mask |= POLLIN | POLLRDNORM;
+			}
+#endif
 		} else
 			mask |= POLLERR;
 		if (likely(!(flag & STWRERR))) {
@@ -4324,8 +4501,28 @@ _strpoll(struct file *file, struct poll_table_struct *poll)
 STATIC __unlikely int
 strmmap(struct file *file, struct vm_area_struct *vma)
 {
+	int err = -ENODEV;
+
+#ifdef HAVE_STRMRING
+	struct stdata *sd;
+
+	if ((sd = stri_acquire(file)) != NULL) {
+		if (!(err = straccess_rlock(sd, (FCREAT | FAPPEND)))) {
+			struct strmring *mr;
+
+			err = -ENODEV;
+			if ((mr = sd->sd_mring) != NULL) {
+				err = -EINVAL;
+				if (vma->vm_pgoff == 0 && vma->vm_end - vma->vm_start == mr->mr_size)
+					err = remap_vmalloc_range(vma, mr->mr_base, 0);
+			}
+			srunlock(sd);
+		}
+		sd_put(&sd);
+	}
+#endif				/* HAVE_STRMRING */
 	strsyscall();		/* save context switch */
-	return (-ENODEV);
+	return (err);
 }
 
 #ifndef O_CLONE
@@ -5317,9 +5514,13 @@ strwaitgetq(struct stdata *sd, queue_t *q, const int f_flags, const int flags, c
  *  have not yet read anything (i.e. @xferd is zero) then we will consume the marked message.
  *  In this way we never return zero, which could be confused with an end-of-file.
  *
+ *  strread_common() takes either a user buffer, @buf, or an iterator, @to, (for readv(2) and
+ *  splice(2) through read_iter()) and is inlined into each with the other one constant NULL.
+ *  @f_flags are the file flags, with %FNDELAY added for non-blocking read_iter() requests.
  */
 STATIC streams_inline streams_fastcall __hot_read ssize_t
-strread_fast(struct file *file, char __user *buf, size_t nbytes, loff_t *ppos)
+strread_common(struct file *file, char __user *buf, struct iov_iter *to, size_t nbytes,
+	       loff_t *ppos, const int f_flags)
 {
 	struct stdata *sd = stri_lookup(file);
 	const int sd_rdopt = sd->sd_rdopt;
@@ -5344,7 +5545,7 @@ strread_fast(struct file *file, char __user *buf, size_t nbytes, loff_t *ppos)
 		goto access_error;
 
 	/* First acquire QHLIST bit. */
-	if (unlikely((err = strwaithlist(sd, q, file->f_flags)) != 0)) {
+	if (unlikely((err = strwaithlist(sd, q, f_flags)) != 0)) {
 		srunlock(sd);
 		goto error;
 	}
@@ -5360,7 +5561,7 @@ strread_fast(struct file *file, char __user *buf, size_t nbytes, loff_t *ppos)
 		flags = unlikely(sd_rdopt & (RPROTDAT | RPROTDIS)) ? MSG_ANY : 0;
 
 		do {
-			mp = strwaitgetq(sd, q, file->f_flags, flags, 0, mread);
+			mp = strwaitgetq(sd, q, f_flags, flags, 0, mread);
 
 			if (unlikely(IS_ERR(mp))) {
 				err = PTR_ERR(mp);
@@ -5416,7 +5617,12 @@ strread_fast(struct file *file, char __user *buf, size_t nbytes, loff_t *ppos)
 
 		if (likely(first != NULL)) {
 			/* transfer the message outside the locks */
-			xferd = strmcopyout(&first, buf, nbytes, ((sd_rdopt & RPROTDIS) != 0));
+#ifdef HAVE_STRREAD_ITER
+			if (to != NULL)
+				xferd = strmcopyout_iter(&first, to, nbytes, ((sd_rdopt & RPROTDIS) != 0));
+			else
+#endif
+				xferd = strmcopyout(&first, buf, nbytes, ((sd_rdopt & RPROTDIS) != 0));
 			if (unlikely(xferd < 0))
 				err = xferd;
 			if (first != NULL) {
@@ -5449,6 +5655,12 @@ strread_fast(struct file *file, char __user *buf, size_t nbytes, loff_t *ppos)
 	return (err);
 }
 
+STATIC streams_inline streams_fastcall __hot_read ssize_t
+strread_fast(struct file *file, char __user *buf, size_t nbytes, loff_t *ppos)
+{
+	return strread_common(file, buf, NULL, nbytes, ppos, file->f_flags);
+}
+
 streams_noinline streams_fastcall ssize_t
 strread_slow(struct file *file, char __user *buf, size_t nbytes, loff_t *ppos)
 {
@@ -5531,6 +5743,49 @@ _strread(struct file *file, char __user *buf, size_t len, loff_t *ppos)
 	goto exit;
 }
 
+#ifdef HAVE_STRREAD_ITER
+/**
+ *  _strread_iter: - read_iter file operation for a stream
+ *  @iocb: kernel I/O control block
+ *  @to: iterator describing the destination
+ *
+ *  Services readv(2), and splice(2) from a Stream when splice_read() is performed through
+ *  read_iter() (copy_splice_read() or generic_file_splice_read()).  The read is performed as a
+ *  single read(2) of the total length, so that read modes and message boundaries apply to the
+ *  vector as a whole rather than to each segment.  Splicing copies message data directly into the
+ *  pipe pages without bouncing through user space.
+ *
+ *  The wantio(9) direct read entry point takes a user buffer only and is not used here: vectored
+ *  reads of a Stream with direct I/O fail with [%EINVAL].
+ *
+ *  A non-blocking request (%IOCB_NOWAIT) is treated as a read with %FNDELAY set.
+ */
+STATIC __hot_read ssize_t
+_strread_iter(struct kiocb *iocb, struct iov_iter *to)
+{
+	struct file *file = iocb->ki_filp;
+	int f_flags = file->f_flags;
+	struct stdata *sd;
+	ssize_t err;
+
+#ifdef IOCB_NOWAIT
+	if (iocb->ki_flags & IOCB_NOWAIT)
+		f_flags |= FNDELAY;
+#endif
+	if (likely((sd = stri_acquire(file)) != NULL)) {
+		if (likely(!sd->sd_directio) || likely(!sd->sd_directio->read))
+			err = strread_common(file, NULL, to, iov_iter_count(to), NULL, f_flags);
+		else
+			err = -EINVAL;
+		sd_put(&sd);
+		/* We want to give the driver queues an opportunity to run. */
+		strsyscall_read();	/* save context switch */
+	} else
+		err = -ENOSTR;
+	return (err);
+}
+#endif				/* HAVE_STRREAD_ITER */
+
 /**
  *  strhold: - perform STRHOLD message coallescing  on write
  *  @sd: stream head
@@ -5624,9 +5879,16 @@ strhold(struct stdata *sd, queue_t *q, const int f_flags, const char *buf, ssize
  *  larger value and breaks it down into individual write() calls on its own.  That is not good, as
  *  it will break delimited messages anyway.  So why not just assume that delimited messages doesn't
  *  work with writev() and leave it at that?
+ *
+ *  With write_iter(), writev(2) now arrives here as one write of the total length, so the whole
+ *  vector is delimited once.  strwrite_common() takes either a user buffer, @buf, or an iterator,
+ *  @from, and is inlined into each with the other one constant NULL.  Message coalescing (strhold())
+ *  is only performed for write(2).  @f_flags are the file flags, with %FNDELAY added for
+ *  non-blocking write_iter() requests.
  */
 STATIC streams_inline streams_fastcall __hot_write ssize_t
-strwrite_fast(struct file *file, const char __user *buf, size_t nbytes, loff_t *ppos)
+strwrite_common(struct file *file, const char __user *buf, struct iov_iter *from, size_t nbytes,
+		loff_t *ppos, const int f_flags)
 {
 	struct stdata *sd = stri_lookup(file);
 	ssize_t err, q_maxpsz;
@@ -5642,8 +5904,8 @@ strwrite_fast(struct file *file, const char __user *buf, size_t nbytes, loff_t *
 	q = sd->sd_wq;
 
 	/* check message coallescing once before flow control */
-	if (likely((mblk_t *volatile) q->q_first != NULL))
-		if ((err = strhold(sd, q, file->f_flags, buf, nbytes)) != 0)
+	if (likely(from == NULL) && likely((mblk_t *volatile) q->q_first != NULL))
+		if ((err = strhold(sd, q, f_flags, buf, nbytes)) != 0)
 			goto error;	/* but not always an error */
 
 	{
@@ -5665,7 +5927,7 @@ strwrite_fast(struct file *file, const char __user *buf, size_t nbytes, loff_t *
 			/* possibly wait for flow control */
 			if (unlikely(!bcanputnext(q, 0))) {
 				/* about to block, check nodelay */
-				if (unlikely(file->f_flags & FNDELAY)
+				if (unlikely(f_flags & FNDELAY)
 				    && likely(!(sd_flag & STRNDEL)))
 					goto eagain;
 				if (unlikely((err = __strwaitband(sd, q, 0)) != 0))
@@ -5684,7 +5946,13 @@ strwrite_fast(struct file *file, const char __user *buf, size_t nbytes, loff_t *
 			where = buf + written;
 
 			/* POSIX says always blocks awaiting message blocks */
-			if (unlikely(IS_ERR((b = alloc_data(sd, block, where))))) {
+#ifdef HAVE_STRWRITE_ITER
+			if (from != NULL)
+				b = alloc_data_iter(sd, block, from);
+			else
+#endif
+				b = alloc_data(sd, block, where);
+			if (unlikely(IS_ERR(b))) {
 				err = PTR_ERR(b);
 				break;
 			}
@@ -5718,6 +5986,12 @@ strwrite_fast(struct file *file, const char __user *buf, size_t nbytes, loff_t *
 	return (err);
 }
 
+STATIC streams_inline streams_fastcall __hot_write ssize_t
+strwrite_fast(struct file *file, const char __user *buf, size_t nbytes, loff_t *ppos)
+{
+	return strwrite_common(file, buf, NULL, nbytes, ppos, file->f_flags);
+}
+
 streams_noinline streams_fastcall ssize_t
 strwrite_slow(struct file *file, const char __user *buf, size_t nbytes, loff_t *ppos)
 {
@@ -5816,6 +6090,113 @@ _strwrite(struct file *file, const char __user *buf, size_t len, loff_t *ppos)
 	goto exit;
 }
 
+#ifdef HAVE_STRWRITE_ITER
+/**
+ *  _strwrite_iter: - write_iter file operation for a stream
+ *  @iocb: kernel I/O control block
+ *  @from: iterator describing the source
+ *
+ *  Services writev(2), and splice(2) to a Stream through iter_file_splice_write(), which passes
+ *  the pipe pages as a bvec iterator so that data is copied from the pipe straight into message
+ *  blocks.  As with _strread_iter(), Streams with wantio(9) direct I/O fail with [%EINVAL], and a
+ *  non-blocking request (%IOCB_NOWAIT) is treated as a write with %FNDELAY set.
+ */
+STATIC __hot_write ssize_t
+_strwrite_iter(struct kiocb *iocb, struct iov_iter *from)
+{
+	struct file *file = iocb->ki_filp;
+	int f_flags = file->f_flags;
+	struct stdata *sd;
+	ssize_t err;
+
+#ifdef IOCB_NOWAIT
+	if (iocb->ki_flags & IOCB_NOWAIT)
+		f_flags |= FNDELAY;
+#endif
+	if (likely((sd = stri_acquire(file)) != NULL)) {
+		if (likely(!sd->sd_directio) || likely(!sd->sd_directio->write))
+			err = strwrite_common(file, NULL, from, iov_iter_count(from), NULL, f_flags);
+		else
+			err = -EINVAL;
+		sd_put(&sd);
+		/* We want to give the driver queues an opportunity to run. */
+		strsyscall_write();	/* save context switch */
+	} else
+		err = -ENOSTR;
+	return (err);
+}
+#endif				/* HAVE_STRWRITE_ITER */
+
+#if defined HAVE_STRREAD_ITER \
+    && (defined HAVE_KFUNC_COPY_SPLICE_READ \
+	|| (defined HAVE_KFUNC_IOV_ITER_PIPE && defined HAVE_KFUNC_GENERIC_FILE_SPLICE_READ))
+/**
+ *  _strsplice_read: - splice_read file operation for a stream
+ *  @file: user file pointer
+ *  @ppos: file position
+ *  @pipe: pipe to fill
+ *  @len: maximum number of bytes
+ *  @flags: splice flags
+ *
+ *  The kernel splice helper reads through _strread_iter() with a synchronous I/O control block, so
+ *  %SPLICE_F_NONBLOCK cannot be passed down.  Instead, fail with [%EAGAIN] here when a
+ *  non-blocking splice finds the Stream head read queue empty (and the Stream not hung up).
+ */
+STATIC ssize_t
+_strsplice_read(struct file *file, loff_t *ppos, struct pipe_inode_info *pipe, size_t len,
+		unsigned int flags)
+{
+	if (unlikely(flags & SPLICE_F_NONBLOCK)) {
+		struct stdata *sd;
+		bool empty;
+
+		if (unlikely((sd = stri_acquire(file)) == NULL))
+			return (-ENOSTR);
+		empty = ((mblk_t *volatile) sd->sd_rq->q_first == NULL
+			 && !test_bit(STRHUP_BIT, &sd->sd_flag));
+		sd_put(&sd);
+		if (empty)
+			return (-EAGAIN);
+	}
+#if defined HAVE_KFUNC_COPY_SPLICE_READ
+	return copy_splice_read(file, ppos, pipe, len, flags);
+#else
+	return generic_file_splice_read(file, ppos, pipe, len, flags);	/* uses read_iter() */
+#endif
+}
+#endif
+
+#if defined HAVE_STRWRITE_ITER && defined HAVE_KFUNC_ITER_FILE_SPLICE_WRITE
+/**
+ *  _strsplice_write: - splice_write file operation for a stream
+ *  @pipe: pipe to drain
+ *  @file: user file pointer
+ *  @ppos: file position
+ *  @len: maximum number of bytes
+ *  @flags: splice flags
+ *
+ *  As _strsplice_read(), a non-blocking splice fails with [%EAGAIN] when the Stream is flow
+ *  controlled, rather than blocking in _strwrite_iter().
+ */
+STATIC ssize_t
+_strsplice_write(struct pipe_inode_info *pipe, struct file *file, loff_t *ppos, size_t len,
+		 unsigned int flags)
+{
+	if (unlikely(flags & SPLICE_F_NONBLOCK)) {
+		struct stdata *sd;
+		bool blocked;
+
+		if (unlikely((sd = stri_acquire(file)) == NULL))
+			return (-ENOSTR);
+		blocked = (!test_bit(STRNDEL_BIT, &sd->sd_flag) && !bcanputnext(sd->sd_wq, 0));
+		sd_put(&sd);
+		if (blocked)
+			return (-EAGAIN);
+	}
+	return iter_file_splice_write(pipe, file, ppos, len, flags);
+}
+#endif
+
 /**
  *  __strfreepage: - free routine function to free a esballoc'ed page
  *  @data: &struct page pointer passed as a caddr_t argument
@@ -6224,14 +6605,19 @@ strcopyin_gstrbuf(struct file *file, struct strbuf __user *from, struct strbuf *
  *  0 in the len fields of @ctlp and @datp.
  *
  *  GLIBC2 puts NULL in bandp for getmsg().
+ *
+ *  When @more is set, this is a subsequent message of an %I_GETMSGV: the call never blocks and
+ *  returns %EAGAIN instead of the end-of-file indications, so that the vector stops at the first
+ *  message that is not already available.
  */
 STATIC streams_inline streams_fastcall __hot_get int
-strgetpmsg_fast(struct file *file, struct strbuf __user *ctlp, struct strbuf __user *datp, int __user *bandp, int __user *flagsp)
+strgetpmsg_common(struct file *file, struct strbuf __user *ctlp, struct strbuf __user *datp, int __user *bandp, int __user *flagsp, const bool more)
 {
 	struct stdata *sd = stri_lookup(file);
 	struct strbuf ctl, dat;
 	int flags, band = 0;
 	int err, retval = 0;
+	int f_flags = more ? (file->f_flags | FNDELAY) : file->f_flags;
 	queue_t *q = sd->sd_rq;
 	mblk_t *mp;
 
@@ -6286,11 +6672,11 @@ strgetpmsg_fast(struct file *file, struct strbuf __user *ctlp, struct strbuf __u
 	if (likely((err = straccess_rlock(sd, (FREAD | FNDELAY))) == 0)) {
 
 		/* First acquire QHLIST bit. */
-		if (likely((err = strwaithlist(sd, q, file->f_flags)) == 0)) {
+		if (likely((err = strwaithlist(sd, q, f_flags)) == 0)) {
 
 			ssize_t mread = datp ? ((datp->maxlen > 0) ? datp->maxlen : -1) : -1;
 
-			mp = strwaitgetq(sd, q, file->f_flags, flags, band, mread);
+			mp = strwaitgetq(sd, q, f_flags, flags, band, mread);
 
 			if (likely(!IS_ERR(mp))) {
 				/* got something - set return flags */
@@ -6400,6 +6786,11 @@ strgetpmsg_fast(struct file *file, struct strbuf __user *ctlp, struct strbuf __u
 		/* fall through */
 	case -ESTRPIPE:	/* STREAM (PIPE, FIFO, TTY) hung up */
 
+		if (unlikely(more)) {
+			err = -EAGAIN;
+			goto error;
+		}
+
 		/* POSIX says: If a hangup occurs on the STREAM from which message are retrieved,
 		   getmsg() and getpmsg() shall continue to operate normally, as described above,
 		   until the STREAM head read queue is empty.  Thereafter, they shall return 0 in
@@ -6424,6 +6815,12 @@ strgetpmsg_fast(struct file *file, struct strbuf __user *ctlp, struct strbuf __u
 	goto error;
 }
 
+STATIC streams_inline streams_fastcall __hot_get int
+strgetpmsg_fast(struct file *file, struct strbuf __user *ctlp, struct strbuf __user *datp, int __user *bandp, int __user *flagsp)
+{
+	return strgetpmsg_common(file, ctlp, datp, bandp, flagsp, false);
+}
+
 streams_noinline streams_fastcall int
 strgetpmsg_slow(struct file *file, struct strbuf __user *ctlp, struct strbuf __user *datp, int __user *bandp, int __user *flagsp)
 {
@@ -6793,6 +7190,441 @@ file_fiosetown32(struct file *file, struct stdata *sd, unsigned long arg)
  *  -------------------------------------------------------------------------
  */
 
+#ifdef HAVE_STRMRING
+/**
+ *  strring_rx: - move messages from the Stream head read queue to the receive ring
+ *  @sd: stream head
+ *  @mr: message rings
+ *
+ *  LOCKING: Called with the Stream head read locked.  The QHLIST bit serializes this function
+ *  against getpmsg(2), read(2) and itself so that messages are placed in the ring in queue order.
+ *
+ *  Messages that do not fit into a slot are left at the head of the read queue, where they stop
+ *  the ring and can be retrieved with getpmsg(2).
+ */
+STATIC streams_fastcall int
+strring_rx(struct stdata *sd, struct strmring *mr)
+{
+	struct strring *r = mr->mr_rx;
+	queue_t *q = sd->sd_rq;
+	unsigned int head = mr->mr_rxhead;
+	unsigned int tail = r->sr_tail;
+	int count = 0;
+
+	/* a bogus tail from the user just leaves the ring full */
+	if (unlikely(head - tail >= mr->mr_slots))
+		return (0);
+	if (strwaithlist(sd, q, FNDELAY))
+		return (0);
+	/* slots freed by the user must be read out before we overwrite them */
+	smp_mb();
+	do {
+		struct strslot *ss;
+		unsigned char *ptr;
+		int clen = -1, dlen = -1;
+		mblk_t *mp, *b;
+
+		mp = strgetq(sd, q, MSG_ANY, 0);
+		if (mp == NULL || IS_ERR(mp))
+			break;
+		for (b = mp; b; b = b->b_cont) {
+			ssize_t blen = b->b_wptr > b->b_rptr ? b->b_wptr - b->b_rptr : 0;
+
+			if (b->b_datap->db_type == M_DATA)
+				dlen = (dlen < 0 ? 0 : dlen) + blen;
+			else
+				clen = (clen < 0 ? 0 : clen) + blen;
+		}
+		if (sizeof(*ss) + (clen > 0 ? clen : 0) + (dlen > 0 ? dlen : 0) > mr->mr_slotsize) {
+			strputbq(sd, q, mp);
+			break;
+		}
+		ss = (struct strslot *) (mr->mr_rxslots + (head & (mr->mr_slots - 1)) * mr->mr_slotsize);
+		ptr = (unsigned char *) (ss + 1);
+		for (b = mp; b; b = b->b_cont)
+			if (b->b_datap->db_type != M_DATA && b->b_wptr > b->b_rptr) {
+				bcopy(b->b_rptr, ptr, b->b_wptr - b->b_rptr);
+				ptr += b->b_wptr - b->b_rptr;
+			}
+		for (b = mp; b; b = b->b_cont)
+			if (b->b_datap->db_type == M_DATA && b->b_wptr > b->b_rptr) {
+				bcopy(b->b_rptr, ptr, b->b_wptr - b->b_rptr);
+				ptr += b->b_wptr - b->b_rptr;
+			}
+		ss->ss_flags = (mp->b_datap->db_type >= QPCTL) ? MSG_HIPRI : MSG_BAND;
+		ss->ss_band = mp->b_band;
+		ss->ss_ctllen = clen;
+		ss->ss_datlen = dlen;
+		freemsg(mp);
+		head++;
+		count++;
+	} while (head - tail < mr->mr_slots);
+	if (count) {
+		/* slot contents must be visible before the new head */
+		smp_wmb();
+		mr->mr_rxhead = head;
+		r->sr_head = head;
+	}
+	strwakehlist(sd, q);
+	return (count);
+}
+
+/**
+ *  strring_tx: - build messages from the transmit ring
+ *  @sd: stream head
+ *  @mr: message rings
+ *  @mpp: where to return the chain of messages (linked by b_next) to be put
+ *
+ *  LOCKING: Called with the Stream head read locked.  The caller puts the returned messages with
+ *  strput() after releasing the lock, in the same manner as putpmsg(2).
+ *
+ *  Draining stops at the first normal or banded message that would be flow controlled, or when
+ *  message blocks cannot be allocated, leaving the slot for the next synchronization.  Slots that
+ *  describe an invalid message are consumed and discarded and %EINVAL is returned if nothing else
+ *  was sent.
+ */
+STATIC streams_fastcall int
+strring_tx(struct stdata *sd, struct strmring *mr, mblk_t **mpp)
+{
+	struct strring *r = mr->mr_tx;
+	unsigned int tail = mr->mr_txtail;
+	unsigned int head = r->sr_head;
+	int count = 0, err = 0;
+
+	if (unlikely(head - tail > mr->mr_slots))
+		return (-EINVAL);
+	/* slot contents must be read after the head */
+	smp_rmb();
+	for (; tail != head; tail++) {
+		struct strslot ss, *sp;
+		struct strbuf ctl, dat;
+		mblk_t *mp = NULL, *dp = NULL;
+
+		sp = (struct strslot *) (mr->mr_txslots + (tail & (mr->mr_slots - 1)) * mr->mr_slotsize);
+		ss = *sp;	/* the user can change it under us */
+		if (ss.ss_ctllen < -1 || ss.ss_datlen < -1)
+			goto einval;
+		if (sizeof(ss) + (ss.ss_ctllen > 0 ? ss.ss_ctllen : 0) +
+		    (ss.ss_datlen > 0 ? ss.ss_datlen : 0) > mr->mr_slotsize)
+			goto einval;
+		if (ss.ss_flags == MSG_HIPRI) {
+			if (ss.ss_ctllen < 0 || ss.ss_band != 0)
+				goto einval;
+		} else if (ss.ss_flags == MSG_BAND) {
+			if (ss.ss_band < 0 || ss.ss_band > 255)
+				goto einval;
+			/* same as putpmsg(2): nothing to send */
+			if (ss.ss_ctllen < 0 && (ss.ss_datlen < 0 || (ss.ss_datlen == 0 &&
+								      !(sd->sd_wropt & SNDZERO))))
+				continue;
+			if (!bcanputnext(sd->sd_wq, ss.ss_band))
+				break;
+		} else
+			goto einval;
+		ctl.maxlen = dat.maxlen = -1;
+		ctl.len = ss.ss_ctllen;
+		dat.len = ss.ss_datlen;
+		ctl.buf = (char *) (sp + 1);
+		dat.buf = ctl.buf + (ss.ss_ctllen > 0 ? ss.ss_ctllen : 0);
+		/* no partial writes from a slot */
+		if (strpsizecheck(sd, &ctl, &dat, 0) != dat.len)
+			goto einval;
+		if (dat.len >= 0) {
+			if (!(dp = allocb_buf(sd, sd->sd_wroff + dat.len + sd->sd_wrpad, BPRI_MED)))
+				break;
+			mblk_reserve(dp, sd->sd_wroff);
+			bcopy(dat.buf, dp->b_wptr, dat.len);
+			dp->b_wptr += dat.len;
+		}
+		if (ctl.len >= 0) {
+			if (!(mp = allocb(ctl.len, BPRI_MED))) {
+				if (dp)
+					freeb(dp);
+				break;
+			}
+			mp->b_datap->db_type = (ss.ss_flags == MSG_HIPRI) ? M_PCPROTO : M_PROTO;
+			bcopy(ctl.buf, mp->b_wptr, ctl.len);
+			mp->b_wptr += ctl.len;
+			mp->b_cont = dp;
+		} else
+			mp = dp;
+		mp->b_band = ss.ss_band;
+		*mpp = mp;
+		mpp = &mp->b_next;
+		count++;
+		continue;
+	      einval:
+		err = -EINVAL;
+	}
+	if (tail != mr->mr_txtail) {
+		/* slot contents must be copied out before the user may reuse them */
+		smp_mb();
+		mr->mr_txtail = tail;
+		r->sr_tail = tail;
+	}
+	if (count == 0 && err == 0 && tail != head)
+		err = -EAGAIN;
+	return (count ? count : err);
+}
+
+/**
+ *  strring_sync: - exchange messages between the Stream head and the memory-mapped rings
+ *  @file: user file pointer
+ *  @sd: stream head
+ *
+ *  Drains the transmit ring downstream and then fills the receive ring from the Stream head read
+ *  queue, so that a process using the rings moves any number of messages in each direction with a
+ *  single system call and no copies to or from user space.  This is only called for %I_RINGSYNC:
+ *  poll(2) merely reports the receive ring (or the read queue) as readable and has no side effects.
+ *  Returns the number of messages moved or a negative error number.
+ */
+STATIC int
+strring_sync(const struct file *file, struct stdata *sd)
+{
+	struct strmring *mr;
+	int rx = 0, tx = 0;
+
+	if (file->f_mode & FWRITE) {
+		mblk_t *mp = NULL, *b;
+
+		if ((tx = straccess_rlock(sd, (FWRITE | FNDELAY))) == 0) {
+			if ((mr = sd->sd_mring) != NULL && !test_and_set_bit(0, &mr->mr_txbusy)) {
+				tx = strring_tx(sd, mr, &mp);
+				clear_bit(0, &mr->mr_txbusy);
+			}
+			srunlock(sd);
+		}
+		while ((b = mp)) {
+			mp = b->b_next;
+			b->b_next = NULL;
+			/* use put instead of putnext because of STRHOLD feature */
+			strput(sd, b);
+		}
+	}
+	if (file->f_mode & FREAD) {
+		if ((rx = straccess_rlock(sd, (FREAD | FNDELAY))) == 0) {
+			if ((mr = sd->sd_mring) != NULL)
+				rx = strring_rx(sd, mr);
+			srunlock(sd);
+		}
+	}
+	if (tx < 0 && rx <= 0)
+		return (tx);
+	if (rx < 0 && tx == 0)
+		return (rx);
+	return ((tx > 0 ? tx : 0) + (rx > 0 ? rx : 0));
+}
+#endif				/* HAVE_STRMRING */
+
+/**
+ *  str_i_ringsetup: - perform streamio(7) %I_RINGSETUP ioctl
+ *  @file: user file pointer
+ *  @sd: stream head
+ *  @arg: ioctl argument, a pointer to a struct strringreq
+ *
+ *  Allocates a receive ring and a transmit ring of @arg->rr_slots slots of @arg->rr_slotsize bytes
+ *  each.  The rings are then mapped into the process with mmap(2) at offset zero for the returned
+ *  length.  The first page of the mapping holds the receive and then the transmit struct strring.
+ *  Each ring (@arg->rr_slots times @arg->rr_slotsize) is limited to %STRRING_MAXSIZE bytes so that
+ *  the mapping length neither overflows nor exceeds the int return value.  Rings cannot be resized
+ *  or removed once set up; they are freed on the last close of the Stream.
+ *
+ *  Messages continue to be available to getpmsg(2) and putpmsg(2) but there is no ordering between
+ *  messages passed through the rings and those passed with system calls.
+ */
+streams_noinline streams_fastcall __unlikely int
+str_i_ringsetup(const struct file *file, struct stdata *sd, unsigned long arg)
+{
+#ifdef HAVE_STRMRING
+	struct strringreq rr;
+	struct strmring *mr;
+	size_t ringsize;
+	int err;
+
+	if ((err = strcopyin((void __user *) arg, &rr, sizeof(rr))))
+		return (err);
+	if (rr.rr_slots < 1 || rr.rr_slots > 65536 || (rr.rr_slots & (rr.rr_slots - 1)))
+		return (-EINVAL);
+	if (rr.rr_slotsize <= sizeof(struct strslot) || rr.rr_slotsize > 65536
+	    || (rr.rr_slotsize & (sizeof(struct strslot) - 1)))
+		return (-EINVAL);
+	if (rr.rr_slotsize > STRRING_MAXSIZE / rr.rr_slots)
+		return (-EINVAL);
+	ringsize = (size_t) rr.rr_slots * rr.rr_slotsize;
+	if (sd->sd_mring != NULL)
+		return (-EBUSY);
+	if (!(mr = kmem_zalloc(sizeof(*mr), KM_SLEEP)))
+		return (-ENOMEM);
+	mr->mr_size = PAGE_ALIGN(PAGE_SIZE + 2 * ringsize);
+	if (!(mr->mr_base = vmalloc_user(mr->mr_size))) {
+		kmem_free(mr, sizeof(*mr));
+		return (-ENOMEM);
+	}
+	mr->mr_slots = rr.rr_slots;
+	mr->mr_slotsize = rr.rr_slotsize;
+	mr->mr_rx = (struct strring *) mr->mr_base;
+	mr->mr_tx = mr->mr_rx + 1;
+	mr->mr_rxslots = (unsigned char *) mr->mr_base + PAGE_SIZE;
+	mr->mr_txslots = mr->mr_rxslots + ringsize;
+	mr->mr_rx->sr_slots = mr->mr_tx->sr_slots = mr->mr_slots;
+	mr->mr_rx->sr_slotsize = mr->mr_tx->sr_slotsize = mr->mr_slotsize;
+	mr->mr_rx->sr_offset = PAGE_SIZE;
+	mr->mr_tx->sr_offset = PAGE_SIZE + ringsize;
+	if (!(err = straccess_rlock(sd, (FREAD | FWRITE | FNDELAY)))) {
+		if (cmpxchg(&sd->sd_mring, NULL, mr) != NULL)
+			err = -EBUSY;
+		srunlock(sd);
+	}
+	if (err) {
+		vfree(mr->mr_base);
+		kmem_free(mr, sizeof(*mr));
+		return (err);
+	}
+	return (mr->mr_size);
+#else				/* HAVE_STRMRING */
+	return (-EOPNOTSUPP);
+#endif				/* HAVE_STRMRING */
+}
+
+/**
+ *  str_i_ringsync: - perform streamio(7) %I_RINGSYNC ioctl
+ *  @file: user file pointer
+ *  @sd: stream head
+ *  @arg: ioctl argument (unused)
+ *
+ *  Exchanges messages with the memory-mapped rings without waiting.  Returns the number of messages
+ *  moved.
+ */
+streams_noinline streams_fastcall int
+str_i_ringsync(const struct file *file, struct stdata *sd, unsigned long arg)
+{
+#ifdef HAVE_STRMRING
+	if (sd->sd_mring == NULL)
+		return (-EINVAL);
+	return strring_sync(file, sd);
+#else				/* HAVE_STRMRING */
+	return (-EOPNOTSUPP);
+#endif				/* HAVE_STRMRING */
+}
+
+/**
+ *  str_i_strft: - perform streamio(7) %I_STRFT ioctl
+ *  @file: user file pointer
+ *  @sd: stream head
+ *  @arg: ioctl argument (unused)
+ *
+ *  Returns true (1) when flow trace is on for the Stream and false (0) otherwise.
+ */
+streams_noinline streams_fastcall __unlikely int
+str_i_strft(const struct file *file, struct stdata *sd, unsigned long arg)
+{
+	return (test_bit(STRFTRACE_BIT, &sd->sd_flag) ? 1 : 0);
+}
+
+/**
+ *  str_i_strfton: - perform streamio(7) %I_STRFTON ioctl
+ *  @file: user file pointer
+ *  @sd: stream head
+ *  @arg: ioctl argument (unused)
+ *
+ *  Turns flow trace on for the Stream.  Messages are traced from their next hop on the Stream.
+ */
+streams_noinline streams_fastcall __unlikely int
+str_i_strfton(const struct file *file, struct stdata *sd, unsigned long arg)
+{
+	int err;
+
+	if (!(err = straccess_rlock(sd, FAPPEND))) {
+		if (!test_and_set_bit(STRFTRACE_BIT, &sd->sd_flag))
+			atomic_inc(&strft_active);
+		srunlock(sd);
+	}
+	return (err);
+}
+
+/**
+ *  str_i_strftoff: - perform streamio(7) %I_STRFTOFF ioctl
+ *  @file: user file pointer
+ *  @sd: stream head
+ *  @arg: ioctl argument (unused)
+ *
+ *  Turns flow trace off for the Stream.  Events already recorded can still be fetched.
+ */
+streams_noinline streams_fastcall __unlikely int
+str_i_strftoff(const struct file *file, struct stdata *sd, unsigned long arg)
+{
+	int err;
+
+	if (!(err = straccess_rlock(sd, FAPPEND))) {
+		if (test_and_clear_bit(STRFTRACE_BIT, &sd->sd_flag))
+			atomic_dec(&strft_active);
+		srunlock(sd);
+	}
+	return (err);
+}
+
+/**
+ *  str_i_strftget: - perform streamio(7) %I_STRFTSTR and %I_STRFTALL ioctls
+ *  @file: user file pointer
+ *  @sd: stream head
+ *  @arg: ioctl argument, pointer to struct strftbuf
+ *  @all: true for %I_STRFTALL
+ *
+ *  Copies out (and consumes) up to fb_count of the recorded events for this Stream, or for all
+ *  Streams, oldest first.  Because %I_STRFTALL returns (and consumes) the events of every Stream,
+ *  it is restricted to privileged users.  struct strftbuf contains no pointers and has the same
+ *  layout for 32-bit callers.
+ */
+streams_noinline streams_fastcall __unlikely int
+str_i_strftget(const struct file *file, struct stdata *sd, unsigned long arg, const int all)
+{
+	struct strftbuf __user *fb = (typeof(fb)) arg;
+	struct strftevnt *buf = NULL;
+	int max, count, lost, err;
+
+	if (all && drv_priv(current_creds) != 0)
+		return (-EPERM);
+	if ((err = strcopyin(&fb->fb_count, &max, sizeof(max))))
+		return (err);
+	if (max < 0)
+		return (-EINVAL);
+	if (max > 1024)
+		max = 1024;
+	if (max > 0 && !(buf = kmem_alloc(max * sizeof(*buf), KM_SLEEP)))
+		return (-ENOSR);
+	count = strft_fetch(sd->sd_dev, all, buf, max, &lost);
+	if (!(err = strcopyout(&count, &fb->fb_count, sizeof(count))))
+		if (!(err = strcopyout(&lost, &fb->fb_lost, sizeof(lost))))
+			if (count > 0)
+				err = strcopyout(buf, fb->fb_evnt, count * sizeof(*buf));
+	if (buf != NULL)
+		kmem_free(buf, max * sizeof(*buf));
+	return (err);
+}
+
+#ifdef WITH_32BIT_CONVERSION
+streams_noinline streams_fastcall __unlikely int
+str_i_strftget32(const struct file *file, struct stdata *sd, unsigned long arg, const int all)
+{
+	return str_i_strftget(file, sd, (unsigned long) compat_ptr(arg), all);
+}
+#endif				/* WITH_32BIT_CONVERSION */
+
+/**
+ *  str_i_strftzero: - perform streamio(7) %I_STRFTZERO ioctl
+ *  @file: user file pointer
+ *  @sd: stream head
+ *  @arg: ioctl argument (unused)
+ *
+ *  Discards the recorded events for the Stream.
+ */
+streams_noinline streams_fastcall __unlikely int
+str_i_strftzero(const struct file *file, struct stdata *sd, unsigned long arg)
+{
+	strft_zero(sd->sd_dev);
+	return (0);
+}
+
 /**
  *  str_i_atmark: - perform streamio(7) %I_ATMARK ioctl
  *  @file: user file pointer
@@ -9298,6 +10130,148 @@ str_i_putpmsg32(struct file *file, struct stdata *sd, unsigned long arg)
 }
 #endif				/* WITH_32BIT_CONVERSION */
 
+/**
+ *  str_i_getmsgv: - perform getpmsg(2) of several messages as streamio(7) ioctl
+ *  @file: file pointer for the stream
+ *  @sd: stream head
+ *  @arg: ioctl argument, a pointer to the &struct strmsgv structure
+ *
+ *  Only the first message can block.  Retrieval stops at the first subsequent message that is not
+ *  immediately available, or that fails.  The result of each message attempted is returned in its
+ *  mm_status member.  Returns the number of messages retrieved, or the error for the first
+ *  message.
+ */
+streams_noinline streams_fastcall __hot_get int
+str_i_getmsgv(struct file *file, struct stdata *sd, unsigned long arg)
+{
+	struct strmsgv sv;
+	struct strmmsg __user *mm;
+	int err, i;
+
+	if (unlikely((err = strcopyin((struct strmsgv __user *) arg, &sv, sizeof(sv))) != 0))
+		return (err);
+	if (unlikely(sv.sv_vlen <= 0 || sv.sv_vlen > UIO_MAXIOV))
+		return (-EINVAL);
+	for (mm = sv.sv_msgv, i = 0; i < sv.sv_vlen; mm++, i++) {
+		struct strpmsg __user *sg = &mm->mm_msg;
+
+		if (likely(i == 0))
+			err = _strgetpmsg(file, &sg->ctlbuf, &sg->databuf, &sg->band, &sg->flags);
+		else if (likely(!sd->sd_directio) || likely(!sd->sd_directio->getpmsg))
+			err = strgetpmsg_common(file, &sg->ctlbuf, &sg->databuf, &sg->band, &sg->flags,
+						true);
+		else
+			break;
+		if (unlikely(put_user(err, &mm->mm_status)))
+			err = -EFAULT;
+		if (unlikely(err < 0))
+			break;
+	}
+	return (i ? i : err);
+}
+
+#ifdef WITH_32BIT_CONVERSION
+streams_noinline streams_fastcall __hot_get int
+str_i_getmsgv32(struct file *file, struct stdata *sd, unsigned long arg)
+{
+	struct strmsgv32 sv32;
+	struct strmmsg32 __user *mm32;
+	int err, i;
+
+	if (unlikely((err = strcopyin(compat_ptr(arg), &sv32, sizeof(sv32))) != 0))
+		return (err);
+	if (unlikely(sv32.sv_vlen <= 0 || sv32.sv_vlen > UIO_MAXIOV))
+		return (-EINVAL);
+	for (mm32 = compat_ptr(sv32.sv_msgv), i = 0; i < sv32.sv_vlen; mm32++, i++) {
+		struct strbuf __user *ctlp = (struct strbuf __user *) &mm32->mm_msg.ctlbuf;
+		struct strbuf __user *datap = (struct strbuf __user *) &mm32->mm_msg.databuf;
+		int __user *bandp = (int __user *) &mm32->mm_msg.band;
+		int __user *flagsp = (int __user *) &mm32->mm_msg.flags;
+
+		if (likely(i == 0))
+			err = _strgetpmsg(file, ctlp, datap, bandp, flagsp);
+		else if (likely(!sd->sd_directio) || likely(!sd->sd_directio->getpmsg))
+			err = strgetpmsg_common(file, ctlp, datap, bandp, flagsp, true);
+		else
+			break;
+		if (unlikely(put_user(err, &mm32->mm_status)))
+			err = -EFAULT;
+		if (unlikely(err < 0))
+			break;
+	}
+	return (i ? i : err);
+}
+#endif				/* WITH_32BIT_CONVERSION */
+
+/**
+ *  str_i_putmsgv: - perform putpmsg(2) of several messages as streamio(7) ioctl
+ *  @file: file pointer for the stream
+ *  @sd: stream head
+ *  @arg: ioctl argument, a pointer to the &struct strmsgv structure
+ *
+ *  Each message is sent as by putpmsg(2), blocking according to the file flags.  Sending stops at
+ *  the first message that fails.  The result of each message attempted is returned in its
+ *  mm_status member.  Returns the number of messages sent, or the error for the first message.
+ */
+streams_noinline streams_fastcall __hot_put int
+str_i_putmsgv(struct file *file, struct stdata *sd, unsigned long arg)
+{
+	struct strmsgv sv;
+	struct strmmsg __user *mm;
+	int err, i;
+
+	if (unlikely((err = strcopyin((struct strmsgv __user *) arg, &sv, sizeof(sv))) != 0))
+		return (err);
+	if (unlikely(sv.sv_vlen <= 0 || sv.sv_vlen > UIO_MAXIOV))
+		return (-EINVAL);
+	for (mm = sv.sv_msgv, i = 0; i < sv.sv_vlen; mm++, i++) {
+		struct strpmsg __user *sp = &mm->mm_msg;
+		int band, flags;
+
+		if (unlikely((err = strcopyin(&sp->band, &band, sizeof(sp->band))) != 0))
+			break;
+		if (unlikely((err = strcopyin(&sp->flags, &flags, sizeof(sp->flags))) != 0))
+			break;
+		err = _strputpmsg(file, &sp->ctlbuf, &sp->databuf, band, flags);
+		if (unlikely(put_user(err, &mm->mm_status)))
+			err = -EFAULT;
+		if (unlikely(err < 0))
+			break;
+	}
+	return (i ? i : err);
+}
+
+#ifdef WITH_32BIT_CONVERSION
+streams_noinline streams_fastcall __hot_put int
+str_i_putmsgv32(struct file *file, struct stdata *sd, unsigned long arg)
+{
+	struct strmsgv32 sv32;
+	struct strmmsg32 __user *mm32;
+	int err, i;
+
+	if (unlikely((err = strcopyin(compat_ptr(arg), &sv32, sizeof(sv32))) != 0))
+		return (err);
+	if (unlikely(sv32.sv_vlen <= 0 || sv32.sv_vlen > UIO_MAXIOV))
+		return (-EINVAL);
+	for (mm32 = compat_ptr(sv32.sv_msgv), i = 0; i < sv32.sv_vlen; mm32++, i++) {
+		struct strbuf __user *ctlp = (struct strbuf __user *) &mm32->mm_msg.ctlbuf;
+		struct strbuf __user *datap = (struct strbuf __user *) &mm32->mm_msg.databuf;
+		int32_t band, flags;
+
+		if (unlikely((err = strcopyin(&mm32->mm_msg.band, &band, sizeof(band))) != 0))
+			break;
+		if (unlikely((err = strcopyin(&mm32->mm_msg.flags, &flags, sizeof(flags))) != 0))
+			break;
+		err = _strputpmsg(file, ctlp, datap, band, flags);
+		if (unlikely(put_user(err, &mm32->mm_status)))
+			err = -EFAULT;
+		if (unlikely(err < 0))
+			break;
+	}
+	return (i ? i : err);
+}
+#endif				/* WITH_32BIT_CONVERSION */
+
 /**
  *  str_i_fattach: - perform fattach(2) system call emulation as streamio(7) ioctl
  *  @file: file pointer for the stream
@@ -9672,6 +10646,36 @@ strioctl_compat(struct file *file, unsigned int cmd, unsigned long arg)
 		case _IOC_NR(I_GET_LOWAT):
 			_printd(("%s: got I_GET_LOWAT\n", __FUNCTION__));
 			return str_i_get_lowat32(file, sd, arg);	/* not compatible */
+		case _IOC_NR(I_RINGSETUP):
+			_printd(("%s: got I_RINGSETUP\n", __FUNCTION__));
+			return str_i_ringsetup(file, sd, arg);	/* compatible */
+		case _IOC_NR(I_RINGSYNC):
+			_printd(("%s: got I_RINGSYNC\n", __FUNCTION__));
+			return str_i_ringsync(file, sd, arg);	/* compatible */
+		case _IOC_NR(I_GETMSGV):
+			_printd(("%s: got I_GETMSGV\n", __FUNCTION__));
+			return str_i_getmsgv32(file, sd, arg);	/* not compatible */
+		case _IOC_NR(I_PUTMSGV):
+			_printd(("%s: got I_PUTMSGV\n", __FUNCTION__));
+			return str_i_putmsgv32(file, sd, arg);	/* not compatible */
+		case _IOC_NR(I_STRFT):
+			_printd(("%s: got I_STRFT\n", __FUNCTION__));
+			return str_i_strft(file, sd, arg);	/* compatible */
+		case _IOC_NR(I_STRFTON):
+			_printd(("%s: got I_STRFTON\n", __FUNCTION__));
+			return str_i_strfton(file, sd, arg);	/* compatible */
+		case _IOC_NR(I_STRFTOFF):
+			_printd(("%s: got I_STRFTOFF\n", __FUNCTION__));
+			return str_i_strftoff(file, sd, arg);	/* compatible */
+		case _IOC_NR(I_STRFTSTR):
+			_printd(("%s: got I_STRFTSTR\n", __FUNCTION__));
+			return str_i_strftget32(file, sd, arg, 0);	/* not compatible */
+		case _IOC_NR(I_STRFTALL):
+			_printd(("%s: got I_STRFTALL\n", __FUNCTION__));
+			return str_i_strftget32(file, sd, arg, 1);	/* not compatible */
+		case _IOC_NR(I_STRFTZERO):
+			_printd(("%s: got I_STRFTZERO\n", __FUNCTION__));
+			return str_i_strftzero(file, sd, arg);	/* compatible */
 #if (_IOC_TYPE(I_STR) != _IOC_TYPE(TCSBRK))
 		}
 		break;
@@ -10169,6 +11173,36 @@ strioctl_slow(struct file *file, unsigned int cmd, unsigned long arg)
 		case _IOC_NR(I_GET_LOWAT):
 			_printd(("%s: got I_GET_LOWAT\n", __FUNCTION__));
 			return str_i_get_lowat(file, sd, arg);
+		case _IOC_NR(I_RINGSETUP):
+			_printd(("%s: got I_RINGSETUP\n", __FUNCTION__));
+			return str_i_ringsetup(file, sd, arg);
+		case _IOC_NR(I_RINGSYNC):
+			_printd(("%s: got I_RINGSYNC\n", __FUNCTION__));
+			return str_i_ringsync(file, sd, arg);
+		case _IOC_NR(I_GETMSGV):
+			_printd(("%s: got I_GETMSGV\n", __FUNCTION__));
+			return str_i_getmsgv(file, sd, arg);
+		case _IOC_NR(I_PUTMSGV):
+			_printd(("%s: got I_PUTMSGV\n", __FUNCTION__));
+			return str_i_putmsgv(file, sd, arg);
+		case _IOC_NR(I_STRFT):
+			_printd(("%s: got I_STRFT\n", __FUNCTION__));
+			return str_i_strft(file, sd, arg);
+		case _IOC_NR(I_STRFTON):
+			_printd(("%s: got I_STRFTON\n", __FUNCTION__));
+			return str_i_strfton(file, sd, arg);
+		case _IOC_NR(I_STRFTOFF):
+			_printd(("%s: got I_STRFTOFF\n", __FUNCTION__));
+			return str_i_strftoff(file, sd, arg);
+		case _IOC_NR(I_STRFTSTR):
+			_printd(("%s: got I_STRFTSTR\n", __FUNCTION__));
+			return str_i_strftget(file, sd, arg, 0);
+		case _IOC_NR(I_STRFTALL):
+			_printd(("%s: got I_STRFTALL\n", __FUNCTION__));
+			return str_i_strftget(file, sd, arg, 1);
+		case _IOC_NR(I_STRFTZERO):
+			_printd(("%s: got I_STRFTZERO\n", __FUNCTION__));
+			return str_i_strftzero(file, sd, arg);
 #if (_IOC_TYPE(I_STR) != _IOC_TYPE(TCSBRK))
 		}
 		break;
@@ -10926,6 +11960,19 @@ struct file_operations strm_f_ops ____cacheline_aligned = {
 	.release = strclose,
 	.fasync = strfasync,
 	.sendpage = _strsendpage,
+#ifdef HAVE_STRREAD_ITER
+	.read_iter = _strread_iter,
+#if defined HAVE_KFUNC_COPY_SPLICE_READ \
+    || (defined HAVE_KFUNC_IOV_ITER_PIPE && defined HAVE_KFUNC_GENERIC_FILE_SPLICE_READ)
+	.splice_read = _strsplice_read,
+#endif
+#endif
+#if defined HAVE_STRWRITE_ITER
+	.write_iter = _strwrite_iter,
+#if defined HAVE_KFUNC_ITER_FILE_SPLICE_WRITE
+	.splice_write = _strsplice_write,
+#endif
+#endif
 #if defined HAVE_PUTPMSG_GETPMSG_FILE_OPS
 	.getpmsg = _strgetpmsg,
 	.putpmsg = _strputpmsg,
@@ -11732,6 +12779,10 @@ strrput(queue_t *q, mblk_t *mp)
 {
 	struct stdata *sd = rqstream(q);
 
+	/* track the node of the processor driving the read side */
+	if (unlikely(sysctl_str_irqnode != 0) && (in_irq() || in_streams())
+	    && unlikely(sd->sd_node != numa_node_id()))
+		sd->sd_node = numa_node_id();
 	/* data fast path */
 	if (likely((mp->b_datap->db_type & ~1) == 0))	/* PROFILED */
 		return str_m_data(sd, q, mp);
@@ -0,0 +1,569 @@
+/*****************************************************************************
+
+ @(#) File: src/test/test-mtp-route.c
+
+ -----------------------------------------------------------------------------
+
+ Copyright (c) 2008-2015  Monavacon Limited <http://www.monavacon.com/>
+ Copyright (c) 2001-2008  OpenSS7 Corporation <http://www.openss7.com/>
+ Copyright (c) 1997-2001  Brian F. G. Bidulock <bidulock@openss7.org>
+
+ All Rights Reserved.
+
+ Unauthorized distribution or duplication is prohibited.
+
+ This software and related documentation is protected by copyright and
+ distributed under licenses restricting its use, copying, distribution and
+ decompilation.  No part of this software or related documentation may be
+ reproduced in any form by any means without the prior written authorization
+ of the copyright holder, and licensors, if any.
+
+ The recipient of this document, by its retention and use, warrants that the
+ recipient will protect this information and keep it confidential, and will
+ not disclose the information contained in this document without the written
+ permission of its owner.
+
+ The author reserves the right to revise this software and documentation for
+ any reason, including but not limited to, conformity with standards
+ promulgated by various agencies, utilization of advances in the state of the
+ technical arts, or the reflection of changes in the design of any techniques,
+ or procedures embodied, described, or referred to herein.  The author is
+ under no obligation to provide any feature listed herein.
+
+ -----------------------------------------------------------------------------
+
+ As an exception to the above, this software may be distributed under the GNU
+ Affero General Public License (AGPL) Version 3, so long as the software is
+ distributed with, and only used for the testing of, OpenSS7 modules, drivers,
+ and libraries.
+
+ -----------------------------------------------------------------------------
+
+ U.S. GOVERNMENT RESTRICTED RIGHTS.  If you are licensing this Software on
+ behalf of the U.S. Government ("Government"), the following provisions apply
+ to you.  If the Software is supplied by the Department of Defense ("DoD"), it
+ is classified as "Commercial Computer Software" under paragraph 252.227-7014
+ of the DoD Supplement to the Federal Acquisition Regulations ("DFARS") (or any
+ successor regulations) and the Government is acquiring only the license rights
+ granted herein (the license rights customarily provided to non-Government
+ users).  If the Software is supplied to any unit or agency of the Government
+ other than DoD, it is classified as "Restricted Computer Software" and the
+ Government's rights in the Software are defined in paragraph 52.227-19 of the
+ Federal Acquisition Regulations ("FAR") (or any successor regulations) or, in
+ the cases of NASA, in paragraph 18.52.227-86 of the NASA Supplement to the FAR
+ (or any successor regulations).
+
+ -----------------------------------------------------------------------------
+
+ Commercial licensing and support of this software is available from OpenSS7
+ Corporation at a fee.  See http://www.openss7.com/
+
+ *****************************************************************************/
+
+static char const ident[] __attribute__ ((unused)) = "src/test/test-mtp-route.c (" PACKAGE_ENVR ") " PACKAGE_DATE;
+
+/*
+ *  This is a benchmark for the MTP route set lookup used when sending messages from an MTP user.
+ *  It opens an MTPI Stream on the mtp(4) driver, configures a network appearance and a signalling
+ *  point with MTP_IOCSCONFIG, binds, and connects to the first route set.  It then adds member
+ *  route sets in doubling steps and, at each step, times a burst of MTP_TRANSFER_REQ primitives.
+ *  Each transfer resolves the connected destination with rs_route() in the driver, so the transfer
+ *  rate should stay flat as the number of route sets on the signalling point grows.  No route
+ *  lists are configured, so the driver discards each message once it has been routed to its route
+ *  set.  Only member route sets are configured because the driver rejects a second route set with
+ *  the same destination point code regardless of route set type.
+ */
+
+#include <sys/types.h>
+#include <stropts.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <errno.h>
+#include <string.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/ioctl.h>
+#include <sys/time.h>
+
+#ifdef _GNU_SOURCE
+#include <getopt.h>
+#endif
+
+#include <ss7/lmi.h>
+#include <ss7/lmi_ioctl.h>
+#include <ss7/mtpi.h>
+#include <ss7/mtpi_ioctl.h>
+
+#define NAME "test-mtp-route"
+
+#define TEST_NAID	1
+#define TEST_SPID	1
+#define TEST_OPC	0x0001
+#define TEST_DPC	0x0100	/* destination of the connected route set (id 1) */
+#define TEST_SI		3
+
+int verbose = 1;
+int maxsets = 4096;
+int transfers = 100000;
+
+static char devname[256] = "/dev/streams/clone/mtp";
+
+union primitives {
+	mtp_ulong mtp_primitive;
+	MTP_addr_req_t addr_req;
+	MTP_bind_req_t bind_req;
+	MTP_unbind_req_t unbind_req;
+	MTP_conn_req_t conn_req;
+	MTP_discon_req_t discon_req;
+	MTP_transfer_req_t transfer_req;
+	MTP_ok_ack_t ok_ack;
+	MTP_error_ack_t error_ack;
+	MTP_bind_ack_t bind_ack;
+	MTP_addr_ack_t addr_ack;
+};
+
+struct {
+	union primitives prim;
+	struct mtp_addr addr;
+} cbuf;
+
+struct {
+	struct mtp_config cnf;
+	union mtp_conf_obj obj;
+} conf;
+
+static double
+now(void)
+{
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+	return (tv.tv_sec + tv.tv_usec / 1000000.0);
+}
+
+static int
+do_config(int fd, mtp_ulong cmd, mtp_ulong type, mtp_ulong id)
+{
+	struct strioctl ic;
+
+	conf.cnf.type = type;
+	conf.cnf.id = id;
+	conf.cnf.cmd = cmd;
+	ic.ic_cmd = MTP_IOCSCONFIG;
+	ic.ic_timout = 0;
+	ic.ic_len = sizeof(conf);
+	ic.ic_dp = (char *) &conf;
+	if (ioctl(fd, I_STR, &ic) < 0) {
+		if (verbose)
+			fprintf(stderr, "%s: MTP_IOCSCONFIG type %lu id %lu: %s\n", NAME,
+				(unsigned long) type, (unsigned long) id, strerror(errno));
+		return (-1);
+	}
+	return (0);
+}
+
+static int
+add_rs(int fd, mtp_ulong id, mtp_ulong dest)
+{
+	memset(&conf.obj, 0, sizeof(conf.obj));
+	conf.obj.rs.spid = TEST_SPID;
+	conf.obj.rs.dest = dest;
+	return do_config(fd, MTP_ADD, MTP_OBJ_TYPE_RS, id);
+}
+
+static int
+put_prim(int fd, size_t len)
+{
+	struct strbuf ctl = { 0, len, (char *) &cbuf };
+
+	if (putmsg(fd, &ctl, NULL, 0) < 0) {
+		if (verbose)
+			perror(NAME ": putmsg");
+		return (-1);
+	}
+	return (0);
+}
+
+/*
+ *  Wait for the acknowledgement of a request, skipping any MTP_PAUSE_IND, MTP_RESUME_IND or
+ *  MTP_STATUS_IND primitives that the driver issues for the connected destination.
+ */
+static int
+get_ack(int fd, mtp_ulong ack)
+{
+	for (;;) {
+		struct strbuf ctl = { sizeof(cbuf), 0, (char *) &cbuf };
+		int flags = 0;
+
+		if (getmsg(fd, &ctl, NULL, &flags) < 0) {
+			if (verbose)
+				perror(NAME ": getmsg");
+			return (-1);
+		}
+		if (ctl.len < (int) sizeof(mtp_ulong))
+			continue;
+		if (cbuf.prim.mtp_primitive == ack)
+			return (0);
+		if (cbuf.prim.mtp_primitive == MTP_ERROR_ACK) {
+			if (verbose)
+				fprintf(stderr, "%s: primitive %lu failed: mtpi error %lu, %s\n", NAME,
+					(unsigned long) cbuf.prim.error_ack.mtp_error_primitive,
+					(unsigned long) cbuf.prim.error_ack.mtp_mtpi_error,
+					strerror(cbuf.prim.error_ack.mtp_unix_error));
+			return (-1);
+		}
+	}
+}
+
+static int
+do_request(int fd, size_t len, mtp_ulong ack)
+{
+	if (put_prim(fd, len))
+		return (-1);
+	return get_ack(fd, ack);
+}
+
+static void
+set_addr(mtp_ulong pc)
+{
+	cbuf.addr.family = AF_MTP;
+	cbuf.addr.ni = 0;
+	cbuf.addr.si = TEST_SI;
+	cbuf.addr.pc = pc;
+}
+
+/*
+ *  Send the transfers and then fence them with an MTP_ADDR_REQ.  The MTP_ADDR_REQ is sent as
+ *  M_PROTO rather than M_PCPROTO so that it is queued behind any transfers still on the driver
+ *  write queue and is only acknowledged once all of them have been routed.
+ */
+static double
+run(int fd)
+{
+	struct strbuf ctl = { 0, sizeof(cbuf.prim.transfer_req), (char *) &cbuf };
+	char data[32] = { 0, };
+	struct strbuf dat = { 0, sizeof(data), data };
+	double beg, end;
+	int i;
+
+	beg = now();
+	for (i = 0; i < transfers; i++) {
+		cbuf.prim.transfer_req.mtp_primitive = MTP_TRANSFER_REQ;
+		cbuf.prim.transfer_req.mtp_dest_length = 0;
+		cbuf.prim.transfer_req.mtp_dest_offset = 0;
+		cbuf.prim.transfer_req.mtp_mp = 0;
+		cbuf.prim.transfer_req.mtp_sls = i;
+		if (putmsg(fd, &ctl, &dat, 0) < 0) {
+			if (verbose)
+				perror(NAME ": putmsg");
+			return (0.0);
+		}
+	}
+	cbuf.prim.addr_req.mtp_primitive = MTP_ADDR_REQ;
+	if (do_request(fd, sizeof(cbuf.prim.addr_req), MTP_ADDR_ACK))
+		return (0.0);
+	end = now();
+	return (end > beg ? transfers / (end - beg) : 0.0);
+}
+
+int
+do_tests(void)
+{
+	int fd, n, nsets = 0, result = -1;
+	double rate = 0.0, first = 0.0;
+
+	if ((fd = open(devname, O_RDWR)) < 0) {
+		perror(NAME ": open");
+		return (-1);
+	}
+	/* network appearance with ITU-T 3-8-3 point code masks */
+	memset(&conf.obj, 0, sizeof(conf.obj));
+	conf.obj.na.mask.member = 0x3fff;
+	conf.obj.na.mask.cluster = 0x3ff8;
+	conf.obj.na.mask.network = 0x3800;
+	conf.obj.na.sls_bits = 4;
+	if (do_config(fd, MTP_ADD, MTP_OBJ_TYPE_NA, TEST_NAID))
+		goto close_out;
+	memset(&conf.obj, 0, sizeof(conf.obj));
+	conf.obj.sp.naid = TEST_NAID;
+	conf.obj.sp.pc = TEST_OPC;
+	conf.obj.sp.users = (1 << TEST_SI);
+	if (do_config(fd, MTP_ADD, MTP_OBJ_TYPE_SP, TEST_SPID))
+		goto del_na;
+	if (add_rs(fd, 1, TEST_DPC))
+		goto del_sp;
+	nsets = 1;
+	cbuf.prim.bind_req.mtp_primitive = MTP_BIND_REQ;
+	cbuf.prim.bind_req.mtp_addr_length = sizeof(cbuf.addr);
+	cbuf.prim.bind_req.mtp_addr_offset = sizeof(cbuf.prim);
+	cbuf.prim.bind_req.mtp_bind_flags = 0;
+	set_addr(TEST_OPC);
+	if (do_request(fd, sizeof(cbuf), MTP_BIND_ACK))
+		goto del_rs;
+	cbuf.prim.conn_req.mtp_primitive = MTP_CONN_REQ;
+	cbuf.prim.conn_req.mtp_addr_length = sizeof(cbuf.addr);
+	cbuf.prim.conn_req.mtp_addr_offset = sizeof(cbuf.prim);
+	cbuf.prim.conn_req.mtp_conn_flags = 0;
+	set_addr(TEST_DPC);
+	if (do_request(fd, sizeof(cbuf), MTP_OK_ACK))
+		goto unbind;
+	if (verbose)
+		printf("%10s %16s\n", "routesets", "transfers/sec");
+	for (n = 16; n <= maxsets; n <<= 1) {
+		for (; nsets < n; nsets++)
+			if (add_rs(fd, nsets + 1, (TEST_DPC + nsets) & 0x3fff))
+				goto disconnect;
+		if ((rate = run(fd)) == 0.0) {
+			fprintf(stderr, "%s: transfer failed at %d route sets\n", NAME, n);
+			goto disconnect;
+		}
+		if (first == 0.0)
+			first = rate;
+		if (verbose)
+			printf("%10d %16.0f\n", n, rate);
+		fflush(stdout);
+	}
+	if (rate < first / 2) {
+		fprintf(stderr, "%s: transfer rate fell from %.0f to %.0f per second\n", NAME, first,
+			rate);
+		goto disconnect;
+	}
+	result = 0;
+      disconnect:
+	cbuf.prim.discon_req.mtp_primitive = MTP_DISCON_REQ;
+	if (do_request(fd, sizeof(cbuf.prim.discon_req), MTP_OK_ACK))
+		result = -1;
+      unbind:
+	cbuf.prim.unbind_req.mtp_primitive = MTP_UNBIND_REQ;
+	if (do_request(fd, sizeof(cbuf.prim.unbind_req), MTP_OK_ACK))
+		result = -1;
+      del_rs:
+	memset(&conf.obj, 0, sizeof(conf.obj));
+	for (; nsets > 0; nsets--)
+		if (do_config(fd, MTP_DEL, MTP_OBJ_TYPE_RS, nsets))
+			result = -1;
+      del_sp:
+	memset(&conf.obj, 0, sizeof(conf.obj));
+	if (do_config(fd, MTP_DEL, MTP_OBJ_TYPE_SP, TEST_SPID))
+		result = -1;
+      del_na:
+	memset(&conf.obj, 0, sizeof(conf.obj));
+	if (do_config(fd, MTP_DEL, MTP_OBJ_TYPE_NA, TEST_NAID))
+		result = -1;
+      close_out:
+	close(fd);
+	return (result);
+}
+
+void
+copying(int argc, char *argv[])
+{
+	if (!verbose)
+		return;
+	fprintf(stdout, "\
+MTP Route Set Lookup Benchmark\n\
+\n\
+Copyright (c) 2008-2015  Monavacon Limited <http://www.monavacon.com/>\n\
+Copyright (c) 2001-2008  OpenSS7 Corporation <http://www.openss7.com/>\n\
+Copyright (c) 1997-2001  Brian F. G. Bidulock <bidulock@openss7.org>\n\
+\n\
+All Rights Reserved.\n\
+\n\
+Unauthorized distribution or duplication is prohibited.\n\
+\n\
+This software and related documentation is protected by copyright and distribut-\n\
+ed under licenses restricting its use,  copying, distribution and decompilation.\n\
+No part of this software or related documentation may  be reproduced in any form\n\
+by any means without the prior  written  authorization of the  copyright holder,\n\
+and licensors, if any.\n\
+\n\
+The recipient of this document,  by its retention and use, warrants that the re-\n\
+cipient  will protect this  information and  keep it confidential,  and will not\n\
+disclose the information contained  in this document without the written permis-\n\
+sion of its owner.\n\
+\n\
+The author reserves the right to revise  this software and documentation for any\n\
+reason,  including but not limited to, conformity with standards  promulgated by\n\
+various agencies, utilization of advances in the state of the technical arts, or\n\
+the reflection of changes  in the design of any techniques, or procedures embod-\n\
+ied, described, or  referred to herein.   The author  is under no  obligation to\n\
+provide any feature listed herein.\n\
+\n\
+As an exception to the above,  this software may be  distributed  under the  GNU\n\
+Affero  General  Public  License  (AGPL)  Version  3, so long as the software is\n\
+distributed with,  and only used for the testing of,  OpenSS7 modules,  drivers,\n\
+and libraries.\n\
+\n\
+U.S. GOVERNMENT RESTRICTED RIGHTS.  If you are licensing this Software on behalf\n\
+of the  U.S. Government  (\"Government\"),  the following provisions apply to you.\n\
+If the Software is  supplied by the Department of Defense (\"DoD\"), it is classi-\n\
+fied as  \"Commercial Computer Software\"  under paragraph 252.227-7014 of the DoD\n\
+Supplement  to the  Federal Acquisition Regulations  (\"DFARS\") (or any successor\n\
+regulations) and the  Government  is acquiring  only the license rights  granted\n\
+herein (the license  rights customarily  provided to non-Government  users).  If\n\
+the Software is supplied to any unit or agency of the Government other than DoD,\n\
+it is classified as  \"Restricted Computer Software\" and the  Government's rights\n\
+in the  Software are defined in  paragraph 52.227-19 of the Federal  Acquisition\n\
+Regulations  (\"FAR\") (or any successor regulations) or, in the cases of NASA, in\n\
+paragraph  18.52.227-86 of the  NASA Supplement  to the  FAR (or  any  successor\n\
+regulations).\n\
+");
+}
+
+void
+version(int argc, char *argv[])
+{
+	if (!verbose)
+		return;
+	fprintf(stdout, "\
+%1$s (OpenSS7 %2$s) %3$s (%4$s)\n\
+Written by Brian Bidulock\n\
+\n\
+Copyright (c) 2008, 2009, 2010, 2015  Monavacon Limited.\n\
+Copyright (c) 2001, 2002, 2003, 2004, 2005, 2006, 2007, 2008  OpenSS7 Corporation.\n\
+Copyright (c) 1997, 1998, 1999, 2000, 2001  Brian F. G. Bidulock.\n\
+This is free software; see the source for copying conditions.  There is NO\n\
+warranty; not even for MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.\n\
+\n\
+Distributed by OpenSS7 Corporation under GNU Affero General Public License Version 3,\n\
+incorporated herein by reference.  See `%1$s --copying' for copying permissions.\n\
+", NAME, PACKAGE, VERSION, PACKAGE_ENVR " " PACKAGE_DATE);
+}
+
+void
+usage(int argc, char *argv[])
+{
+	if (!verbose)
+		return;
+	fprintf(stderr, "\
+Usage:\n\
+    %1$s [options]\n\
+    %1$s {-h, --help}\n\
+    %1$s {-V, --version}\n\
+    %1$s {-C, --copying}\n\
+", argv[0]);
+}
+
+void
+help(int argc, char *argv[])
+{
+	if (!verbose)
+		return;
+	fprintf(stdout, "\
+Usage:\n\
+    %1$s [options]\n\
+    %1$s {-h, --help}\n\
+    %1$s {-V, --version}\n\
+    %1$s {-C, --copying}\n\
+Arguments:\n\
+    (none)\n\
+Options:\n\
+    -n, --routesets NUMBER\n\
+        maximum number of route sets to configure, 16 to 8192 [default: %2$d]\n\
+    -i, --iterations NUMBER\n\
+        number of transfers for each measurement [default: %3$d]\n\
+    -q, --quiet\n\
+        suppress normal output (equivalent to --verbose=0)\n\
+    -v, --verbose [LEVEL]\n\
+        increase verbosity or set to LEVEL [default: 1]\n\
+        this option may be repeated.\n\
+    -h, --help, -?, --?\n\
+        print this usage message and exit\n\
+    -V, --version\n\
+        print the version and exit\n\
+    -C, --copying\n\
+        print copying permissions and exit\n\
+", argv[0], maxsets, transfers);
+}
+
+int
+main(int argc, char *argv[])
+{
+	for (;;) {
+		int c, val;
+
+#if defined _GNU_SOURCE
+		int option_index = 0;
+		/* *INDENT-OFF* */
+		static struct option long_options[] = {
+			{"routesets",	required_argument,	NULL, 'n'},
+			{"iterations",	required_argument,	NULL, 'i'},
+			{"quiet",	no_argument,		NULL, 'q'},
+			{"verbose",	optional_argument,	NULL, 'v'},
+			{"help",	no_argument,		NULL, 'h'},
+			{"version",	no_argument,		NULL, 'V'},
+			{"copying",	no_argument,		NULL, 'C'},
+			{"?",		no_argument,		NULL, 'h'},
+			{ 0, }
+		};
+		/* *INDENT-ON* */
+
+		c = getopt_long(argc, argv, "n:i:qvhVC?", long_options, &option_index);
+#else				/* defined _GNU_SOURCE */
+		c = getopt(argc, argv, "n:i:qvhVC?");
+#endif				/* defined _GNU_SOURCE */
+		if (c == -1)
+			break;
+		switch (c) {
+		case 'n':	/* -n, --routesets NUMBER */
+			if ((val = strtol(optarg, NULL, 0)) < 16 || val > 8192)
+				goto bad_option;
+			maxsets = val;
+			break;
+		case 'i':	/* -i, --iterations NUMBER */
+			if ((val = strtol(optarg, NULL, 0)) < 1)
+				goto bad_option;
+			transfers = val;
+			break;
+		case 'q':	/* -q, --quiet */
+			verbose = 0;
+			break;
+		case 'v':
+			if (optarg == NULL) {
+				verbose++;
+				break;
+			}
+			if ((val = strtol(optarg, NULL, 0)) < 0)
+				goto bad_option;
+			verbose = val;
+			break;
+		case 'H':	/* -H */
+		case 'h':	/* -h, --help */
+			help(argc, argv);
+			exit(0);
+		case 'V':
+			version(argc, argv);
+			exit(0);
+		case 'C':
+			copying(argc, argv);
+			exit(0);
+		case '?':
+		default:
+		      bad_option:
+			optind--;
+		      bad_nonopt:
+			if (optind < argc && verbose) {
+				fprintf(stderr, "%s: illegal syntax -- ", argv[0]);
+				while (optind < argc)
+					fprintf(stderr, "%s ", argv[optind++]);
+				fprintf(stderr, "\n");
+				fflush(stderr);
+			}
+			goto bad_usage;
+		      bad_usage:
+			usage(argc, argv);
+			exit(2);
+		}
+	}
+	/* 
+	 * dont' ignore non-option arguments
+	 */
+	if (optind < argc)
+		goto bad_nonopt;
+	copying(argc, argv);
+	if (do_tests())
+		exit(1);
+	exit(0);
+}
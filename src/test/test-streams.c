@@ -78,6 +78,7 @@ static char const ident[] __attribute__ ((unused)) = "src/test/test-streams.c ("
 #include <sys/ioctl.h>
 #include <sys/time.h>
 #include <sys/poll.h>
+#include <sys/mman.h>
 #include <stdio.h>
 #include <sys/stat.h>
 #include <fcntl.h>
@@ -910,6 +911,26 @@ ioctl_string(int cmd, intptr_t arg)
 		return ("I_FATTACH");	/* 2.46 */
 	case I_FDETACH:
 		return ("I_FDETACH");	/* 2.47 */
+	case I_GETMSGV:
+		return ("I_GETMSGV");	/* 2.49 */
+	case I_PUTMSGV:
+		return ("I_PUTMSGV");	/* 2.50 */
+	case I_RINGSETUP:
+		return ("I_RINGSETUP");	/* 2.51 */
+	case I_RINGSYNC:
+		return ("I_RINGSYNC");	/* 2.52 */
+	case I_STRFT:
+		return ("I_STRFT");	/* 2.53 */
+	case I_STRFTON:
+		return ("I_STRFTON");	/* 2.53 */
+	case I_STRFTOFF:
+		return ("I_STRFTOFF");	/* 2.53 */
+	case I_STRFTSTR:
+		return ("I_STRFTSTR");	/* 2.54 */
+	case I_STRFTALL:
+		return ("I_STRFTALL");	/* 2.54 */
+	case I_STRFTZERO:
+		return ("I_STRFTZERO");	/* 2.54 */
 	case TM_IOC_HANGUP:
 		return ("TM_IOC_HANGUP");
 	case TM_IOC_RDERR:
@@ -12888,6 +12909,891 @@ struct test_stream test_2_48_6 = { &preamble_2, &test_case_2_48_6, &postamble_2
 #define test_case_2_48_6_stream_1 (NULL)
 #define test_case_2_48_6_stream_2 (NULL)
 
+/*
+ *  Perform IOCTL on one Stream - I_GETMSGV  (LfS)
+ */
+static const char sref_case_2_49[] = "streamio(7) manual page, I_GETMSGV section.";
+
+#define tgrp_case_2_49_1 test_group_2
+#define numb_case_2_49_1 "2.49.1"
+#define name_case_2_49_1 "Perform streamio I_GETMSGV."
+#define sref_case_2_49_1 sref_case_2_49
+#define desc_case_2_49_1 "\
+Checks that I_GETMSGV can be performed on a Stream.  Checks that the two\n\
+messages echoed by the driver are retrieved in one call, that the number\n\
+of messages retrieved is returned, and that the third element of the\n\
+vector reports EAGAIN in its mm_status."
+
+int
+test_case_2_49_1(int child)
+{
+	char buf[3][16] = { "one", "two", "" };
+	struct strbuf data = { -1, 4, buf[0] };
+	struct strmmsg mm[3];
+	struct strmsgv sv = { mm, 3 };
+	int i;
+
+	if (test_putpmsg(child, NULL, &data, 0, MSG_BAND) != __RESULT_SUCCESS)
+		return (__RESULT_FAILURE);
+	state++;
+	data.buf = buf[1];
+	if (test_putpmsg(child, NULL, &data, 0, MSG_BAND) != __RESULT_SUCCESS)
+		return (__RESULT_FAILURE);
+	state++;
+	memset(buf, 0, sizeof(buf));
+	for (i = 0; i < 3; i++) {
+		mm[i].mm_msg.ctlbuf.maxlen = 0;
+		mm[i].mm_msg.ctlbuf.len = -1;
+		mm[i].mm_msg.ctlbuf.buf = NULL;
+		mm[i].mm_msg.databuf.maxlen = sizeof(buf[i]);
+		mm[i].mm_msg.databuf.len = -1;
+		mm[i].mm_msg.databuf.buf = buf[i];
+		mm[i].mm_msg.band = 0;
+		mm[i].mm_msg.flags = MSG_ANY;
+		mm[i].mm_status = 1;
+	}
+	if (test_ioctl(child, I_GETMSGV, (intptr_t) &sv) != __RESULT_SUCCESS)
+		return (__RESULT_FAILURE);
+	state++;
+	if (last_retval != 2)
+		return (__RESULT_FAILURE);
+	state++;
+	if (mm[0].mm_status != 0 || mm[0].mm_msg.databuf.len != 4 || strcmp(buf[0], "one"))
+		return (__RESULT_FAILURE);
+	state++;
+	if (mm[1].mm_status != 0 || mm[1].mm_msg.databuf.len != 4 || strcmp(buf[1], "two"))
+		return (__RESULT_FAILURE);
+	state++;
+	if (mm[2].mm_status != -EAGAIN)
+		return (__RESULT_FAILURE);
+	state++;
+	return (__RESULT_SUCCESS);
+}
+struct test_stream test_2_49_1 = { &preamble_0, &test_case_2_49_1, &postamble_0 };
+
+#define test_case_2_49_1_stream_0 (&test_2_49_1)
+#define test_case_2_49_1_stream_1 (NULL)
+#define test_case_2_49_1_stream_2 (NULL)
+
+#define tgrp_case_2_49_2 test_group_2
+#define numb_case_2_49_2 "2.49.2"
+#define name_case_2_49_2 "Perform streamio I_GETMSGV - EAGAIN."
+#define sref_case_2_49_2 sref_case_2_49
+#define desc_case_2_49_2 "\
+Checks that I_GETMSGV can be performed on a Stream.  Checks that EAGAIN\n\
+is returned when I_GETMSGV is attempted on a Stream set for non-blocking\n\
+operation with no messages on the Stream head read queue."
+
+int
+test_case_2_49_2(int child)
+{
+	char buf[2][16];
+	struct strmmsg mm[2];
+	struct strmsgv sv = { mm, 2 };
+	int i;
+
+	for (i = 0; i < 2; i++) {
+		mm[i].mm_msg.ctlbuf.maxlen = 0;
+		mm[i].mm_msg.ctlbuf.len = -1;
+		mm[i].mm_msg.ctlbuf.buf = NULL;
+		mm[i].mm_msg.databuf.maxlen = sizeof(buf[i]);
+		mm[i].mm_msg.databuf.len = -1;
+		mm[i].mm_msg.databuf.buf = buf[i];
+		mm[i].mm_msg.band = 0;
+		mm[i].mm_msg.flags = MSG_ANY;
+		mm[i].mm_status = 1;
+	}
+	if (test_ioctl(child, I_GETMSGV, (intptr_t) &sv) == __RESULT_SUCCESS)
+		return (__RESULT_FAILURE);
+	state++;
+	if (last_errno != EAGAIN)
+		return (__RESULT_FAILURE);
+	state++;
+	if (mm[0].mm_status != -EAGAIN)
+		return (__RESULT_FAILURE);
+	state++;
+	return (__RESULT_SUCCESS);
+}
+struct test_stream test_2_49_2 = { &preamble_0, &test_case_2_49_2, &postamble_0 };
+
+#define test_case_2_49_2_stream_0 (&test_2_49_2)
+#define test_case_2_49_2_stream_1 (NULL)
+#define test_case_2_49_2_stream_2 (NULL)
+
+#define tgrp_case_2_49_3 test_group_2
+#define numb_case_2_49_3 "2.49.3"
+#define name_case_2_49_3 "Perform streamio I_GETMSGV - EINVAL."
+#define sref_case_2_49_3 sref_case_2_49
+#define desc_case_2_49_3 "\
+Checks that I_GETMSGV can be performed on a Stream.  Checks that EINVAL\n\
+is returned when I_GETMSGV is attempted with an empty message vector."
+
+int
+test_case_2_49_3(int child)
+{
+	struct strmmsg mm[1];
+	struct strmsgv sv = { mm, 0 };
+
+	if (test_ioctl(child, I_GETMSGV, (intptr_t) &sv) == __RESULT_SUCCESS)
+		return (__RESULT_FAILURE);
+	state++;
+	if (last_errno != EINVAL)
+		return (__RESULT_FAILURE);
+	state++;
+	return (__RESULT_SUCCESS);
+}
+struct test_stream test_2_49_3 = { &preamble_0, &test_case_2_49_3, &postamble_0 };
+
+#define test_case_2_49_3_stream_0 (&test_2_49_3)
+#define test_case_2_49_3_stream_1 (NULL)
+#define test_case_2_49_3_stream_2 (NULL)
+
+#define tgrp_case_2_49_4 test_group_2
+#define numb_case_2_49_4 "2.49.4"
+#define name_case_2_49_4 "Perform streamio I_GETMSGV - EFAULT."
+#define sref_case_2_49_4 sref_case_2_49
+#define desc_case_2_49_4 "\
+Checks that I_GETMSGV can be performed on a Stream.  Checks that EFAULT\n\
+is returned when the argument points outside the caller's address space."
+
+int
+test_case_2_49_4(int child)
+{
+	if (test_ioctl(child, I_GETMSGV, (intptr_t) INVALID_ADDRESS) == __RESULT_SUCCESS)
+		return (__RESULT_FAILURE);
+	state++;
+	if (last_errno != EFAULT)
+		return (__RESULT_FAILURE);
+	state++;
+	return (__RESULT_SUCCESS);
+}
+struct test_stream test_2_49_4 = { &preamble_0, &test_case_2_49_4, &postamble_0 };
+
+#define test_case_2_49_4_stream_0 (&test_2_49_4)
+#define test_case_2_49_4_stream_1 (NULL)
+#define test_case_2_49_4_stream_2 (NULL)
+
+/*
+ *  Perform IOCTL on one Stream - I_PUTMSGV  (LfS)
+ */
+static const char sref_case_2_50[] = "streamio(7) manual page, I_PUTMSGV section.";
+
+#define tgrp_case_2_50_1 test_group_2
+#define numb_case_2_50_1 "2.50.1"
+#define name_case_2_50_1 "Perform streamio I_PUTMSGV."
+#define sref_case_2_50_1 sref_case_2_50
+#define desc_case_2_50_1 "\
+Checks that I_PUTMSGV can be performed on a Stream.  Checks that three\n\
+messages are sent in one call, that the number of messages sent is\n\
+returned, and that the messages are echoed back in order."
+
+int
+test_case_2_50_1(int child)
+{
+	char buf[3][16] = { "one", "two", "three" };
+	char rbuf[16];
+	struct strmmsg mm[3];
+	struct strmsgv sv = { mm, 3 };
+	struct strbuf data = { sizeof(rbuf), -1, rbuf };
+	int i, band, flags;
+
+	for (i = 0; i < 3; i++) {
+		mm[i].mm_msg.ctlbuf.maxlen = -1;
+		mm[i].mm_msg.ctlbuf.len = -1;
+		mm[i].mm_msg.ctlbuf.buf = NULL;
+		mm[i].mm_msg.databuf.maxlen = -1;
+		mm[i].mm_msg.databuf.len = strlen(buf[i]) + 1;
+		mm[i].mm_msg.databuf.buf = buf[i];
+		mm[i].mm_msg.band = 0;
+		mm[i].mm_msg.flags = MSG_BAND;
+		mm[i].mm_status = 1;
+	}
+	if (test_ioctl(child, I_PUTMSGV, (intptr_t) &sv) != __RESULT_SUCCESS)
+		return (__RESULT_FAILURE);
+	state++;
+	if (last_retval != 3)
+		return (__RESULT_FAILURE);
+	state++;
+	if (mm[0].mm_status != 0 || mm[1].mm_status != 0 || mm[2].mm_status != 0)
+		return (__RESULT_FAILURE);
+	state++;
+	for (i = 0; i < 3; i++) {
+		band = 0;
+		flags = MSG_ANY;
+		if (test_getpmsg(child, NULL, &data, &band, &flags) != __RESULT_SUCCESS)
+			return (__RESULT_FAILURE);
+		state++;
+		if (data.len != (int) strlen(buf[i]) + 1 || strcmp(rbuf, buf[i]))
+			return (__RESULT_FAILURE);
+		state++;
+	}
+	return (__RESULT_SUCCESS);
+}
+struct test_stream test_2_50_1 = { &preamble_0, &test_case_2_50_1, &postamble_0 };
+
+#define test_case_2_50_1_stream_0 (&test_2_50_1)
+#define test_case_2_50_1_stream_1 (NULL)
+#define test_case_2_50_1_stream_2 (NULL)
+
+#define tgrp_case_2_50_2 test_group_2
+#define numb_case_2_50_2 "2.50.2"
+#define name_case_2_50_2 "Perform streamio I_PUTMSGV - EINVAL."
+#define sref_case_2_50_2 sref_case_2_50
+#define desc_case_2_50_2 "\
+Checks that I_PUTMSGV can be performed on a Stream.  Checks that sending\n\
+stops at the first message that fails: when the second message requests\n\
+MSG_HIPRI without a control part, one is returned and the mm_status of\n\
+the second message is EINVAL."
+
+int
+test_case_2_50_2(int child)
+{
+	char buf[2][16] = { "one", "two" };
+	struct strmmsg mm[2];
+	struct strmsgv sv = { mm, 2 };
+	int i;
+
+	for (i = 0; i < 2; i++) {
+		mm[i].mm_msg.ctlbuf.maxlen = -1;
+		mm[i].mm_msg.ctlbuf.len = -1;
+		mm[i].mm_msg.ctlbuf.buf = NULL;
+		mm[i].mm_msg.databuf.maxlen = -1;
+		mm[i].mm_msg.databuf.len = strlen(buf[i]) + 1;
+		mm[i].mm_msg.databuf.buf = buf[i];
+		mm[i].mm_msg.band = 0;
+		mm[i].mm_msg.flags = MSG_BAND;
+		mm[i].mm_status = 1;
+	}
+	mm[1].mm_msg.flags = MSG_HIPRI;
+	if (test_ioctl(child, I_PUTMSGV, (intptr_t) &sv) != __RESULT_SUCCESS)
+		return (__RESULT_FAILURE);
+	state++;
+	if (last_retval != 1)
+		return (__RESULT_FAILURE);
+	state++;
+	if (mm[0].mm_status != 0 || mm[1].mm_status != -EINVAL)
+		return (__RESULT_FAILURE);
+	state++;
+	return (__RESULT_SUCCESS);
+}
+struct test_stream test_2_50_2 = { &preamble_0, &test_case_2_50_2, &postamble_0 };
+
+#define test_case_2_50_2_stream_0 (&test_2_50_2)
+#define test_case_2_50_2_stream_1 (NULL)
+#define test_case_2_50_2_stream_2 (NULL)
+
+#define tgrp_case_2_50_3 test_group_2
+#define numb_case_2_50_3 "2.50.3"
+#define name_case_2_50_3 "Perform streamio I_PUTMSGV - EINVAL."
+#define sref_case_2_50_3 sref_case_2_50
+#define desc_case_2_50_3 "\
+Checks that I_PUTMSGV can be performed on a Stream.  Checks that EINVAL\n\
+is returned when I_PUTMSGV is attempted with an empty message vector."
+
+int
+test_case_2_50_3(int child)
+{
+	struct strmmsg mm[1];
+	struct strmsgv sv = { mm, 0 };
+
+	if (test_ioctl(child, I_PUTMSGV, (intptr_t) &sv) == __RESULT_SUCCESS)
+		return (__RESULT_FAILURE);
+	state++;
+	if (last_errno != EINVAL)
+		return (__RESULT_FAILURE);
+	state++;
+	return (__RESULT_SUCCESS);
+}
+struct test_stream test_2_50_3 = { &preamble_0, &test_case_2_50_3, &postamble_0 };
+
+#define test_case_2_50_3_stream_0 (&test_2_50_3)
+#define test_case_2_50_3_stream_1 (NULL)
+#define test_case_2_50_3_stream_2 (NULL)
+
+#define tgrp_case_2_50_4 test_group_2
+#define numb_case_2_50_4 "2.50.4"
+#define name_case_2_50_4 "Perform streamio I_PUTMSGV - EFAULT."
+#define sref_case_2_50_4 sref_case_2_50
+#define desc_case_2_50_4 "\
+Checks that I_PUTMSGV can be performed on a Stream.  Checks that EFAULT\n\
+is returned when the argument points outside the caller's address space."
+
+int
+test_case_2_50_4(int child)
+{
+	if (test_ioctl(child, I_PUTMSGV, (intptr_t) INVALID_ADDRESS) == __RESULT_SUCCESS)
+		return (__RESULT_FAILURE);
+	state++;
+	if (last_errno != EFAULT)
+		return (__RESULT_FAILURE);
+	state++;
+	return (__RESULT_SUCCESS);
+}
+struct test_stream test_2_50_4 = { &preamble_0, &test_case_2_50_4, &postamble_0 };
+
+#define test_case_2_50_4_stream_0 (&test_2_50_4)
+#define test_case_2_50_4_stream_1 (NULL)
+#define test_case_2_50_4_stream_2 (NULL)
+
+/*
+ *  Perform IOCTL on one Stream - I_RINGSETUP  (LfS)
+ */
+static const char sref_case_2_51[] = "streamio(7) manual page, I_RINGSETUP section.";
+
+#define tgrp_case_2_51_1 test_group_2
+#define numb_case_2_51_1 "2.51.1"
+#define name_case_2_51_1 "Perform streamio I_RINGSETUP."
+#define sref_case_2_51_1 sref_case_2_51
+#define desc_case_2_51_1 "\
+Checks that I_RINGSETUP can be performed on a Stream.  Checks that the\n\
+length returned covers the ring control page and both rings."
+
+int
+test_case_2_51_1(int child)
+{
+	struct strringreq rr = { 16, 256 };
+
+	if (test_ioctl(child, I_RINGSETUP, (intptr_t) &rr) != __RESULT_SUCCESS) {
+		if (last_errno == EOPNOTSUPP)
+			return (__RESULT_NOTAPPL);
+		return (__RESULT_FAILURE);
+	}
+	state++;
+	if (last_retval < getpagesize() + 2 * 16 * 256)
+		return (__RESULT_FAILURE);
+	state++;
+	return (__RESULT_SUCCESS);
+}
+struct test_stream test_2_51_1 = { &preamble_0, &test_case_2_51_1, &postamble_0 };
+
+#define test_case_2_51_1_stream_0 (&test_2_51_1)
+#define test_case_2_51_1_stream_1 (NULL)
+#define test_case_2_51_1_stream_2 (NULL)
+
+#define tgrp_case_2_51_2 test_group_2
+#define numb_case_2_51_2 "2.51.2"
+#define name_case_2_51_2 "Perform streamio I_RINGSETUP - EINVAL."
+#define sref_case_2_51_2 sref_case_2_51
+#define desc_case_2_51_2 "\
+Checks that I_RINGSETUP can be performed on a Stream.  Checks that EINVAL\n\
+is returned when the number of slots is not a power of 2."
+
+int
+test_case_2_51_2(int child)
+{
+	struct strringreq rr = { 3, 256 };
+
+	if (test_ioctl(child, I_RINGSETUP, (intptr_t) &rr) == __RESULT_SUCCESS)
+		return (__RESULT_FAILURE);
+	state++;
+	if (last_errno == EOPNOTSUPP)
+		return (__RESULT_NOTAPPL);
+	if (last_errno != EINVAL)
+		return (__RESULT_FAILURE);
+	state++;
+	return (__RESULT_SUCCESS);
+}
+struct test_stream test_2_51_2 = { &preamble_0, &test_case_2_51_2, &postamble_0 };
+
+#define test_case_2_51_2_stream_0 (&test_2_51_2)
+#define test_case_2_51_2_stream_1 (NULL)
+#define test_case_2_51_2_stream_2 (NULL)
+
+#define tgrp_case_2_51_3 test_group_2
+#define numb_case_2_51_3 "2.51.3"
+#define name_case_2_51_3 "Perform streamio I_RINGSETUP - EINVAL."
+#define sref_case_2_51_3 sref_case_2_51
+#define desc_case_2_51_3 "\
+Checks that I_RINGSETUP can be performed on a Stream.  Checks that EINVAL\n\
+is returned when a ring would exceed STRRING_MAXSIZE bytes."
+
+int
+test_case_2_51_3(int child)
+{
+	struct strringreq rr = { 65536, 128 };
+
+	if (test_ioctl(child, I_RINGSETUP, (intptr_t) &rr) == __RESULT_SUCCESS)
+		return (__RESULT_FAILURE);
+	state++;
+	if (last_errno == EOPNOTSUPP)
+		return (__RESULT_NOTAPPL);
+	if (last_errno != EINVAL)
+		return (__RESULT_FAILURE);
+	state++;
+	return (__RESULT_SUCCESS);
+}
+struct test_stream test_2_51_3 = { &preamble_0, &test_case_2_51_3, &postamble_0 };
+
+#define test_case_2_51_3_stream_0 (&test_2_51_3)
+#define test_case_2_51_3_stream_1 (NULL)
+#define test_case_2_51_3_stream_2 (NULL)
+
+#define tgrp_case_2_51_4 test_group_2
+#define numb_case_2_51_4 "2.51.4"
+#define name_case_2_51_4 "Perform streamio I_RINGSETUP - EBUSY."
+#define sref_case_2_51_4 sref_case_2_51
+#define desc_case_2_51_4 "\
+Checks that I_RINGSETUP can be performed on a Stream.  Checks that EBUSY\n\
+is returned when rings have already been set up on the Stream."
+
+int
+test_case_2_51_4(int child)
+{
+	struct strringreq rr = { 16, 256 };
+
+	if (test_ioctl(child, I_RINGSETUP, (intptr_t) &rr) != __RESULT_SUCCESS) {
+		if (last_errno == EOPNOTSUPP)
+			return (__RESULT_NOTAPPL);
+		return (__RESULT_FAILURE);
+	}
+	state++;
+	if (test_ioctl(child, I_RINGSETUP, (intptr_t) &rr) == __RESULT_SUCCESS)
+		return (__RESULT_FAILURE);
+	state++;
+	if (last_errno != EBUSY)
+		return (__RESULT_FAILURE);
+	state++;
+	return (__RESULT_SUCCESS);
+}
+struct test_stream test_2_51_4 = { &preamble_0, &test_case_2_51_4, &postamble_0 };
+
+#define test_case_2_51_4_stream_0 (&test_2_51_4)
+#define test_case_2_51_4_stream_1 (NULL)
+#define test_case_2_51_4_stream_2 (NULL)
+
+#define tgrp_case_2_51_5 test_group_2
+#define numb_case_2_51_5 "2.51.5"
+#define name_case_2_51_5 "Perform streamio I_RINGSETUP - EFAULT."
+#define sref_case_2_51_5 sref_case_2_51
+#define desc_case_2_51_5 "\
+Checks that I_RINGSETUP can be performed on a Stream.  Checks that EFAULT\n\
+is returned when the argument points outside the caller's address space."
+
+int
+test_case_2_51_5(int child)
+{
+	if (test_ioctl(child, I_RINGSETUP, (intptr_t) INVALID_ADDRESS) == __RESULT_SUCCESS)
+		return (__RESULT_FAILURE);
+	state++;
+	if (last_errno == EOPNOTSUPP)
+		return (__RESULT_NOTAPPL);
+	if (last_errno != EFAULT)
+		return (__RESULT_FAILURE);
+	state++;
+	return (__RESULT_SUCCESS);
+}
+struct test_stream test_2_51_5 = { &preamble_0, &test_case_2_51_5, &postamble_0 };
+
+#define test_case_2_51_5_stream_0 (&test_2_51_5)
+#define test_case_2_51_5_stream_1 (NULL)
+#define test_case_2_51_5_stream_2 (NULL)
+
+/*
+ *  Perform IOCTL on one Stream - I_RINGSYNC  (LfS)
+ */
+static const char sref_case_2_52[] = "streamio(7) manual page, I_RINGSYNC section.";
+
+#define tgrp_case_2_52_1 test_group_2
+#define numb_case_2_52_1 "2.52.1"
+#define name_case_2_52_1 "Perform streamio I_RINGSYNC."
+#define sref_case_2_52_1 sref_case_2_52
+#define desc_case_2_52_1 "\
+Checks that I_RINGSYNC can be performed on a Stream.  Checks that a\n\
+message placed in the mapped transmit ring is sent downstream and that\n\
+its echo is returned in the mapped receive ring."
+
+int
+test_case_2_52_1(int child)
+{
+	struct strringreq rr = { 16, 256 };
+	struct strring *rx, *tx;
+	struct strslot *ss;
+	unsigned char *base;
+	int i, len;
+
+	if (test_ioctl(child, I_RINGSETUP, (intptr_t) &rr) != __RESULT_SUCCESS) {
+		if (last_errno == EOPNOTSUPP)
+			return (__RESULT_NOTAPPL);
+		return (__RESULT_FAILURE);
+	}
+	state++;
+	len = last_retval;
+	if ((base = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED, test_fd[child], 0))
+	    == MAP_FAILED) {
+		last_errno = errno;
+		return (__RESULT_FAILURE);
+	}
+	state++;
+	rx = (struct strring *) base;
+	tx = rx + 1;
+	ss = (struct strslot *) (base + tx->sr_offset + (tx->sr_head % tx->sr_slots) * tx->sr_slotsize);
+	ss->ss_flags = 0;
+	ss->ss_band = 0;
+	ss->ss_ctllen = -1;
+	ss->ss_datlen = 4;
+	memcpy(ss + 1, "ring", 4);
+	tx->sr_head++;
+	/* the echo might only reach the Stream head read queue after the transmit ring is drained */
+	for (i = 0; i < 2 && rx->sr_head == rx->sr_tail; i++) {
+		if (test_ioctl(child, I_RINGSYNC, 0) != __RESULT_SUCCESS)
+			goto failure;
+		state++;
+	}
+	if (tx->sr_tail != tx->sr_head || rx->sr_head - rx->sr_tail != 1)
+		goto failure;
+	state++;
+	ss = (struct strslot *) (base + rx->sr_offset + (rx->sr_tail % rx->sr_slots) * rx->sr_slotsize);
+	if (ss->ss_ctllen != -1 || ss->ss_datlen != 4 || memcmp(ss + 1, "ring", 4))
+		goto failure;
+	state++;
+	rx->sr_tail++;
+	munmap(base, len);
+	return (__RESULT_SUCCESS);
+      failure:
+	munmap(base, len);
+	return (__RESULT_FAILURE);
+}
+struct test_stream test_2_52_1 = { &preamble_0, &test_case_2_52_1, &postamble_0 };
+
+#define test_case_2_52_1_stream_0 (&test_2_52_1)
+#define test_case_2_52_1_stream_1 (NULL)
+#define test_case_2_52_1_stream_2 (NULL)
+
+#define tgrp_case_2_52_2 test_group_2
+#define numb_case_2_52_2 "2.52.2"
+#define name_case_2_52_2 "Perform streamio I_RINGSYNC - EINVAL."
+#define sref_case_2_52_2 sref_case_2_52
+#define desc_case_2_52_2 "\
+Checks that I_RINGSYNC can be performed on a Stream.  Checks that EINVAL\n\
+is returned when I_RINGSYNC is attempted before rings have been set up\n\
+with I_RINGSETUP."
+
+int
+test_case_2_52_2(int child)
+{
+	if (test_ioctl(child, I_RINGSYNC, 0) == __RESULT_SUCCESS)
+		return (__RESULT_FAILURE);
+	state++;
+	if (last_errno == EOPNOTSUPP)
+		return (__RESULT_NOTAPPL);
+	if (last_errno != EINVAL)
+		return (__RESULT_FAILURE);
+	state++;
+	return (__RESULT_SUCCESS);
+}
+struct test_stream test_2_52_2 = { &preamble_0, &test_case_2_52_2, &postamble_0 };
+
+#define test_case_2_52_2_stream_0 (&test_2_52_2)
+#define test_case_2_52_2_stream_1 (NULL)
+#define test_case_2_52_2_stream_2 (NULL)
+
+/*
+ *  Perform IOCTL on one Stream - I_STRFT, I_STRFTON, I_STRFTOFF  (LfS)
+ */
+static const char sref_case_2_53[] = "streamio(7) manual page, I_STRFT section.";
+
+#define tgrp_case_2_53_1 test_group_2
+#define numb_case_2_53_1 "2.53.1"
+#define name_case_2_53_1 "Perform streamio I_STRFTON and I_STRFTOFF."
+#define sref_case_2_53_1 sref_case_2_53
+#define desc_case_2_53_1 "\
+Checks that I_STRFT, I_STRFTON and I_STRFTOFF can be performed on a\n\
+Stream.  Checks that I_STRFT returns false on a new Stream, true after\n\
+I_STRFTON, and false again after I_STRFTOFF."
+
+int
+test_case_2_53_1(int child)
+{
+	if (test_ioctl(child, I_STRFT, 0) != __RESULT_SUCCESS || last_retval != 0)
+		return (__RESULT_FAILURE);
+	state++;
+	if (test_ioctl(child, I_STRFTON, 0) != __RESULT_SUCCESS)
+		return (__RESULT_FAILURE);
+	state++;
+	if (test_ioctl(child, I_STRFT, 0) != __RESULT_SUCCESS || last_retval != 1)
+		return (__RESULT_FAILURE);
+	state++;
+	if (test_ioctl(child, I_STRFTOFF, 0) != __RESULT_SUCCESS)
+		return (__RESULT_FAILURE);
+	state++;
+	if (test_ioctl(child, I_STRFT, 0) != __RESULT_SUCCESS || last_retval != 0)
+		return (__RESULT_FAILURE);
+	state++;
+	return (__RESULT_SUCCESS);
+}
+struct test_stream test_2_53_1 = { &preamble_0, &test_case_2_53_1, &postamble_0 };
+
+#define test_case_2_53_1_stream_0 (&test_2_53_1)
+#define test_case_2_53_1_stream_1 (NULL)
+#define test_case_2_53_1_stream_2 (NULL)
+
+#define tgrp_case_2_53_2 test_group_2
+#define numb_case_2_53_2 "2.53.2"
+#define name_case_2_53_2 "Perform streamio I_STRFTON and I_STRFTOFF."
+#define sref_case_2_53_2 sref_case_2_53
+#define desc_case_2_53_2 "\
+Checks that I_STRFTON and I_STRFTOFF can be performed on a hung up\n\
+Stream.  Checks that flow trace can be turned on and off on a hung up\n\
+Stream so that events already recorded can still be examined."
+
+int
+test_case_2_53_2(int child)
+{
+	if (test_ioctl(child, I_STRFTON, 0) != __RESULT_SUCCESS)
+		return (__RESULT_FAILURE);
+	state++;
+	if (test_ioctl(child, I_STRFT, 0) != __RESULT_SUCCESS || last_retval != 1)
+		return (__RESULT_FAILURE);
+	state++;
+	if (test_ioctl(child, I_STRFTOFF, 0) != __RESULT_SUCCESS)
+		return (__RESULT_FAILURE);
+	state++;
+	return (__RESULT_SUCCESS);
+}
+struct test_stream test_2_53_2 = { &preamble_2_1, &test_case_2_53_2, &postamble_2 };
+
+#define test_case_2_53_2_stream_0 (&test_2_53_2)
+#define test_case_2_53_2_stream_1 (NULL)
+#define test_case_2_53_2_stream_2 (NULL)
+
+/*
+ *  Perform IOCTL on one Stream - I_STRFTSTR, I_STRFTALL, I_STRFTZERO  (LfS)
+ */
+static const char sref_case_2_54[] = "streamio(7) manual page, I_STRFTSTR section.";
+
+/* room for the events of a few messages */
+struct {
+	struct strftbuf fb;
+	struct strftevnt more[15];
+} ftbuf;
+
+#define tgrp_case_2_54_1 test_group_2
+#define numb_case_2_54_1 "2.54.1"
+#define name_case_2_54_1 "Perform streamio I_STRFTSTR."
+#define sref_case_2_54_1 sref_case_2_54
+#define desc_case_2_54_1 "\
+Checks that I_STRFTSTR can be performed on a Stream.  Checks that events\n\
+are recorded for a message sent while flow trace is on, that they are\n\
+returned for the Stream, and that they are consumed by the fetch."
+
+int
+test_case_2_54_1(int child)
+{
+	char buf[16] = "trace";
+	struct strbuf data = { -1, 6, buf };
+	int i;
+
+	if (test_ioctl(child, I_STRFTZERO, 0) != __RESULT_SUCCESS)
+		return (__RESULT_FAILURE);
+	state++;
+	if (test_ioctl(child, I_STRFTON, 0) != __RESULT_SUCCESS)
+		return (__RESULT_FAILURE);
+	state++;
+	if (test_putpmsg(child, NULL, &data, 0, MSG_BAND) != __RESULT_SUCCESS)
+		return (__RESULT_FAILURE);
+	state++;
+	if (test_ioctl(child, I_STRFTOFF, 0) != __RESULT_SUCCESS)
+		return (__RESULT_FAILURE);
+	state++;
+	ftbuf.fb.fb_count = 16;
+	if (test_ioctl(child, I_STRFTSTR, (intptr_t) &ftbuf) != __RESULT_SUCCESS)
+		return (__RESULT_FAILURE);
+	state++;
+	if (ftbuf.fb.fb_count <= 0 || ftbuf.fb.fb_count > 16)
+		return (__RESULT_FAILURE);
+	state++;
+	for (i = 0; i < ftbuf.fb.fb_count; i++) {
+		switch (ftbuf.fb.fb_evnt[i].fe_evnt & FTEV_MASK) {
+		case FTEV_PUT:
+		case FTEV_PUTQ:
+		case FTEV_GETQ:
+		case FTEV_SRVP:
+			break;
+		default:
+			return (__RESULT_FAILURE);
+		}
+		if (i > 0 && ftbuf.fb.fb_evnt[i].fe_ts < ftbuf.fb.fb_evnt[i - 1].fe_ts)
+			return (__RESULT_FAILURE);
+	}
+	state++;
+	ftbuf.fb.fb_count = 16;
+	if (test_ioctl(child, I_STRFTSTR, (intptr_t) &ftbuf) != __RESULT_SUCCESS)
+		return (__RESULT_FAILURE);
+	state++;
+	if (ftbuf.fb.fb_count != 0)
+		return (__RESULT_FAILURE);
+	state++;
+	return (__RESULT_SUCCESS);
+}
+struct test_stream test_2_54_1 = { &preamble_0, &test_case_2_54_1, &postamble_0 };
+
+#define test_case_2_54_1_stream_0 (&test_2_54_1)
+#define test_case_2_54_1_stream_1 (NULL)
+#define test_case_2_54_1_stream_2 (NULL)
+
+#define tgrp_case_2_54_2 test_group_2
+#define numb_case_2_54_2 "2.54.2"
+#define name_case_2_54_2 "Perform streamio I_STRFTZERO."
+#define sref_case_2_54_2 sref_case_2_54
+#define desc_case_2_54_2 "\
+Checks that I_STRFTZERO can be performed on a Stream.  Checks that the\n\
+events recorded for the Stream are discarded, so that a following\n\
+I_STRFTSTR returns no events."
+
+int
+test_case_2_54_2(int child)
+{
+	char buf[16] = "trace";
+	struct strbuf data = { -1, 6, buf };
+
+	if (test_ioctl(child, I_STRFTON, 0) != __RESULT_SUCCESS)
+		return (__RESULT_FAILURE);
+	state++;
+	if (test_putpmsg(child, NULL, &data, 0, MSG_BAND) != __RESULT_SUCCESS)
+		return (__RESULT_FAILURE);
+	state++;
+	if (test_ioctl(child, I_STRFTOFF, 0) != __RESULT_SUCCESS)
+		return (__RESULT_FAILURE);
+	state++;
+	if (test_ioctl(child, I_STRFTZERO, 0) != __RESULT_SUCCESS)
+		return (__RESULT_FAILURE);
+	state++;
+	ftbuf.fb.fb_count = 16;
+	if (test_ioctl(child, I_STRFTSTR, (intptr_t) &ftbuf) != __RESULT_SUCCESS)
+		return (__RESULT_FAILURE);
+	state++;
+	if (ftbuf.fb.fb_count != 0)
+		return (__RESULT_FAILURE);
+	state++;
+	return (__RESULT_SUCCESS);
+}
+struct test_stream test_2_54_2 = { &preamble_0, &test_case_2_54_2, &postamble_0 };
+
+#define test_case_2_54_2_stream_0 (&test_2_54_2)
+#define test_case_2_54_2_stream_1 (NULL)
+#define test_case_2_54_2_stream_2 (NULL)
+
+#define tgrp_case_2_54_3 test_group_2
+#define numb_case_2_54_3 "2.54.3"
+#define name_case_2_54_3 "Perform streamio I_STRFTSTR - EINVAL."
+#define sref_case_2_54_3 sref_case_2_54
+#define desc_case_2_54_3 "\
+Checks that I_STRFTSTR can be performed on a Stream.  Checks that EINVAL\n\
+is returned when fb_count is negative."
+
+int
+test_case_2_54_3(int child)
+{
+	ftbuf.fb.fb_count = -1;
+	if (test_ioctl(child, I_STRFTSTR, (intptr_t) &ftbuf) == __RESULT_SUCCESS)
+		return (__RESULT_FAILURE);
+	state++;
+	if (last_errno != EINVAL)
+		return (__RESULT_FAILURE);
+	state++;
+	return (__RESULT_SUCCESS);
+}
+struct test_stream test_2_54_3 = { &preamble_0, &test_case_2_54_3, &postamble_0 };
+
+#define test_case_2_54_3_stream_0 (&test_2_54_3)
+#define test_case_2_54_3_stream_1 (NULL)
+#define test_case_2_54_3_stream_2 (NULL)
+
+#define tgrp_case_2_54_4 test_group_2
+#define numb_case_2_54_4 "2.54.4"
+#define name_case_2_54_4 "Perform streamio I_STRFTSTR - EFAULT."
+#define sref_case_2_54_4 sref_case_2_54
+#define desc_case_2_54_4 "\
+Checks that I_STRFTSTR can be performed on a Stream.  Checks that EFAULT\n\
+is returned when the argument points outside the caller's address space."
+
+int
+test_case_2_54_4(int child)
+{
+	if (test_ioctl(child, I_STRFTSTR, (intptr_t) INVALID_ADDRESS) == __RESULT_SUCCESS)
+		return (__RESULT_FAILURE);
+	state++;
+	if (last_errno != EFAULT)
+		return (__RESULT_FAILURE);
+	state++;
+	return (__RESULT_SUCCESS);
+}
+struct test_stream test_2_54_4 = { &preamble_0, &test_case_2_54_4, &postamble_0 };
+
+#define test_case_2_54_4_stream_0 (&test_2_54_4)
+#define test_case_2_54_4_stream_1 (NULL)
+#define test_case_2_54_4_stream_2 (NULL)
+
+#define tgrp_case_2_54_5 test_group_2
+#define numb_case_2_54_5 "2.54.5"
+#define name_case_2_54_5 "Perform streamio I_STRFTALL."
+#define sref_case_2_54_5 sref_case_2_54
+#define desc_case_2_54_5 "\
+Checks that I_STRFTALL can be performed on a Stream by a privileged\n\
+user."
+
+int
+test_case_2_54_5(int child)
+{
+	if (geteuid() != 0)
+		return (__RESULT_NOTAPPL);
+	ftbuf.fb.fb_count = 16;
+	if (test_ioctl(child, I_STRFTALL, (intptr_t) &ftbuf) != __RESULT_SUCCESS)
+		return (__RESULT_FAILURE);
+	state++;
+	if (ftbuf.fb.fb_count < 0 || ftbuf.fb.fb_count > 16)
+		return (__RESULT_FAILURE);
+	state++;
+	return (__RESULT_SUCCESS);
+}
+struct test_stream test_2_54_5 = { &preamble_0, &test_case_2_54_5, &postamble_0 };
+
+#define test_case_2_54_5_stream_0 (&test_2_54_5)
+#define test_case_2_54_5_stream_1 (NULL)
+#define test_case_2_54_5_stream_2 (NULL)
+
+#define tgrp_case_2_54_6 test_group_2
+#define numb_case_2_54_6 "2.54.6"
+#define name_case_2_54_6 "Perform streamio I_STRFTALL - EPERM."
+#define sref_case_2_54_6 sref_case_2_54
+#define desc_case_2_54_6 "\
+Checks that I_STRFTALL can be performed on a Stream.  Checks that EPERM\n\
+is returned when I_STRFTALL is attempted by an unprivileged user.  When\n\
+run as root, the real and effective user ids are set to nobody for the\n\
+call and the saved user id is used to restore them."
+
+int
+test_case_2_54_6(int child)
+{
+	int priv = (getuid() == 0 || geteuid() == 0);
+	int result = __RESULT_FAILURE;
+
+	if (priv && setresuid(65534, 65534, -1) == -1) {
+		last_errno = errno;
+		return (__RESULT_INCONCLUSIVE);
+	}
+	state++;
+	ftbuf.fb.fb_count = 16;
+	if (test_ioctl(child, I_STRFTALL, (intptr_t) &ftbuf) == __RESULT_SUCCESS)
+		goto restore;
+	state++;
+	if (last_errno != EPERM)
+		goto restore;
+	state++;
+	result = __RESULT_SUCCESS;
+      restore:
+	if (priv && setresuid(0, 0, -1) == -1) {
+		last_errno = errno;
+		return (__RESULT_INCONCLUSIVE);
+	}
+	return (result);
+}
+struct test_stream test_2_54_6 = { &preamble_0, &test_case_2_54_6, &postamble_0 };
+
+#define test_case_2_54_6_stream_0 (&test_2_54_6)
+#define test_case_2_54_6_stream_1 (NULL)
+#define test_case_2_54_6_stream_2 (NULL)
+
 static const char test_group_3[] __attribute__ ((unused)) = "Perform information transfer on one Stream";
 
 static const char test_group_3_1[] = "Perform READ on one Stream";
@@ -21646,6 +22552,52 @@ struct test_case {
 	test_case_2_48_5_stream_0, test_case_2_48_5_stream_1, test_case_2_48_5_stream_2}, &begin_tests, &end_tests, 0, 0, 0, __RESULT_SUCCESS}, {
 		numb_case_2_48_6, tgrp_case_2_48_6, NULL, name_case_2_48_6, NULL, desc_case_2_48_6, sref_case_2_48_6, {
 	test_case_2_48_6_stream_0, test_case_2_48_6_stream_1, test_case_2_48_6_stream_2}, &begin_tests, &end_tests, 0, 0, 0, __RESULT_SUCCESS}, {
+		numb_case_2_49_1, tgrp_case_2_49_1, NULL, name_case_2_49_1, NULL, desc_case_2_49_1, sref_case_2_49_1, {
+	test_case_2_49_1_stream_0, test_case_2_49_1_stream_1, test_case_2_49_1_stream_2}, &begin_tests, &end_tests, 0, 0, 0, __RESULT_SUCCESS}, {
+		numb_case_2_49_2, tgrp_case_2_49_2, NULL, name_case_2_49_2, NULL, desc_case_2_49_2, sref_case_2_49_2, {
+	test_case_2_49_2_stream_0, test_case_2_49_2_stream_1, test_case_2_49_2_stream_2}, &begin_tests, &end_tests, 0, 0, 0, __RESULT_SUCCESS}, {
+		numb_case_2_49_3, tgrp_case_2_49_3, NULL, name_case_2_49_3, NULL, desc_case_2_49_3, sref_case_2_49_3, {
+	test_case_2_49_3_stream_0, test_case_2_49_3_stream_1, test_case_2_49_3_stream_2}, &begin_tests, &end_tests, 0, 0, 0, __RESULT_SUCCESS}, {
+		numb_case_2_49_4, tgrp_case_2_49_4, NULL, name_case_2_49_4, NULL, desc_case_2_49_4, sref_case_2_49_4, {
+	test_case_2_49_4_stream_0, test_case_2_49_4_stream_1, test_case_2_49_4_stream_2}, &begin_tests, &end_tests, 0, 0, 0, __RESULT_SUCCESS}, {
+		numb_case_2_50_1, tgrp_case_2_50_1, NULL, name_case_2_50_1, NULL, desc_case_2_50_1, sref_case_2_50_1, {
+	test_case_2_50_1_stream_0, test_case_2_50_1_stream_1, test_case_2_50_1_stream_2}, &begin_tests, &end_tests, 0, 0, 0, __RESULT_SUCCESS}, {
+		numb_case_2_50_2, tgrp_case_2_50_2, NULL, name_case_2_50_2, NULL, desc_case_2_50_2, sref_case_2_50_2, {
+	test_case_2_50_2_stream_0, test_case_2_50_2_stream_1, test_case_2_50_2_stream_2}, &begin_tests, &end_tests, 0, 0, 0, __RESULT_SUCCESS}, {
+		numb_case_2_50_3, tgrp_case_2_50_3, NULL, name_case_2_50_3, NULL, desc_case_2_50_3, sref_case_2_50_3, {
+	test_case_2_50_3_stream_0, test_case_2_50_3_stream_1, test_case_2_50_3_stream_2}, &begin_tests, &end_tests, 0, 0, 0, __RESULT_SUCCESS}, {
+		numb_case_2_50_4, tgrp_case_2_50_4, NULL, name_case_2_50_4, NULL, desc_case_2_50_4, sref_case_2_50_4, {
+	test_case_2_50_4_stream_0, test_case_2_50_4_stream_1, test_case_2_50_4_stream_2}, &begin_tests, &end_tests, 0, 0, 0, __RESULT_SUCCESS}, {
+		numb_case_2_51_1, tgrp_case_2_51_1, NULL, name_case_2_51_1, NULL, desc_case_2_51_1, sref_case_2_51_1, {
+	test_case_2_51_1_stream_0, test_case_2_51_1_stream_1, test_case_2_51_1_stream_2}, &begin_tests, &end_tests, 0, 0, 0, __RESULT_SUCCESS}, {
+		numb_case_2_51_2, tgrp_case_2_51_2, NULL, name_case_2_51_2, NULL, desc_case_2_51_2, sref_case_2_51_2, {
+	test_case_2_51_2_stream_0, test_case_2_51_2_stream_1, test_case_2_51_2_stream_2}, &begin_tests, &end_tests, 0, 0, 0, __RESULT_SUCCESS}, {
+		numb_case_2_51_3, tgrp_case_2_51_3, NULL, name_case_2_51_3, NULL, desc_case_2_51_3, sref_case_2_51_3, {
+	test_case_2_51_3_stream_0, test_case_2_51_3_stream_1, test_case_2_51_3_stream_2}, &begin_tests, &end_tests, 0, 0, 0, __RESULT_SUCCESS}, {
+		numb_case_2_51_4, tgrp_case_2_51_4, NULL, name_case_2_51_4, NULL, desc_case_2_51_4, sref_case_2_51_4, {
+	test_case_2_51_4_stream_0, test_case_2_51_4_stream_1, test_case_2_51_4_stream_2}, &begin_tests, &end_tests, 0, 0, 0, __RESULT_SUCCESS}, {
+		numb_case_2_51_5, tgrp_case_2_51_5, NULL, name_case_2_51_5, NULL, desc_case_2_51_5, sref_case_2_51_5, {
+	test_case_2_51_5_stream_0, test_case_2_51_5_stream_1, test_case_2_51_5_stream_2}, &begin_tests, &end_tests, 0, 0, 0, __RESULT_SUCCESS}, {
+		numb_case_2_52_1, tgrp_case_2_52_1, NULL, name_case_2_52_1, NULL, desc_case_2_52_1, sref_case_2_52_1, {
+	test_case_2_52_1_stream_0, test_case_2_52_1_stream_1, test_case_2_52_1_stream_2}, &begin_tests, &end_tests, 0, 0, 0, __RESULT_SUCCESS}, {
+		numb_case_2_52_2, tgrp_case_2_52_2, NULL, name_case_2_52_2, NULL, desc_case_2_52_2, sref_case_2_52_2, {
+	test_case_2_52_2_stream_0, test_case_2_52_2_stream_1, test_case_2_52_2_stream_2}, &begin_tests, &end_tests, 0, 0, 0, __RESULT_SUCCESS}, {
+		numb_case_2_53_1, tgrp_case_2_53_1, NULL, name_case_2_53_1, NULL, desc_case_2_53_1, sref_case_2_53_1, {
+	test_case_2_53_1_stream_0, test_case_2_53_1_stream_1, test_case_2_53_1_stream_2}, &begin_tests, &end_tests, 0, 0, 0, __RESULT_SUCCESS}, {
+		numb_case_2_53_2, tgrp_case_2_53_2, NULL, name_case_2_53_2, NULL, desc_case_2_53_2, sref_case_2_53_2, {
+	test_case_2_53_2_stream_0, test_case_2_53_2_stream_1, test_case_2_53_2_stream_2}, &begin_tests, &end_tests, 0, 0, 0, __RESULT_SUCCESS}, {
+		numb_case_2_54_1, tgrp_case_2_54_1, NULL, name_case_2_54_1, NULL, desc_case_2_54_1, sref_case_2_54_1, {
+	test_case_2_54_1_stream_0, test_case_2_54_1_stream_1, test_case_2_54_1_stream_2}, &begin_tests, &end_tests, 0, 0, 0, __RESULT_SUCCESS}, {
+		numb_case_2_54_2, tgrp_case_2_54_2, NULL, name_case_2_54_2, NULL, desc_case_2_54_2, sref_case_2_54_2, {
+	test_case_2_54_2_stream_0, test_case_2_54_2_stream_1, test_case_2_54_2_stream_2}, &begin_tests, &end_tests, 0, 0, 0, __RESULT_SUCCESS}, {
+		numb_case_2_54_3, tgrp_case_2_54_3, NULL, name_case_2_54_3, NULL, desc_case_2_54_3, sref_case_2_54_3, {
+	test_case_2_54_3_stream_0, test_case_2_54_3_stream_1, test_case_2_54_3_stream_2}, &begin_tests, &end_tests, 0, 0, 0, __RESULT_SUCCESS}, {
+		numb_case_2_54_4, tgrp_case_2_54_4, NULL, name_case_2_54_4, NULL, desc_case_2_54_4, sref_case_2_54_4, {
+	test_case_2_54_4_stream_0, test_case_2_54_4_stream_1, test_case_2_54_4_stream_2}, &begin_tests, &end_tests, 0, 0, 0, __RESULT_SUCCESS}, {
+		numb_case_2_54_5, tgrp_case_2_54_5, NULL, name_case_2_54_5, NULL, desc_case_2_54_5, sref_case_2_54_5, {
+	test_case_2_54_5_stream_0, test_case_2_54_5_stream_1, test_case_2_54_5_stream_2}, &begin_tests, &end_tests, 0, 0, 0, __RESULT_SUCCESS}, {
+		numb_case_2_54_6, tgrp_case_2_54_6, NULL, name_case_2_54_6, NULL, desc_case_2_54_6, sref_case_2_54_6, {
+	test_case_2_54_6_stream_0, test_case_2_54_6_stream_1, test_case_2_54_6_stream_2}, &begin_tests, &end_tests, 0, 0, 0, __RESULT_SUCCESS}, {
 		numb_case_3_1_1, tgrp_case_3_1_1, NULL, name_case_3_1_1, NULL, desc_case_3_1_1, sref_case_3_1_1, {
 	test_case_3_1_1_stream_0, test_case_3_1_1_stream_1, test_case_3_1_1_stream_2}, &begin_tests, &end_tests, 0, 0, 0, __RESULT_SUCCESS}, {
 		numb_case_3_1_2, tgrp_case_3_1_2, NULL, name_case_3_1_2, NULL, desc_case_3_1_2, sref_case_3_1_2, {
@@ -73,6 +73,7 @@ static char const ident[] = "src/util/strinfo.c (" PACKAGE_ENVR ") " PACKAGE_DAT
 
 static int debug = 0;			/* default no debug */
 static int output = 1;			/* default normal output */
+static int histograms = 0;		/* default no queue histograms */
 
 static void
 copying(int argc, char *argv[])
@@ -178,6 +179,8 @@ Options:\n\
     -v, --verbose [LEVEL]\n\
         increment or set output verbosity LEVEL [default: 1]\n\
         this option may be repeated.\n\
+    -g, --histograms\n\
+        print queue pair histograms from /proc/streams/qhist\n\
     -h, --help, -?, --?\n\
         print this usage information and exit\n\
     -V, --version\n\
@@ -187,9 +190,74 @@ Options:\n\
 ", argv[0]);
 }
 
+#define QH_PROCFILE "/proc/streams/qhist"
+
+/*
+ *  Print one histogram line of /proc/streams/qhist, which has the form:
+ *
+ *  queue module side histogram bucket:count ...
+ *
+ *  Bucket b counts values v with 2^(b-1) <= v < 2^b (bucket 0 counts zero).  Delay and runtime are
+ *  in nanoseconds; depth is in bytes.
+ */
+static void
+print_histogram(char *line)
+{
+	char *queue, *module, *side, *what, *tok;
+	unsigned long counts[64] = { 0, }, max = 0;
+	int b, lo = 64, hi = -1;
+
+	if ((queue = strtok(line, " \t\n")) == NULL || queue[0] == '#')
+		return;
+	if ((module = strtok(NULL, " \t\n")) == NULL || (side = strtok(NULL, " \t\n")) == NULL
+	    || (what = strtok(NULL, " \t\n")) == NULL)
+		return;
+	while ((tok = strtok(NULL, " \t\n")) != NULL) {
+		unsigned long count;
+
+		if (sscanf(tok, "%d:%lu", &b, &count) != 2 || b < 0 || b >= 64)
+			continue;
+		counts[b] = count;
+		if (count > max)
+			max = count;
+		if (b < lo)
+			lo = b;
+		if (b > hi)
+			hi = b;
+	}
+	if (hi < 0)
+		return;
+	fprintf(stdout, "%s (%s) %s %s:\n", module, queue, side[0] == 'R' ? "read" : "write", what);
+	for (b = lo; b <= hi; b++) {
+		unsigned long long from = b ? (1ULL << (b - 1)) : 0, to = 1ULL << b;
+		int bar = max ? (int) ((counts[b] * 40 + max - 1) / max) : 0;
+
+		fprintf(stdout, "  %12llu .. %-12llu %12lu ", from, to, counts[b]);
+		while (bar-- > 0)
+			fputc('*', stdout);
+		fputc('\n', stdout);
+	}
+}
+
 void
 strinfo(int argc, char *argv[])
 {
+	if (histograms) {
+		char buf[4096];
+		FILE *f;
+
+		if ((f = fopen(QH_PROCFILE, "r")) == NULL) {
+			perror(QH_PROCFILE);
+			exit(1);
+		}
+		while (fgets(buf, sizeof(buf), f) != NULL) {
+			if (output > 1)
+				fputs(buf, stdout);
+			else if (output)
+				print_histogram(buf);
+		}
+		fclose(f);
+	}
 }
 
 int
@@ -205,6 +273,7 @@ main(int argc, char *argv[])
 			{"quiet",	no_argument,		NULL, 'q'},
 			{"debug",	optional_argument,	NULL, 'D'},
 			{"verbose",	optional_argument,	NULL, 'v'},
+			{"histograms",	no_argument,		NULL, 'g'},
 			{"help",	no_argument,		NULL, 'h'},
 			{"version",	no_argument,		NULL, 'V'},
 			{"copying",	no_argument,		NULL, 'C'},
@@ -213,9 +282,9 @@ main(int argc, char *argv[])
 		};
 		/* *INDENT-ON* */
 
-		c = getopt_long_only(argc, argv, "qD::v::hVC?W:", long_options, &option_index);
+		c = getopt_long_only(argc, argv, "qD::v::ghVC?W:", long_options, &option_index);
 #else				/* defined _GNU_SOURCE */
-		c = getopt(argc, argv, "qdvhVC?");
+		c = getopt(argc, argv, "qdvghVC?");
 #endif				/* defined _GNU_SOURCE */
 		if (c == -1) {
 			if (debug)
@@ -253,6 +322,11 @@ main(int argc, char *argv[])
 				goto bad_option;
 			output = val;
 			break;
+		case 'g':	/* -g, --histograms */
+			if (debug)
+				fprintf(stderr, "%s: printing queue histograms\n", argv[0]);
+			histograms = 1;
+			break;
 		case 'h':	/* -h, --help */
 		case 'H':	/* -H, --? */
 			if (debug)